@@ -37,6 +37,7 @@
 
 #include <assert.h>
 #include "../porting/ei_classifier_porting.h"
+#include "../porting/ei_memory_tiers.h"
 
 #ifdef __cplusplus
 namespace {
@@ -61,10 +62,10 @@ typedef uint16_t offset_t;
 
 /**
 * aligned_malloc takes in the requested alignment and size
-*	We will call malloc with extra bytes for our header and the offset
+*	We will call calloc_fn with extra bytes for our header and the offset
 *	required to guarantee the desired alignment.
 */
-__attribute__((unused)) void * ei_aligned_calloc(size_t align, size_t size)
+__attribute__((unused)) void * ei_aligned_calloc_from(void *(*calloc_fn)(size_t, size_t), size_t align, size_t size)
 {
 	void * ptr = NULL;
 
@@ -78,7 +79,7 @@ __attribute__((unused)) void * ei_aligned_calloc(size_t align, size_t size)
 		 * We also allocate extra bytes to ensure we can meet the alignment
 		 */
 		uint32_t hdr_size = PTR_OFFSET_SZ + (align - 1);
-		void * p = ei_calloc(size + hdr_size, 1);
+		void * p = calloc_fn(size + hdr_size, 1);
 
 		if(p)
 		{
@@ -97,6 +98,20 @@ __attribute__((unused)) void * ei_aligned_calloc(size_t align, size_t size)
 	return ptr;
 }
 
+__attribute__((unused)) void * ei_aligned_calloc(size_t align, size_t size)
+{
+	return ei_aligned_calloc_from(ei_calloc, align, size);
+}
+
+/**
+* Same as ei_aligned_calloc, but placed in the hot memory tier (see ei_memory_tiers.h)
+* for buffers that are accessed on every inference, like the tensor arena.
+*/
+__attribute__((unused)) void * ei_aligned_calloc_hot(size_t align, size_t size)
+{
+	return ei_aligned_calloc_from(ei_calloc_hot, align, size);
+}
+
 /**
 * aligned_free works like free(), but we work backwards from the returned
 * pointer to find the correct offset and pointer location to return to free()
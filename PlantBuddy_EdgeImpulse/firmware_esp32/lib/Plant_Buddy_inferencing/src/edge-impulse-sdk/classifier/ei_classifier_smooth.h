@@ -42,55 +42,74 @@
 typedef struct ei_classifier_smooth {
     int *last_readings;
     size_t last_readings_size;
-    uint8_t min_readings_same;
+    size_t last_readings_ix; // oldest reading, overwritten by the next update
+    uint16_t min_readings_same;
     float classifier_confidence;
     float anomaly_confidence;
-    uint8_t count[EI_CLASSIFIER_LABEL_COUNT + 2] = { 0 };
+    // number of readings per label in last_readings, then uncertain, then anomaly
+    uint16_t count[EI_CLASSIFIER_LABEL_COUNT + 2] = { 0 };
     size_t count_size = EI_CLASSIFIER_LABEL_COUNT + 2;
 } ei_classifier_smooth_t;
 
+/**
+ * Index into ei_classifier_smooth_t::count for a reading
+ */
+static inline size_t ei_classifier_smooth_count_ix(int reading) {
+    if (reading >= 0) {
+        return (size_t)reading;
+    }
+    return reading == -2 ? EI_CLASSIFIER_LABEL_COUNT + 1 : EI_CLASSIFIER_LABEL_COUNT;
+}
+
 /**
  * Initialize a smooth structure. This is useful if you don't want to trust
  * single readings, but rather want consensus
  * (e.g. 7 / 10 readings should be the same before I draw any ML conclusions).
  * This allocates memory on the heap!
  * @param smooth Pointer to an uninitialized ei_classifier_smooth_t struct
- * @param n_readings Number of readings you want to store
+ * @param n_readings Number of readings you want to store (at most 65535)
  * @param min_readings_same Minimum readings that need to be the same before concluding (needs to be lower than n_readings)
  * @param classifier_confidence Minimum confidence in a class (default 0.8)
  * @param anomaly_confidence Maximum error for anomalies (default 0.3)
  */
 void ei_classifier_smooth_init(ei_classifier_smooth_t *smooth, size_t n_readings,
-                               uint8_t min_readings_same, float classifier_confidence = 0.8,
+                               uint16_t min_readings_same, float classifier_confidence = 0.8,
                                float anomaly_confidence = 0.3) {
+    if (n_readings > UINT16_MAX) {
+        n_readings = UINT16_MAX;
+    }
     smooth->last_readings = (int*)ei_malloc(n_readings * sizeof(int));
+    if (!smooth->last_readings) {
+        n_readings = 0;
+    }
     for (size_t ix = 0; ix < n_readings; ix++) {
         smooth->last_readings[ix] = -1; // -1 == uncertain
     }
     smooth->last_readings_size = n_readings;
+    smooth->last_readings_ix = 0;
     smooth->min_readings_same = min_readings_same;
     smooth->classifier_confidence = classifier_confidence;
     smooth->anomaly_confidence = anomaly_confidence;
     smooth->count_size = EI_CLASSIFIER_LABEL_COUNT + 2;
+    memset(smooth->count, 0, sizeof(smooth->count));
+    smooth->count[EI_CLASSIFIER_LABEL_COUNT] = (uint16_t)n_readings;
 }
 
 /**
- * Call when a new reading comes in.
+ * Call when a new reading comes in. The history is a ring buffer and the
+ * per-label counts are kept up to date, so an update doesn't depend on the
+ * number of readings stored.
  * @param smooth Pointer to an initialized ei_classifier_smooth_t struct
  * @param result Pointer to a result structure (after calling ei_run_classifier)
  * @returns Label, either 'uncertain', 'anomaly', or a label from the result struct
  */
 const char* ei_classifier_smooth_update(ei_classifier_smooth_t *smooth, ei_impulse_result_t *result) {
-    // clear out the count array
-    memset(smooth->count, 0, EI_CLASSIFIER_LABEL_COUNT + 2);
-
-    // roll through the last_readings buffer
-    numpy::roll(smooth->last_readings, smooth->last_readings_size, -1);
+    if (smooth->last_readings_size == 0) {
+        return "uncertain";
+    }
 
     int reading = -1; // uncertain
 
-    // print the predictions
-    // printf("[");
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
         if (result->classification[ix].value >= smooth->classifier_confidence) {
             reading = (int)ix;
@@ -100,26 +119,22 @@ const char* ei_classifier_smooth_update(ei_classifier_smooth_t *smooth, ei_impul
         reading = -2; // anomaly
     }
 
-    smooth->last_readings[smooth->last_readings_size - 1] = reading;
+    // replace the oldest reading, and move its count over to the new one
+    int *oldest = &smooth->last_readings[smooth->last_readings_ix];
+    smooth->count[ei_classifier_smooth_count_ix(*oldest)]--;
+    smooth->count[ei_classifier_smooth_count_ix(reading)]++;
+    *oldest = reading;
 
-    // now count last 10 readings and see what we actually see...
-    for (size_t ix = 0; ix < smooth->last_readings_size; ix++) {
-        if (smooth->last_readings[ix] >= 0) {
-            smooth->count[smooth->last_readings[ix]]++;
-        }
-        else if (smooth->last_readings[ix] == -1) { // uncertain
-            smooth->count[EI_CLASSIFIER_LABEL_COUNT]++;
-        }
-        else if (smooth->last_readings[ix] == -2) { // anomaly
-            smooth->count[EI_CLASSIFIER_LABEL_COUNT + 1]++;
-        }
+    smooth->last_readings_ix++;
+    if (smooth->last_readings_ix >= smooth->last_readings_size) {
+        smooth->last_readings_ix = 0;
     }
 
     // then loop over the count and see which is highest
-    uint8_t top_result = 0;
-    uint8_t top_count = 0;
+    size_t top_result = 0;
+    uint16_t top_count = 0;
     bool met_confidence_threshold = false;
-    uint8_t confidence_threshold = smooth->min_readings_same; // XX% of windows should be the same
+    uint16_t confidence_threshold = smooth->min_readings_same; // XX% of windows should be the same
     for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT + 2; ix++) {
         if (smooth->count[ix] > top_count) {
             top_result = ix;
@@ -149,6 +164,112 @@ const char* ei_classifier_smooth_update(ei_classifier_smooth_t *smooth, ei_impul
  */
 void ei_classifier_smooth_free(ei_classifier_smooth_t *smooth) {
     ei_free(smooth->last_readings);
+    smooth->last_readings = nullptr;
+    smooth->last_readings_size = 0;
+}
+
+typedef struct ei_classifier_hysteresis {
+    float alpha;
+    float enter_threshold[EI_CLASSIFIER_LABEL_COUNT];
+    float exit_threshold[EI_CLASSIFIER_LABEL_COUNT];
+    float confidence[EI_CLASSIFIER_LABEL_COUNT];
+    bool active[EI_CLASSIFIER_LABEL_COUNT];
+    bool primed;
+} ei_classifier_hysteresis_t;
+
+/**
+ * Initialize a hysteresis structure. Confidences are smoothed with an
+ * exponentially weighted moving average (EWMA), and a label only becomes active
+ * once its smoothed confidence reaches `enter_threshold`. It then stays active
+ * until it drops below `exit_threshold`, so a confidence hovering around a single
+ * threshold doesn't make the output flap. Needs no heap and O(labels) per update.
+ * @param hysteresis Pointer to an uninitialized ei_classifier_hysteresis_t struct
+ * @param alpha Weight of the newest reading, in (0, 1]. 1 disables smoothing,
+ *              lower values smooth over roughly 2 / alpha readings
+ * @param enter_threshold Smoothed confidence at which a label becomes active
+ * @param exit_threshold Smoothed confidence below which an active label is cleared
+ *                       (should be lower than enter_threshold)
+ */
+void ei_classifier_hysteresis_init(ei_classifier_hysteresis_t *hysteresis, float alpha = 0.5f,
+                                   float enter_threshold = 0.8f, float exit_threshold = 0.6f) {
+    if (alpha <= 0.0f || alpha > 1.0f) {
+        alpha = 1.0f;
+    }
+    hysteresis->alpha = alpha;
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        hysteresis->enter_threshold[ix] = enter_threshold;
+        hysteresis->exit_threshold[ix] = exit_threshold;
+        hysteresis->confidence[ix] = 0.0f;
+        hysteresis->active[ix] = false;
+    }
+    hysteresis->primed = false;
+}
+
+/**
+ * Override the thresholds for a single label (e.g. be quicker to enter a
+ * safe state than an unsafe one)
+ * @param hysteresis Pointer to an initialized ei_classifier_hysteresis_t struct
+ * @param label_ix Index of the label in the result's classification array
+ */
+void ei_classifier_hysteresis_set_thresholds(ei_classifier_hysteresis_t *hysteresis, size_t label_ix,
+                                             float enter_threshold, float exit_threshold) {
+    if (label_ix >= EI_CLASSIFIER_LABEL_COUNT) {
+        return;
+    }
+    hysteresis->enter_threshold[label_ix] = enter_threshold;
+    hysteresis->exit_threshold[label_ix] = exit_threshold;
+}
+
+/**
+ * Call when a new reading comes in.
+ * @param hysteresis Pointer to an initialized ei_classifier_hysteresis_t struct
+ * @param result Pointer to a result structure (after calling ei_run_classifier)
+ * @returns The active label with the highest smoothed confidence, or 'uncertain'
+ */
+const char* ei_classifier_hysteresis_update(ei_classifier_hysteresis_t *hysteresis, ei_impulse_result_t *result) {
+    int top_result = -1;
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        float value = result->classification[ix].value;
+        float confidence = hysteresis->primed ?
+            hysteresis->confidence[ix] + hysteresis->alpha * (value - hysteresis->confidence[ix]) :
+            value;
+        hysteresis->confidence[ix] = confidence;
+
+        if (hysteresis->active[ix]) {
+            if (confidence < hysteresis->exit_threshold[ix]) {
+                hysteresis->active[ix] = false;
+            }
+        }
+        else if (confidence >= hysteresis->enter_threshold[ix]) {
+            hysteresis->active[ix] = true;
+        }
+
+        if (hysteresis->active[ix] &&
+            (top_result < 0 || confidence > hysteresis->confidence[top_result])) {
+            top_result = (int)ix;
+        }
+    }
+    hysteresis->primed = true;
+
+    if (top_result < 0) {
+        return "uncertain";
+    }
+    return result->classification[top_result].label;
+}
+
+/**
+ * @returns Whether a label is currently active
+ */
+bool ei_classifier_hysteresis_is_active(const ei_classifier_hysteresis_t *hysteresis, size_t label_ix) {
+    return label_ix < EI_CLASSIFIER_LABEL_COUNT && hysteresis->active[label_ix];
+}
+
+/**
+ * @returns The smoothed confidence of a label
+ */
+float ei_classifier_hysteresis_confidence(const ei_classifier_hysteresis_t *hysteresis, size_t label_ix) {
+    return label_ix < EI_CLASSIFIER_LABEL_COUNT ? hysteresis->confidence[label_ix] : 0.0f;
 }
 
 #endif // #if EI_CLASSIFIER_OBJECT_DETECTION != 1
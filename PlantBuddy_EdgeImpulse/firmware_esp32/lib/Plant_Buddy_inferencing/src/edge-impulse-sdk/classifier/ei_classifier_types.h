@@ -44,6 +44,21 @@
 #define EI_CLASSIFIER_MAX_OBJECT_DETECTION_COUNT 10
 #endif
 
+// Record per-operator timing (see ei_op_profiler.h) into ei_impulse_result_t.
+// Define as a global build flag, the compiled model needs to see it as well.
+#ifndef EI_CLASSIFIER_PROFILE_OPS
+#define EI_CLASSIFIER_PROFILE_OPS 0
+#endif
+
+#ifndef EI_CLASSIFIER_PROFILE_MAX_EVENTS
+#define EI_CLASSIFIER_PROFILE_MAX_EVENTS 32
+#endif
+
+// Carry recurrent state over between inferences (see ei_recurrent_state.h)
+#ifndef EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+#define EI_CLASSIFIER_STREAMING_RECURRENT_STATE 0
+#endif
+
 // Whether ei_result_t classification field is statically allocated on the result struct or not
 #if defined(EI_DSP_RESULT_OVERRIDE)
 #define EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED    0
@@ -229,6 +244,46 @@ typedef struct {
     int64_t anomaly_us;
 } ei_impulse_result_timing_t;
 
+/**
+ * @brief Stage of the impulse that a profiling event belongs to
+ */
+typedef enum {
+    EI_PROFILE_STAGE_DSP = 0,
+    EI_PROFILE_STAGE_INFERENCE = 1,
+    EI_PROFILE_STAGE_POSTPROCESSING = 2
+} ei_profile_stage_t;
+
+/**
+ * @brief Timing of a single operator / stage, only recorded if `EI_CLASSIFIER_PROFILE_OPS` is set.
+ */
+typedef struct {
+    /**
+     * Name of the operator or stage (e.g. "FULLY_CONNECTED", "flatten_scale"). Static string.
+     */
+    const char *tag;
+
+    /**
+     * Stage this event belongs to, see ei_profile_stage_t
+     */
+    uint8_t stage;
+
+    /**
+     * Nesting depth, 0 for top-level events
+     */
+    uint8_t depth;
+
+    /**
+     * Amount of time (in microseconds) spent in this event, including nested events
+     */
+    int64_t us;
+
+    /**
+     * CPU cycles spent in this event. Only available on targets with a cycle counter
+     * (ESP32), otherwise 0.
+     */
+    uint32_t cycles;
+} ei_impulse_result_op_profile_t;
+
 /**
  * @brief Holds intermediate results of hr / hrv block
  *
@@ -335,6 +390,27 @@ typedef struct {
 #if EI_CLASSIFIER_HR_ENABLED == 1
     ei_impulse_result_hr_t hr_calcs;
 #endif
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    /**
+     * Per-operator timing, in the order the events started. Only available if
+     * `EI_CLASSIFIER_PROFILE_OPS` is set. See ei_print_op_profile_csv().
+     */
+    ei_impulse_result_op_profile_t op_profile[EI_CLASSIFIER_PROFILE_MAX_EVENTS];
+
+    /**
+     * Number of valid entries in `op_profile`
+     */
+    uint32_t op_profile_count;
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    /**
+     * State of the learning block that's running (see ei_recurrent_state.h)
+     * INTERNAL
+     */
+    void *_recurrent_block;
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
 } ei_impulse_result_t;
 
 /** @} */
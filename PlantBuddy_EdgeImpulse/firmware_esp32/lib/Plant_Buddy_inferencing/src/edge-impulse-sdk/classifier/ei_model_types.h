@@ -46,6 +46,10 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #endif // EI_CLASSIFIER_USE_FULL_TFLITE
 
+namespace tflite {
+class MicroProfilerInterface;
+}
+
 #define EI_CLASSIFIER_NONE                       255
 #define EI_CLASSIFIER_UTENSOR                    1
 #define EI_CLASSIFIER_TFLITE                     2
@@ -302,6 +306,10 @@ typedef struct {
     TfLiteStatus (*model_reset)(void (*free)(void* ptr));
     TfLiteStatus (*model_input)(int, TfLiteTensor*);
     TfLiteStatus (*model_output)(int, TfLiteTensor*);
+    // optional, only set if the model was built with EI_CLASSIFIER_PROFILE_OPS
+    TfLiteStatus (*model_set_profiler)(tflite::MicroProfilerInterface*);
+    // optional, reports arena usage (arena, planned, persistent, heap overflow) after model_init
+    TfLiteStatus (*model_arena_usage)(size_t*, size_t*, size_t*, size_t*);
 } ei_config_tflite_eon_graph_t;
 
 typedef struct {
@@ -466,12 +474,29 @@ public:
     }
 };
 
+/**
+ * Variable tensors (e.g. LSTM/GRU hidden and cell state) of one learning block,
+ * carried over between inferences (see ei_recurrent_state.h)
+ */
+typedef struct {
+    uint32_t tensor_count; // number of variable tensors, in graph order
+    size_t bytes;          // total size of the variable tensors
+    uint8_t *data;         // the variable tensors, back to back
+    bool valid;            // false until the block has run (or after a reset)
+} ei_recurrent_block_state_t;
+
+typedef struct {
+    size_t blocks_size;                  // one entry per learning block
+    ei_recurrent_block_state_t *blocks;
+} ei_recurrent_state_t;
+
 class ei_impulse_handle_t {
 public:
     ei_impulse_handle_t(const ei_impulse_t *impulse)
         : state(impulse)
         , impulse(impulse)
         , post_processing_state(nullptr)
+        , recurrent_state(nullptr)
 #if EI_CLASSIFIER_FREEFORM_OUTPUT
         , freeform_outputs(nullptr)
 #endif //EI_CLASSIFIER_FREEFORM_OUTPUT
@@ -480,6 +505,7 @@ public:
     ei_impulse_state_t state;
     const ei_impulse_t *impulse;
     void** post_processing_state;
+    ei_recurrent_state_t *recurrent_state;
 #if EI_CLASSIFIER_FREEFORM_OUTPUT == 1
     ei::matrix_t *freeform_outputs;
 #endif // EI_CLASSIFIER_FREEFORM_OUTPUT
@@ -214,8 +214,188 @@ static inline void NonMaxSuppression(const float* boxes, const int num_boxes,
   }
 }
 
+#ifndef EI_CLASSIFIER_NMS_BUCKETED
+#define EI_CLASSIFIER_NMS_BUCKETED 1
+#endif // EI_CLASSIFIER_NMS_BUCKETED
+
+#ifndef EI_CLASSIFIER_NMS_GRID_MAX_CELLS
+#define EI_CLASSIFIER_NMS_GRID_MAX_CELLS 32
+#endif // EI_CLASSIFIER_NMS_GRID_MAX_CELLS
+
+// Everything below this line is not from TensorFlow.
+
+struct NmsCandidate {
+  int index;
+  float score;
+};
+
+// Bytes of scratch NonMaxSuppressionBucketed() needs for num_boxes boxes in num_classes
+// classes (num_classes == 0 for class-agnostic suppression).
+static inline size_t NonMaxSuppressionBucketedScratchSize(const int num_boxes,
+                                                          const int num_classes) {
+  const size_t cells = EI_CLASSIFIER_NMS_GRID_MAX_CELLS * EI_CLASSIFIER_NMS_GRID_MAX_CELLS;
+  const int bucket_count = num_classes > 0 ? num_classes : 1;
+  return (size_t)num_boxes * sizeof(NmsCandidate) +   // candidates, per class
+         (size_t)num_boxes * sizeof(int) +            // grid chain links
+         (size_t)num_boxes * sizeof(int) +            // box indices sorted by class
+         (size_t)(bucket_count + 1) * sizeof(int) +   // class offsets
+         cells * sizeof(int);                         // grid cell heads
+}
+
+// Hard NMS (soft_nms_sigma == 0) with the same selections, in the same order, as
+// NonMaxSuppression() above, but without its O(n^2) scan or heap allocations:
+//
+//  * candidates are ordered once, into a preallocated array, with the heap operations
+//    std::priority_queue would do (so even equal scores pop in the same order);
+//  * every selected box is linked into the cell of a uniform grid that holds its min
+//    corner. A selected box can only reach iou_threshold with a candidate if its min
+//    corner lies within a window around the candidate's (see below), so only those
+//    cells (plus a guard cell for rounding) are compared against. For
+//    iou_threshold <= 0 or non-finite coordinates the grid collapses to a single cell,
+//    i.e. the exhaustive check.
+//
+// classes: if not null, boxes only suppress boxes of the same class (class-batched),
+//   which equals calling NonMaxSuppression() once per class: selections are returned
+//   class by class in ascending order, and max_output_size applies per class.
+//   Classes must be in [0, num_classes).
+// scratch: NonMaxSuppressionBucketedScratchSize(num_boxes, num_classes) bytes, int aligned.
+static inline void NonMaxSuppressionBucketed(const float* boxes, const int num_boxes,
+                                             const float* scores, const int* classes,
+                                             const int num_classes,
+                                             const int max_output_size,
+                                             const float iou_threshold,
+                                             const float score_threshold,
+                                             void* scratch, int* selected_indices,
+                                             float* selected_scores,
+                                             int* num_selected_indices) {
+  const int max_cells = EI_CLASSIFIER_NMS_GRID_MAX_CELLS;
+  NmsCandidate* candidates = static_cast<NmsCandidate*>(scratch);
+  int* next = reinterpret_cast<int*>(candidates + num_boxes);
+  int* sorted = next + num_boxes;
+  const int bucket_count = classes ? num_classes : 1;
+  int* offsets = sorted + num_boxes;
+  int* heads = offsets + bucket_count + 1;
+  const BoxCornerEncoding* corners = reinterpret_cast<const BoxCornerEncoding*>(boxes);
+
+  // Stable counting sort of the candidates above the threshold by class, so each class
+  // keeps the order a per-class call would have pushed them in.
+  for (int c = 0; c <= bucket_count; ++c) offsets[c] = 0;
+  for (int i = 0; i < num_boxes; ++i) {
+    if (scores[i] > score_threshold) offsets[(classes ? classes[i] : 0) + 1]++;
+  }
+  for (int c = 0; c < bucket_count; ++c) offsets[c + 1] += offsets[c];
+  for (int i = 0; i < num_boxes; ++i) {
+    if (scores[i] > score_threshold) sorted[offsets[classes ? classes[i] : 0]++] = i;
+  }
+  for (int c = bucket_count; c > 0; --c) offsets[c] = offsets[c - 1];
+  offsets[0] = 0;
+
+  auto cmp = [](const NmsCandidate& bs_i, const NmsCandidate& bs_j) {
+    return bs_i.score < bs_j.score;
+  };
+
+  *num_selected_indices = 0;
+  for (int bucket = 0; bucket < bucket_count; ++bucket) {
+    NmsCandidate* cand = candidates + offsets[bucket];
+    const int count = offsets[bucket + 1] - offsets[bucket];
+    const int num_outputs = std::min(count, max_output_size);
+    if (num_outputs <= 0) continue;
+
+    // Heap sort with the exact push / pop sequence of the priority queue:
+    // cand[count - 1] is the first candidate it would pop.
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    float magnitude = 0.0f;
+    for (int i = 0; i < count; ++i) {
+      const int ix = sorted[offsets[bucket] + i];
+      cand[i] = { ix, scores[ix] };
+      std::push_heap(cand, cand + i + 1, cmp);
+
+      const BoxCornerEncoding& b = corners[ix];
+      const float x0 = std::min<float>(b.x1, b.x2), y0 = std::min<float>(b.y1, b.y2);
+      min_x = std::min(min_x, x0);
+      max_x = std::max(max_x, x0);
+      min_y = std::min(min_y, y0);
+      max_y = std::max(max_y, y0);
+      magnitude = std::max(magnitude, std::max(std::fabs(b.x1) + std::fabs(b.x2),
+                                               std::fabs(b.y1) + std::fabs(b.y2)));
+    }
+    std::sort_heap(cand, cand + count, cmp);
+
+    // Grid resolution: ~one candidate per cell, but cells stay far wider than the
+    // rounding error of (min - widest box), which the guard cell has to absorb.
+    int grid = 1;
+    const float range = std::max(max_x - min_x, max_y - min_y);
+    if (iou_threshold > 0.0f && std::isfinite(range) && std::isfinite(magnitude) && range > 0.0f) {
+      grid = std::min<int>(max_cells, (int)std::ceil(std::sqrt((float)count)));
+      const float min_cell = magnitude * 1e-5f;
+      if (min_cell > 0.0f && range / grid < min_cell) {
+        grid = std::max(1, std::min(grid, (int)(range / min_cell)));
+      }
+    }
+    const float inv_x = (grid > 1 && max_x > min_x) ? grid / (max_x - min_x) : 0.0f;
+    const float inv_y = (grid > 1 && max_y > min_y) ? grid / (max_y - min_y) : 0.0f;
+    auto cell_of = [grid](float v, float origin, float inv) -> int {
+      const float t = (v - origin) * inv;
+      return !(t > 0.0f) ? 0 : (t >= (float)grid ? grid - 1 : (int)t);
+    };
+    for (int i = 0; i < grid * grid; ++i) heads[i] = -1;
+
+    // iou_threshold <= 0 has a single cell, so the window below doesn't matter
+    const float iou_slack = std::min(std::max(iou_threshold * 0.999f, 1e-6f), 1.0f);
+    float widest = 0.0f, tallest = 0.0f;
+    int bucket_selected = 0;
+    for (int p = count - 1; p >= 0 && bucket_selected < num_outputs; --p) {
+      const int ix = cand[p].index;
+      const BoxCornerEncoding& b = corners[ix];
+      const float x0 = std::min<float>(b.x1, b.x2), x1 = std::max<float>(b.x1, b.x2);
+      const float y0 = std::min<float>(b.y1, b.y2), y1 = std::max<float>(b.y1, b.y2);
+
+      // IoU >= t needs the min corners within (1 - t) * w (right) and (1 - t) / t * w
+      // (left) of each other, and the left one can't be wider than the widest selected box.
+      // Slack on t and the guard cell keep this conservative under float rounding.
+      const float w = x1 - x0, h = y1 - y0;
+      const float reach_x_lo = (1.0f - iou_slack) * std::min(widest, w / iou_slack);
+      const float reach_y_lo = (1.0f - iou_slack) * std::min(tallest, h / iou_slack);
+      const int cx_lo = std::max(cell_of(x0 - reach_x_lo, min_x, inv_x) - 1, 0);
+      const int cx_hi = std::min(cell_of(x0 + (1.0f - iou_slack) * w, min_x, inv_x) + 1, grid - 1);
+      const int cy_lo = std::max(cell_of(y0 - reach_y_lo, min_y, inv_y) - 1, 0);
+      const int cy_hi = std::min(cell_of(y0 + (1.0f - iou_slack) * h, min_y, inv_y) + 1, grid - 1);
+      const int own_cell = cell_of(y0, min_y, inv_y) * grid + cell_of(x0, min_x, inv_x);
+
+      // the box's own cell first, that's where a suppressing box most likely is
+      bool should_hard_suppress = false;
+      for (int j = heads[own_cell]; j >= 0 && !should_hard_suppress; j = next[j]) {
+        should_hard_suppress = ComputeIntersectionOverUnion(boxes, ix, j) >= iou_threshold;
+      }
+      for (int cy = cy_lo; cy <= cy_hi && !should_hard_suppress; ++cy) {
+        for (int cx = cx_lo; cx <= cx_hi && !should_hard_suppress; ++cx) {
+          if (cy * grid + cx == own_cell) continue;
+          for (int j = heads[cy * grid + cx]; j >= 0 && !should_hard_suppress; j = next[j]) {
+            should_hard_suppress = ComputeIntersectionOverUnion(boxes, ix, j) >= iou_threshold;
+          }
+        }
+      }
+      if (should_hard_suppress) continue;
+
+      selected_indices[*num_selected_indices] = ix;
+      if (selected_scores) {
+        selected_scores[*num_selected_indices] = cand[p].score;
+      }
+      ++*num_selected_indices;
+      ++bucket_selected;
+
+      next[ix] = heads[own_cell];
+      heads[own_cell] = ix;
+      widest = std::max(widest, w);
+      tallest = std::max(tallest, h);
+    }
+  }
+}
+
 /**
  * Run non-max suppression over the results array (for bounding boxes)
+ * If class_batched is set, boxes only suppress boxes of the same class, and the results
+ * come out class by class (same as calling this once per class).
  */
 EI_IMPULSE_ERROR ei_run_nms(
     const ei_impulse_t *impulse,
@@ -225,7 +405,8 @@ EI_IMPULSE_ERROR ei_run_nms(
     int *classes,
     size_t bb_count,
     bool clip_boxes,
-    const ei_object_detection_nms_config_t *nms_config) {
+    const ei_object_detection_nms_config_t *nms_config,
+    bool class_batched = false) {
 
     if (bb_count < 1) {
         return EI_IMPULSE_OK;
@@ -233,10 +414,21 @@ EI_IMPULSE_ERROR ei_run_nms(
 
     int *selected_indices = (int*)ei_malloc(1 * bb_count * sizeof(int));
     float *selected_scores = (float*)ei_malloc(1 * bb_count * sizeof(float));
-
-    if (!scores || !boxes || !selected_indices || !selected_scores || !classes) {
+#if EI_CLASSIFIER_NMS_BUCKETED == 1
+    const int num_classes = class_batched ? (int)impulse->label_count : 0;
+    void *nms_scratch = ei_malloc(NonMaxSuppressionBucketedScratchSize(bb_count, num_classes));
+#else
+    void *nms_scratch = nullptr;
+#endif
+
+    if (!scores || !boxes || !selected_indices || !selected_scores || !classes
+#if EI_CLASSIFIER_NMS_BUCKETED == 1
+        || !nms_scratch
+#endif
+        ) {
         ei_free(selected_indices);
         ei_free(selected_scores);
+        ei_free(nms_scratch);
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
 
@@ -248,19 +440,65 @@ EI_IMPULSE_ERROR ei_run_nms(
     //  score_threshold: All candidate scores below this value are rejected
     //  soft_nms_sigma: Soft NMS parameter, used for decaying scores
 
-    int num_selected_indices;
+    int num_selected_indices = 0;
 
-    NonMaxSuppression(
+#if EI_CLASSIFIER_NMS_BUCKETED == 1
+    NonMaxSuppressionBucketed(
         (const float*)boxes, // boxes
         bb_count, // num_boxes
         (const float*)scores, // scores
+        class_batched ? classes : nullptr, // classes
+        num_classes, // num_classes
         bb_count, // max_output_size
         nms_config->iou_threshold, // iou_threshold
         nms_config->confidence_threshold, // score_threshold
-        0.0f, // soft_nms_sigma
+        nms_scratch,
         selected_indices,
         selected_scores,
         &num_selected_indices);
+#else
+    if (class_batched) {
+        // one call per class, same as the bucketed path
+        for (size_t cls = 0; cls < impulse->label_count; cls++) {
+            std::vector<float> class_boxes;
+            std::vector<float> class_scores;
+            std::vector<int> class_map;
+            for (size_t ix = 0; ix < bb_count; ix++) {
+                if (classes[ix] != (int)cls) {
+                    continue;
+                }
+                class_boxes.insert(class_boxes.end(), boxes + ix * 4, boxes + ix * 4 + 4);
+                class_scores.push_back(scores[ix]);
+                class_map.push_back((int)ix);
+            }
+            if (class_map.empty()) {
+                continue;
+            }
+            int class_selected = 0;
+            NonMaxSuppression(class_boxes.data(), class_map.size(), class_scores.data(), class_map.size(),
+                              nms_config->iou_threshold, nms_config->confidence_threshold, 0.0f,
+                              selected_indices + num_selected_indices, selected_scores + num_selected_indices,
+                              &class_selected);
+            for (int ix = 0; ix < class_selected; ix++) {
+                selected_indices[num_selected_indices + ix] = class_map[selected_indices[num_selected_indices + ix]];
+            }
+            num_selected_indices += class_selected;
+        }
+    }
+    else {
+        NonMaxSuppression(
+            (const float*)boxes, // boxes
+            bb_count, // num_boxes
+            (const float*)scores, // scores
+            bb_count, // max_output_size
+            nms_config->iou_threshold, // iou_threshold
+            nms_config->confidence_threshold, // score_threshold
+            0.0f, // soft_nms_sigma
+            selected_indices,
+            selected_scores,
+            &num_selected_indices);
+    }
+#endif // EI_CLASSIFIER_NMS_BUCKETED == 1
 
     std::vector<ei_impulse_result_bounding_box_t> new_results;
 
@@ -300,6 +538,7 @@ EI_IMPULSE_ERROR ei_run_nms(
 
     ei_free(selected_indices);
     ei_free(selected_scores);
+    ei_free(nms_scratch);
 
     return EI_IMPULSE_OK;
 
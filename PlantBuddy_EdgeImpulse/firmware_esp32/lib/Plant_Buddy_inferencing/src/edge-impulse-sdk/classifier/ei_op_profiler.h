@@ -0,0 +1,247 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_CLASSIFIER_OP_PROFILER_H_
+#define _EI_CLASSIFIER_OP_PROFILER_H_
+
+#include <stdint.h>
+#include "edge-impulse-sdk/classifier/ei_classifier_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/dsp/ei_alloc_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+
+/**
+ * Per-operator profiling. If EI_CLASSIFIER_PROFILE_OPS is set, process_impulse() records
+ * the time spent in every DSP block (and its sub-stages), every node of the compiled
+ * graph and every postprocessing block into result->op_profile. The recorder implements
+ * tflite::MicroProfilerInterface, so it's handed to the EON compiled model the same way
+ * a MicroProfiler would be handed to the interpreter.
+ *
+ * If profiling is disabled the macros below compile to nothing.
+ *
+ * The SDK's own code is instrumented through the combined macros at the end of this
+ * file, which also feed the zone profiler (ei_profiler.h) and the allocation profiler
+ * (ei_alloc_profiler.h), so every profiler sees the same scopes.
+ */
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+
+// CPU cycle counter, only used where one is cheaply available
+#if defined(ESP_PLATFORM) || defined(ESP32)
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "esp_cpu.h"
+#define EI_OP_PROFILER_CYCLES() ((uint32_t)esp_cpu_get_cycle_count())
+#elif defined(__XTENSA__)
+#include "xtensa/hal.h"
+#define EI_OP_PROFILER_CYCLES() ((uint32_t)xthal_get_ccount())
+#endif
+#endif // ESP_PLATFORM
+
+#ifndef EI_OP_PROFILER_CYCLES
+#define EI_OP_PROFILER_CYCLES() ((uint32_t)0)
+#endif
+
+class EiOpProfiler : public tflite::MicroProfilerInterface {
+public:
+    static const uint32_t dropped_event = 0xffffffff;
+
+    /**
+     * Start recording into the result, and make this the active profiler
+     * until it goes out of scope
+     */
+    EiOpProfiler(ei_impulse_result_t *result)
+        : result(result), stage(EI_PROFILE_STAGE_DSP), depth(0), previous(active())
+    {
+        result->op_profile_count = 0;
+        active() = this;
+    }
+
+    ~EiOpProfiler()
+    {
+        active() = previous;
+    }
+
+    void set_stage(ei_profile_stage_t new_stage)
+    {
+        stage = new_stage;
+    }
+
+    uint32_t BeginEvent(const char *tag) override
+    {
+        if (result->op_profile_count >= EI_CLASSIFIER_PROFILE_MAX_EVENTS) {
+            depth++;
+            return dropped_event;
+        }
+
+        uint32_t handle = result->op_profile_count++;
+        ei_impulse_result_op_profile_t *event = &result->op_profile[handle];
+        event->tag = tag;
+        event->stage = (uint8_t)stage;
+        event->depth = depth++;
+        // hold the start values until EndEvent
+        event->us = (int64_t)ei_read_timer_us();
+        event->cycles = EI_OP_PROFILER_CYCLES();
+        return handle;
+    }
+
+    void EndEvent(uint32_t event_handle) override
+    {
+        uint32_t end_cycles = EI_OP_PROFILER_CYCLES();
+        int64_t end_us = (int64_t)ei_read_timer_us();
+
+        if (depth > 0) {
+            depth--;
+        }
+        if (event_handle >= result->op_profile_count) {
+            return;
+        }
+
+        ei_impulse_result_op_profile_t *event = &result->op_profile[event_handle];
+        event->us = end_us - event->us;
+        event->cycles = end_cycles - event->cycles;
+    }
+
+    /**
+     * The profiler that's currently recording, or nullptr
+     */
+    static EiOpProfiler *&active()
+    {
+        static EiOpProfiler *current = nullptr;
+        return current;
+    }
+
+private:
+    ei_impulse_result_t *result;
+    ei_profile_stage_t stage;
+    uint8_t depth;
+    EiOpProfiler *previous;
+};
+
+/**
+ * Times the enclosing scope on the active profiler (if any)
+ */
+class EiOpProfilerScope {
+public:
+    EiOpProfilerScope(const char *tag)
+        : profiler(EiOpProfiler::active()), handle(EiOpProfiler::dropped_event)
+    {
+        if (profiler) {
+            handle = profiler->BeginEvent(tag);
+        }
+    }
+
+    ~EiOpProfilerScope()
+    {
+        if (profiler) {
+            profiler->EndEvent(handle);
+        }
+    }
+
+private:
+    EiOpProfiler *profiler;
+    uint32_t handle;
+};
+
+#define EI_OP_PROFILER_CONCAT_INNER(a, b) a##b
+#define EI_OP_PROFILER_CONCAT(a, b) EI_OP_PROFILER_CONCAT_INNER(a, b)
+
+#define EI_PROFILE_OPS_START(result) EiOpProfiler ei_op_profiler_instance(result)
+#define EI_PROFILE_OPS_STAGE(stage) \
+    do { if (EiOpProfiler::active()) { EiOpProfiler::active()->set_stage(stage); } } while (0)
+#define EI_PROFILE_OPS_EVENT(tag) EiOpProfilerScope EI_OP_PROFILER_CONCAT(ei_op_profiler_scope_, __LINE__)(tag)
+
+#else
+
+#define EI_PROFILE_OPS_START(result)
+#define EI_PROFILE_OPS_STAGE(stage)
+#define EI_PROFILE_OPS_EVENT(tag)
+
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
+/**
+ * Times the rest of the enclosing scope as an operator event and as a zone of the same
+ * name (tags must be static strings, and count towards EI_PROFILER_MAX_ZONES)
+ */
+#define EI_PROFILE_OPS_SCOPE(tag) \
+    EI_PROFILE_OPS_EVENT(tag); \
+    EI_PROFILE_ZONE(tag)
+
+/**
+ * Moves the impulse on to a stage (DSP, INFERENCE or POSTPROCESSING): operator events and
+ * allocations are attributed to it from here on, and the rest of the enclosing scope is
+ * timed as `tag`, like EI_PROFILE_OPS_SCOPE (so the operator profile also holds the
+ * total of every stage)
+ */
+#define EI_PROFILE_STAGE(stage, tag) \
+    EI_PROFILE_OPS_STAGE(EI_PROFILE_STAGE_##stage); \
+    EI_ALLOC_PROFILER_PHASE(EI_ALLOC_PHASE_##stage); \
+    EI_PROFILE_OPS_SCOPE(tag)
+
+/**
+ * Entry point of a run: allocations are attributed to DSP until the first stage switch,
+ * and to whatever phase was running before once the scope ends. Timed as zone `name`,
+ * there's no operator profile to record into yet.
+ */
+#define EI_PROFILE_RUN(name) \
+    EI_ALLOC_PROFILER_PHASE_SCOPE(EI_ALLOC_PHASE_DSP); \
+    EI_PROFILE_ZONE(name)
+
+/**
+ * Print the per-operator profile of a result as CSV
+ * (stage,depth,tag,time_us,cycles), one line per event
+ */
+__attribute__((unused)) static void ei_print_op_profile_csv(const ei_impulse_result_t *result)
+{
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    static const char *stage_names[] = { "dsp", "inference", "postprocessing" };
+
+    ei_printf("stage,depth,tag,time_us,cycles\n");
+    for (uint32_t ix = 0; ix < result->op_profile_count; ix++) {
+        const ei_impulse_result_op_profile_t *event = &result->op_profile[ix];
+        ei_printf("%s,%u,%s,%lu,%lu\n",
+            event->stage <= EI_PROFILE_STAGE_POSTPROCESSING ? stage_names[event->stage] : "unknown",
+            (unsigned int)event->depth,
+            event->tag ? event->tag : "",
+            (unsigned long)event->us,
+            (unsigned long)event->cycles);
+    }
+#else
+    (void)result;
+    ei_printf("ERR: per-operator profiling is disabled, build with EI_CLASSIFIER_PROFILE_OPS=1\n");
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+}
+
+#endif // _EI_CLASSIFIER_OP_PROFILER_H_
@@ -0,0 +1,339 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EI_RECURRENT_STATE_H__
+#define __EI_RECURRENT_STATE_H__
+
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include <string.h>
+
+/**
+ * Carry the variable tensors of the learning blocks (the hidden and cell state of
+ * LSTM/GRU layers) over from one inference to the next, instead of starting every
+ * window from a zeroed state. Export the model stateful, with a time dimension that
+ * covers only the new sample(s), so each call costs one step instead of a window.
+ * Only the TFLite interpreter supports this; EON compiled models ignore it.
+ */
+#ifndef EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+#define EI_CLASSIFIER_STREAMING_RECURRENT_STATE 0
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
+#define EI_RECURRENT_STATE_SNAPSHOT_MAGIC    0x53524945 // "EIRS"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t blocks_size;
+} ei_recurrent_state_snapshot_header_t;
+
+typedef struct {
+    uint32_t tensor_count;
+    uint32_t bytes;
+    uint32_t valid;
+} ei_recurrent_state_snapshot_block_t;
+
+static ei_recurrent_state_t *get_recurrent_state(ei_impulse_handle_t *handle)
+{
+    if (handle->recurrent_state != nullptr) {
+        return handle->recurrent_state;
+    }
+
+    ei_recurrent_state_t *state = (ei_recurrent_state_t*)ei_calloc(1, sizeof(ei_recurrent_state_t));
+    if (state == nullptr) {
+        return nullptr;
+    }
+    state->blocks = (ei_recurrent_block_state_t*)ei_calloc(
+        handle->impulse->learning_blocks_size, sizeof(ei_recurrent_block_state_t));
+    if (state->blocks == nullptr) {
+        ei_free(state);
+        return nullptr;
+    }
+    state->blocks_size = handle->impulse->learning_blocks_size;
+
+    handle->recurrent_state = state;
+    return state;
+}
+
+/**
+ * Make the state of a learning block available to its inferencing engine for the
+ * duration of the block (see ei_recurrent_state_current_block()). The state travels
+ * with the result of this run_classifier() call, so handles that run on different
+ * tasks each see their own.
+ */
+class EiRecurrentStateScope {
+public:
+    EiRecurrentStateScope(ei_impulse_handle_t *handle, size_t learn_block_index, ei_impulse_result_t *result)
+        : _result(result)
+    {
+        _result->_recurrent_block = nullptr;
+        ei_recurrent_state_t *state = get_recurrent_state(handle);
+        if (state != nullptr && learn_block_index < state->blocks_size) {
+            _result->_recurrent_block = &state->blocks[learn_block_index];
+        }
+    }
+
+    ~EiRecurrentStateScope()
+    {
+        _result->_recurrent_block = nullptr;
+    }
+
+private:
+    ei_impulse_result_t *_result;
+};
+
+/**
+ * @return  The state of the running learning block, or nullptr if there is none
+ *          (e.g. for a model that runs as a DSP block)
+ */
+__attribute__((unused)) static ei_recurrent_block_state_t *ei_recurrent_state_current_block(ei_impulse_result_t *result)
+{
+    return (ei_recurrent_block_state_t*)result->_recurrent_block;
+}
+
+/**
+ * Size the state of a block for `tensor_count` variable tensors of `bytes` in total.
+ * Keeps the buffer (and the state) if the layout didn't change.
+ *
+ * @return  false if out of memory
+ */
+static bool reserve_recurrent_block_state(ei_recurrent_block_state_t *block, uint32_t tensor_count, size_t bytes)
+{
+    if (block->data != nullptr && block->tensor_count == tensor_count && block->bytes == bytes) {
+        return true;
+    }
+
+    ei_free(block->data);
+    block->data = nullptr;
+    block->tensor_count = 0;
+    block->bytes = 0;
+    block->valid = false;
+
+    if (bytes > 0) {
+        block->data = (uint8_t*)ei_malloc(bytes);
+        if (block->data == nullptr) {
+            return false;
+        }
+    }
+    block->tensor_count = tensor_count;
+    block->bytes = bytes;
+    return true;
+}
+
+/**
+ * Start every block over from its initial state on the next inference (keeps the buffers)
+ */
+static void reset_recurrent_state(ei_impulse_handle_t *handle)
+{
+    ei_recurrent_state_t *state = handle->recurrent_state;
+    if (state == nullptr) {
+        return;
+    }
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        state->blocks[ix].valid = false;
+    }
+}
+
+static void free_recurrent_state(ei_impulse_handle_t *handle)
+{
+    ei_recurrent_state_t *state = handle->recurrent_state;
+    if (state == nullptr) {
+        return;
+    }
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        ei_free(state->blocks[ix].data);
+    }
+    ei_free(state->blocks);
+    ei_free(state);
+    handle->recurrent_state = nullptr;
+}
+
+/**
+ * Serialize the state of all blocks: a header, the layout of every block, then the
+ * tensors of the blocks that have run.
+ *
+ * @param      buffer   Output buffer, or nullptr to only query the size
+ * @param      written  Bytes written (or required, if buffer is nullptr)
+ */
+static EI_IMPULSE_ERROR snapshot_recurrent_state(
+    ei_impulse_handle_t *handle,
+    void *buffer,
+    size_t buffer_size,
+    size_t *written)
+{
+    ei_recurrent_state_t *state = get_recurrent_state(handle);
+    if (state == nullptr) {
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    size_t size = sizeof(ei_recurrent_state_snapshot_header_t) +
+        state->blocks_size * sizeof(ei_recurrent_state_snapshot_block_t);
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        if (state->blocks[ix].valid) {
+            size += state->blocks[ix].bytes;
+        }
+    }
+    if (written != nullptr) {
+        *written = size;
+    }
+    if (buffer == nullptr) {
+        return EI_IMPULSE_OK;
+    }
+    if (buffer_size < size) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    uint8_t *out = (uint8_t*)buffer;
+    ei_recurrent_state_snapshot_header_t header = { EI_RECURRENT_STATE_SNAPSHOT_MAGIC, (uint32_t)state->blocks_size };
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        const ei_recurrent_block_state_t *block = &state->blocks[ix];
+        ei_recurrent_state_snapshot_block_t layout = { block->tensor_count, (uint32_t)block->bytes, block->valid ? 1u : 0u };
+        memcpy(out, &layout, sizeof(layout));
+        out += sizeof(layout);
+    }
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        const ei_recurrent_block_state_t *block = &state->blocks[ix];
+        if (block->valid) {
+            memcpy(out, block->data, block->bytes);
+            out += block->bytes;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Load a snapshot taken by snapshot_recurrent_state(). Blocks whose layout no longer
+ * matches the model are reset by the engine on the next inference. On error the
+ * current state is left untouched.
+ */
+static EI_IMPULSE_ERROR restore_recurrent_state(
+    ei_impulse_handle_t *handle,
+    const void *buffer,
+    size_t buffer_size)
+{
+    ei_recurrent_state_t *state = get_recurrent_state(handle);
+    if (state == nullptr) {
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    const uint8_t *in = (const uint8_t*)buffer;
+    ei_recurrent_state_snapshot_header_t header;
+    if (buffer == nullptr || buffer_size < sizeof(header)) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+    memcpy(&header, in, sizeof(header));
+    if (header.magic != EI_RECURRENT_STATE_SNAPSHOT_MAGIC || header.blocks_size != state->blocks_size) {
+        ei_printf("ERR: recurrent state snapshot doesn't match this impulse\n");
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    // validate the whole snapshot before touching the current state
+    const uint8_t *layouts = in + sizeof(header);
+    size_t size = sizeof(header) + state->blocks_size * sizeof(ei_recurrent_state_snapshot_block_t);
+    if (buffer_size < size) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        ei_recurrent_state_snapshot_block_t layout;
+        memcpy(&layout, layouts + ix * sizeof(layout), sizeof(layout));
+        if (layout.valid) {
+            size += layout.bytes;
+        }
+    }
+    if (buffer_size < size) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    // allocate every buffer whose layout changed up front, so running out of memory
+    // leaves the current state as it was
+    uint8_t **buffers = (uint8_t**)ei_calloc(state->blocks_size, sizeof(uint8_t*));
+    if (buffers == nullptr && state->blocks_size > 0) {
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        const ei_recurrent_block_state_t *block = &state->blocks[ix];
+        ei_recurrent_state_snapshot_block_t layout;
+        memcpy(&layout, layouts + ix * sizeof(layout), sizeof(layout));
+
+        if (!layout.valid || layout.bytes == 0 ||
+                (block->data != nullptr && block->tensor_count == layout.tensor_count && block->bytes == layout.bytes)) {
+            continue;
+        }
+        buffers[ix] = (uint8_t*)ei_malloc(layout.bytes);
+        if (buffers[ix] == nullptr) {
+            for (size_t jx = 0; jx < ix; jx++) {
+                ei_free(buffers[jx]);
+            }
+            ei_free(buffers);
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
+    }
+
+    const uint8_t *data = layouts + state->blocks_size * sizeof(ei_recurrent_state_snapshot_block_t);
+    for (size_t ix = 0; ix < state->blocks_size; ix++) {
+        ei_recurrent_block_state_t *block = &state->blocks[ix];
+        ei_recurrent_state_snapshot_block_t layout;
+        memcpy(&layout, layouts + ix * sizeof(layout), sizeof(layout));
+
+        if (!layout.valid) {
+            block->valid = false;
+            continue;
+        }
+        if (buffers[ix] != nullptr || layout.bytes == 0) {
+            ei_free(block->data);
+            block->data = buffers[ix];
+            block->tensor_count = layout.tensor_count;
+            block->bytes = layout.bytes;
+        }
+        if (layout.bytes > 0) {
+            memcpy(block->data, data, layout.bytes);
+        }
+        block->valid = true;
+        data += layout.bytes;
+    }
+    ei_free(buffers);
+
+    return EI_IMPULSE_OK;
+}
+
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
+#endif // __EI_RECURRENT_STATE_H__
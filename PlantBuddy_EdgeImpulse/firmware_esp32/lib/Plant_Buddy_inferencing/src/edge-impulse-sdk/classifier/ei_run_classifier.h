@@ -44,9 +44,14 @@
 #include "postprocessing/ei_postprocessing.h"
 #include "edge-impulse-sdk/classifier/ei_data_normalization.h"
 #include "edge-impulse-sdk/classifier/ei_print_results.h"
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#include "edge-impulse-sdk/classifier/ei_recurrent_state.h"
+#include "edge-impulse-sdk/dsp/ei_alloc_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
+#include "edge-impulse-sdk/porting/ei_pool_allocator.h"
 #include <memory>
 
 #if EI_CLASSIFIER_LOAD_ANOMALY_H
@@ -102,6 +107,7 @@ namespace {
 extern "C" EI_IMPULSE_ERROR run_inference(ei_impulse_handle_t *handle, ei_feature_t *fmatrix, ei_impulse_result_t *result, bool debug);
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(const ei_impulse_t *impulse, signal_t *signal, ei_impulse_result_t *result, bool debug);
 static EI_IMPULSE_ERROR can_run_classifier_image_quantized(const ei_impulse_t *impulse, ei_learning_block_t block_ptr);
+static EI_IMPULSE_ERROR can_run_classifier_features_quantized(ei_impulse_handle_t *handle);
 
 #if EI_CLASSIFIER_LOAD_IMAGE_SCALING
 EI_IMPULSE_ERROR ei_scale_fmatrix(ei_learning_block_t *block, ei::matrix_t *fmatrix);
@@ -129,21 +135,30 @@ __attribute__((unused)) void display_results(ei_impulse_handle_t *handle, ei_imp
 }
 
 /**
- * @brief      Do inferencing over the processed feature matrix
- *
- * @param      impulse  struct with information about model and DSP
- * @param      fmatrix  Processed matrix
+ * @brief      Run every learning block. Both run_inference() and the quantized features
+ *             shortcut in process_impulse() go through here, so the per-block wrappers
+ *             (profiling zone, allocation phase, recurrent state) apply to both.
+ *
+ * @param      handle   Handle from open_impulse
+ * @param      fmatrix  Processed matrix, nullptr when signal is set
+ * @param      signal   Raw signal for the quantized features path (see
+ *                      can_run_classifier_features_quantized()), where the single DSP block
+ *                      runs inside the learning block and writes straight into its input
+ *                      tensor. nullptr to run on fmatrix.
  * @param      result   Output classifier results
  * @param[in]  debug    Debug output enable
  *
  * @return     The ei impulse error.
  */
-extern "C" EI_IMPULSE_ERROR run_inference(
+static EI_IMPULSE_ERROR run_learning_blocks(
     ei_impulse_handle_t *handle,
     ei_feature_t *fmatrix,
+    signal_t *signal,
     ei_impulse_result_t *result,
-    bool debug = false)
+    bool debug)
 {
+    EI_PROFILE_STAGE(INFERENCE, "inference");
+
     auto& impulse = handle->impulse;
     for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
 
@@ -152,22 +167,37 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 #if EI_CLASSIFIER_LOAD_IMAGE_SCALING
         // we do not plan to have multiple dsp blocks with image
         // so just apply scaling to the first one
-        EI_IMPULSE_ERROR scale_res = ei_scale_fmatrix(&block, fmatrix[0].matrix);
-        if (scale_res != EI_IMPULSE_OK) {
-            return scale_res;
+        if (fmatrix) {
+            EI_IMPULSE_ERROR scale_res = ei_scale_fmatrix(&block, fmatrix[0].matrix);
+            if (scale_res != EI_IMPULSE_OK) {
+                return scale_res;
+            }
         }
 #endif
 
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+        EiRecurrentStateScope recurrent_state_scope(handle, ix, result);
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
+#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE && EI_CLASSIFIER_COMPILED == 1
+        EI_IMPULSE_ERROR res = signal ?
+            run_nn_inference_features_quantized(handle, signal, ix, result, block.config, debug) :
+            block.infer_fn(impulse, fmatrix, ix, (uint32_t*)block.input_block_ids, block.input_block_ids_size, result, block.config, debug);
+#else
+        (void)signal;
         EI_IMPULSE_ERROR res = block.infer_fn(impulse, fmatrix, ix, (uint32_t*)block.input_block_ids, block.input_block_ids_size, result, block.config, debug);
+#endif
         if (res != EI_IMPULSE_OK) {
             return res;
         }
 
 #if EI_CLASSIFIER_LOAD_IMAGE_SCALING
         // undo scaling
-        scale_res = ei_unscale_fmatrix(&block, fmatrix[0].matrix);
-        if (scale_res != EI_IMPULSE_OK) {
-            return scale_res;
+        if (fmatrix) {
+            EI_IMPULSE_ERROR scale_res = ei_unscale_fmatrix(&block, fmatrix[0].matrix);
+            if (scale_res != EI_IMPULSE_OK) {
+                return scale_res;
+            }
         }
 #endif
     }
@@ -180,25 +210,34 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 }
 
 /**
- * @brief      Process a complete impulse
+ * @brief      Do inferencing over the processed feature matrix
  *
  * @param      impulse  struct with information about model and DSP
- * @param      signal   Sample data
+ * @param      fmatrix  Processed matrix
  * @param      result   Output classifier results
- * @param      handle   Handle from open_impulse. nullptr for backward compatibility
  * @param[in]  debug    Debug output enable
  *
  * @return     The ei impulse error.
  */
-extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
-                                            signal_t *signal,
-                                            ei_impulse_result_t *result,
-                                            bool debug = false)
+extern "C" EI_IMPULSE_ERROR run_inference(
+    ei_impulse_handle_t *handle,
+    ei_feature_t *fmatrix,
+    ei_impulse_result_t *result,
+    bool debug = false)
 {
-    if ((handle == nullptr) || (handle->impulse  == nullptr) || (result  == nullptr) || (signal  == nullptr)) {
-        return EI_IMPULSE_INFERENCE_ERROR;
-    }
+    return run_learning_blocks(handle, fmatrix, nullptr, result, debug);
+}
 
+/**
+ * @brief      Clear the result, and point it at the classification and raw output storage
+ *
+ * @param      handle  Handle from open_impulse
+ * @param      result  Output classifier results
+ *
+ * @return     Owner of the raw outputs, keep it alive until the result is post-processed
+ */
+static std::unique_ptr<ei_feature_t[]> init_impulse_result(ei_impulse_handle_t *handle, ei_impulse_result_t *result)
+{
     memset(result, 0, sizeof(ei_impulse_result_t));
 
 #if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
@@ -236,6 +275,37 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     result->_raw_outputs = raw_results_ptr.get();
     memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * num_results);
 
+    return raw_results_ptr;
+}
+
+/**
+ * @brief      Process a complete impulse
+ *
+ * @param      impulse  struct with information about model and DSP
+ * @param      signal   Sample data
+ * @param      result   Output classifier results
+ * @param      handle   Handle from open_impulse. nullptr for backward compatibility
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
+                                            signal_t *signal,
+                                            ei_impulse_result_t *result,
+                                            bool debug = false)
+{
+    // marks the SDK allocator (if enabled) so the statistics describe this inference
+    EI_POOL_ALLOCATOR_SCOPE();
+    // allocations are attributed to DSP until inference starts, back to "other" when we return
+    EI_PROFILE_RUN("process_impulse");
+
+    if ((handle == nullptr) || (handle->impulse  == nullptr) || (result  == nullptr) || (signal  == nullptr)) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    std::unique_ptr<ei_feature_t[]> raw_results_ptr = init_impulse_result(handle, result);
+    EI_PROFILE_OPS_START(result);
+
 #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON)
     // Shortcut for quantized image models
     ei_learning_block_t block = handle->impulse->learning_blocks[0];
@@ -249,6 +319,20 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     }
 #endif
 
+#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE && EI_CLASSIFIER_COMPILED == 1 && !EI_CLASSIFIER_DSP_ONLY
+    // Shortcut for quantized models where the DSP block can write straight into the input tensor.
+    // Not taken with debug on, the features printed there are the DSP block's float output,
+    // which this path never materializes.
+    if (!debug && can_run_classifier_features_quantized(handle) == EI_IMPULSE_OK) {
+        EI_IMPULSE_ERROR res = run_learning_blocks(handle, nullptr, signal, result, debug);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+        res = run_postprocessing(handle, result);
+        return res;
+    }
+#endif
+
     uint32_t block_num = handle->impulse->dsp_blocks_size;
 
     // smart pointer to features array
@@ -310,6 +394,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         auto internal_signal = swa.get_signal();
 #endif
 
+        EI_PROFILE_OPS_SCOPE("dsp_block");
         int ret;
         if (block.factory) { // ie, if we're using state
             // Msg user
@@ -360,21 +445,18 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
-        ei_printf("Features (%d ms.): ", result->timing.dsp);
+        EI_PRINTF_DEFERRED("Features (%d ms.): ", result->timing.dsp);
         for (size_t ix = 0; ix < block_num; ix++) {
             if (features[ix].matrix == nullptr) {
                 continue;
             }
-            for (size_t jx = 0; jx < features[ix].matrix->cols; jx++) {
-                ei_printf_float(features[ix].matrix->buffer[jx]);
-                ei_printf(" ");
-            }
-            ei_printf("\n");
+            EI_PRINTF_FLOATS_DEFERRED(features[ix].matrix->buffer, features[ix].matrix->cols);
+            EI_PRINTF_DEFERRED("\n");
         }
     }
 
     if (debug) {
-        ei_printf("Running impulse...\n");
+        EI_PRINTF_DEFERRED("Running impulse...\n");
     }
 
 #if EI_CLASSIFIER_DSP_ONLY
@@ -420,11 +502,15 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
                                                        ei_impulse_result_t *result,
                                                        bool debug = false)
 {
+    EI_POOL_ALLOCATOR_SCOPE();
+    EI_PROFILE_RUN("process_impulse_continuous");
+
     if ((handle == nullptr) || (handle->impulse  == nullptr) || (result  == nullptr) || (signal  == nullptr)) {
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
     memset(result, 0, sizeof(ei_impulse_result_t));
+    EI_PROFILE_OPS_START(result);
 
 #if EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 0
     static std::vector<ei_impulse_result_classification_t> classification_results;
@@ -490,7 +576,9 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         ei::matrix_t fm(1, block.n_output_features,
                         static_features_matrix.buffer + out_features_index);
 
-        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
+        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size) = nullptr;
+        // blocks whose features are statistics over the whole window, these keep a sliding window of raw_sample_count samples
+        int (*extract_fn_window_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, size_t window_size, matrix_size_t *out_matrix_size) = nullptr;
 
         /* Switch to the slice version of the mfcc feature extract function */
         if (block.extract_fn == extract_mfcc_features) {
@@ -502,23 +590,37 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         else if (block.extract_fn == extract_mfe_features) {
             extract_fn_slice = &extract_mfe_per_slice_features;
         }
+        else if (block.extract_fn == extract_flatten_features) {
+            extract_fn_window_slice = &extract_flatten_per_slice_features;
+        }
+        else if (block.extract_fn == extract_spectral_analysis_features) {
+            extract_fn_window_slice = &extract_spectral_analysis_per_slice_features;
+        }
         else {
-            ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
+            ei_printf("ERR: Unknown extract function, only MFCC, MFE, spectrogram, flatten and spectral analysis supported\n");
             return EI_IMPULSE_DSP_ERROR;
         }
 
         matrix_size_t features_written;
 
+        EI_PROFILE_OPS_SCOPE("dsp_block");
 #if EIDSP_SIGNAL_C_FN_POINTER
         if (block.axes_size != impulse->raw_samples_per_frame) {
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
             return EI_IMPULSE_DSP_ERROR;
         }
-        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = signal;
 #else
         SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
-        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = swa.get_signal();
 #endif
+        int ret;
+        if (extract_fn_slice) {
+            ret = extract_fn_slice(block_signal, &fm, block.config, impulse->frequency, &features_written);
+        }
+        else {
+            ret = extract_fn_window_slice(block_signal, &fm, block.config, impulse->frequency, impulse->raw_sample_count, &features_written);
+        }
 
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -599,13 +701,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
         if (debug) {
-            ei_printf("Feature Matrix: \n");
-            for (size_t ix = 0; ix < features->matrix->cols; ix++) {
-                ei_printf_float(features->matrix->buffer[ix]);
-                ei_printf(" ");
-            }
-            ei_printf("\n");
-            ei_printf("Running impulse...\n");
+            EI_PRINTF_DEFERRED("Feature Matrix: \n");
+            EI_PRINTF_FLOATS_DEFERRED(features->matrix->buffer, features->matrix->cols);
+            EI_PRINTF_DEFERRED("\n");
+            EI_PRINTF_DEFERRED("Running impulse...\n");
         }
 
         ei_impulse_error = run_inference(handle, features, result, debug);
@@ -660,6 +759,61 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Check if the current impulse could be used by 'run_nn_inference_features_quantized', i.e. a single
+ * stateful DSP block that can quantize its own output, feeding a single quantized EON model
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_features_quantized(ei_impulse_handle_t *handle) {
+#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE && EI_CLASSIFIER_COMPILED == 1
+    const ei_impulse_t *impulse = handle->impulse;
+
+    if (impulse->inferencing_engine != EI_CLASSIFIER_TFLITE) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+
+    // anomaly blocks need the float features
+    if (impulse->has_anomaly) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    if (impulse->dsp_blocks_size != 1 || impulse->learning_blocks_size != 1) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    ei_learning_block_t block = impulse->learning_blocks[0];
+    if (block.infer_fn != run_nn_inference) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)block.config;
+    if (block_config->quantized != 1) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    const ei_model_dsp_t &dsp_block = impulse->dsp_blocks[0];
+    if (!dsp_block.factory || dsp_block.data_normalization_config != nullptr
+        || dsp_block.n_output_features != impulse->nn_input_frame_size) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+    if (dsp_block.axes_size != impulse->raw_samples_per_frame) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+#endif
+
+    // getter has a lazy init, so we can just call it
+    DspHandle *dsp_handle = handle->state.get_dsp_handle(0);
+    if (!dsp_handle || !dsp_handle->supports_quantized_output()) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    return EI_IMPULSE_OK;
+#else
+    return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+#endif
+}
+
 #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON)
 
 /**
@@ -839,6 +993,9 @@ extern "C" void run_classifier_init(void)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(&ei_default_impulse);
 #endif
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    reset_recurrent_state(&ei_default_impulse);
+#endif
 }
 
 /**
@@ -864,13 +1021,16 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     init_data_normalization(handle);
 #endif
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    reset_recurrent_state(handle);
+#endif
 }
 
 /**
  * @brief Deletes static variables when running preprocessing and inference continuously.
  *
  * Deletes internal static variables used by `run_classifier_continuous()`, which
- * includes the moving average filter (MAF). This function should be called when you
+ * includes the moving average filter (MAF), cached FFT plans, K-means search indexes and the recurrent state. This function should be called when you
  * are done running continuous classification.
  *
  * **Blocking**: yes
@@ -880,6 +1040,13 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 extern "C" void run_classifier_deinit(void)
 {
     deinit_postprocessing(&ei_default_impulse);
+    ei::fft::clear_fft_plans();
+#if EI_CLASSIFIER_LOAD_ANOMALY_H && EI_CLASSIFIER_HAS_ANOMALY_KMEANS
+    clear_kmeans_indexes();
+#endif
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    free_recurrent_state(&ei_default_impulse);
+#endif
 }
 
 __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
@@ -887,9 +1054,122 @@ __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
     deinit_postprocessing(handle);
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     deinit_data_normalization(handle);
+#endif
+    ei::fft::clear_fft_plans();
+#if EI_CLASSIFIER_LOAD_ANOMALY_H && EI_CLASSIFIER_HAS_ANOMALY_KMEANS
+    clear_kmeans_indexes();
+#endif
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    free_recurrent_state(handle);
 #endif
 }
 
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+/**
+ * @brief Reset the recurrent (LSTM/GRU) state carried between inferences.
+ *
+ * With `EI_CLASSIFIER_STREAMING_RECURRENT_STATE` enabled, the variable tensors of the model
+ * are kept from one `run_classifier()` call to the next, so a model exported with a single
+ * timestep only needs the new sample on every call. Call this when the stream is interrupted,
+ * so the next inference starts from the initial state again. `run_classifier_init()` does
+ * the same.
+ *
+ * **Blocking**: yes
+ */
+extern "C" void run_classifier_reset_state(void)
+{
+    reset_recurrent_state(&ei_default_impulse);
+}
+
+/**
+ * @brief Reset the recurrent (LSTM/GRU) state carried between inferences.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in]   handle struct with information about model and DSP
+ */
+__attribute__((unused)) void run_classifier_reset_state(ei_impulse_handle_t *handle)
+{
+    reset_recurrent_state(handle);
+}
+
+/**
+ * @brief Copy the recurrent (LSTM/GRU) state into a buffer, e.g. to keep it in RTC memory
+ *  or flash over deep sleep. Restore it with `run_classifier_restore_state()`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[out] buffer Output buffer, or nullptr to only query the required size
+ * @param[in] buffer_size Size of the output buffer
+ * @param[out] written Number of bytes written (or required, if `buffer` is nullptr)
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. `EI_IMPULSE_INVALID_SIZE` if the
+ *  buffer is too small.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_snapshot_state(void *buffer, size_t buffer_size, size_t *written)
+{
+    return snapshot_recurrent_state(&ei_default_impulse, buffer, buffer_size, written);
+}
+
+/**
+ * @brief Copy the recurrent (LSTM/GRU) state into a buffer.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] handle struct with information about model and DSP
+ * @param[out] buffer Output buffer, or nullptr to only query the required size
+ * @param[in] buffer_size Size of the output buffer
+ * @param[out] written Number of bytes written (or required, if `buffer` is nullptr)
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_snapshot_state(
+    ei_impulse_handle_t *handle,
+    void *buffer,
+    size_t buffer_size,
+    size_t *written)
+{
+    return snapshot_recurrent_state(handle, buffer, buffer_size, written);
+}
+
+/**
+ * @brief Load the recurrent (LSTM/GRU) state from a buffer filled by
+ *  `run_classifier_snapshot_state()`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] buffer Snapshot
+ * @param[in] buffer_size Size of the snapshot
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. `EI_IMPULSE_INVALID_SIZE` if the
+ *  snapshot doesn't belong to this impulse.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_restore_state(const void *buffer, size_t buffer_size)
+{
+    return restore_recurrent_state(&ei_default_impulse, buffer, buffer_size);
+}
+
+/**
+ * @brief Load the recurrent (LSTM/GRU) state from a buffer filled by
+ *  `run_classifier_snapshot_state()`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] handle struct with information about model and DSP
+ * @param[in] buffer Snapshot
+ * @param[in] buffer_size Size of the snapshot
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_restore_state(
+    ei_impulse_handle_t *handle,
+    const void *buffer,
+    size_t buffer_size)
+{
+    return restore_recurrent_state(handle, buffer, buffer_size);
+}
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
 /**
  * @brief Run preprocessing (DSP) on new slice of raw features. Add output features
  *  to rolling matrix and run inference on full sample.
@@ -914,6 +1194,11 @@ __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
  * inference is performed using the whole matrix, which acts as a sliding window of
  * pre-processed features.
  *
+ * Flatten and spectral analysis blocks compute their features over the whole window, so
+ * they keep the last `raw_sample_count` samples instead: flatten updates running per-axis
+ * statistics with each slice, spectral analysis appends the slice to a ring buffer and
+ * recomputes its features from it. Both produce features once the first full window is in.
+ *
  * Additionally, a moving average filter (MAF) can be enabled for `run_classifier_continuous()`,
  * which averages (arithmetic mean) the last *n* inference results for each class. *n* is
  * `EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW / 2`. In our example above, if we enabled the MAF, the
@@ -973,6 +1258,11 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(
  * inference is performed using the whole matrix, which acts as a sliding window of
  * pre-processed features.
  *
+ * Flatten and spectral analysis blocks compute their features over the whole window, so
+ * they keep the last `raw_sample_count` samples instead: flatten updates running per-axis
+ * statistics with each slice, spectral analysis appends the slice to a ring buffer and
+ * recomputes its features from it. Both produce features once the first full window is in.
+ *
  * Additionally, a moving average filter (MAF) can be enabled for `run_classifier_continuous()`,
  * which averages (arithmetic mean) the last *n* inference results for each class. *n* is
  * `EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW / 2`. In our example above, if we enabled the MAF, the
@@ -1069,6 +1359,111 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier(
     return process_impulse(impulse, signal, result, debug);
 }
 
+#if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
+/**
+ * @brief Run the classifier straight from a raw camera frame.
+ *
+ * For quantized image models (the ones `run_classifier()` sends through
+ * `run_classifier_image_quantized()`). The frame is converted, cropped / resized to the model
+ * input (following EI_CLASSIFIER_RESIZE_MODE) and quantized into the input tensor one row at
+ * a time, so no full-size RGB888 copy of the frame and no `signal_t` callback are needed.
+ * The result matches converting the frame and resizing it with
+ * `ei::image::processing::resize_image_using_mode()` before calling `run_classifier()`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] handle Pointer to an `ei_impulse_handle_t` struct that contains the model and
+ *  preprocessing information.
+ * @param[in] frame Raw frame (YUV422, RGB565 or RGB888) of any size
+ * @param[out] result Pointer to an ei_impulse_result_t struct that will contain the various output
+ *  results from inference.
+ * @param[in] debug Print internal preprocessing and inference debugging information via `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. `EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES`
+ *  if the impulse isn't a quantized image model.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_image_frame(
+    ei_impulse_handle_t *handle,
+    const ei_image_frame_t *frame,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    EI_POOL_ALLOCATOR_SCOPE();
+    EI_PROFILE_RUN("process_impulse_image_frame");
+
+    if ((handle == nullptr) || (handle->impulse == nullptr) || (result == nullptr) || (frame == nullptr)) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    std::unique_ptr<ei_feature_t[]> raw_results_ptr = init_impulse_result(handle, result);
+    EI_PROFILE_OPS_START(result);
+
+    const ei_impulse_t *impulse = handle->impulse;
+    EI_IMPULSE_ERROR res = can_run_classifier_image_quantized(impulse, impulse->learning_blocks[0]);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    res = run_nn_inference_image_quantized(impulse, nullptr, 0, result, impulse->learning_blocks[0].config, debug, frame);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_postprocessing(handle, result);
+}
+
+/**
+ * @brief Run the classifier straight from a raw camera frame.
+ *
+ * See `run_classifier_image_frame(ei_impulse_handle_t*, ...)`.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] frame Raw frame (YUV422, RGB565 or RGB888) of any size
+ * @param[out] result Pointer to an ei_impulse_result_t struct that will contain the various output
+ *  results from inference.
+ * @param[in] debug Print internal preprocessing and inference debugging information via `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum.
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_image_frame(
+    const ei_image_frame_t *frame,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_image_frame(&ei_default_impulse, frame, result, debug);
+}
+#endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
+
+#if EI_CLASSIFIER_HAS_STATIC_IMPULSE
+/**
+ * @brief Run the classifier over a raw features array, using the compile-time specialized impulse.
+ *
+ * Produces the same results as [run_classifier()](#run_classifier) for the default impulse, but
+ * runs `ei_default_static_impulse` (see ei_static_impulse.h) rather than walking the runtime
+ * impulse tables. Does not keep DSP state between calls.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in] signal Pointer to a `signal_t` struct that contains the total length of the raw
+ *  feature array, which must match EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, and a pointer to a callback
+ *  that reads in the raw features.
+ * @param[out] result  Pointer to an ei_impulse_result_t struct that will contain the various output
+ *  results from inference after `run_classifier_static()` returns.
+ * @param[in] debug Print internal preprocessing and inference debugging information via `ei_printf()`.
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum. Will be `EI_IMPULSE_OK` if inference
+ *  completed successfully.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_static(
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return ei_default_static_impulse::run(signal, result, debug);
+}
+#endif // EI_CLASSIFIER_HAS_STATIC_IMPULSE
+
 #if EI_CLASSIFIER_FREEFORM_OUTPUT
 /**
  * Set the location for freeform outputs. For impulses with freeform output the application needs to allocate
@@ -36,10 +36,13 @@
 #define _EDGE_IMPULSE_RUN_DSP_H_
 
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/porting/ei_memory_tiers.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
 #include "edge-impulse-sdk/dsp/ei_flatten.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+#include "edge-impulse-sdk/dsp/image/processing.hpp"
 #include "model-parameters/model_metadata.h"
 
 #if EI_CLASSIFIER_HR_ENABLED
@@ -74,6 +77,16 @@ extern "C" {
 extern void ei_printf(const char *format, ...);
 #endif
 
+/**
+ * A raw camera frame, see run_classifier_image_frame()
+ */
+typedef struct {
+    const uint8_t *buffer;
+    int width;
+    int height;
+    ei::image::processing::PIXEL_FORMAT format;
+} ei_image_frame_t;
+
 #ifdef __cplusplus
 namespace {
 #endif // __cplusplus
@@ -85,16 +98,38 @@ float ei_dsp_image_buffer[EI_DSP_IMAGE_BUFFER_STATIC_SIZE];
 #endif
 
 // this is the frame we work on... allocate it statically so we share between invocations
+// (only for implementation version 1 of MFE and spectrogram, see ei_dsp_cont_run_frames)
 static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+#ifndef EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS
+#define EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS 4
+#endif // EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS
+
+// state for blocks that keep data between slices in continuous classification
+// (flatten, spectral analysis, framed audio), one entry per DSP block config
+typedef struct {
+    void *config;
+    flatten_class *flatten;     // running statistics (flatten)
+    float *window;              // ring buffer of raw interleaved samples (spectral analysis)
+    size_t window_size;
+    size_t window_head;         // oldest sample once the ring is full
+    size_t window_filled;
+    float *frame_carry;         // samples from the start of the next frame on (MFE, MFCC, spectrogram)
+    size_t frame_carry_size;
+    size_t frame_carry_filled;
+} ei_dsp_cont_window_state_t;
+
+static ei_dsp_cont_window_state_t ei_dsp_cont_window_states[EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS];
+
 __attribute__((unused)) int extract_hr_features(
     signal_t *signal,
     matrix_t *output_matrix,
     void *config_ptr,
     const float frequency)
 {
+    EI_PROFILE_FUNCTION();
 #if EI_CLASSIFIER_HR_ENABLED
     auto handle = hr_class::create(config_ptr, frequency);
     auto ret = handle->extract(signal, output_matrix, config_ptr, frequency, nullptr);
@@ -112,6 +147,7 @@ __attribute__((unused)) int extract_eeg_features(
     void *config_ptr,
     const float frequency)
 {
+    EI_PROFILE_FUNCTION();
 #if EI_CLASSIFIER_EEG_ENABLED
     auto handle = eeg_class::create(config_ptr, frequency);
     auto ret = handle->extract(signal, output_matrix, config_ptr, frequency, nullptr);
@@ -129,22 +165,39 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     void *config_ptr,
     const float frequency)
 {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
 
+#if EI_DSP_PARAMS_SPECTRAL_ANALYSIS_ANALYSIS_TYPE_WAVELET || EI_DSP_PARAMS_ALL
+    if (strcmp(config->analysis_type, "Wavelet") == 0) {
+        // raw signal and the DWT work buffer share a single allocation
+        size_t work_size = spectral::wavelet::get_work_size(signal->total_length / config->axes, config->wavelet);
+        matrix_t buffer(1, signal->total_length + work_size, EI_MEMORY_TIER_BULK);
+        if (!buffer.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        matrix_t input_matrix(signal->total_length / config->axes, config->axes, buffer.buffer);
+
+        signal->get_data(0, signal->total_length, input_matrix.buffer);
+
+        return spectral::wavelet::extract_wavelet_features(
+            &input_matrix,
+            output_matrix,
+            config,
+            frequency,
+            buffer.buffer + signal->total_length,
+            work_size);
+    }
+#endif
+
     // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config->axes, config->axes);
+    matrix_t input_matrix(signal->total_length / config->axes, config->axes, EI_MEMORY_TIER_BULK);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
     signal->get_data(0, signal->total_length, input_matrix.buffer);
 
-#if EI_DSP_PARAMS_SPECTRAL_ANALYSIS_ANALYSIS_TYPE_WAVELET || EI_DSP_PARAMS_ALL
-    if (strcmp(config->analysis_type, "Wavelet") == 0) {
-        return spectral::wavelet::extract_wavelet_features(&input_matrix, output_matrix, config, frequency);
-    }
-#endif
-
 #if EI_DSP_PARAMS_SPECTRAL_ANALYSIS_ANALYSIS_TYPE_FFT || EI_DSP_PARAMS_ALL
     if (strcmp(config->analysis_type, "FFT") == 0) {
         if (config->implementation_version == 1) {
@@ -189,6 +242,7 @@ __attribute__((unused)) int extract_spectral_analysis_features(
 }
 
 __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
     // Because of rounding errors during re-sampling the output size of the block might be
@@ -212,18 +266,279 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
 }
 
 __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_FUNCTION();
     auto handle = flatten_class::create(config_ptr, frequency);
     auto ret = handle->extract(signal, output_matrix, config_ptr, frequency, nullptr);
     delete handle;
     return ret;
 }
 
+static ei_dsp_cont_window_state_t *ei_dsp_cont_get_window_state(void *config) {
+    ei_dsp_cont_window_state_t *unused = nullptr;
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS; ix++) {
+        if (ei_dsp_cont_window_states[ix].config == config) {
+            return &ei_dsp_cont_window_states[ix];
+        }
+        if (!unused && ei_dsp_cont_window_states[ix].config == nullptr) {
+            unused = &ei_dsp_cont_window_states[ix];
+        }
+    }
+    if (unused) {
+        unused->config = config;
+    }
+    return unused;
+}
+
+/**
+ * Continuous variant of extract_flatten_features(). Statistics are kept per axis
+ * over the last `window_size` samples and updated with every slice, features are
+ * written once the first full window has been seen.
+ */
+__attribute__((unused)) int extract_flatten_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, size_t window_size, matrix_size_t *matrix_size_out) {
+    EI_PROFILE_FUNCTION();
+    ei_dsp_cont_window_state_t *state = ei_dsp_cont_get_window_state(config_ptr);
+    if (!state) {
+        ei_printf("ERR: More than %d windowed DSP blocks in continuous mode, increase EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS\n",
+            EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS);
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    if (!state->flatten) {
+        state->flatten = static_cast<flatten_class*>(flatten_class::create(config_ptr, frequency));
+        if (!state->flatten) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+    }
+
+    return state->flatten->extract_per_slice(signal, output_matrix, config_ptr, window_size, matrix_size_out);
+}
+
+static ei_dsp_cont_window_state_t *ei_dsp_cont_window_signal_state = nullptr;
+static int ei_dsp_cont_window_signal_get_data(size_t offset, size_t length, float *out_ptr) {
+    ei_dsp_cont_window_state_t *state = ei_dsp_cont_window_signal_state;
+    if (offset + length > state->window_size) {
+        return EIDSP_OUT_OF_BOUNDS;
+    }
+
+    size_t start = state->window_head + offset;
+    if (start >= state->window_size) {
+        start -= state->window_size;
+    }
+    size_t first = std::min(length, state->window_size - start);
+    memcpy(out_ptr, state->window + start, first * sizeof(float));
+    memcpy(out_ptr + first, state->window, (length - first) * sizeof(float));
+    return EIDSP_OK;
+}
+
+/**
+ * Continuous variant of extract_spectral_analysis_features(). Slices are appended
+ * to a ring buffer holding the last `window_size` samples (O(slice) per call); the
+ * FFT / wavelet features are inherently window wide, so they're recomputed from the
+ * ring once it's full, reading it in place rather than from a re-assembled copy.
+ */
+__attribute__((unused)) int extract_spectral_analysis_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, size_t window_size, matrix_size_t *matrix_size_out) {
+    EI_PROFILE_FUNCTION();
+    ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    if (config->axes == 0 || signal->total_length % config->axes != 0) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    ei_dsp_cont_window_state_t *state = ei_dsp_cont_get_window_state(config_ptr);
+    if (!state) {
+        ei_printf("ERR: More than %d windowed DSP blocks in continuous mode, increase EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS\n",
+            EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS);
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    const size_t ring_size = window_size * config->axes;
+    if (state->window && state->window_size != ring_size) {
+        ei_free(state->window);
+        state->window = nullptr;
+    }
+    if (!state->window) {
+        state->window = (float*)ei_calloc_bulk(ring_size, sizeof(float));
+        if (!state->window) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        state->window_size = ring_size;
+        state->window_head = 0;
+        state->window_filled = 0;
+    }
+
+    // only the last window's worth of the slice can end up in the ring
+    size_t offset = 0;
+    if (signal->total_length > ring_size) {
+        offset = signal->total_length - ring_size;
+    }
+
+    while (offset < signal->total_length) {
+        // next write position, as the ring fills up (or wraps) this is always right after the newest sample
+        size_t write_ix = state->window_head + state->window_filled;
+        if (write_ix >= ring_size) {
+            write_ix -= ring_size;
+        }
+        size_t length = std::min(signal->total_length - offset, ring_size - write_ix);
+        int ret = signal->get_data(offset, length, state->window + write_ix);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        offset += length;
+
+        size_t room = ring_size - state->window_filled;
+        if (length <= room) {
+            state->window_filled += length;
+        }
+        else {
+            state->window_filled = ring_size;
+            state->window_head += length - room;
+            if (state->window_head >= ring_size) {
+                state->window_head -= ring_size;
+            }
+        }
+    }
+
+    if (state->window_filled < ring_size) {
+        return EIDSP_OK;
+    }
+
+    signal_t window_signal;
+    window_signal.total_length = ring_size;
+    window_signal.get_data = &ei_dsp_cont_window_signal_get_data;
+    ei_dsp_cont_window_signal_state = state;
+
+    int ret = extract_spectral_analysis_features(&window_signal, output_matrix, config_ptr, frequency);
+    ei_dsp_cont_window_signal_state = nullptr;
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = 1;
+    matrix_size_out->cols = output_matrix->rows * output_matrix->cols;
+
+    return EIDSP_OK;
+}
+
 static class speechpy::processing::preemphasis *preemphasis;
 static int preemphasized_audio_signal_get_data(size_t offset, size_t length, float *out_ptr) {
     return preemphasis->get_data(offset, length, out_ptr);
 }
 
+// the carried over samples followed by the current slice
+static ei_dsp_cont_window_state_t *ei_dsp_cont_frames_state = nullptr;
+static signal_t *ei_dsp_cont_frames_slice = nullptr;
+static int ei_dsp_cont_frames_get_data(size_t offset, size_t length, float *out_ptr) {
+    ei_dsp_cont_window_state_t *state = ei_dsp_cont_frames_state;
+    size_t from_carry = 0;
+    if (offset < state->frame_carry_filled) {
+        from_carry = std::min(length, state->frame_carry_filled - offset);
+        memcpy(out_ptr, state->frame_carry + offset, from_carry * sizeof(float));
+    }
+    if (from_carry == length) {
+        return EIDSP_OK;
+    }
+    return ei_dsp_cont_frames_slice->get_data(offset + from_carry - state->frame_carry_filled,
+        length - from_carry, out_ptr + from_carry);
+}
+
+static int ei_dsp_cont_frames_reserve(ei_dsp_cont_window_state_t *state, size_t size) {
+    if (state->frame_carry && state->frame_carry_size >= size) {
+        return EIDSP_OK;
+    }
+    float *carry = (float*)ei_calloc_bulk(size * sizeof(float), 1);
+    if (!carry) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    if (state->frame_carry) {
+        memcpy(carry, state->frame_carry, state->frame_carry_filled * sizeof(float));
+        ei_free(state->frame_carry);
+    }
+    state->frame_carry = carry;
+    state->frame_carry_size = size;
+    return EIDSP_OK;
+}
+
+/**
+ * Continuous framing for the audio blocks (MFE, MFCC, spectrogram). Every frame that
+ * completes with this slice, including the ones straddling the previous slice, is
+ * computed by a single `run_slice` call over the carried samples followed by the slice,
+ * so the output matrix is rolled and the filterbank set up once per slice rather than
+ * once per straddling frame. Only the samples from the start of the next frame on
+ * (less than a frame_length) are kept, per block, for the next slice.
+ *
+ * @param run_slice int(signal_t *frames, matrix_size_t *matrix_size_out), appends the
+ *  features for all frames in `frames` to the output matrix
+ */
+template<typename RunSlice>
+static int ei_dsp_cont_run_frames(void *config_ptr, signal_t *slice, float sampling_frequency,
+    float frame_length, float frame_stride, size_t frame_length_values, size_t frame_stride_values,
+    int implementation_version, matrix_size_t *matrix_size_out, RunSlice run_slice)
+{
+    ei_dsp_cont_window_state_t *state = ei_dsp_cont_get_window_state(config_ptr);
+    if (!state) {
+        ei_printf("ERR: More than %d windowed DSP blocks in continuous mode, increase EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS\n",
+            EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS);
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    int x = ei_dsp_cont_frames_reserve(state, frame_length_values);
+    if (x != EIDSP_OK) {
+        EIDSP_ERR(x);
+    }
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    const size_t slice_length = slice->total_length;
+    const size_t total_length = state->frame_carry_filled + slice_length;
+    size_t left = total_length;
+
+    if (total_length >= frame_length_values) {
+        signal_t frames_signal;
+        frames_signal.total_length = total_length;
+        frames_signal.get_data = &ei_dsp_cont_frames_get_data;
+        ei_dsp_cont_frames_state = state;
+        ei_dsp_cont_frames_slice = slice;
+
+        x = run_slice(&frames_signal, matrix_size_out);
+
+        ei_dsp_cont_frames_state = nullptr;
+        ei_dsp_cont_frames_slice = nullptr;
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+
+        int length_of_signal_used = speechpy::processing::calculate_signal_used(total_length, sampling_frequency,
+            frame_length, frame_stride, false, implementation_version);
+        left = total_length - length_of_signal_used + (frame_length_values - frame_stride_values);
+    }
+
+    x = ei_dsp_cont_frames_reserve(state, left);
+    if (x != EIDSP_OK) {
+        EIDSP_ERR(x);
+    }
+
+    // keep the last `left` samples: the tail of the current carry (if the slice is
+    // shorter than that), then the slice
+    size_t from_slice = std::min(left, slice_length);
+    size_t from_carry = left - from_slice;
+    memmove(state->frame_carry, state->frame_carry + state->frame_carry_filled - from_carry,
+        from_carry * sizeof(float));
+    if (from_slice > 0) {
+        x = slice->get_data(slice_length - from_slice, from_slice, state->frame_carry + from_carry);
+        if (x != EIDSP_OK) {
+            EIDSP_ERR(x);
+        }
+    }
+    state->frame_carry_filled = left;
+
+    return EIDSP_OK;
+}
+
 __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_mfcc_t config = *((ei_dsp_config_mfcc_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -328,6 +643,7 @@ __attribute__((unused)) static int extract_mfcc_run_slice(signal_t *signal, matr
 }
 
 __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+    EI_PROFILE_FUNCTION();
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -371,132 +687,28 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
-    int x;
-
-    // have current frame, but wrong size? then free
-    if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
-        ei_free(ei_dsp_cont_current_frame);
-        ei_dsp_cont_current_frame = nullptr;
-    }
-
-    int implementation_version = config.implementation_version;
-
-    // this is the offset in the signal from which we'll work
-    size_t offset_in_signal = 0;
-
-    if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
-        if (!ei_dsp_cont_current_frame) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-        ei_dsp_cont_current_frame_size = frame_length_values;
-        ei_dsp_cont_current_frame_ix = 0;
-    }
-
-
-    if ((frame_length_values) > preemphasized_audio_signal.total_length  + ei_dsp_cont_current_frame_ix) {
-        ei_printf("ERR: frame_length (%d) cannot be larger than signal's total length (%d) for continuous classification\n",
-            (int)frame_length_values, (int)preemphasized_audio_signal.total_length  + ei_dsp_cont_current_frame_ix);
-        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
-    }
-
-    matrix_size_out->rows = 0;
-    matrix_size_out->cols = 0;
-
     // for continuous use v2 stack frame calculations
+    int implementation_version = config.implementation_version;
     if (implementation_version == 1) {
         implementation_version = 2;
     }
 
-    if (ei_dsp_cont_current_frame_ix > (int)ei_dsp_cont_current_frame_size) {
-        ei_printf("ERR: ei_dsp_cont_current_frame_ix is larger than frame size (ix=%d size=%d)\n",
-            ei_dsp_cont_current_frame_ix, (int)ei_dsp_cont_current_frame_size);
-        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
-    }
-
-    // if we still have some code from previous run
-    while (ei_dsp_cont_current_frame_ix > 0) {
-        // then from the current frame we need to read `frame_length_values - ei_dsp_cont_current_frame_ix`
-        // starting at offset 0
-        x = preemphasized_audio_signal.get_data(0, frame_length_values - ei_dsp_cont_current_frame_ix, ei_dsp_cont_current_frame + ei_dsp_cont_current_frame_ix);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
-
-        // now ei_dsp_cont_current_frame is complete
-        signal_t frame_signal;
-        x = numpy::signal_from_buffer(ei_dsp_cont_current_frame, frame_length_values, &frame_signal);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
-
-        x = extract_mfcc_run_slice(&frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
-
-        // if there's overlap between frames we roll through
-        if (frame_stride_values > 0) {
-            numpy::roll(ei_dsp_cont_current_frame, frame_length_values, -frame_stride_values);
-        }
-
-        ei_dsp_cont_current_frame_ix -= frame_stride_values;
-    }
-
-    if (ei_dsp_cont_current_frame_ix < 0) {
-        offset_in_signal = -ei_dsp_cont_current_frame_ix;
-        ei_dsp_cont_current_frame_ix = 0;
-    }
-
-    if (offset_in_signal >= signal->total_length) {
-        offset_in_signal -= signal->total_length;
-        return EIDSP_OK;
-    }
-
-    // now... we need to discard part of the signal...
-    SignalWithRange signal_with_range(&preemphasized_audio_signal, offset_in_signal, signal->total_length);
-
-    signal_t *range_signal = signal_with_range.get_signal();
-    size_t range_signal_orig_length = range_signal->total_length;
-
-    // then we'll just go through normal processing of the signal:
-    x = extract_mfcc_run_slice(range_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
-    if (x != EIDSP_OK) {
-        EIDSP_ERR(x);
-    }
-
-    // Make sure v1 model are reset to the original length;
-    range_signal->total_length = range_signal_orig_length;
-
-    // update offset
-    int length_of_signal_used = speechpy::processing::calculate_signal_used(range_signal->total_length, sampling_frequency,
-        config.frame_length, config.frame_stride, false, implementation_version);
-    offset_in_signal += length_of_signal_used;
-
-    // see what's left?
-    int bytes_left_end_of_frame = signal->total_length - offset_in_signal;
-    bytes_left_end_of_frame += frame_overlap_values;
-
-    if (bytes_left_end_of_frame > 0) {
-        // then read that into the ei_dsp_cont_current_frame buffer
-        x = preemphasized_audio_signal.get_data(
-            (preemphasized_audio_signal.total_length - bytes_left_end_of_frame),
-            bytes_left_end_of_frame,
-            ei_dsp_cont_current_frame);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
-    }
-
-    ei_dsp_cont_current_frame_ix = bytes_left_end_of_frame;
+    int x = ei_dsp_cont_run_frames(config_ptr, &preemphasized_audio_signal, sampling_frequency,
+        config.frame_length, config.frame_stride, frame_length_values, frame_stride_values,
+        implementation_version, matrix_size_out,
+        [&](signal_t *frames_signal, matrix_size_t *frames_size_out) {
+            return extract_mfcc_run_slice(frames_signal, output_matrix, &config, sampling_frequency, frames_size_out,
+                implementation_version);
+        });
 
     preemphasis = nullptr;
 
-    return EIDSP_OK;
+    return x;
 #endif
 }
 
 __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_spectrogram_t config = *((ei_dsp_config_spectrogram_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -599,6 +811,7 @@ __attribute__((unused)) static int extract_spectrogram_run_slice(signal_t *signa
 }
 
 __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+    EI_PROFILE_FUNCTION();
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -652,6 +865,15 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
 
     int x;
 
+    if (config.implementation_version >= 2) {
+        return ei_dsp_cont_run_frames(config_ptr, signal, sampling_frequency,
+            config.frame_length, config.frame_stride, frame_length_values, frame_stride_values,
+            config.implementation_version, matrix_size_out,
+            [&](signal_t *frames_signal, matrix_size_t *frames_size_out) {
+                return extract_spectrogram_run_slice(frames_signal, output_matrix, &config, sampling_frequency, frames_size_out);
+            });
+    }
+
     // have current frame, but wrong size? then free
     if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
         ei_free(ei_dsp_cont_current_frame);
@@ -659,7 +881,7 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     }
 
     if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        ei_dsp_cont_current_frame = (float*)ei_calloc_bulk(frame_length_values * sizeof(float), 1);
         if (!ei_dsp_cont_current_frame) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
@@ -766,6 +988,7 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
 
 
 __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_mfe_t config = *((ei_dsp_config_mfe_t*)config_ptr);
 
     if (config.axes != 1) {
@@ -917,6 +1140,7 @@ __attribute__((unused)) static int extract_mfe_run_slice(signal_t *signal, matri
 }
 
 __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+    EI_PROFILE_FUNCTION();
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -1000,6 +1224,19 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
 
     int x;
 
+    if (config.implementation_version > 1) {
+        x = ei_dsp_cont_run_frames(config_ptr, &preemphasized_audio_signal, sampling_frequency,
+            config.frame_length, config.frame_stride, frame_length_values, frame_stride_values,
+            config.implementation_version, matrix_size_out,
+            [&](signal_t *frames_signal, matrix_size_t *frames_size_out) {
+                return extract_mfe_run_slice(frames_signal, output_matrix, &config, sampling_frequency, frames_size_out);
+            });
+        if (preemphasis) {
+            delete preemphasis;
+        }
+        return x;
+    }
+
     // have current frame, but wrong size? then free
     if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
         ei_free(ei_dsp_cont_current_frame);
@@ -1007,7 +1244,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     }
 
     if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        ei_dsp_cont_current_frame = (float*)ei_calloc_bulk(frame_length_values * sizeof(float), 1);
         if (!ei_dsp_cont_current_frame) {
             if (preemphasis) {
                 delete preemphasis;
@@ -1142,6 +1379,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
 }
 
 __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
@@ -1162,7 +1400,7 @@ __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *o
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
         matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
 #else
-        matrix_t input_matrix(elements_to_read, config.axes);
+        matrix_t input_matrix(elements_to_read, config.axes, EI_MEMORY_TIER_BULK);
 #endif
         if (!input_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -1202,6 +1440,7 @@ __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *o
  * Since we run the preprocessing on the DRP we pass the input buffer (mostly) as-is.
 */
 __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, matrix_u8_t *output_matrix, void *config_ptr, const float frequency) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
@@ -1222,7 +1461,7 @@ __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, m
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
         matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
 #else
-        matrix_t input_matrix(elements_to_read, config.axes);
+        matrix_t input_matrix(elements_to_read, config.axes, EI_MEMORY_TIER_BULK);
 #endif
         if (!input_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -1262,20 +1501,113 @@ __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, m
 
 #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
+/**
+ * Maps 8-bit RGB pixels to the quantized input of an image model. RGB models go through
+ * a table per channel (built with the float math of the slow path), grayscale models are
+ * converted per pixel.
+ */
+typedef struct {
+    int8_t rgb[3][256];
+    int16_t channel_count;
+    bool fast; // default 1/255, -128 quantization without image scaling
+    float scale;
+    float zero_point;
+    int image_scaling;
+} ei_image_quantizer_t;
+
+static void image_scale_pixel(float *r, float *g, float *b, int image_scaling) {
+    static const float torch_mean[] = { 0.485, 0.456, 0.406 };
+    static const float torch_std[] = { 0.229, 0.224, 0.225 };
+
+    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
+        *r /= 255.0f;
+        *g /= 255.0f;
+        *b /= 255.0f;
+    }
+    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
+        *r /= 255.0f;
+        *g /= 255.0f;
+        *b /= 255.0f;
+
+        *r = (*r - torch_mean[0]) / torch_std[0];
+        *g = (*g - torch_mean[1]) / torch_std[1];
+        *b = (*b - torch_mean[2]) / torch_std[2];
+    }
+    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
+        *r -= 128.0f;
+        *g -= 128.0f;
+        *b -= 128.0f;
+    }
+}
+
+static void init_image_quantizer(ei_image_quantizer_t *q, int16_t channel_count, float scale, float zero_point, int image_scaling) {
+    q->channel_count = channel_count;
+    q->fast = scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE;
+    q->scale = scale;
+    q->zero_point = zero_point;
+    q->image_scaling = image_scaling;
+
+    if (channel_count != 3) {
+        return;
+    }
+    for (int32_t v = 0; v < 256; v++) {
+        if (q->fast) {
+            q->rgb[0][v] = q->rgb[1][v] = q->rgb[2][v] = static_cast<int8_t>(v + zero_point);
+            continue;
+        }
+        float r = static_cast<float>(v);
+        float g = static_cast<float>(v);
+        float b = static_cast<float>(v);
+        image_scale_pixel(&r, &g, &b, image_scaling);
+        q->rgb[0][v] = static_cast<int8_t>(round(r / scale) + zero_point);
+        q->rgb[1][v] = static_cast<int8_t>(round(g / scale) + zero_point);
+        q->rgb[2][v] = static_cast<int8_t>(round(b / scale) + zero_point);
+    }
+}
+
+static inline void quantize_image_pixel(const ei_image_quantizer_t *q, int32_t r, int32_t g, int32_t b, int8_t *output, size_t *output_ix) {
+    if (q->channel_count == 3) {
+        output[(*output_ix)++] = q->rgb[0][r];
+        output[(*output_ix)++] = q->rgb[1][g];
+        output[(*output_ix)++] = q->rgb[2][b];
+    }
+    else if (q->fast) {
+        const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
+        const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
+        const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+
+        // ITU-R 601-2 luma transform
+        // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
+        int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
+        gray >>= 16; // scale down to int8_t
+        gray += q->zero_point;
+        if (gray < - 128) gray = -128;
+        else if (gray > 127) gray = 127;
+        output[(*output_ix)++] = static_cast<int8_t>(gray);
+    }
+    else {
+        float fr = static_cast<float>(r);
+        float fg = static_cast<float>(g);
+        float fb = static_cast<float>(b);
+        image_scale_pixel(&fr, &fg, &fb, q->image_scaling);
+
+        // ITU-R 601-2 luma transform
+        float v = (0.299f * fr) + (0.587f * fg) + (0.114f * fb);
+        output[(*output_ix)++] = static_cast<int8_t>(round(v / q->scale) + q->zero_point);
+    }
+}
+
 __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency,
                                                              int image_scaling) {
+    EI_PROFILE_FUNCTION();
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
     int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
 
-    size_t output_ix = 0;
-
-    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
-    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
-    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+    ei_image_quantizer_t quantizer;
+    init_image_quantizer(&quantizer, channel_count, scale, zero_point, image_scaling);
 
-    static const float torch_mean[] = { 0.485, 0.456, 0.406 };
-    static const float torch_std[] = { 0.229, 0.224, 0.225 };
+    size_t output_ix = 0;
 
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
     const size_t page_size = EI_DSP_IMAGE_BUFFER_STATIC_SIZE;
@@ -1291,7 +1623,7 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
         matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
 #else
-        matrix_t input_matrix(elements_to_read, config.axes);
+        matrix_t input_matrix(elements_to_read, config.axes, EI_MEMORY_TIER_BULK);
 #endif
         if (!input_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -1301,96 +1633,11 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
         for (size_t jx = 0; jx < elements_to_read; jx++) {
             uint32_t pixel = static_cast<uint32_t>(input_matrix.buffer[jx]);
 
-            if (channel_count == 3) {
-                // fast code path
-                if (scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(r + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(g + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(b + zero_point);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff);
-                    float g = static_cast<float>(pixel >> 8 & 0xff);
-                    float b = static_cast<float>(pixel & 0xff);
-
-                    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-
-                        r = (r - torch_mean[0]) / torch_std[0];
-                        g = (g - torch_mean[1]) / torch_std[1];
-                        b = (b - torch_mean[2]) / torch_std[2];
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
-                        r -= 128.0f;
-                        g -= 128.0f;
-                        b -= 128.0f;
-                    }
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(r / scale) + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(g / scale) + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(b / scale) + zero_point);
-                }
-            }
-            else {
-                // fast code path
-                if (scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
-                    gray >>= 16; // scale down to int8_t
-                    gray += zero_point;
-                    if (gray < - 128) gray = -128;
-                    else if (gray > 127) gray = 127;
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(gray);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff);
-                    float g = static_cast<float>(pixel >> 8 & 0xff);
-                    float b = static_cast<float>(pixel & 0xff);
-
-                    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-
-                        r = (r - torch_mean[0]) / torch_std[0];
-                        g = (g - torch_mean[1]) / torch_std[1];
-                        b = (b - torch_mean[2]) / torch_std[2];
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
-                        r -= 128.0f;
-                        g -= 128.0f;
-                        b -= 128.0f;
-                    }
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(v / scale) + zero_point);
-                }
-            }
+            quantize_image_pixel(&quantizer,
+                static_cast<int32_t>(pixel >> 16 & 0xff),
+                static_cast<int32_t>(pixel >> 8 & 0xff),
+                static_cast<int32_t>(pixel & 0xff),
+                output_matrix->buffer, &output_ix);
         }
 
         bytes_left -= elements_to_read;
@@ -1398,10 +1645,60 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
     }
     return EIDSP_OK;
 }
+
+typedef struct {
+    const ei_image_quantizer_t *quantizer;
+    int8_t *output;
+    size_t output_ix;
+} ei_image_frame_quantize_ctx_t;
+
+static int quantize_image_frame_row(const uint8_t *rgb_row, int width, int y, void *ctx_ptr) {
+    (void)y;
+    ei_image_frame_quantize_ctx_t *ctx = (ei_image_frame_quantize_ctx_t*)ctx_ptr;
+    for (int x = 0; x < width; x++) {
+        quantize_image_pixel(ctx->quantizer, rgb_row[0], rgb_row[1], rgb_row[2], ctx->output, &ctx->output_ix);
+        rgb_row += 3;
+    }
+    return EIDSP_OK;
+}
+
+/**
+ * Same output as extract_image_features_quantized(), but straight from a raw camera frame:
+ * conversion, crop / resize and quantization run one output row at a time, without a
+ * full-size RGB888 copy of the frame or a float page of pixels.
+ *
+ * @param frame         Raw camera frame
+ * @param output_matrix Input tensor of the model (width * height * channels)
+ * @param width         Model input width
+ * @param height        Model input height
+ * @param resize_mode   EI_CLASSIFIER_RESIZE_* (NONE stretches, like SQUASH)
+ */
+__attribute__((unused)) int extract_image_frame_features_quantized(const ei_image_frame_t *frame, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point,
+                                                                   int width, int height, int resize_mode, int image_scaling) {
+    EI_PROFILE_FUNCTION();
+    ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
+
+    int16_t channel_count = strcmp(config.channels, "Grayscale") == 0 ? 1 : 3;
+
+    if (!frame || !frame->buffer) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+    if (output_matrix->rows * output_matrix->cols != (size_t)width * height * channel_count) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    ei_image_quantizer_t quantizer;
+    init_image_quantizer(&quantizer, channel_count, scale, zero_point, image_scaling);
+
+    ei_image_frame_quantize_ctx_t ctx = { &quantizer, output_matrix->buffer, 0 };
+    return ei::image::processing::resize_frame_to_rgb888_rows(frame->buffer, frame->width, frame->height, frame->format,
+        width, height, resize_mode, quantize_image_frame_row, &ctx);
+}
 #endif // (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
 /**
- * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
+ * Clear all state regarding continuous audio (and the sliding windows of flatten and
+ * spectral analysis blocks). Invoke this function after continuous audio loop ends.
  */
 __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     if (ei_dsp_cont_current_frame) {
@@ -1412,6 +1709,18 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS; ix++) {
+        ei_dsp_cont_window_state_t *state = &ei_dsp_cont_window_states[ix];
+        delete state->flatten;
+        if (state->window) {
+            ei_free(state->window);
+        }
+        if (state->frame_carry) {
+            ei_free(state->frame_carry);
+        }
+        memset(state, 0, sizeof(ei_dsp_cont_window_state_t));
+    }
+
     return EIDSP_OK;
 }
 
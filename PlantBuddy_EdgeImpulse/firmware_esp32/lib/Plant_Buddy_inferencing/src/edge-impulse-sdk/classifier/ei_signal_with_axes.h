@@ -41,6 +41,15 @@
 
 #if !EIDSP_SIGNAL_C_FN_POINTER
 
+/**
+ * Number of floats that SignalWithAxes stages on the stack when it fetches whole
+ * frames from a callback-backed signal. Frames wider than this fall back to
+ * fetching one value at a time.
+ */
+#ifndef EI_SIGNAL_WITH_AXES_STAGING_SIZE
+#define EI_SIGNAL_WITH_AXES_STAGING_SIZE    64
+#endif
+
 using namespace ei;
 
 class SignalWithAxes {
@@ -68,24 +77,83 @@ public:
     }
 
     int get_data(size_t offset, size_t length, float *out_ptr) {
-        size_t offset_on_original_signal = offset / _axes_count * _impulse->raw_samples_per_frame;
-        size_t length_on_original_signal = length / _axes_count * _impulse->raw_samples_per_frame;
+        const size_t frame_size = _impulse->raw_samples_per_frame;
+        size_t offset_on_original_signal = offset / _axes_count * frame_size;
+        size_t frame_count = length / _axes_count;
+
+        // signal is backed by memory (e.g. numpy::signal_from_buffer), gather straight from it
+        if (_original_signal->raw_buffer) {
+            gather_axes(_original_signal->raw_buffer + offset_on_original_signal, frame_count, out_ptr);
+            return 0;
+        }
+
+        // otherwise fetch as many whole frames per get_data call as fit in the staging buffer
+        const size_t frames_per_chunk = EI_SIGNAL_WITH_AXES_STAGING_SIZE / frame_size;
+        if (frames_per_chunk == 0) {
+            return get_data_per_value(offset_on_original_signal, frame_count, out_ptr);
+        }
+
+        float staging[EI_SIGNAL_WITH_AXES_STAGING_SIZE];
+
+        while (frame_count > 0) {
+            size_t chunk_frames = frame_count < frames_per_chunk ? frame_count : frames_per_chunk;
+
+            int r = _original_signal->get_data(offset_on_original_signal, chunk_frames * frame_size, staging);
+            if (r != 0) {
+                return r;
+            }
+
+            gather_axes(staging, chunk_frames, out_ptr);
+
+            out_ptr += chunk_frames * _axes_count;
+            offset_on_original_signal += chunk_frames * frame_size;
+            frame_count -= chunk_frames;
+        }
 
+        return 0;
+    }
+
+private:
+    /**
+     * De-interleave the selected axes out of `frame_count` consecutive frames
+     */
+    void gather_axes(const float *frames, size_t frame_count, float *out_ptr) {
+        const size_t frame_size = _impulse->raw_samples_per_frame;
+
+        if (_axes_count == 1) {
+            const float *in_ptr = frames + _axes[0];
+            for (size_t fx = 0; fx < frame_count; fx++) {
+                out_ptr[fx] = in_ptr[fx * frame_size];
+            }
+            return;
+        }
+
+        for (size_t fx = 0; fx < frame_count; fx++) {
+            for (size_t axis_ix = 0; axis_ix < _axes_count; axis_ix++) {
+                out_ptr[axis_ix] = frames[_axes[axis_ix]];
+            }
+            frames += frame_size;
+            out_ptr += _axes_count;
+        }
+    }
+
+    int get_data_per_value(size_t offset_on_original_signal, size_t frame_count, float *out_ptr) {
+        const size_t frame_size = _impulse->raw_samples_per_frame;
         size_t out_ptr_ix = 0;
 
-        for (size_t ix = offset_on_original_signal; ix < offset_on_original_signal + length_on_original_signal; ix += _impulse->raw_samples_per_frame) {
-            for (size_t axis_ix = 0; axis_ix < this->_axes_count; axis_ix++) {
-                int r = _original_signal->get_data(ix + _axes[axis_ix], 1, &out_ptr[out_ptr_ix++]);
+        for (size_t fx = 0; fx < frame_count; fx++) {
+            for (size_t axis_ix = 0; axis_ix < _axes_count; axis_ix++) {
+                int r = _original_signal->get_data(offset_on_original_signal + _axes[axis_ix], 1, &out_ptr[out_ptr_ix++]);
                 if (r != 0) {
                     return r;
                 }
             }
+            offset_on_original_signal += frame_size;
         }
 
         return 0;
     }
 
-private:
     signal_t *_original_signal;
     EI_CLASSIFIER_DSP_AXES_INDEX_TYPE *_axes;
     size_t _axes_count;
@@ -63,6 +63,8 @@ public:
             return this->get_data(offset, length, out_ptr);
         };
 #endif
+        wrapped_signal.raw_buffer = _original_signal->raw_buffer ?
+            _original_signal->raw_buffer + _range_start : nullptr;
         return &wrapped_signal;
     }
 
@@ -0,0 +1,402 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_CLASSIFIER_STATIC_IMPULSE_H_
+#define _EI_CLASSIFIER_STATIC_IMPULSE_H_
+
+/**
+ * @file
+ *  Compile-time specialized impulse pipeline. Where the runtime impulse walks the
+ *  ei_impulse_t tables (function pointers and void* configs) on every call, an
+ *  ei_static_impulse is a type assembled from the same configuration at build time,
+ *  so the DSP -> quantize -> invoke -> dequantize chain can be inlined and the
+ *  constant block parameters folded by the compiler.
+ *
+ *  Only the block types that have a static variant below can be used, see
+ *  `ei_default_static_impulse` in model_variables.h (present when
+ *  EI_CLASSIFIER_HAS_STATIC_IMPULSE is set) and run_classifier_static().
+ *  EI_CLASSIFIER_HAS_STATIC_IMPULSE is derived here: set for EON with a statically
+ *  allocated classification result, cleared otherwise. Define it to 0 to leave the
+ *  static pipeline out.
+ */
+
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_types.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/classifier/ei_quantize.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && (EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED == 1)
+#ifndef EI_CLASSIFIER_HAS_STATIC_IMPULSE
+#define EI_CLASSIFIER_HAS_STATIC_IMPULSE            1
+#endif
+#else
+// The static pipeline can't be built in this configuration (e.g. full TFLite, or a
+// result struct without a static classification array)
+#if defined(EI_CLASSIFIER_HAS_STATIC_IMPULSE) && (EI_CLASSIFIER_HAS_STATIC_IMPULSE == 1)
+#error "EI_CLASSIFIER_HAS_STATIC_IMPULSE requires EON with EI_IMPULSE_RESULT_CLASSIFICATION_IS_STATICALLY_ALLOCATED"
+#endif
+#undef EI_CLASSIFIER_HAS_STATIC_IMPULSE
+#define EI_CLASSIFIER_HAS_STATIC_IMPULSE            0
+#endif
+
+#if EI_CLASSIFIER_HAS_STATIC_IMPULSE
+
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+
+/**
+ * Windows up to this many floats are staged on the stack, larger ones on the heap
+ */
+#ifndef EI_STATIC_IMPULSE_STACK_FLOATS
+#define EI_STATIC_IMPULSE_STACK_FLOATS      256
+#endif
+
+/**
+ * Scratch buffer of N floats, on the stack if small enough, otherwise on the heap
+ */
+template<size_t N, bool OnStack = (N <= EI_STATIC_IMPULSE_STACK_FLOATS)>
+class ei_static_scratch {
+public:
+    float *get() { return _buffer; }
+private:
+    float _buffer[N];
+};
+
+template<size_t N>
+class ei_static_scratch<N, false> {
+public:
+    ei_static_scratch() : _matrix(1, N) { }
+    float *get() { return _matrix.buffer; }
+private:
+    ei::matrix_t _matrix;
+};
+
+/**
+ * Static variant of the flatten DSP block (extract_flatten_features).
+ * Config is a struct with the same fields as ei_dsp_config_flatten_t, as static constexpr members,
+ * RuntimeConfig the ei_dsp_config_flatten_t the runtime impulse uses for the same block.
+ * Axes are the offsets of the selected axes into a raw frame.
+ */
+template<typename Config, const ei_dsp_config_flatten_t *RuntimeConfig, size_t SampleCount, size_t FrameSize, size_t... Axes>
+struct ei_static_flatten_block {
+    static_assert(sizeof...(Axes) == Config::axes, "Axes list does not match config");
+    static_assert(Config::moving_avg_num_windows == 0, "Moving average keeps state, use run_classifier() instead");
+
+    static constexpr size_t features_per_axis =
+        Config::average + Config::minimum + Config::maximum + Config::rms +
+        Config::stdev + Config::skewness + Config::kurtosis;
+    static constexpr size_t n_output_features = features_per_axis * Config::axes;
+    static constexpr size_t raw_window_size = SampleCount * FrameSize;
+
+    /**
+     * Whether Config still describes RuntimeConfig, so both pipelines extract the same features
+     */
+    static bool matches_runtime_config() {
+        return RuntimeConfig->axes == (int)Config::axes &&
+            RuntimeConfig->scale_axes == Config::scale_axes &&
+            RuntimeConfig->average == Config::average &&
+            RuntimeConfig->minimum == Config::minimum &&
+            RuntimeConfig->maximum == Config::maximum &&
+            RuntimeConfig->rms == Config::rms &&
+            RuntimeConfig->stdev == Config::stdev &&
+            RuntimeConfig->skewness == Config::skewness &&
+            RuntimeConfig->kurtosis == Config::kurtosis &&
+            RuntimeConfig->moving_avg_num_windows == Config::moving_avg_num_windows;
+    }
+
+    /**
+     * Extract features from a raw window
+     * @param raw Window of SampleCount frames of FrameSize floats each
+     * @param features Output buffer of n_output_features floats
+     */
+    static int extract(const float *raw, float *features) {
+        using namespace ei;
+
+        const size_t axes[] = { Axes... };
+        ei_static_scratch<SampleCount> row_scratch;
+        float *row = row_scratch.get();
+        if (!row) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        matrix_t row_matrix(1, SampleCount, row);
+        float value;
+        matrix_t out_matrix(1, 1, &value);
+        size_t out_ix = 0;
+
+        for (size_t axis_ix = 0; axis_ix < Config::axes; axis_ix++) {
+            const float *in_ptr = raw + axes[axis_ix];
+            for (size_t ix = 0; ix < SampleCount; ix++) {
+                row[ix] = in_ptr[ix * FrameSize];
+            }
+            if (Config::scale_axes != 1.0f) {
+                numpy::scale(&row_matrix, Config::scale_axes);
+            }
+
+            // same order as flatten_class so features match run_classifier() bit for bit
+            if (Config::average) {
+                numpy::mean(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::minimum) {
+                numpy::min(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::maximum) {
+                numpy::max(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::rms) {
+                numpy::rms(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::stdev) {
+                numpy::stdev(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::skewness) {
+                numpy::skew(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+            if (Config::kurtosis) {
+                numpy::kurtosis(&row_matrix, &out_matrix);
+                features[out_ix++] = value;
+            }
+        }
+
+        return EIDSP_OK;
+    }
+};
+
+/**
+ * Static variant of an EON compiled learning block (run_nn_inference), calls the
+ * generated graph functions directly instead of through ei_config_tflite_eon_graph_t.
+ */
+template<
+    TfLiteStatus (*Init)(void*(*)(size_t, size_t)),
+    TfLiteStatus (*Invoke)(),
+    TfLiteStatus (*Reset)(void (*)(void*)),
+    TfLiteStatus (*Input)(int, TfLiteTensor*),
+    TfLiteStatus (*Output)(int, TfLiteTensor*)>
+struct ei_static_eon_block {
+    static EI_IMPULSE_ERROR init(TfLiteTensor *input, TfLiteTensor *output) {
+        if (Init(ei_aligned_calloc) != kTfLiteOk) {
+            return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+        if (Input(0, input) != kTfLiteOk || Output(0, output) != kTfLiteOk) {
+            Reset(ei_aligned_free);
+            return EI_IMPULSE_TFLITE_ERROR;
+        }
+        return EI_IMPULSE_OK;
+    }
+
+    static EI_IMPULSE_ERROR invoke() {
+        return Invoke() == kTfLiteOk ? EI_IMPULSE_OK : EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    static void reset() {
+        Reset(ei_aligned_free);
+    }
+
+    /**
+     * Quantize features into the input tensor, same rounding as fill_input_tensor_from_matrix()
+     */
+    template<size_t N>
+    static EI_IMPULSE_ERROR fill_input(const float *features, TfLiteTensor *input) {
+        switch (input->type) {
+            case kTfLiteFloat32: {
+                if (input->bytes != N * sizeof(float)) {
+                    return EI_IMPULSE_INVALID_SIZE;
+                }
+                memcpy(input->data.f, features, N * sizeof(float));
+                break;
+            }
+            case kTfLiteInt8: {
+                if (input->bytes != N) {
+                    return EI_IMPULSE_INVALID_SIZE;
+                }
+                const float scale = input->params.scale;
+                const int32_t zero_point = input->params.zero_point;
+                for (size_t ix = 0; ix < N; ix++) {
+                    input->data.int8[ix] = static_cast<int8_t>(
+                        pre_cast_quantize(features[ix], scale, zero_point, true));
+                }
+                break;
+            }
+            case kTfLiteUInt8: {
+                if (input->bytes != N) {
+                    return EI_IMPULSE_INVALID_SIZE;
+                }
+                const float scale = input->params.scale;
+                const int32_t zero_point = input->params.zero_point;
+                for (size_t ix = 0; ix < N; ix++) {
+                    input->data.uint8[ix] = static_cast<uint8_t>(
+                        pre_cast_quantize(features[ix], scale, zero_point, false));
+                }
+                break;
+            }
+            default: {
+                ei_printf("ERR: Cannot handle input type (%d)\n", input->type);
+                return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+            }
+        }
+        return EI_IMPULSE_OK;
+    }
+};
+
+/**
+ * Static variant of process_classification_i8. Config holds `label_count` as a
+ * static constexpr member, scale and zero point come from the output tensor.
+ */
+template<typename Config, const char **Labels>
+struct ei_static_classification_i8 {
+    static EI_IMPULSE_ERROR process(const TfLiteTensor *output, ei_impulse_result_t *result) {
+        if (output->type != kTfLiteInt8 || output->bytes < Config::label_count) {
+            return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
+        }
+
+        const float scale = output->params.scale;
+        const int32_t zero_point = output->params.zero_point;
+        for (size_t ix = 0; ix < Config::label_count; ix++) {
+            result->classification[ix].label = Labels[ix];
+            result->classification[ix].value =
+                static_cast<float>(output->data.int8[ix] - zero_point) * scale;
+        }
+        return EI_IMPULSE_OK;
+    }
+};
+
+/**
+ * A complete impulse resolved at compile time: one DSP block feeding one learning
+ * block, followed by one postprocessing block.
+ */
+template<size_t SampleCount, size_t FrameSize, typename DspBlock, typename LearnBlock, typename PostBlock>
+class ei_static_impulse {
+public:
+    static constexpr size_t dsp_input_frame_size = SampleCount * FrameSize;
+    static constexpr size_t nn_input_frame_size = DspBlock::n_output_features;
+
+    /**
+     * Run the impulse, equivalent to run_classifier() for the impulse this type was generated from
+     */
+    static EI_IMPULSE_ERROR run(ei::signal_t *signal, ei_impulse_result_t *result, bool debug = false) {
+        if (signal == nullptr || result == nullptr) {
+            return EI_IMPULSE_INFERENCE_ERROR;
+        }
+        if (signal->total_length != dsp_input_frame_size) {
+            return EI_IMPULSE_INVALID_SIZE;
+        }
+
+        // checked once, a stale static config would silently diverge from run_classifier()
+        static const bool config_matches = DspBlock::matches_runtime_config();
+        if (!config_matches) {
+            ei_printf("ERR: Static DSP config does not match the impulse, regenerate model_variables.h\n");
+            return EI_IMPULSE_DSP_ERROR;
+        }
+
+        memset(result, 0, sizeof(ei_impulse_result_t));
+
+        uint64_t dsp_start_us = ei_read_timer_us();
+
+        float features[nn_input_frame_size];
+        {
+            ei_static_scratch<dsp_input_frame_size> raw_scratch;
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+            const float *raw = signal->raw_buffer;
+#else
+            const float *raw = nullptr;
+#endif
+            if (!raw) {
+                if (!raw_scratch.get()) {
+                    return EI_IMPULSE_ALLOC_FAILED;
+                }
+                if (signal->get_data(0, dsp_input_frame_size, raw_scratch.get()) != 0) {
+                    return EI_IMPULSE_DSP_ERROR;
+                }
+                raw = raw_scratch.get();
+            }
+
+            int ret = DspBlock::extract(raw, features);
+            if (ret != ei::EIDSP_OK) {
+                ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+                return EI_IMPULSE_DSP_ERROR;
+            }
+        }
+
+        result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+        result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+        if (debug) {
+            ei_printf("Features (%d ms.): ", result->timing.dsp);
+            for (size_t ix = 0; ix < nn_input_frame_size; ix++) {
+                ei_printf_float(features[ix]);
+                ei_printf(" ");
+            }
+            ei_printf("\n");
+        }
+
+        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            return EI_IMPULSE_CANCELED;
+        }
+
+        uint64_t ctx_start_us = ei_read_timer_us();
+
+        TfLiteTensor input;
+        TfLiteTensor output;
+        EI_IMPULSE_ERROR res = LearnBlock::init(&input, &output);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+
+        res = LearnBlock::template fill_input<nn_input_frame_size>(features, &input);
+        if (res == EI_IMPULSE_OK) {
+            res = LearnBlock::invoke();
+        }
+
+        result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+        result->timing.classification = (int)(result->timing.classification_us / 1000);
+
+        if (res == EI_IMPULSE_OK) {
+            res = PostBlock::process(&output, result);
+        }
+
+        LearnBlock::reset();
+
+        return res;
+    }
+};
+
+#endif // EI_CLASSIFIER_HAS_STATIC_IMPULSE
+#endif // _EI_CLASSIFIER_STATIC_IMPULSE_H_
@@ -47,6 +47,33 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/engines.h"
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_simd_kernels.h"
+#include <algorithm>
+#include <cfloat>
+
+/**
+ * K-means anomaly scoring keeps a small search index per cluster set (centroid
+ * norms, and pairwise centroid distances up to
+ * EI_CLASSIFIER_ANOMALY_KMEANS_PAIRWISE_MAX_CLUSTERS clusters, which takes
+ * n * (n - 1) / 2 floats: 8 KB at 64 clusters).
+ */
+#ifndef EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES
+#define EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES            2
+#endif // EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES
+
+#ifndef EI_CLASSIFIER_ANOMALY_KMEANS_PAIRWISE_MAX_CLUSTERS
+#define EI_CLASSIFIER_ANOMALY_KMEANS_PAIRWISE_MAX_CLUSTERS  64
+#endif // EI_CLASSIFIER_ANOMALY_KMEANS_PAIRWISE_MAX_CLUSTERS
+
+// smaller cluster sets are scored with a plain linear scan
+#ifndef EI_CLASSIFIER_ANOMALY_KMEANS_PRUNE_MIN_CLUSTERS
+#define EI_CLASSIFIER_ANOMALY_KMEANS_PRUNE_MIN_CLUSTERS     8
+#endif // EI_CLASSIFIER_ANOMALY_KMEANS_PRUNE_MIN_CLUSTERS
+
+// features per partial distance check
+#ifndef EI_CLASSIFIER_ANOMALY_KMEANS_PDE_BLOCK
+#define EI_CLASSIFIER_ANOMALY_KMEANS_PDE_BLOCK              16
+#endif // EI_CLASSIFIER_ANOMALY_KMEANS_PDE_BLOCK
 
 #ifdef __cplusplus
 namespace {
@@ -68,29 +95,41 @@ static void standard_scaler(float *input, const float *scale, const float *mean,
 }
 
 /**
- * Calculate the distance between input vector and the cluster
+ * Calculate the squared distance between input vector and the cluster centroid,
+ * accumulated in input order
  * @param input Array of input values (already scaled by standard_scaler)
  * @param input_size Size of the input array
  * @param cluster A cluster (number of centroids should match input_size)
  */
-static float calculate_cluster_distance(float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
-    // todo: check input_size and centroid size?
-
+static float calculate_cluster_squared_distance(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
     float dist = 0.0f;
     for (size_t ix = 0; ix < input_size; ix++) {
         dist += pow(input[ix] - cluster->centroid[ix], 2);
     }
+    return dist;
+}
+
+/**
+ * Calculate the distance between input vector and the cluster
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param input_size Size of the input array
+ * @param cluster A cluster (number of centroids should match input_size)
+ */
+static float calculate_cluster_distance(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
+    // todo: check input_size and centroid size?
+
+    float dist = calculate_cluster_squared_distance(input, input_size, cluster);
     return sqrt(dist) - cluster->max_error;
 }
 
 /**
- * Get minimum distance to a cluster
+ * Get minimum distance to a cluster, by scoring every cluster
  * @param input Array of input values (already scaled by standard_scaler)
  * @param input_size Size of the input array
  * @param clusters Array of clusters
  * @param cluster_size Size of cluster array
  */
-static float get_min_distance_to_cluster(float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
+static float get_min_distance_to_cluster_linear(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
     float min = 1000.0f;
     for (size_t ix = 0; ix < cluster_size; ix++) {
         float dist = calculate_cluster_distance(input, input_size, &clusters[ix]);
@@ -100,6 +139,212 @@ static float get_min_distance_to_cluster(float *input, size_t input_size, const
     }
     return min;
 }
+
+/**
+ * Per cluster set data for the pruned search, built on first use
+ */
+typedef struct {
+    const ei_classifier_anom_cluster_t *clusters;
+    size_t cluster_count;
+    size_t input_size;
+    float *norms;       // |centroid|, i.e. distance to the training mean (the origin after scaling)
+    float *pairwise;    // |c_i - c_j| for j < i at [i * (i - 1) / 2 + j], or nullptr
+} ei_kmeans_index_t;
+
+static ei_kmeans_index_t kmeans_indexes[EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES];
+
+static void clear_kmeans_indexes(void) {
+    for (size_t ix = 0; ix < EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES; ix++) {
+        ei_free(kmeans_indexes[ix].norms);
+        ei_free(kmeans_indexes[ix].pairwise);
+        kmeans_indexes[ix] = ei_kmeans_index_t();
+    }
+}
+
+static double centroid_distance(const float *a, const float *b, size_t input_size) {
+    double dist = 0.0;
+    for (size_t ix = 0; ix < input_size; ix++) {
+        double d = (double)a[ix] - (double)b[ix];
+        dist += d * d;
+    }
+    return sqrt(dist);
+}
+
+/**
+ * Get (or build) the search index for a cluster set
+ * @returns nullptr if it could not be allocated, callers then fall back to the linear scan
+ */
+static const ei_kmeans_index_t *get_kmeans_index(const ei_classifier_anom_cluster_t *clusters, size_t cluster_size, size_t input_size) {
+    ei_kmeans_index_t *unused = nullptr;
+    for (size_t ix = 0; ix < EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES; ix++) {
+        ei_kmeans_index_t *index = &kmeans_indexes[ix];
+        if (index->clusters == clusters && index->cluster_count == cluster_size && index->input_size == input_size) {
+            return index;
+        }
+        if (!unused && index->clusters == nullptr) {
+            unused = index;
+        }
+    }
+    if (!unused || cluster_size == 0) {
+        return nullptr;
+    }
+
+    float *norms = (float*)ei_malloc(cluster_size * sizeof(float));
+    if (!norms) {
+        return nullptr;
+    }
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        double norm = 0.0;
+        for (size_t d = 0; d < input_size; d++) {
+            norm += (double)clusters[ix].centroid[d] * (double)clusters[ix].centroid[d];
+        }
+        norms[ix] = (float)sqrt(norm);
+    }
+
+    // optional, the norm bound and partial distances still work without it
+    float *pairwise = nullptr;
+    if (cluster_size > 1 && cluster_size <= EI_CLASSIFIER_ANOMALY_KMEANS_PAIRWISE_MAX_CLUSTERS) {
+        pairwise = (float*)ei_malloc((cluster_size * (cluster_size - 1) / 2) * sizeof(float));
+        if (pairwise) {
+            for (size_t i = 1; i < cluster_size; i++) {
+                for (size_t j = 0; j < i; j++) {
+                    pairwise[i * (i - 1) / 2 + j] =
+                        (float)centroid_distance(clusters[i].centroid, clusters[j].centroid, input_size);
+                }
+            }
+        }
+    }
+
+    unused->clusters = clusters;
+    unused->cluster_count = cluster_size;
+    unused->input_size = input_size;
+    unused->norms = norms;
+    unused->pairwise = pairwise;
+    return unused;
+}
+
+/**
+ * Squared distance from which a cluster can no longer score below `best`, i.e.
+ * sqrt(dist) - max_error >= best holds for any dist >= the returned value, after
+ * float rounding. 0 when no distance can.
+ */
+static double kmeans_prune_threshold(float best, float max_error) {
+    double bound = (double)best + (double)max_error;
+    // keeps rounding in the final sqrt / subtraction from getting below `best`
+    double margin = 1e-5 * (fabs((double)best) + fabs((double)max_error)) + 1e-30;
+    bound += margin;
+    if (bound <= 0.0) {
+        return 0.0;
+    }
+    return bound * bound;
+}
+
+/**
+ * Get minimum distance to a cluster
+ *
+ * Returns exactly what scoring every cluster returns, but skips clusters that
+ * provably can't improve on the best score so far:
+ *  - a lower bound on the distance from the centroid norms (triangle inequality
+ *    through the training mean), and through the pairwise centroid distances to
+ *    the nearest centroid seen so far, when that table fits;
+ *  - partial distance elimination, stopping a vectorized squared distance once
+ *    it exceeds the threshold.
+ * Bounds carry a margin for the difference between the vectorized sum and the
+ * in-order sum used for the score, and clusters that survive are scored with
+ * calculate_cluster_distance(), so the result is bit-identical.
+ *
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param input_size Size of the input array
+ * @param clusters Array of clusters
+ * @param cluster_size Size of cluster array
+ */
+static float get_min_distance_to_cluster(const float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
+    // with only a few clusters the bounds cost more than they save
+    if (cluster_size < EI_CLASSIFIER_ANOMALY_KMEANS_PRUNE_MIN_CLUSTERS) {
+        return get_min_distance_to_cluster_linear(input, input_size, clusters, cluster_size);
+    }
+
+    const ei_kmeans_index_t *index = get_kmeans_index(clusters, cluster_size, input_size);
+    if (!index) {
+        return get_min_distance_to_cluster_linear(input, input_size, clusters, cluster_size);
+    }
+
+    // relative error allowed between a reordered float sum and the in-order one
+    const double rel = 8.0 * (double)(input_size + 2) * FLT_EPSILON;
+    const double shrink = rel < 1.0 ? 1.0 - rel : 0.0;
+
+    double input_norm = 0.0;
+    for (size_t ix = 0; ix < input_size; ix++) {
+        input_norm += (double)input[ix] * (double)input[ix];
+    }
+    input_norm = sqrt(input_norm);
+
+    // start from the cluster that looks most promising by the norm bound, so the others prune early
+    size_t first = 0;
+    double first_bound = INFINITY;
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        double bound = fabs(input_norm - (double)index->norms[ix]) - (double)clusters[ix].max_error;
+        if (bound < first_bound) {
+            first_bound = bound;
+            first = ix;
+        }
+    }
+
+    float min = 1000.0f;
+    size_t nearest = cluster_size;  // closest centroid scored so far
+    double nearest_dist = 0.0;
+
+    for (size_t step = 0; step < cluster_size; step++) {
+        size_t ix = first + step < cluster_size ? first + step : first + step - cluster_size;
+        const ei_classifier_anom_cluster_t *cluster = &clusters[ix];
+
+        double threshold = kmeans_prune_threshold(min, cluster->max_error);
+        if (threshold == 0.0) {
+            continue;
+        }
+
+        double lower = fabs(input_norm - (double)index->norms[ix]) - 1e-6 * (input_norm + (double)index->norms[ix]);
+        if (index->pairwise && nearest != cluster_size) {
+            double pair = nearest < ix ?
+                index->pairwise[ix * (ix - 1) / 2 + nearest] :
+                index->pairwise[nearest * (nearest - 1) / 2 + ix];
+            double through_nearest = pair * (1.0 - 1e-6) - nearest_dist * (1.0 + rel);
+            if (through_nearest > lower) {
+                lower = through_nearest;
+            }
+        }
+        if (lower > 0.0 && lower * lower * shrink >= threshold) {
+            continue;
+        }
+
+        float partial = 0.0f;
+        bool pruned = false;
+        for (size_t offset = 0; offset < input_size; offset += EI_CLASSIFIER_ANOMALY_KMEANS_PDE_BLOCK) {
+            size_t length = std::min((size_t)EI_CLASSIFIER_ANOMALY_KMEANS_PDE_BLOCK, input_size - offset);
+            partial += ei::simd::squared_distance(input + offset, cluster->centroid + offset, length);
+            if ((double)partial * shrink >= threshold) {
+                pruned = true;
+                break;
+            }
+        }
+        if (pruned) {
+            continue;
+        }
+
+        float dist_squared = calculate_cluster_squared_distance(input, input_size, cluster);
+        float dist = sqrt(dist_squared) - cluster->max_error;
+        if (dist < min) {
+            min = dist;
+        }
+
+        double centroid_dist = sqrt((double)dist_squared);
+        if (std::isfinite(centroid_dist) && (nearest == cluster_size || centroid_dist < nearest_dist)) {
+            nearest = ix;
+            nearest_dist = centroid_dist;
+        }
+    }
+    return min;
+}
 #endif // EI_CLASSIFIER_HAS_ANOMALY_KMEANS
 
 #ifdef __cplusplus
@@ -210,6 +455,42 @@ EI_IMPULSE_ERROR run_kmeans_anomaly(
 
     return EI_IMPULSE_OK;
 }
+
+/**
+ * Anomaly scores for a batch of feature vectors, e.g. to score a recorded
+ * dataset on device. Same result as run_kmeans_anomaly() for each vector.
+ * @param block_config K-means anomaly block config
+ * @param inputs `input_count` vectors of `anom_axes_size` (unscaled) values each,
+ *  laid out one after the other. Not modified.
+ * @param input_count Number of vectors
+ * @param scores Output, one score per vector
+ * @return EI_IMPULSE_OK if successful, otherwise an error code
+ */
+EI_IMPULSE_ERROR run_kmeans_anomaly_batch(
+    const ei_learning_block_config_anomaly_kmeans_t *block_config,
+    const float *inputs,
+    size_t input_count,
+    float *scores)
+{
+    const size_t input_size = block_config->anom_axes_size;
+
+    float *input = (float*)ei_malloc(input_size * sizeof(float));
+    if (!input) {
+        ei_printf("Failed to allocate memory for anomaly input buffer");
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    for (size_t ix = 0; ix < input_count; ix++) {
+        memcpy(input, inputs + ix * input_size, input_size * sizeof(float));
+        standard_scaler(input, block_config->anom_scale, block_config->anom_mean, input_size);
+        scores[ix] = get_min_distance_to_cluster(
+            input, input_size, block_config->anom_clusters, block_config->anom_cluster_count);
+    }
+
+    ei_free(input);
+
+    return EI_IMPULSE_OK;
+}
 #endif // EI_CLASSIFIER_HAS_ANOMALY_KMEANS
 
 #if EI_CLASSIFIER_HAS_ANOMALY_GMM
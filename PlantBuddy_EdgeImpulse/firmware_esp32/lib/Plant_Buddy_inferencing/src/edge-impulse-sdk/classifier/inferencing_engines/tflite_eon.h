@@ -43,6 +43,11 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+#include "edge-impulse-sdk/classifier/ei_signal_with_axes.h"
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_alloc_profiler.h"
+#include "edge-impulse-sdk/porting/ei_deferred_log.h"
 
 /**
  * Setup the TFLite runtime
@@ -66,12 +71,29 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     TfLiteTensor *outputs = *output_arg;
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc);
+    EI_ALLOC_PROFILER_PHASE(EI_ALLOC_PHASE_INFERENCE);
+
+    TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc_hot);
     if (init_status != kTfLiteOk) {
         ei_printf("Failed to initialize the model (error code %d)\n", init_status);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
 
+#if EIDSP_TRACK_ALLOCATIONS
+    if (graph_config->model_arena_usage) {
+        size_t planned_bytes = 0, persistent_bytes = 0, overflow_bytes = 0;
+        ei_alloc_profiler_arena_t arena = { };
+        arena.name = "eon";
+        graph_config->model_arena_usage(&arena.arena_bytes, &planned_bytes, &persistent_bytes, &overflow_bytes);
+        arena.used_bytes = planned_bytes + persistent_bytes;
+        arena.sections[0] = { "planned", planned_bytes, 1 };
+        arena.sections[1] = { "persistent", persistent_bytes, 1 };
+        arena.sections[2] = { "heap_overflow", overflow_bytes, overflow_bytes > 0 ? 1u : 0u };
+        arena.section_count = 3;
+        ei_alloc_profiler_record_arena(&arena);
+    }
+#endif // EIDSP_TRACK_ALLOCATIONS
+
     TfLiteStatus status;
 
     status = graph_config->model_input(0, input);
@@ -112,9 +134,24 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
+    EI_PROFILE_STAGE(INFERENCE, "model_invoke");
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    if (graph_config->model_set_profiler) {
+        graph_config->model_set_profiler(EiOpProfiler::active());
+    }
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    if (graph_config->model_set_profiler) {
+        graph_config->model_set_profiler(nullptr);
+    }
+    if (invoke_status != kTfLiteOk) {
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+#else
     if (graph_config->model_invoke() != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
 
     uint64_t ctx_end_us = ei_read_timer_us();
 
@@ -130,6 +167,69 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Copy (and optionally dequantize) the output tensors into the raw outputs of the result
+ *
+ * @param      block_config       Learning block config
+ * @param      outputs            Output tensors
+ * @param      learn_block_index  Index of the first raw output slot for this block
+ * @param      result             Output classifier results
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR copy_output_tensors_to_result(
+    ei_learning_block_config_tflite_graph_t *block_config,
+    TfLiteTensor *outputs,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result) {
+
+    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
+        TfLiteTensor* output = &outputs[output_ix];
+        // calculate the size of the output by iterating through dims
+        size_t output_size = 1;
+        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
+            output_size *= output->dims->data[dim_num];
+        }
+        switch (output->type) {
+            case kTfLiteFloat32: {
+                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
+                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
+                break;
+            }
+            case kTfLiteInt8: {
+                if (block_config->dequantize_output) {
+                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
+                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
+                }
+                else {
+                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
+                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
+                }
+                break;
+            }
+            case kTfLiteUInt8: {
+                if (block_config->dequantize_output) {
+                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
+                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
+                }
+                else {
+                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
+                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
+                }
+                break;
+            }
+            default: {
+                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
+                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
+            }
+        }
+
+        result->_raw_outputs[learn_block_index + output_ix].blockId = block_config->block_id + output_ix;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * @brief      Do neural network inferencing over a signal (from the DSP)
  *
@@ -251,49 +351,8 @@ EI_IMPULSE_ERROR run_nn_inference(
         &outputs,
         tensor_arena, result, debug);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
+    EI_IMPULSE_ERROR output_res = copy_output_tensors_to_result(block_config, outputs, learn_block_index, result);
 
-        result->_raw_outputs[learn_block_index + output_ix].blockId = block_config->block_id + output_ix;
-    }
 
     graph_config->model_reset(ei_aligned_free);
     ei_free(outputs);
@@ -302,6 +361,10 @@ EI_IMPULSE_ERROR run_nn_inference(
         return run_res;
     }
 
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
+    }
+
     return EI_IMPULSE_OK;
 }
 
@@ -317,7 +380,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     uint32_t learn_block_index,
     ei_impulse_result_t *result,
     void *config_ptr,
-    bool debug = false) {
+    bool debug = false,
+    const ei_image_frame_t *frame = nullptr) {
 
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
@@ -352,8 +416,12 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input.data.int8);
 
     // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input.params.scale, input.params.zero_point,
-        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    // (from a raw camera frame if we got one, see run_classifier_image_frame)
+    int ret = frame != nullptr
+        ? extract_image_frame_features_quantized(frame, &features_matrix, impulse->dsp_blocks[0].config, input.params.scale, input.params.zero_point,
+            impulse->input_width, impulse->input_height, EI_CLASSIFIER_RESIZE_MODE, impulse->learning_blocks[0].image_scaling)
+        : extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input.params.scale, input.params.zero_point,
+            impulse->frequency, impulse->learning_blocks[0].image_scaling);
 
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -368,12 +436,12 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
-        ei_printf("Features (%d ms.): ", result->timing.dsp);
+        EI_PRINTF_DEFERRED("Features (%d ms.): ", result->timing.dsp);
         for (size_t ix = 0; ix < features_matrix.cols; ix++) {
-            ei_printf_float((features_matrix.buffer[ix] - input.params.zero_point) * input.params.scale);
-            ei_printf(" ");
+            EI_PRINTF_FLOAT_DEFERRED((features_matrix.buffer[ix] - input.params.zero_point) * input.params.scale);
+            EI_PRINTF_DEFERRED(" ");
         }
-        ei_printf("\n");
+        EI_PRINTF_DEFERRED("\n");
     }
 
     ctx_start_us = ei_read_timer_us();
@@ -387,51 +455,124 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         result,
         debug);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
+    EI_IMPULSE_ERROR output_res = copy_output_tensors_to_result(block_config, outputs, learn_block_index, result);
 
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
 
-        result->_raw_outputs[learn_block_index + output_ix].blockId = block_config->block_id + output_ix;
+    graph_config->model_reset(ei_aligned_free);
+    ei_free(outputs);
+
+    if (run_res != EI_IMPULSE_OK) {
+        return run_res;
+    }
+
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Special function to run the classifier on non-image impulses where the (single) DSP block
+ * can write quantized features itself (see DspHandle::extract_quantized). The DSP block writes
+ * straight into the int8 input tensor, so no float features matrix is allocated and there's no
+ * separate quantization pass. This only works if 'can_run_classifier_features_quantized'
+ * returns EI_IMPULSE_OK. Called from run_learning_blocks(), which process_impulse() skips
+ * in debug mode, as the float features are never materialized here to print them.
+ */
+EI_IMPULSE_ERROR run_nn_inference_features_quantized(
+    ei_impulse_handle_t *handle,
+    signal_t *signal,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false) {
+
+    const ei_impulse_t *impulse = handle->impulse;
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+    ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+
+    uint64_t ctx_start_us;
+    TfLiteTensor input;
+    TfLiteTensor *outputs;
+
+    DspHandle *dsp_handle = handle->state.get_dsp_handle(0);
+    if (!dsp_handle || !dsp_handle->supports_quantized_output()) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    // allocate outputs
+    outputs = (TfLiteTensor*)ei_malloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &input,
+        &outputs,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    if (input.type != TfLiteType::kTfLiteInt8) {
+        graph_config->model_reset(ei_aligned_free);
+        ei_free(outputs);
+        return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
     }
 
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    // features matrix maps around the input tensor to not allocate any memory
+    ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input.data.int8);
+
+    const ei_model_dsp_t &block = impulse->dsp_blocks[0];
+#if EIDSP_SIGNAL_C_FN_POINTER
+    auto internal_signal = signal;
+#else
+    SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
+    auto internal_signal = swa.get_signal();
+#endif
+
+    // run DSP process and quantize automatically
+    int ret;
+    {
+        EI_PROFILE_STAGE(DSP, "dsp_block");
+        ret = dsp_handle->extract_quantized(internal_signal, &features_matrix, block.config, impulse->frequency,
+            input.params.scale, input.params.zero_point, result);
+    }
+
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+        graph_config->model_reset(ei_aligned_free);
+        ei_free(outputs);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        graph_config->model_reset(ei_aligned_free);
+        ei_free(outputs);
+        return EI_IMPULSE_CANCELED;
+    }
+
+    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+    ctx_start_us = ei_read_timer_us();
+
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(
+        impulse,
+        block_config,
+        ctx_start_us,
+        &outputs,
+        static_cast<uint8_t*>(p_tensor_arena.get()),
+        result,
+        debug);
+
+    EI_IMPULSE_ERROR output_res = copy_output_tensors_to_result(block_config, outputs, learn_block_index, result);
+
     graph_config->model_reset(ei_aligned_free);
     ei_free(outputs);
 
@@ -439,6 +580,10 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return run_res;
     }
 
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
+    }
+
     return EI_IMPULSE_OK;
 }
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
@@ -453,6 +598,8 @@ __attribute__((unused)) int extract_tflite_eon_features(signal_t *signal, matrix
         .model_reset = dsp_config->reset_fn,
         .model_input = dsp_config->input_fn,
         .model_output = dsp_config->output_fn,
+        .model_set_profiler = nullptr,
+        .model_arena_usage = nullptr,
     };
 
     const uint8_t ei_output_tensor_indices[1] = { 0 };
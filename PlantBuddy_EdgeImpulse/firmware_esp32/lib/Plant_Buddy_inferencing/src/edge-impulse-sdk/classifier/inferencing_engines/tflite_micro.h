@@ -47,6 +47,7 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
+#include "edge-impulse-sdk/classifier/ei_recurrent_state.h"
 
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
 #include "tflite-model/tflite-resolver.h"
@@ -56,6 +57,29 @@
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler.h"
 #endif
 
+#include "edge-impulse-sdk/dsp/ei_alloc_profiler.h"
+
+/**
+ * Adopt the arena plan from the model's "EIMemoryPlan" metadata, if it has one,
+ * instead of planning the arena at every setup (see precomputed_memory_planner.h)
+ */
+#ifndef EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+#define EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN 1
+#endif // EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+
+#if EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_arena_constants.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/single_arena_buffer_allocator.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/precomputed_memory_planner.h"
+#endif // EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+#if EIDSP_TRACK_ALLOCATIONS && EIDSP_ALLOC_PROFILER_RECORD_TFLM == 1
+#include "edge-impulse-sdk/tensorflow/lite/micro/recording_micro_allocator.h"
+#endif
+
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
 #if defined __GNUC__
 #define ALIGN(X) __attribute__((aligned(X)))
@@ -88,6 +112,138 @@
 #define DEFINE_SECTION(x) __attribute__((section(x)))
 #endif
 
+#if EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+/**
+ * Create an allocator whose memory planner adopts the plan stored in the model
+ * (falling back to the greedy planner if the plan doesn't match the buffers
+ * this build requests)
+ *
+ * @return  nullptr if the model has no plan, use the default allocator then
+ */
+static tflite::MicroAllocator* create_precomputed_plan_allocator(
+    const tflite::Model *model,
+    uint8_t *tensor_arena,
+    size_t arena_size) {
+
+    const tflite::PrecomputedMemoryPlan *plan = tflite::GetPrecomputedMemoryPlan(model);
+    if (plan == nullptr) {
+        return nullptr;
+    }
+
+    uint8_t *aligned_arena = tflite::AlignPointerUp(tensor_arena, tflite::MicroArenaBufferAlignment());
+    size_t aligned_arena_size = tensor_arena + arena_size - aligned_arena;
+    tflite::SingleArenaBufferAllocator *memory_allocator =
+        tflite::SingleArenaBufferAllocator::Create(aligned_arena, aligned_arena_size);
+
+    // lives in the tail of the arena, like the default GreedyMemoryPlanner
+    uint8_t *planner_buffer = memory_allocator->AllocatePersistentBuffer(
+        sizeof(tflite::PrecomputedMemoryPlanner), alignof(tflite::PrecomputedMemoryPlanner));
+    if (planner_buffer == nullptr) {
+        return nullptr;
+    }
+    tflite::PrecomputedMemoryPlanner *planner = new (planner_buffer) tflite::PrecomputedMemoryPlanner(plan);
+
+    return tflite::MicroAllocator::Create(memory_allocator, planner);
+}
+#endif // EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+/**
+ * Count the variable tensors of the model (the recurrent state) and their total size
+ */
+static EI_IMPULSE_ERROR get_tflite_variable_tensors_size(
+    tflite::MicroInterpreter *interpreter,
+    uint32_t *tensor_count,
+    size_t *bytes) {
+
+    *tensor_count = 0;
+    *bytes = 0;
+    for (size_t ix = 0; ix < interpreter->tensors_size(); ix++) {
+        TfLiteEvalTensor *tensor = interpreter->variable_tensor(ix);
+        if (tensor == nullptr) {
+            continue;
+        }
+        size_t tensor_bytes;
+        if (tflite::TfLiteEvalTensorByteLength(tensor, &tensor_bytes) != kTfLiteOk) {
+            return EI_IMPULSE_TFLITE_ERROR;
+        }
+        (*tensor_count)++;
+        *bytes += tensor_bytes;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Overwrite the variable tensors (reset by AllocateTensors) with the state the
+ * previous inference of this learning block left behind
+ */
+static EI_IMPULSE_ERROR restore_tflite_variable_tensors(tflite::MicroInterpreter *interpreter, ei_impulse_result_t *result) {
+    ei_recurrent_block_state_t *state = ei_recurrent_state_current_block(result);
+    if (state == nullptr || !state->valid) {
+        return EI_IMPULSE_OK;
+    }
+
+    uint32_t tensor_count;
+    size_t bytes;
+    EI_IMPULSE_ERROR res = get_tflite_variable_tensors_size(interpreter, &tensor_count, &bytes);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    if (tensor_count != state->tensor_count || bytes != state->bytes) {
+        EI_LOGW("Recurrent state doesn't match the model, starting from the initial state\n");
+        state->valid = false;
+        return EI_IMPULSE_OK;
+    }
+
+    const uint8_t *data = state->data;
+    for (size_t ix = 0; ix < interpreter->tensors_size(); ix++) {
+        TfLiteEvalTensor *tensor = interpreter->variable_tensor(ix);
+        if (tensor == nullptr) {
+            continue;
+        }
+        size_t tensor_bytes;
+        tflite::TfLiteEvalTensorByteLength(tensor, &tensor_bytes);
+        memcpy(tensor->data.raw, data, tensor_bytes);
+        data += tensor_bytes;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Keep the variable tensors of this learning block for its next inference
+ */
+static EI_IMPULSE_ERROR save_tflite_variable_tensors(tflite::MicroInterpreter *interpreter, ei_impulse_result_t *result) {
+    ei_recurrent_block_state_t *state = ei_recurrent_state_current_block(result);
+    if (state == nullptr) {
+        return EI_IMPULSE_OK;
+    }
+
+    uint32_t tensor_count;
+    size_t bytes;
+    EI_IMPULSE_ERROR res = get_tflite_variable_tensors_size(interpreter, &tensor_count, &bytes);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    if (!reserve_recurrent_block_state(state, tensor_count, bytes)) {
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+
+    uint8_t *data = state->data;
+    for (size_t ix = 0; ix < interpreter->tensors_size(); ix++) {
+        TfLiteEvalTensor *tensor = interpreter->variable_tensor(ix);
+        if (tensor == nullptr) {
+            continue;
+        }
+        size_t tensor_bytes;
+        tflite::TfLiteEvalTensorByteLength(tensor, &tensor_bytes);
+        memcpy(data, tensor->data.raw, tensor_bytes);
+        data += tensor_bytes;
+    }
+    state->valid = true;
+    return EI_IMPULSE_OK;
+}
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
 /**
  * Setup the TFLite runtime
  *
@@ -118,7 +274,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, [](void*){});
 #else
     // Create an area of memory to use for input, output, and intermediate arrays.
-    uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc(16, graph_config->arena_size);
+    uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc_hot(16, graph_config->arena_size);
     if (tensor_arena == NULL) {
         ei_printf("Failed to allocate TFLite arena (%zu bytes)\n", graph_config->arena_size);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
@@ -166,17 +322,39 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 #ifdef EI_CLASSIFIER_ENABLE_PROFILER
     tflite::MicroProfiler *profiler = new tflite::MicroProfiler;
 
-    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
-        model, resolver, tensor_arena, graph_config->arena_size, nullptr, profiler);
-
     *micro_profiler = (void*)profiler;
 #else
-    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
-        model, resolver, tensor_arena, graph_config->arena_size, nullptr, nullptr);
+    tflite::MicroProfilerInterface *profiler = nullptr;
 
     micro_profiler = nullptr;
 #endif
 
+#if EIDSP_TRACK_ALLOCATIONS && EIDSP_ALLOC_PROFILER_RECORD_TFLM == 1
+    // lives in the tail of the arena, so it goes away together with the arena
+    tflite::RecordingMicroAllocator *recording_allocator =
+        tflite::RecordingMicroAllocator::Create(tensor_arena, graph_config->arena_size);
+    if (recording_allocator == nullptr) {
+        ei_printf("Failed to create the recording allocator, arena too small\n");
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
+        model, resolver, recording_allocator, nullptr, profiler);
+#else
+    tflite::MicroInterpreter *interpreter = nullptr;
+#if EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+    tflite::MicroAllocator *plan_allocator =
+        create_precomputed_plan_allocator(model, tensor_arena, graph_config->arena_size);
+    if (plan_allocator != nullptr) {
+        interpreter = new tflite::MicroInterpreter(
+            model, resolver, plan_allocator, nullptr, profiler);
+    }
+#endif // EI_CLASSIFIER_TFLITE_PRECOMPUTED_MEMORY_PLAN
+    if (interpreter == nullptr) {
+        interpreter = new tflite::MicroInterpreter(
+            model, resolver, tensor_arena, graph_config->arena_size, nullptr, profiler);
+    }
+#endif
+
     *micro_interpreter = interpreter;
 
     // Allocate memory from the tensor_arena for the model's tensors.
@@ -186,6 +364,33 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
+#if EIDSP_TRACK_ALLOCATIONS
+    ei_alloc_profiler_arena_t arena_usage = { };
+    arena_usage.name = "tflm";
+    arena_usage.arena_bytes = graph_config->arena_size;
+    arena_usage.used_bytes = interpreter->arena_used_bytes();
+#if EIDSP_ALLOC_PROFILER_RECORD_TFLM == 1
+    static const struct {
+        tflite::RecordedAllocationType type;
+        const char *name;
+    } recorded_types[] = {
+        { tflite::RecordedAllocationType::kTfLiteEvalTensorData, "eval_tensor_data" },
+        { tflite::RecordedAllocationType::kPersistentTfLiteTensorData, "persistent_tensor_data" },
+        { tflite::RecordedAllocationType::kPersistentTfLiteTensorQuantizationData, "persistent_quantization_data" },
+        { tflite::RecordedAllocationType::kPersistentBufferData, "persistent_buffer_data" },
+        { tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData, "variable_buffer_data" },
+        { tflite::RecordedAllocationType::kNodeAndRegistrationArray, "node_and_registration" },
+        { tflite::RecordedAllocationType::kOpData, "op_data" },
+    };
+    for (size_t ix = 0; ix < sizeof(recorded_types) / sizeof(recorded_types[0]); ix++) {
+        tflite::RecordedAllocation recorded = recording_allocator->GetRecordedAllocation(recorded_types[ix].type);
+        arena_usage.sections[ix] = { recorded_types[ix].name, recorded.used_bytes, recorded.count };
+    }
+    arena_usage.section_count = sizeof(recorded_types) / sizeof(recorded_types[0]);
+#endif // EIDSP_ALLOC_PROFILER_RECORD_TFLM == 1
+    ei_alloc_profiler_record_arena(&arena_usage);
+#endif // EIDSP_TRACK_ALLOCATIONS
+
     // Obtain pointers to the model's input and output tensors.
     *input = interpreter->input(0);
     for (uint8_t i = 0; i < block_config->output_tensors_size; i++) {
@@ -217,6 +422,13 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     ei_impulse_result_t *result,
     void* micro_profiler) {
 
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    EI_IMPULSE_ERROR state_res = restore_tflite_variable_tensors(interpreter, result);
+    if (state_res != EI_IMPULSE_OK) {
+        return state_res;
+    }
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
     // Run inference, and report any error
     TfLiteStatus invoke_status = interpreter->Invoke();
     if (invoke_status != kTfLiteOk) {
@@ -225,6 +437,13 @@ static EI_IMPULSE_ERROR inference_tflite_run(
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
+#if EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+    state_res = save_tflite_variable_tensors(interpreter, result);
+    if (state_res != EI_IMPULSE_OK) {
+        return state_res;
+    }
+#endif // EI_CLASSIFIER_STREAMING_RECURRENT_STATE
+
     uint64_t ctx_end_us = ei_read_timer_us();
 
     result->timing.classification_us = ctx_end_us - ctx_start_us;
@@ -446,7 +665,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     uint32_t learn_block_index,
     ei_impulse_result_t *result,
     void *config_ptr,
-    bool debug = false)
+    bool debug = false,
+    const ei_image_frame_t *frame = nullptr)
 {
     ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
 
@@ -487,8 +707,12 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input->data.int8);
 
     // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input->params.scale, input->params.zero_point,
-        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    // (from a raw camera frame if we got one, see run_classifier_image_frame)
+    int ret = frame != nullptr
+        ? extract_image_frame_features_quantized(frame, &features_matrix, impulse->dsp_blocks[0].config, input->params.scale, input->params.zero_point,
+            impulse->input_width, impulse->input_height, EI_CLASSIFIER_RESIZE_MODE, impulse->learning_blocks[0].image_scaling)
+        : extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input->params.scale, input->params.zero_point,
+            impulse->frequency, impulse->learning_blocks[0].image_scaling);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
         return EI_IMPULSE_DSP_ERROR;
@@ -11,6 +11,12 @@
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #endif
 
+typedef struct {
+    int trace_idx;
+    int detection_idx;
+    float value;
+} ei_alignment_match_t;
+
 __attribute__((unused)) static bool compare_tuples(std::tuple<int, int, float> a, std::tuple<int, int, float> b) {
     return std::get<2>(a) < std::get<2>(b);
 }
@@ -108,6 +114,75 @@ public:
         return matches;
     }
 
+    /**
+     * Same alignment as above, but without touching the heap.
+     * @param cost_mtx Scratch for traces_count * detections_count costs
+     * @param workspace Scratch of rectangular_lsap_workspace_size(min(traces_count, detections_count),
+     *                  max(traces_count, detections_count)) bytes, aligned for double
+     * @param matches Receives up to min(traces_count, detections_count) matches, ordered by trace
+     * @returns Number of matches
+     */
+    size_t align(const ei_impulse_result_bounding_box_t *traces, size_t traces_count,
+                 const ei_impulse_result_bounding_box_t *detections, size_t detections_count,
+                 double *cost_mtx, void *workspace, ei_alignment_match_t *matches) {
+
+        if (traces_count == 0 || detections_count == 0) {
+            return 0;
+        }
+
+        // the solver wants nr <= nc, so build a tall matrix already transposed
+        const bool transpose = detections_count < traces_count;
+        const size_t trace_stride = transpose ? 1 : detections_count;
+        const size_t detection_stride = transpose ? traces_count : 1;
+
+        for (size_t trace_idx = 0; trace_idx < traces_count; ++trace_idx) {
+            for (size_t detection_idx = 0; detection_idx < detections_count; ++detection_idx) {
+                float cost = 0.0;
+                if (use_iou) {
+                    float iou = intersection_over_union(traces[trace_idx], detections[detection_idx]);
+                    cost = 1 - iou;
+                } else {
+                    cost = centroid_euclidean_distance(traces[trace_idx], detections[detection_idx]);
+                }
+                EI_LOGD("t_idx=%zu d_idx=%zu cost=%.6f\n", trace_idx, detection_idx, cost);
+                cost_mtx[trace_idx * trace_stride + detection_idx * detection_stride] = cost;
+            }
+        }
+
+        const intptr_t nr = transpose ? detections_count : traces_count;
+        const intptr_t nc = transpose ? traces_count : detections_count;
+        rectangular_lsap_workspace_t ws;
+        rectangular_lsap_workspace_init(&ws, workspace, nr, nc);
+
+        int res = solve_preallocated(nr, nc, cost_mtx, &ws);
+        if (res != 0) {
+            EI_LOGW("alignment failed (%d), no matches\n", res);
+            return 0;
+        }
+
+        size_t matches_count = 0;
+        for (size_t trace_idx = 0; trace_idx < traces_count; trace_idx++) {
+            intptr_t detection_idx = transpose ? ws.row4col[trace_idx] : ws.col4row[trace_idx];
+            if (detection_idx < 0) {
+                continue;
+            }
+
+            double c = cost_mtx[trace_idx * trace_stride + detection_idx * detection_stride];
+            if (use_iou) {
+                float iou = 1 - c;
+                if (iou > threshold) {
+                    matches[matches_count++] = { (int)trace_idx, (int)detection_idx, iou };
+                }
+            } else {
+                float cost = c;
+                if (cost < threshold) {
+                    matches[matches_count++] = { (int)trace_idx, (int)detection_idx, cost };
+                }
+            }
+        }
+        return matches_count;
+    }
+
     float threshold;
     bool use_iou;
 };
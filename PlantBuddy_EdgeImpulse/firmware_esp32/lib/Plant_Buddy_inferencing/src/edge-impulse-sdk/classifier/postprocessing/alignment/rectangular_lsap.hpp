@@ -44,6 +44,7 @@ Author: PM Larsen
 #include <vector>
 #include <numeric>
 #include <algorithm>
+#include <stdint.h>
 
 #define RECTANGULAR_LSAP_INFEASIBLE -1
 #define RECTANGULAR_LSAP_INVALID -2
@@ -57,13 +58,51 @@ template <typename T> std::vector<intptr_t> argsort_iter(const std::vector<T> &v
     return index;
 }
 
+// Working memory of the solver, for nr <= nc. Carve it out of
+// rectangular_lsap_workspace_size(nr, nc) bytes with rectangular_lsap_workspace_init()
+// to solve without touching the heap.
+typedef struct {
+    double *u;
+    double *v;
+    double *shortestPathCosts;
+    intptr_t *path;
+    intptr_t *col4row;
+    intptr_t *row4col;
+    intptr_t *remaining;
+    bool *SR;
+    bool *SC;
+} rectangular_lsap_workspace_t;
+
+static inline constexpr size_t rectangular_lsap_workspace_size(intptr_t nr, intptr_t nc)
+{
+    return (nr + 2 * nc) * sizeof(double) +
+           (nr + 3 * nc) * sizeof(intptr_t) +
+           (nr + nc) * sizeof(bool);
+}
+
+static inline void rectangular_lsap_workspace_init(rectangular_lsap_workspace_t *ws, void *buffer,
+                                                   intptr_t nr, intptr_t nc)
+{
+    double *d = static_cast<double*>(buffer);
+    ws->u = d;
+    ws->v = d + nr;
+    ws->shortestPathCosts = d + nr + nc;
+    intptr_t *p = reinterpret_cast<intptr_t*>(d + nr + 2 * nc);
+    ws->path = p;
+    ws->col4row = p + nc;
+    ws->row4col = p + nc + nr;
+    ws->remaining = p + 2 * nc + nr;
+    bool *b = reinterpret_cast<bool*>(p + 3 * nc + nr);
+    ws->SR = b;
+    ws->SC = b + nr;
+}
+
 static intptr_t
-augmenting_path(intptr_t nc, double *cost, std::vector<double>& u,
-                std::vector<double>& v, std::vector<intptr_t>& path,
-                std::vector<intptr_t>& row4col,
-                std::vector<double>& shortestPathCosts, intptr_t i,
-                std::vector<bool>& SR, std::vector<bool>& SC,
-                std::vector<intptr_t>& remaining, double* p_minVal)
+augmenting_path(intptr_t nr, intptr_t nc, const double *cost, const double *u,
+                const double *v, intptr_t *path, const intptr_t *row4col,
+                double *shortestPathCosts, intptr_t i,
+                bool *SR, bool *SC,
+                intptr_t *remaining, double* p_minVal)
 {
     double minVal = 0;
 
@@ -76,9 +115,9 @@ augmenting_path(intptr_t nc, double *cost, std::vector<double>& u,
         remaining[it] = nc - it - 1;
     }
 
-    std::fill(SR.begin(), SR.end(), false);
-    std::fill(SC.begin(), SC.end(), false);
-    std::fill(shortestPathCosts.begin(), shortestPathCosts.end(), INFINITY);
+    std::fill(SR, SR + nr, false);
+    std::fill(SC, SC + nc, false);
+    std::fill(shortestPathCosts, shortestPathCosts + nc, INFINITY);
 
     // find shortest augmenting path
     intptr_t sink = -1;
@@ -127,6 +166,65 @@ augmenting_path(intptr_t nc, double *cost, std::vector<double>& u,
     return sink;
 }
 
+// Solve a cost matrix with nr <= nc in the given workspace. On success ws->col4row[i] is
+// the column of row i and ws->row4col[j] the row of column j (-1 if unassigned).
+static int solve_preallocated(intptr_t nr, intptr_t nc, const double* cost,
+                              rectangular_lsap_workspace_t *ws)
+{
+    // test for NaN and -inf entries
+    for (intptr_t i = 0; i < nr * nc; i++) {
+        if (cost[i] != cost[i] || cost[i] == -INFINITY) {
+            return RECTANGULAR_LSAP_INVALID;
+        }
+    }
+
+    // initialize variables
+    std::fill(ws->u, ws->u + nr, 0);
+    std::fill(ws->v, ws->v + nc, 0);
+    std::fill(ws->path, ws->path + nc, -1);
+    std::fill(ws->col4row, ws->col4row + nr, -1);
+    std::fill(ws->row4col, ws->row4col + nc, -1);
+
+    // iteratively build the solution
+    for (intptr_t curRow = 0; curRow < nr; curRow++) {
+
+        double minVal;
+        intptr_t sink = augmenting_path(nr, nc, cost, ws->u, ws->v, ws->path, ws->row4col,
+                                        ws->shortestPathCosts, curRow, ws->SR, ws->SC,
+                                        ws->remaining, &minVal);
+        if (sink < 0) {
+            return RECTANGULAR_LSAP_INFEASIBLE;
+        }
+
+        // update dual variables
+        ws->u[curRow] += minVal;
+        for (intptr_t i = 0; i < nr; i++) {
+            if (ws->SR[i] && i != curRow) {
+                ws->u[i] += minVal - ws->shortestPathCosts[ws->col4row[i]];
+            }
+        }
+
+        for (intptr_t j = 0; j < nc; j++) {
+            if (ws->SC[j]) {
+                ws->v[j] -= minVal - ws->shortestPathCosts[j];
+            }
+        }
+
+        // augment previous solution
+        intptr_t j = sink;
+        while (1) {
+            intptr_t i = ws->path[j];
+            ws->row4col[j] = i;
+            std::swap(ws->col4row[i], j);
+            if (i == curRow) {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
 static int solve(intptr_t nr, intptr_t nc, double* cost, bool maximize,
                  int64_t* a, int64_t* b) {
     // handle trivial inputs
@@ -165,61 +263,16 @@ static int solve(intptr_t nr, intptr_t nc, double* cost, bool maximize,
         cost = temp.data();
     }
 
-    // test for NaN and -inf entries
-    for (intptr_t i = 0; i < nr * nc; i++) {
-        if (cost[i] != cost[i] || cost[i] == -INFINITY) {
-            return RECTANGULAR_LSAP_INVALID;
-        }
-    }
-
-    // initialize variables
-    std::vector<double> u(nr, 0);
-    std::vector<double> v(nc, 0);
-    std::vector<double> shortestPathCosts(nc);
-    std::vector<intptr_t> path(nc, -1);
-    std::vector<intptr_t> col4row(nr, -1);
-    std::vector<intptr_t> row4col(nc, -1);
-    std::vector<bool> SR(nr);
-    std::vector<bool> SC(nc);
-    std::vector<intptr_t> remaining(nc);
-
-    // iteratively build the solution
-    for (intptr_t curRow = 0; curRow < nr; curRow++) {
-
-        double minVal;
-        intptr_t sink = augmenting_path(nc, cost, u, v, path, row4col,
-                                        shortestPathCosts, curRow, SR, SC,
-                                        remaining, &minVal);
-        if (sink < 0) {
-            return RECTANGULAR_LSAP_INFEASIBLE;
-        }
-
-        // update dual variables
-        u[curRow] += minVal;
-        for (intptr_t i = 0; i < nr; i++) {
-            if (SR[i] && i != curRow) {
-                u[i] += minVal - shortestPathCosts[col4row[i]];
-            }
-        }
+    std::vector<uint8_t> buffer(rectangular_lsap_workspace_size(nr, nc));
+    rectangular_lsap_workspace_t ws;
+    rectangular_lsap_workspace_init(&ws, buffer.data(), nr, nc);
 
-        for (intptr_t j = 0; j < nc; j++) {
-            if (SC[j]) {
-                v[j] -= minVal - shortestPathCosts[j];
-            }
-        }
-
-        // augment previous solution
-        intptr_t j = sink;
-        while (1) {
-            intptr_t i = path[j];
-            row4col[j] = i;
-            std::swap(col4row[i], j);
-            if (i == curRow) {
-                break;
-            }
-        }
+    int res = solve_preallocated(nr, nc, cost, &ws);
+    if (res != 0) {
+        return res;
     }
 
+    std::vector<intptr_t> col4row(ws.col4row, ws.col4row + nr);
     if (transpose) {
         intptr_t i = 0;
         for (auto v: argsort_iter(col4row)) {
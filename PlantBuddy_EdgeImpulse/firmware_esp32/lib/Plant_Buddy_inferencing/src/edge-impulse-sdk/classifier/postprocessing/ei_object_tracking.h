@@ -39,6 +39,7 @@
 #include "edge-impulse-sdk/dsp/numpy_types.h"
 #include "edge-impulse-sdk/dsp/returntypes.hpp"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 #include "edge-impulse-sdk/classifier/postprocessing/ei_postprocessing_common.h"
 #include "model-parameters/model_metadata.h"
@@ -55,12 +56,30 @@ float clip(float num, float min_val = -3.4028235e+38, float max_val = 3.4028235e
 
 #if EI_CLASSIFIER_OBJECT_TRACKING_ENABLED == 1
 
+// Maximum number of traces kept open at once, all traces come from a pool of this size
+#ifndef EI_CLASSIFIER_OBJECT_TRACKING_MAX_TRACES
+#define EI_CLASSIFIER_OBJECT_TRACKING_MAX_TRACES    16
+#endif // EI_CLASSIFIER_OBJECT_TRACKING_MAX_TRACES
+
+// Maximum number of detections considered per frame, any beyond this are dropped
+#ifndef EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS
+#define EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS    32
+#endif // EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS
+
+// Upper bound on max_observations, observations are kept in a ring of this size per trace
+#ifndef EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS
+#define EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS    8
+#endif // EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS
+
 typedef struct {
     float keep_grace;
 } ei_obj_tracking_params_t;
 
 class ExponentialMovingAverage {
 public:
+    ExponentialMovingAverage() : gain(0), ema_value(-255.0) {
+    }
+
     ExponentialMovingAverage(int n, float gain = 2) : gain(gain / (n + 1)), ema_value(-255.0) {
     }
 
@@ -72,7 +91,7 @@ public:
         }
     }
 
-    float smoothed_value() {
+    float smoothed_value() const {
         return ema_value;
     }
 
@@ -83,56 +102,62 @@ private:
 
 class Trace {
 public:
-    Trace(int id, int t, const ei_impulse_result_bounding_box_t& initial_bbox, uint32_t max_observations = 5)
-        : id(id), last_ground_truth_update_t(t), last_prediction(initial_bbox), max_observations(max_observations) {
+    Trace() : id(0), last_ground_truth_update_t(0), observations_start(0), observations_count(0) {
+    }
+
+    Trace(int id, int t, const ei_impulse_result_bounding_box_t& initial_bbox, uint32_t max_observations = 5) {
+        reset(id, t, initial_bbox, max_observations);
+    }
+
+    /**
+     * (Re)start this trace from a single detection, used when the trace is taken from the pool.
+     */
+    void reset(int id, int t, const ei_impulse_result_bounding_box_t& initial_bbox, uint32_t max_observations = 5) {
         if (max_observations < 2) {
             EI_LOGE("%s", "max_observations needs to be at least 2 for counting");
         }
 
+        this->id = id;
+        this->last_ground_truth_update_t = t;
+        this->last_prediction = initial_bbox;
+        this->max_observations = max_observations;
+
         trace_label = initial_bbox.label;
         trace_score = initial_bbox.value;
-        observations.push_back(initial_bbox);
+        observations_start = 0;
+        observations_count = 0;
+        push_observation(initial_bbox);
         float initial_centroid[2] = { initial_bbox.x + static_cast<float>(initial_bbox.width) / 2,
                                       initial_bbox.y + static_cast<float>(initial_bbox.height) / 2 };
 
         float initial_width_height[2] = { static_cast<float>(initial_bbox.width),
                                           static_cast<float>(initial_bbox.height) };
 
-        centroid_filter = new TinyEKF(initial_centroid, 8, 2);
-        width_height_filter = new TinyEKF(initial_width_height, 8, 2);
+        centroid_filter = TinyEKF(initial_centroid, 8, 2);
+        width_height_filter = TinyEKF(initial_width_height, 8, 2);
 
         // Use x0, y0, x1, y1 for EMAs
-        xyxy_emas[0] = new ExponentialMovingAverage(this->max_observations);
-        xyxy_emas[1] = new ExponentialMovingAverage(this->max_observations);
-        xyxy_emas[2] = new ExponentialMovingAverage(this->max_observations);
-        xyxy_emas[3] = new ExponentialMovingAverage(this->max_observations);
-    }
-
-    ~Trace() {
-        delete centroid_filter;
-        delete width_height_filter;
-        delete xyxy_emas[0];
-        delete xyxy_emas[1];
-        delete xyxy_emas[2];
-        delete xyxy_emas[3];
+        for (int i = 0; i < 4; i++) {
+            xyxy_emas[i] = ExponentialMovingAverage(this->max_observations);
+        }
     }
 
     ei_impulse_result_bounding_box_t predict() {
-        fx_centroid[0] = centroid_filter->x[0];
-        fx_centroid[1] = centroid_filter->x[1];
-        fx_width_height[0] = width_height_filter->x[0];
-        fx_width_height[1] = width_height_filter->x[1];
+        fx_centroid[0] = centroid_filter.x[0];
+        fx_centroid[1] = centroid_filter.x[1];
+        fx_width_height[0] = width_height_filter.x[0];
+        fx_width_height[1] = width_height_filter.x[1];
 
-        centroid_filter->predict(fx_centroid);
-        width_height_filter->predict(fx_width_height);
+        centroid_filter.predict(fx_centroid);
+        width_height_filter.predict(fx_width_height);
 
         ei_impulse_result_bounding_box_t p_bbox = {"", 0, 0, 0, 0, 0.0};
         p_bbox.label = trace_label;
         p_bbox.value = trace_score;
-        p_bbox.x = round(clip((centroid_filter->x[0] - width_height_filter->x[0] / 2), 0));
-        p_bbox.y = round(clip(centroid_filter->x[1] - width_height_filter->x[1] / 2, 0));
-        p_bbox.width = round(clip(width_height_filter->x[0], 0));
-        p_bbox.height = round(clip(width_height_filter->x[1], 0));
+        p_bbox.x = round(clip((centroid_filter.x[0] - width_height_filter.x[0] / 2), 0));
+        p_bbox.y = round(clip(centroid_filter.x[1] - width_height_filter.x[1] / 2, 0));
+        p_bbox.width = round(clip(width_height_filter.x[0], 0));
+        p_bbox.height = round(clip(width_height_filter.x[1], 0));
         last_prediction = p_bbox;
         EI_LOGD("predict %d %d %d %d %f\n", last_prediction.x, last_prediction.y, last_prediction.width, last_prediction.height, last_prediction.value);
         return last_prediction;
@@ -147,38 +172,41 @@ public:
             last_ground_truth_update_t = t;
         }
 
-        hx_centroid[0] = centroid_filter->x[0];
-        hx_centroid[1] = centroid_filter->x[1];
-        hx_width_height[0] = width_height_filter->x[0];
-        hx_width_height[1] = width_height_filter->x[1];
+        hx_centroid[0] = centroid_filter.x[0];
+        hx_centroid[1] = centroid_filter.x[1];
+        hx_width_height[0] = width_height_filter.x[0];
+        hx_width_height[1] = width_height_filter.x[1];
 
         float centroid[2] = { bbox->x + static_cast<float>(bbox->width) / 2,
                               bbox->y + static_cast<float>(bbox->height) / 2 };
-        centroid_filter->update(centroid , hx_centroid);
+        centroid_filter.update(centroid , hx_centroid);
 
         float width_height[2] = { static_cast<float>(bbox->width),
                                   static_cast<float>(bbox->height) };
-        width_height_filter->update(width_height, hx_width_height);
+        width_height_filter.update(width_height, hx_width_height);
 
         trace_score = bbox->value;
-        observations.push_back(*bbox);
-        while (observations.size() > max_observations) {
-            observations.erase(observations.begin());
+        push_observation(*bbox);
+        // always keep the newest observation, last_observation() is used for alignment
+        uint32_t keep = max_observations < 1 ? 1 : max_observations;
+        while (observations_count > keep) {
+            observations_start = (observations_start + 1) % EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS;
+            observations_count--;
         }
 
-        xyxy_emas[0]->update(bbox->x);
-        xyxy_emas[1]->update(bbox->y);
-        xyxy_emas[2]->update(bbox->width);
-        xyxy_emas[3]->update(bbox->height);
+        xyxy_emas[0].update(bbox->x);
+        xyxy_emas[1].update(bbox->y);
+        xyxy_emas[2].update(bbox->width);
+        xyxy_emas[3].update(bbox->height);
 
     }
 
     std::tuple<int, int, int, int> last_centroid_segment() const {
-        if (observations.size() < 2) {
+        if (observations_count < 2) {
             return {};
         }
-        auto obs_t_minus1 = observations[observations.size() - 2];
-        auto obs_t_0 = observations.back();
+        const ei_impulse_result_bounding_box_t &obs_t_minus1 = observation(observations_count - 2);
+        const ei_impulse_result_bounding_box_t &obs_t_0 = observation(observations_count - 1);
 
         return {obs_t_minus1.x + static_cast<float>(obs_t_minus1.width) / 2,
                 obs_t_minus1.y + static_cast<float>(obs_t_minus1.height) / 2,
@@ -187,22 +215,22 @@ public:
     }
 
     const ei_impulse_result_bounding_box_t* last_observation() const {
-        if (observations.empty()) {
+        if (observations_count == 0) {
             return nullptr;
         }
-        return &observations.back();
+        return &observation(observations_count - 1);
     }
 
     ei_impulse_result_bounding_box_t smoothed_last_observation() const {
         ei_impulse_result_bounding_box_t bbox = {"", 0, 0, 0, 0, 0.0};
-        if (observations.empty()) {
+        if (observations_count == 0) {
             return bbox;
         }
 
-        bbox.x = round(xyxy_emas[0]->smoothed_value());
-        bbox.y = round(xyxy_emas[1]->smoothed_value());
-        bbox.width = round(xyxy_emas[2]->smoothed_value());
-        bbox.height = round(xyxy_emas[3]->smoothed_value());
+        bbox.x = round(xyxy_emas[0].smoothed_value());
+        bbox.y = round(xyxy_emas[1].smoothed_value());
+        bbox.width = round(xyxy_emas[2].smoothed_value());
+        bbox.height = round(xyxy_emas[3].smoothed_value());
         bbox.label = trace_label;
         bbox.value = trace_score;
         return bbox;
@@ -215,7 +243,8 @@ public:
         ei_printf("  Last ground truth update: %d\n", last_ground_truth_update_t);
         ei_printf("  Last prediction: %d %d %d %d %f\n", last_prediction.x, last_prediction.y, last_prediction.width, last_prediction.height, last_prediction.value);
         ei_printf("  Observations:\n");
-        for (const auto& obs : observations) {
+        for (uint32_t i = 0; i < observations_count; i++) {
+            const ei_impulse_result_bounding_box_t &obs = observation(i);
             ei_printf("%d %d %d %d %f\n", obs.x, obs.y, obs.width, obs.height, obs.value);
         }
 #endif
@@ -226,9 +255,24 @@ public:
     ei_impulse_result_bounding_box_t last_prediction;
 
 private:
-    std::vector<ei_impulse_result_bounding_box_t> observations;
-    TinyEKF* centroid_filter;
-    TinyEKF* width_height_filter;
+    const ei_impulse_result_bounding_box_t& observation(uint32_t i) const {
+        return observations[(observations_start + i) % EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS];
+    }
+
+    void push_observation(const ei_impulse_result_bounding_box_t& bbox) {
+        if (observations_count == EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS) {
+            observations_start = (observations_start + 1) % EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS;
+            observations_count--;
+        }
+        observations[(observations_start + observations_count) % EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS] = bbox;
+        observations_count++;
+    }
+
+    ei_impulse_result_bounding_box_t observations[EI_CLASSIFIER_OBJECT_TRACKING_MAX_OBSERVATIONS];
+    uint32_t observations_start;
+    uint32_t observations_count;
+    TinyEKF centroid_filter;
+    TinyEKF width_height_filter;
     uint32_t max_observations;
     float fx_centroid[2];
     float fx_width_height[2];
@@ -236,129 +280,183 @@ private:
     float hx_width_height[2];
     const char* trace_label;
     float trace_score;
-    ExponentialMovingAverage *xyxy_emas[4];
+    ExponentialMovingAverage xyxy_emas[4];
 };
 
+/**
+ * Tracks detections across frames. All traces, detections and alignment scratch are
+ * held inline, so process_new_detections() does not allocate and its cost is bounded by
+ * EI_CLASSIFIER_OBJECT_TRACKING_MAX_TRACES x EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS.
+ */
 class Tracker {
 public:
-    Tracker (uint32_t keep_grace = 5, uint16_t max_observations = 5, float threshold = 0.5, bool use_iou = true)
-            : keep_grace(keep_grace),
+    static constexpr size_t max_traces = EI_CLASSIFIER_OBJECT_TRACKING_MAX_TRACES;
+    static constexpr size_t max_detections = EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS;
+
+    Tracker (uint32_t keep_grace = 5, uint16_t max_observations = 5, float threshold = 0.5, bool use_iou = true,
+             const char **categories = nullptr, uint16_t label_count = 0)
+            : open_traces_count(0),
+              object_tracking_output_count(0),
+              keep_grace(keep_grace),
               max_observations(max_observations),
-              alignment(threshold, use_iou) {
+              alignment(threshold, use_iou),
+              categories(categories),
+              label_count(label_count),
+              label_ranks(nullptr) {
         trace_seq_id = 0;
         t = 0;
+
+        for (size_t i = 0; i < max_traces; i++) {
+            free_traces[i] = &trace_pool[max_traces - 1 - i];
+        }
+        free_traces_count = max_traces;
+
+        // rank the labels once in strcmp order, so sorting detections compares integers
+        if (categories && label_count > 0) {
+            label_ranks = (uint16_t*)ei_malloc(label_count * sizeof(uint16_t));
+            if (label_ranks) {
+                for (uint16_t i = 0; i < label_count; i++) {
+                    uint16_t rank = 0;
+                    for (uint16_t j = 0; j < label_count; j++) {
+                        if (std::strcmp(categories[j], categories[i]) < 0) {
+                            rank++;
+                        }
+                    }
+                    label_ranks[i] = rank;
+                }
+            }
+        }
     }
 
     ~Tracker() {
-        for (auto trace : open_traces) {
-            delete trace;
-        }
-        for (auto trace : closed_traces) {
-            delete trace;
+        if (label_ranks) {
+            ei_free(label_ranks);
         }
     }
 
-    std::vector<Trace*>open_traces;
-    std::vector<Trace*>closed_traces;
-    std::vector<ei_object_tracking_trace_t> object_tracking_output;
+    Trace *open_traces[max_traces];
+    size_t open_traces_count;
+    ei_object_tracking_trace_t object_tracking_output[max_traces];
+    size_t object_tracking_output_count;
 
     /**
      * Process new detections.
-     * @param detections Bounding boxes, this vector might be reordered.
+     * @param input Bounding boxes, copied and sorted internally (only the first
+     *              EI_CLASSIFIER_OBJECT_TRACKING_MAX_DETECTIONS are used)
+     * @param input_count Number of bounding boxes
      */
-    void process_new_detections(std::vector<ei_impulse_result_bounding_box_t> detections) {
+    void process_new_detections(const ei_impulse_result_bounding_box_t *input, size_t input_count) {
+        if (input_count > max_detections) {
+            EI_LOGW("object tracking: %u detections, only the first %u are tracked\n",
+                (unsigned)input_count, (unsigned)max_detections);
+            input_count = max_detections;
+        }
+
         // sort detections by x, y, width, height, label (same in Python code, see ei_tracking/tracking.py)
         // so it doesn't matter in what order we pass in the detections
-        std::sort(detections.begin(), detections.end(), [](const ei_impulse_result_bounding_box_t& a, const ei_impulse_result_bounding_box_t& b) {
+        for (size_t i = 0; i < input_count; i++) {
+            detection_order[i] = i;
+            detection_label_ranks[i] = label_rank(input[i].label);
+        }
+        std::sort(detection_order, detection_order + input_count, [&](uint16_t ia, uint16_t ib) {
+            const ei_impulse_result_bounding_box_t& a = input[ia];
+            const ei_impulse_result_bounding_box_t& b = input[ib];
             if (a.x != b.x) return a.x < b.x;
             if (a.y != b.y) return a.y < b.y;
             if (a.width != b.width) return a.width < b.width;
             if (a.height != b.height) return a.height < b.height;
-            return std::strcmp(a.label, b.label) < 0;
+            int32_t ra = detection_label_ranks[ia];
+            int32_t rb = detection_label_ranks[ib];
+            if (ra < 0 || rb < 0) {
+                // label not from this impulse
+                int cmp = std::strcmp(a.label, b.label);
+                if (cmp != 0) return cmp < 0;
+            }
+            else if (ra != rb) {
+                return ra < rb;
+            }
+            return ia < ib;
         });
 
+        const size_t detections_count = input_count;
+        for (size_t i = 0; i < detections_count; i++) {
+            detections[i] = input[detection_order[i]];
+        }
+
         // firstly try an alignment with last observations...
-        std::vector<ei_impulse_result_bounding_box_t> last_obs_bboxes;
-        for (auto trace : open_traces) {
-            last_obs_bboxes.push_back(*trace->last_observation());
+        for (size_t i = 0; i < open_traces_count; i++) {
+            trace_bboxes[i] = *open_traces[i]->last_observation();
         }
 
-        std::vector<std::tuple<int, int, float>> last_obs_matches = alignment.align(last_obs_bboxes, detections);
+        size_t last_obs_matches_count = alignment.align(trace_bboxes, open_traces_count,
+            detections, detections_count, cost_mtx, lsap_workspace, last_obs_matches);
 
         float last_obs_cost = 0;
-        for (auto last_obs_match : last_obs_matches) {
-            EI_LOGD("last_obs_match %d %d %f\n", std::get<0>(last_obs_match), std::get<1>(last_obs_match), std::get<2>(last_obs_match));
-            last_obs_cost += std::get<2>(last_obs_match);
+        for (size_t i = 0; i < last_obs_matches_count; i++) {
+            EI_LOGD("last_obs_match %d %d %f\n", last_obs_matches[i].trace_idx, last_obs_matches[i].detection_idx, last_obs_matches[i].value);
+            last_obs_cost += last_obs_matches[i].value;
         }
         EI_LOGD("last_obs_cost %f\n", last_obs_cost);
 
         // ... then with the kalman filter predictions
-        std::vector<ei_impulse_result_bounding_box_t> predicted_bboxes;
-        for (auto trace : open_traces) {
-            predicted_bboxes.push_back(trace->predict());
+        for (size_t i = 0; i < open_traces_count; i++) {
+            Trace *trace = open_traces[i];
+            trace_bboxes[i] = trace->predict();
             EI_LOGD("predicted %d %d %d %d %f\n", trace->last_prediction.x, trace->last_prediction.y, trace->last_prediction.width, trace->last_prediction.height, trace->last_prediction.value);
         }
 
-        std::vector<std::tuple<int, int, float>> predicted_matches = alignment.align(predicted_bboxes, detections);
+        size_t predicted_matches_count = alignment.align(trace_bboxes, open_traces_count,
+            detections, detections_count, cost_mtx, lsap_workspace, predicted_matches);
+
         float predicted_cost = 0;
-        for (auto predicted_match : predicted_matches) {
-            EI_LOGD("predicted_match %d %d %f\n", std::get<0>(predicted_match), std::get<1>(predicted_match), std::get<2>(predicted_match));
-            predicted_cost += std::get<2>(predicted_match);
+        for (size_t i = 0; i < predicted_matches_count; i++) {
+            EI_LOGD("predicted_match %d %d %f\n", predicted_matches[i].trace_idx, predicted_matches[i].detection_idx, predicted_matches[i].value);
+            predicted_cost += predicted_matches[i].value;
         }
         EI_LOGD("predicted_cost %f\n", predicted_cost);
 
         // and use whichever matching set is better
-        std::vector<std::tuple<int, int, float>> matches;
+        const ei_alignment_match_t *matches;
+        size_t matches_count;
 
         if (last_obs_cost < predicted_cost) {
             EI_LOGD("using last_obs_matches matches\n");
             matches = last_obs_matches;
+            matches_count = last_obs_matches_count;
         }
         else {
             EI_LOGD("using predicted_matches matches\n");
             matches = predicted_matches;
+            matches_count = predicted_matches_count;
         }
 
         // assume all detections are unassigned and will becomes new tracks
-        // until we see otherwise ( i.e. they match an existing track )∂        //
-        std::set<uint16_t>unassigned_detection_idxs;
-        for (size_t i = 0; i < detections.size(); i++) {
-            unassigned_detection_idxs.insert(i);
-        }
-
-        // keep track of open traces idxs that haven't been updated
-        std::set<uint16_t>open_traces_idxs_to_be_updated;
-        for (size_t i = 0; i < open_traces.size(); i++) {
-            open_traces_idxs_to_be_updated.insert(i);
+        // until we see otherwise ( i.e. they match an existing track )
+        for (size_t i = 0; i < detections_count; i++) {
+            detection_assigned[i] = false;
         }
 
         // update existing traces with any matches
-        for (size_t i = 0; i < matches.size(); i++) {
-            uint32_t trace_idx = std::get<0>(matches[i]);
-            uint32_t detection_idx = std::get<1>(matches[i]);
-            EI_LOGD("t_idx=%u d_idx=%u iou=%.6f\n", trace_idx, detection_idx, std::get<2>(matches[i]));
-
-            Trace *trace = open_traces[trace_idx];
-            open_traces_idxs_to_be_updated.erase(trace_idx);
-            trace->update(t, &detections[detection_idx]);
-            unassigned_detection_idxs.erase(detection_idx);
-        }
+        for (size_t i = 0; i < matches_count; i++) {
+            uint32_t trace_idx = matches[i].trace_idx;
+            uint32_t detection_idx = matches[i].detection_idx;
+            EI_LOGD("t_idx=%u d_idx=%u iou=%.6f\n", trace_idx, detection_idx, matches[i].value);
 
-        for (auto detection_idx : unassigned_detection_idxs ) {
-            EI_LOGD("unassigned detection %d %d %d %d %d %f => starting new trace\n", detection_idx, detections[detection_idx].x, detections[detection_idx].y, detections[detection_idx].width, detections[detection_idx].height, detections[detection_idx].value);
-            open_traces.push_back(new Trace(trace_seq_id, t, detections[detection_idx], max_observations));
-            trace_seq_id += 1;
+            open_traces[trace_idx]->update(t, &detections[detection_idx]);
+            detection_assigned[detection_idx] = true;
         }
 
-        std::vector<Trace*>traces_tmp;
-
-        for (auto trace : open_traces) {
+        // compact the open traces in place, closed ones go back to the pool. New traces are
+        // never closed on their first step, so closing first frees their pool slots up front
+        size_t kept = 0;
+        for (size_t i = 0; i < open_traces_count; i++) {
+            Trace *trace = open_traces[i];
             EI_LOGD("grace checking trace %d at t=%d (trace.last_ground_truth_update_t=%d)\n", trace->id, t, trace->last_ground_truth_update_t);
             uint32_t time_since_last_update = t - trace->last_ground_truth_update_t;
             if (time_since_last_update > keep_grace) {
                 // been too long since last update, close it
                 EI_LOGD("closing trace %d\n", trace->id);
-                closed_traces.push_back(trace);
+                free_traces[free_traces_count++] = trace;
             }
             else {
                 if (trace->last_ground_truth_update_t != t) {
@@ -367,15 +465,30 @@ public:
                     trace->update(t, nullptr);
                 }
                 EI_LOGD("trace %d still alive\n", trace->id);
-                traces_tmp.push_back(trace);
+                open_traces[kept++] = trace;
             }
         }
+        open_traces_count = kept;
 
-        open_traces = traces_tmp;
-        object_tracking_output.clear();
+        for (size_t detection_idx = 0; detection_idx < detections_count; detection_idx++) {
+            if (detection_assigned[detection_idx]) {
+                continue;
+            }
+            if (free_traces_count == 0) {
+                EI_LOGW("object tracking: all %u traces in use, not tracking new detection\n", (unsigned)max_traces);
+                break;
+            }
+            EI_LOGD("unassigned detection %d %d %d %d %d %f => starting new trace\n", (int)detection_idx, detections[detection_idx].x, detections[detection_idx].y, detections[detection_idx].width, detections[detection_idx].height, detections[detection_idx].value);
+            Trace *trace = free_traces[--free_traces_count];
+            trace->reset(trace_seq_id, t, detections[detection_idx], max_observations);
+            open_traces[open_traces_count++] = trace;
+            trace_seq_id += 1;
+        }
 
-        for (auto trace : open_traces) {
-            ei_object_tracking_trace_t trace_result = { 0 };
+        for (size_t i = 0; i < open_traces_count; i++) {
+            const Trace *trace = open_traces[i];
+            ei_object_tracking_trace_t &trace_result = object_tracking_output[i];
+            trace_result = { 0 };
             trace_result.id = trace->id;
             trace_result.last_ground_truth_update_t = trace->last_ground_truth_update_t;
             trace_result.label = trace->last_prediction.label;
@@ -384,12 +497,19 @@ public:
             trace_result.width = trace->last_prediction.width;
             trace_result.height = trace->last_prediction.height;
             trace_result.last_centroid_segment = trace->last_centroid_segment();
-
-            object_tracking_output.push_back(trace_result);
         }
+        object_tracking_output_count = open_traces_count;
         t += 1;
     }
 
+    /**
+     * Process new detections.
+     * @param detections Bounding boxes
+     */
+    void process_new_detections(const std::vector<ei_impulse_result_bounding_box_t> &detections) {
+        process_new_detections(detections.data(), detections.size());
+    }
+
     void set_threshold(float threshold) {
         alignment.threshold = threshold;
     }
@@ -401,22 +521,64 @@ public:
     uint32_t keep_grace;
     uint16_t max_observations;
 private:
+    /**
+     * Rank of the label in strcmp order, or -1 if the label is not one of the impulse categories.
+     */
+    int32_t label_rank(const char *label) const {
+        if (!label_ranks) {
+            return -1;
+        }
+        for (uint16_t i = 0; i < label_count; i++) {
+            if (categories[i] == label) {
+                return label_ranks[i];
+            }
+        }
+        for (uint16_t i = 0; i < label_count; i++) {
+            if (std::strcmp(categories[i], label) == 0) {
+                return label_ranks[i];
+            }
+        }
+        return -1;
+    }
+
+    static constexpr size_t max_matches = max_traces < max_detections ? max_traces : max_detections;
+    static constexpr size_t lsap_workspace_bytes = rectangular_lsap_workspace_size(
+        max_matches, max_traces < max_detections ? max_detections : max_traces);
+
     uint32_t trace_seq_id;
     uint32_t t;
     JonkerVolgenantAlignment alignment;
-    std::vector<std::string> seen_labels;
+    const char **categories;
+    uint16_t label_count;
+    uint16_t *label_ranks;
+
+    Trace trace_pool[max_traces];
+    Trace *free_traces[max_traces];
+    size_t free_traces_count;
+
+    ei_impulse_result_bounding_box_t detections[max_detections];
+    uint16_t detection_order[max_detections];
+    int32_t detection_label_ranks[max_detections];
+    bool detection_assigned[max_detections];
+    ei_impulse_result_bounding_box_t trace_bboxes[max_traces];
+    double cost_mtx[max_traces * max_detections];
+    double lsap_workspace[(lsap_workspace_bytes + sizeof(double) - 1) / sizeof(double)];
+    ei_alignment_match_t last_obs_matches[max_matches];
+    ei_alignment_match_t predicted_matches[max_matches];
 };
 
 EI_IMPULSE_ERROR init_object_tracking(ei_impulse_handle_t *handle, void** state, void *config)
 {
-    //const ei_impulse_t *impulse = handle->impulse;
+    const ei_impulse_t *impulse = handle->impulse;
     const ei_object_tracking_config_t *ei_object_tracking_config = (ei_object_tracking_config_t*)config;
 
     // Allocate the object counter
     Tracker *object_tracker = new Tracker(ei_object_tracking_config->keep_grace,
                                           ei_object_tracking_config->max_observations,
                                           ei_object_tracking_config->threshold,
-                                          ei_object_tracking_config->use_iou);
+                                          ei_object_tracking_config->use_iou,
+                                          impulse->categories,
+                                          impulse->label_count);
     if (!object_tracker) {
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
@@ -448,14 +610,10 @@ EI_IMPULSE_ERROR process_object_tracking(ei_impulse_handle_t *handle,
     Tracker *object_tracker = (Tracker *)state;
 
     if((void *)object_tracker != NULL) {
-        ei_impulse_result_bounding_box_t *bbs = result->bounding_boxes;
-        uint32_t bbs_num = result->bounding_boxes_count;
-        std::vector<ei_impulse_result_bounding_box_t> detections(bbs, bbs + bbs_num);
-
-        object_tracker->process_new_detections(detections);
+        object_tracker->process_new_detections(result->bounding_boxes, result->bounding_boxes_count);
 
-        result->postprocessed_output.object_tracking_output.open_traces = object_tracker->object_tracking_output.data();
-        result->postprocessed_output.object_tracking_output.open_traces_count = object_tracker->object_tracking_output.size();
+        result->postprocessed_output.object_tracking_output.open_traces = object_tracker->object_tracking_output;
+        result->postprocessed_output.object_tracking_output.open_traces_count = object_tracker->object_tracking_output_count;
     }
     else {
         EI_LOGW("process_object_tracking: object_tracker is NULL, did you forget to call run_classifier_init()?\n");
@@ -36,6 +36,9 @@
 #define EI_POSTPROCESSING_H
 
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_alloc_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
 
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
 #include "edge-impulse-sdk/classifier/postprocessing/ei_performance_calibration.h"
@@ -106,12 +109,15 @@ extern "C" EI_IMPULSE_ERROR run_postprocessing(ei_impulse_handle_t *handle,
     }
     auto impulse = handle->impulse;
 
+    EI_PROFILE_STAGE(POSTPROCESSING, "postprocessing");
+
     for (size_t ix = 0; ix < impulse->postprocessing_blocks_size; ix++) {
         void* state = NULL;
         if (handle->post_processing_state != NULL) {
             state = handle->post_processing_state[ix];
         }
 
+        EI_PROFILE_OPS_SCOPE("postprocessing_block");
         EI_IMPULSE_ERROR res = impulse->postprocessing_blocks[ix].postprocess_fn(handle,
                                                                                 ix,
                                                                                 impulse->postprocessing_blocks[ix].input_block_id,
@@ -2014,37 +2014,35 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_yolo_pro_comm
     size_t row_count = output_features_count / col_size;
 
     static std::vector<ei_impulse_result_bounding_box_t> results;
-    static std::vector<ei_impulse_result_bounding_box_t> class_results;
     results.clear();
 
-    // (xmin, ymin, xmax, ymax, cls...)
-    for (size_t cls_idx = 0; cls_idx < (size_t)impulse->label_count; cls_idx++)  {
-
-        std::vector<float> boxes;
-        std::vector<float> scores;
-        std::vector<int> classes;
-        class_results.clear();
-
+    std::vector<float> boxes;
+    std::vector<float> scores;
+    std::vector<int> classes;
 
-        for (size_t ix = 0; ix < row_count; ix++) {
-            size_t base_ix = ix * col_size;
-            float xmin  = (static_cast<float>(data[base_ix + 0]) - zero_point) * scale;
-            float ymin  = (static_cast<float>(data[base_ix + 1]) - zero_point) * scale;
-            float xmax  = (static_cast<float>(data[base_ix + 2]) - zero_point) * scale;
-            float ymax  = (static_cast<float>(data[base_ix + 3]) - zero_point) * scale;
+    // (xmin, ymin, xmax, ymax, cls...)
+    // one pass over the rows, all classes go through a single class-batched NMS
+    for (size_t ix = 0; ix < row_count; ix++) {
+        size_t base_ix = ix * col_size;
+        float xmin  = (static_cast<float>(data[base_ix + 0]) - zero_point) * scale;
+        float ymin  = (static_cast<float>(data[base_ix + 1]) - zero_point) * scale;
+        float xmax  = (static_cast<float>(data[base_ix + 2]) - zero_point) * scale;
+        float ymax  = (static_cast<float>(data[base_ix + 3]) - zero_point) * scale;
+
+        if (xmin < 0) xmin = 0;
+        if (xmin > 1) xmin = 1;
+        if (ymin < 0) ymin = 0;
+        if (ymin > 1) ymin = 1;
+        if (ymax < 0) ymax = 0;
+        if (ymax > 1) ymax = 1;
+        if (xmax < 0) xmax = 0;
+        if (xmax > 1) xmax = 1;
+        if (xmax < xmin) xmax = xmin;
+        if (ymax < ymin) ymax = ymin;
+
+        for (size_t cls_idx = 0; cls_idx < (size_t)impulse->label_count; cls_idx++)  {
             float score = (static_cast<float>(data[base_ix + 4 + cls_idx]) - zero_point) * scale;
 
-            if (xmin < 0) xmin = 0;
-            if (xmin > 1) xmin = 1;
-            if (ymin < 0) ymin = 0;
-            if (ymin > 1) ymin = 1;
-            if (ymax < 0) ymax = 0;
-            if (ymax > 1) ymax = 1;
-            if (xmax < 0) xmax = 0;
-            if (xmax > 1) xmax = 1;
-            if (xmax < xmin) xmax = xmin;
-            if (ymax < ymin) ymax = ymin;
-
 #if EI_LOG_LEVEL == EI_LOG_LEVEL_DEBUG
                 ei_printf("%s (", impulse->categories[(uint32_t)cls_idx]);
                 ei_printf_float(cls_idx);
@@ -2062,38 +2060,28 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_yolo_pro_comm
 #endif
 
             if (score >= threshold && score <= 1.0f) {
-                ymin *= static_cast<float>(impulse->input_height);
-                xmin *= static_cast<float>(impulse->input_width);
-                ymax *= static_cast<float>(impulse->input_height);
-                xmax *= static_cast<float>(impulse->input_width);
-
-                boxes.push_back(ymin);
-                boxes.push_back(xmin);
-                boxes.push_back(ymax);
-                boxes.push_back(xmax);
+                boxes.push_back(ymin * static_cast<float>(impulse->input_height));
+                boxes.push_back(xmin * static_cast<float>(impulse->input_width));
+                boxes.push_back(ymax * static_cast<float>(impulse->input_height));
+                boxes.push_back(xmax * static_cast<float>(impulse->input_width));
                 scores.push_back(score);
                 classes.push_back((int)cls_idx);
             }
         }
+    }
 
-        size_t nr_boxes = scores.size();
-
-        EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse,
-                                            &class_results,
-                                            boxes.data(),
-                                            scores.data(),
-                                            classes.data(),
-                                            nr_boxes,
-                                            true /*clip_boxes*/,
-                                            &nms_config);
-
-        if (nms_res != EI_IMPULSE_OK) {
-            return nms_res;
-        }
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse,
+                                          &results,
+                                          boxes.data(),
+                                          scores.data(),
+                                          classes.data(),
+                                          scores.size(),
+                                          true /*clip_boxes*/,
+                                          &nms_config,
+                                          true /*class_batched*/);
 
-        for (auto bb: class_results) {
-            results.push_back(bb);
-        }
+    if (nms_res != EI_IMPULSE_OK) {
+        return nms_res;
     }
 
     prepare_nms_results_common(object_detection_count, result, &results);
@@ -2182,63 +2170,62 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_yolov11_commo
     size_t col_size = output_features_count / row_count;
 
     static std::vector<ei_impulse_result_bounding_box_t> results;
-    static std::vector<ei_impulse_result_bounding_box_t> class_results;
     results.clear();
 
+    std::vector<float> boxes;
+    std::vector<float> scores;
+    std::vector<int> classes;
+
     // output shape: (num_classes + 4, num_detections) e.g. (5, 189)
     //  [0] -> (xcenter, ycenter, width, height, cls...)
-    for (size_t cls_idx = 0; cls_idx < (size_t)impulse->label_count; cls_idx++)  {
-        std::vector<float> boxes;
-        std::vector<float> scores;
-        std::vector<int> classes;
-        class_results.clear();
+    // one pass over the detections, all classes go through a single class-batched NMS
+    for (size_t det_idx = 0; det_idx < col_size; det_idx++) {
 
-        for (size_t det_idx = 0; det_idx < col_size; det_idx++) {
+        float xcenter = (static_cast<float>(data[0 * col_size + det_idx]) - zero_point) * scale;
+        float ycenter = (static_cast<float>(data[1 * col_size + det_idx]) - zero_point) * scale;
+        float width   = (static_cast<float>(data[2 * col_size + det_idx]) - zero_point) * scale;
+        float height  = (static_cast<float>(data[3 * col_size + det_idx]) - zero_point) * scale;
 
-            float xcenter = (static_cast<float>(data[0 * col_size + det_idx]) - zero_point) * scale;
-            float ycenter = (static_cast<float>(data[1 * col_size + det_idx]) - zero_point) * scale;
-            float width   = (static_cast<float>(data[2 * col_size + det_idx]) - zero_point) * scale;
-            float height  = (static_cast<float>(data[3 * col_size + det_idx]) - zero_point) * scale;
+        // xywh -> xyxy
+        float xmin  = xcenter - (width / 2.0f);
+        float ymin  = ycenter - (height / 2.0f);
+        float xmax  = xcenter + (width / 2.0f);
+        float ymax  = ycenter + (height / 2.0f);
 
-            // xywh -> xyxy
-            float xmin  = xcenter - (width / 2.0f);
-            float ymin  = ycenter - (height / 2.0f);
-            float xmax  = xcenter + (width / 2.0f);
-            float ymax  = ycenter + (height / 2.0f);
-
-            if (is_coord_normalized) {
-                ymin *= static_cast<float>(impulse->input_height);
-                xmin *= static_cast<float>(impulse->input_width);
-                ymax *= static_cast<float>(impulse->input_height);
-                xmax *= static_cast<float>(impulse->input_width);
-            }
+        if (is_coord_normalized) {
+            ymin *= static_cast<float>(impulse->input_height);
+            xmin *= static_cast<float>(impulse->input_width);
+            ymax *= static_cast<float>(impulse->input_height);
+            xmax *= static_cast<float>(impulse->input_width);
+        }
 
-            if (xmin < 0) {
-                xmin = 0;
-            }
-            if (xmin > impulse->input_width) {
-                xmin = impulse->input_width;
-            }
-            if (ymin < 0) {
-                ymin = 0;
-            }
-            if (ymin > impulse->input_height) {
-                ymin = impulse->input_height;
-            }
+        if (xmin < 0) {
+            xmin = 0;
+        }
+        if (xmin > impulse->input_width) {
+            xmin = impulse->input_width;
+        }
+        if (ymin < 0) {
+            ymin = 0;
+        }
+        if (ymin > impulse->input_height) {
+            ymin = impulse->input_height;
+        }
 
-            if (xmax < 0) {
-                xmax = 0;
-            }
-            if (xmax > impulse->input_width) {
-                xmax = impulse->input_width;
-            }
-            if (ymax < 0) {
-                ymax = 0;
-            }
-            if (ymax > impulse->input_height) {
-                ymax = impulse->input_height;
-            }
+        if (xmax < 0) {
+            xmax = 0;
+        }
+        if (xmax > impulse->input_width) {
+            xmax = impulse->input_width;
+        }
+        if (ymax < 0) {
+            ymax = 0;
+        }
+        if (ymax > impulse->input_height) {
+            ymax = impulse->input_height;
+        }
 
+        for (size_t cls_idx = 0; cls_idx < (size_t)impulse->label_count; cls_idx++)  {
             float score = (static_cast<float>(data[(4+cls_idx) * col_size + det_idx]) - zero_point) * scale;
 
 #if EI_LOG_LEVEL == EI_LOG_LEVEL_DEBUG
@@ -2266,25 +2253,20 @@ __attribute__((unused)) static EI_IMPULSE_ERROR fill_result_struct_yolov11_commo
                 classes.push_back((int)cls_idx);
             }
         }
+    }
 
-        size_t nr_boxes = scores.size();
-
-        EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse,
-                                            &class_results,
-                                            boxes.data(),
-                                            scores.data(),
-                                            classes.data(),
-                                            nr_boxes,
-                                            true /*clip_boxes*/,
-                                            &nms_config);
+    EI_IMPULSE_ERROR nms_res = ei_run_nms(impulse,
+                                          &results,
+                                          boxes.data(),
+                                          scores.data(),
+                                          classes.data(),
+                                          scores.size(),
+                                          true /*clip_boxes*/,
+                                          &nms_config,
+                                          true /*class_batched*/);
 
-        if (nms_res != EI_IMPULSE_OK) {
-            return nms_res;
-        }
-
-        for (auto bb: class_results) {
-            results.push_back(bb);
-        }
+    if (nms_res != EI_IMPULSE_OK) {
+        return nms_res;
     }
 
     prepare_nms_results_common(object_detection_count, result, &results);
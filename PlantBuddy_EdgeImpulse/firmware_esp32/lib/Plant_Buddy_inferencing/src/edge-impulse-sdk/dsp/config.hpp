@@ -87,7 +87,7 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
-// prints buffer allocations to stdout, useful when debugging
+// prints buffer allocations to stdout and feeds the allocation profiler (ei_alloc_profiler.h)
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
 #endif // EIDSP_TRACK_ALLOCATIONS
@@ -109,5 +109,10 @@
 #define EIDSP_USE_ESP_DSP 0
 #endif
 #endif
+
+// Vectorized 1-D kernels for the non-CMSIS numpy paths, see dsp_engines/ei_simd_kernels.h
+#ifndef EIDSP_USE_SIMD_KERNELS
+#define EIDSP_USE_SIMD_KERNELS 1
+#endif // EIDSP_USE_SIMD_KERNELS
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
@@ -7,8 +7,11 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <math.h>
+#include <atomic>
 #include "edge-impulse-sdk/porting/espressif/esp-dsp/modules/fft/include/dsps_fft2r.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
 
 namespace ei {
 namespace fft {
@@ -16,7 +19,19 @@ namespace fft {
 constexpr int MIN_FFT_SIZE = 4;
 constexpr int MAX_FFT_SIZE = 4096;
 
-static bool init_done = false;
+enum {
+    ESP_FFT_NOT_INITIALIZED = 0,
+    ESP_FFT_INITIALIZING,
+    ESP_FFT_READY,
+    ESP_FFT_FAILED
+};
+
+// Below this size the split rfft isn't worth a call into ESP-DSP, the DFT is computed directly
+constexpr size_t MIN_SPLIT_FFT_SIZE = 16;
+
+// dsps_fft2r_init_fc32 sets up one twiddle table for every size up to
+// CONFIG_DSP_MAX_FFT_SIZE, so it only runs once, whatever n_fft asked first.
+static std::atomic<int> init_state(ESP_FFT_NOT_INITIALIZED);
 
 static bool can_do_fft(size_t n_fft) {
     // if power of 2 and within range
@@ -24,68 +39,116 @@ static bool can_do_fft(size_t n_fft) {
         return false;
     if ((n_fft & (n_fft - 1)) != 0)
         return false; // not a power of 2
+    // a real FFT of n_fft points runs as a complex FFT of n_fft / 2 points
+    if (n_fft / 2 > CONFIG_DSP_MAX_FFT_SIZE)
+        return false;
     return true;
 }
 
-static bool init_fft(size_t n_fft) {
-    if (init_done) {
-        return true; // Already initialized
+static bool init_fft(void) {
+    int state = init_state.load(std::memory_order_acquire);
+    if (state == ESP_FFT_READY) {
+        return true;
+    }
+    if (state != ESP_FFT_NOT_INITIALIZED ||
+            !init_state.compare_exchange_strong(state, ESP_FFT_INITIALIZING, std::memory_order_acq_rel)) {
+        // failed before, or another thread is initializing right now; use the SW FFT for this call
+        return false;
     }
-    EI_LOGD("Initializing ESP-DSP FFT with size %zu\n", n_fft);
-    if (!can_do_fft(n_fft)) { return false; /* EIDSP_FFT_SIZE_NOT_SUPPORTED */ }
 
+    EI_LOGD("Initializing ESP-DSP FFT with size %d\n", (int)CONFIG_DSP_MAX_FFT_SIZE);
     esp_err_t ret = dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
     if (ret != ESP_OK) {
         EI_LOGE("Not possible to initialize FFT. Error = %i\n", ret);
+        init_state.store(ESP_FFT_FAILED, std::memory_order_release);
         return false;
     }
+    init_state.store(ESP_FFT_READY, std::memory_order_release);
     return true;
 }
 
-static int hw_r2c_fft(const float *input, ei::fft_complex_t *output_as_complex, size_t n_fft) {
-    if (!init_done) {
-        if (!init_fft(n_fft)) {
-            EI_LOGE("Failed to initialize FFT\n");
-            return -1; // EIDSP_FFT_INIT_FAILED
-        }
-        init_done = true;
+/**
+ * Real-input FFT of n_fft points, computed as a complex FFT of n_fft / 2 points
+ * over the even/odd samples followed by a split step, so no complex copy of the
+ * input is needed.
+ * @param input n_fft real samples, overwritten (used as the complex work buffer)
+ * @param output_as_complex n_fft / 2 + 1 bins
+ * @param n_fft FFT size
+ * @param twiddles (cos, sin) of 2*pi*k/n_fft for k < n_fft / 2, e.g. from a cached
+ *  FFT plan. When nullptr they are computed on the fly.
+ * @returns 0 if OK
+ */
+static int hw_r2c_fft(float *input, ei::fft_complex_t *output_as_complex, size_t n_fft,
+    const float *twiddles = nullptr)
+{
+    if (!can_do_fft(n_fft)) {
+        return EIDSP_FFT_SIZE_NOT_SUPPORTED;
     }
-    // ESP-DSP expects input/output as float arrays, length must be power of 2
-    float *in = const_cast<float *>(input);
-    float *output = (float*)output_as_complex;
-    int err = 0;
-
-    // Prepare input as complex numbers (real part, imaginary part)
-    float *complex_input = (float*)ei_malloc(n_fft * sizeof(float) * 2);
-    if (complex_input == nullptr) {
-        EI_LOGE("Failed to allocate memory for complex input\n");
-        goto out;
-        return -1; // EIDSP_MEMORY_ALLOC_FAILED
+    if (n_fft < MIN_SPLIT_FFT_SIZE) {
+        for (size_t k = 0; k <= n_fft / 2; k++) {
+            float re = 0.0f, im = 0.0f;
+            for (size_t n = 0; n < n_fft; n++) {
+                float phase = 2.0f * (float)M_PI * (float)((k * n) % n_fft) / (float)n_fft;
+                re += input[n] * cosf(phase);
+                im -= input[n] * sinf(phase);
+            }
+            output_as_complex[k].r = re;
+            output_as_complex[k].i = im;
+        }
+        return EIDSP_OK;
     }
-
-    for (size_t i = 0; i < n_fft; i++) {
-        complex_input[i * 2 + 0] = in[i]; // Real part
-        complex_input[i * 2 + 1] = 0.0f; // Imaginary part
+    if (!init_fft()) {
+        return EIDSP_NO_HW_ACCEL;
     }
 
-    err = dsps_fft2r_fc32(complex_input, n_fft);
+    // Consecutive (even, odd) sample pairs are read as one complex value: z[m] = x[2m] + j*x[2m+1]
+    const size_t half = n_fft / 2;
+    int err = dsps_fft2r_fc32(input, half);
     if (err != 0) {
         EI_LOGE("Error in dsps_fft2r_fc32: %d\n", err);
-        return err;
+        return EIDSP_NO_HW_ACCEL;
     }
-    // Rearrange output if needed (ESP-DSP uses bit-reversed order)
-    dsps_bit_rev_fc32(complex_input, n_fft);
+    // ESP-DSP leaves the output in bit-reversed order
+    dsps_bit_rev_fc32(input, half);
 
-    // Copy result to output
-    for (size_t i = 0; i < n_fft + 2; i++) {
-        output[i] = complex_input[i];
+    // Split Z into the spectra of the even (E) and odd (O) samples, then X[k] = E[k] + W^k * O[k]
+    const ei::fft_complex_t *z = (const ei::fft_complex_t *)input;
+    ei::fft_complex_t *x = output_as_complex;
+
+    x[0].r = z[0].r + z[0].i;
+    x[0].i = 0.0f;
+    x[half].r = z[0].r - z[0].i;
+    x[half].i = 0.0f;
+
+    for (size_t k = 1; k < half; k++) {
+        const ei::fft_complex_t a = z[k];
+        const ei::fft_complex_t b = z[half - k];
+
+        float even_r = 0.5f * (a.r + b.r);
+        float even_i = 0.5f * (a.i - b.i);
+        float odd_r = 0.5f * (a.i + b.i);
+        float odd_i = -0.5f * (a.r - b.r);
+
+        float c, s;
+        if (twiddles) {
+            c = twiddles[2 * k + 0];
+            s = twiddles[2 * k + 1];
+        }
+        else {
+            float phase = 2.0f * (float)M_PI * (float)k / (float)n_fft;
+            c = cosf(phase);
+            s = sinf(phase);
+        }
+
+        // W^k = exp(-j * 2 * pi * k / n_fft) = c - j*s
+        x[k].r = even_r + c * odd_r + s * odd_i;
+        x[k].i = even_i + c * odd_i - s * odd_r;
     }
-out:
-    ei_free(complex_input);
-    return 0;
+
+    return EIDSP_OK;
 }
 
 } // namespace fft
 } // namespace ei
 
-#endif // EI_ESP_DSP_H
\ No newline at end of file
+#endif // EI_ESP_DSP_H
@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SIMD_KERNELS_H_
+#define _EIDSP_SIMD_KERNELS_H_
+
+/**
+ * 1-D float kernels used by the non-CMSIS code paths in numpy.hpp.
+ *
+ * The backend is picked at compile time from the target's predefines:
+ *  - AVX2 (__AVX2__), 8 lanes
+ *  - SSE (__SSE2__, always available on x86-64), 4 lanes
+ *  - NEON (__ARM_NEON, e.g. Linux gateways on Cortex-A), 4 lanes
+ *  - scalar, unrolled over 4 independent accumulators. This is also the path
+ *    used on ESP32 / ESP32-S3: their FPU is scalar (the S3 PIE extension is
+ *    integer-only), so breaking the dependency chain on the accumulator is
+ *    what keeps the FPU pipeline busy.
+ *
+ * Elementwise kernels (scale, offset, axpy) are bit-exact with the scalar
+ * loops they replace (except for denormals on 32-bit Arm, where NEON flushes
+ * them to zero). Reductions (sum, dot, sum_squares, sum_squared_diff,
+ * squared_distance) add in a different order and thus match within normal
+ * float tolerance.
+ * min/max ignore NaN inputs, like the original `v < min` loops.
+ * lerp_u8 (the vertical step of the image resizer) is exact integer math.
+ *
+ * Define EIDSP_SIMD_BACKEND to one of the EIDSP_SIMD_BACKEND_* values to force
+ * a backend, or set EIDSP_USE_SIMD_KERNELS to 0 to get the plain scalar loops.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <cfloat>
+#include "edge-impulse-sdk/dsp/config.hpp"
+
+#define EIDSP_SIMD_BACKEND_NONE     0
+#define EIDSP_SIMD_BACKEND_UNROLLED 1
+#define EIDSP_SIMD_BACKEND_SSE      2
+#define EIDSP_SIMD_BACKEND_AVX2     3
+#define EIDSP_SIMD_BACKEND_NEON     4
+
+#ifndef EIDSP_SIMD_BACKEND
+#if EIDSP_USE_SIMD_KERNELS == 0
+#define EIDSP_SIMD_BACKEND          EIDSP_SIMD_BACKEND_NONE
+#elif defined(__AVX2__)
+#define EIDSP_SIMD_BACKEND          EIDSP_SIMD_BACKEND_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EIDSP_SIMD_BACKEND          EIDSP_SIMD_BACKEND_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define EIDSP_SIMD_BACKEND          EIDSP_SIMD_BACKEND_NEON
+#else
+#define EIDSP_SIMD_BACKEND          EIDSP_SIMD_BACKEND_UNROLLED
+#endif
+#endif // EIDSP_SIMD_BACKEND
+
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+#include <immintrin.h>
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+#include <emmintrin.h>
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ei {
+
+namespace simd {
+
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE || EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+static inline float hsum_ps(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+static inline float hmin_ps(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(v);
+}
+
+static inline float hmax_ps(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+static inline __m128 fold_ps(__m256 v) {
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+#endif
+
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+static inline float hsum_f32x4(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t r = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(r, r), 0);
+#endif
+}
+#endif
+
+/**
+ * Sum of all elements
+ */
+static inline float sum(const float *x, size_t n) {
+    size_t ix = 0;
+    float res = 0.0f;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; ix + 16 <= n; ix += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + ix));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(x + ix + 8));
+    }
+    res = hsum_ps(fold_ps(_mm256_add_ps(acc0, acc1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; ix + 8 <= n; ix += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_loadu_ps(x + ix));
+        acc1 = _mm_add_ps(acc1, _mm_loadu_ps(x + ix + 4));
+    }
+    res = hsum_ps(_mm_add_ps(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; ix + 8 <= n; ix += 8) {
+        acc0 = vaddq_f32(acc0, vld1q_f32(x + ix));
+        acc1 = vaddq_f32(acc1, vld1q_f32(x + ix + 4));
+    }
+    res = hsum_f32x4(vaddq_f32(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_UNROLLED
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    for (; ix + 4 <= n; ix += 4) {
+        acc0 += x[ix];
+        acc1 += x[ix + 1];
+        acc2 += x[ix + 2];
+        acc3 += x[ix + 3];
+    }
+    res = (acc0 + acc1) + (acc2 + acc3);
+#endif
+    for (; ix < n; ix++) {
+        res += x[ix];
+    }
+    return res;
+}
+
+/**
+ * Dot product of two vectors
+ */
+static inline float dot(const float *x, const float *y, size_t n) {
+    size_t ix = 0;
+    float res = 0.0f;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; ix + 16 <= n; ix += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + ix), _mm256_loadu_ps(y + ix)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(x + ix + 8), _mm256_loadu_ps(y + ix + 8)));
+    }
+    res = hsum_ps(fold_ps(_mm256_add_ps(acc0, acc1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; ix + 8 <= n; ix += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + ix), _mm_loadu_ps(y + ix)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + ix + 4), _mm_loadu_ps(y + ix + 4)));
+    }
+    res = hsum_ps(_mm_add_ps(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; ix + 8 <= n; ix += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(x + ix), vld1q_f32(y + ix));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(x + ix + 4), vld1q_f32(y + ix + 4));
+    }
+    res = hsum_f32x4(vaddq_f32(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_UNROLLED
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    for (; ix + 4 <= n; ix += 4) {
+        acc0 += x[ix] * y[ix];
+        acc1 += x[ix + 1] * y[ix + 1];
+        acc2 += x[ix + 2] * y[ix + 2];
+        acc3 += x[ix + 3] * y[ix + 3];
+    }
+    res = (acc0 + acc1) + (acc2 + acc3);
+#endif
+    for (; ix < n; ix++) {
+        res += x[ix] * y[ix];
+    }
+    return res;
+}
+
+/**
+ * Sum of squares, sum(x[i] * x[i])
+ */
+static inline float sum_squares(const float *x, size_t n) {
+    return dot(x, x, n);
+}
+
+/**
+ * Sum of squared differences from a constant, sum((x[i] - mean)^2)
+ */
+static inline float sum_squared_diff(const float *x, size_t n, float mean) {
+    size_t ix = 0;
+    float res = 0.0f;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    const __m256 m = _mm256_set1_ps(mean);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; ix + 16 <= n; ix += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + ix), m);
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(x + ix + 8), m);
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    res = hsum_ps(fold_ps(_mm256_add_ps(acc0, acc1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    const __m128 m = _mm_set1_ps(mean);
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; ix + 8 <= n; ix += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(x + ix), m);
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(x + ix + 4), m);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+    }
+    res = hsum_ps(_mm_add_ps(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    const float32x4_t m = vdupq_n_f32(mean);
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; ix + 8 <= n; ix += 8) {
+        float32x4_t d0 = vsubq_f32(vld1q_f32(x + ix), m);
+        float32x4_t d1 = vsubq_f32(vld1q_f32(x + ix + 4), m);
+        acc0 = vmlaq_f32(acc0, d0, d0);
+        acc1 = vmlaq_f32(acc1, d1, d1);
+    }
+    res = hsum_f32x4(vaddq_f32(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_UNROLLED
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    for (; ix + 4 <= n; ix += 4) {
+        float d0 = x[ix] - mean;
+        float d1 = x[ix + 1] - mean;
+        float d2 = x[ix + 2] - mean;
+        float d3 = x[ix + 3] - mean;
+        acc0 += d0 * d0;
+        acc1 += d1 * d1;
+        acc2 += d2 * d2;
+        acc3 += d3 * d3;
+    }
+    res = (acc0 + acc1) + (acc2 + acc3);
+#endif
+    for (; ix < n; ix++) {
+        float d = x[ix] - mean;
+        res += d * d;
+    }
+    return res;
+}
+
+/**
+ * Squared Euclidean distance between two vectors, sum((x[i] - y[i])^2)
+ */
+static inline float squared_distance(const float *x, const float *y, size_t n) {
+    size_t ix = 0;
+    float res = 0.0f;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; ix + 16 <= n; ix += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(x + ix), _mm256_loadu_ps(y + ix));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(x + ix + 8), _mm256_loadu_ps(y + ix + 8));
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(d0, d0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(d1, d1));
+    }
+    res = hsum_ps(fold_ps(_mm256_add_ps(acc0, acc1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; ix + 8 <= n; ix += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_loadu_ps(x + ix), _mm_loadu_ps(y + ix));
+        __m128 d1 = _mm_sub_ps(_mm_loadu_ps(x + ix + 4), _mm_loadu_ps(y + ix + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+    }
+    res = hsum_ps(_mm_add_ps(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; ix + 8 <= n; ix += 8) {
+        float32x4_t d0 = vsubq_f32(vld1q_f32(x + ix), vld1q_f32(y + ix));
+        float32x4_t d1 = vsubq_f32(vld1q_f32(x + ix + 4), vld1q_f32(y + ix + 4));
+        acc0 = vmlaq_f32(acc0, d0, d0);
+        acc1 = vmlaq_f32(acc1, d1, d1);
+    }
+    res = hsum_f32x4(vaddq_f32(acc0, acc1));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_UNROLLED
+    float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+    for (; ix + 4 <= n; ix += 4) {
+        float d0 = x[ix] - y[ix];
+        float d1 = x[ix + 1] - y[ix + 1];
+        float d2 = x[ix + 2] - y[ix + 2];
+        float d3 = x[ix + 3] - y[ix + 3];
+        acc0 += d0 * d0;
+        acc1 += d1 * d1;
+        acc2 += d2 * d2;
+        acc3 += d3 * d3;
+    }
+    res = (acc0 + acc1) + (acc2 + acc3);
+#endif
+    for (; ix < n; ix++) {
+        float d = x[ix] - y[ix];
+        res += d * d;
+    }
+    return res;
+}
+
+/**
+ * Smallest element, FLT_MAX for an empty vector. NaN elements are skipped.
+ */
+static inline float min(const float *x, size_t n) {
+    size_t ix = 0;
+    float res = FLT_MAX;
+    // note: the SSE/AVX min returns its second operand when either is NaN,
+    // so keep the accumulator second to skip NaN inputs
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    __m256 acc = _mm256_set1_ps(FLT_MAX);
+    for (; ix + 8 <= n; ix += 8) {
+        acc = _mm256_min_ps(_mm256_loadu_ps(x + ix), acc);
+    }
+    res = hmin_ps(_mm_min_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    __m128 acc = _mm_set1_ps(FLT_MAX);
+    for (; ix + 4 <= n; ix += 4) {
+        acc = _mm_min_ps(_mm_loadu_ps(x + ix), acc);
+    }
+    res = hmin_ps(acc);
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON && defined(__aarch64__)
+    float32x4_t acc = vdupq_n_f32(FLT_MAX);
+    for (; ix + 4 <= n; ix += 4) {
+        acc = vminnmq_f32(acc, vld1q_f32(x + ix));
+    }
+    res = vminnmvq_f32(acc);
+#endif
+    for (; ix < n; ix++) {
+        if (x[ix] < res) {
+            res = x[ix];
+        }
+    }
+    return res;
+}
+
+/**
+ * Largest element, -FLT_MAX for an empty vector. NaN elements are skipped.
+ */
+static inline float max(const float *x, size_t n) {
+    size_t ix = 0;
+    float res = -FLT_MAX;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    __m256 acc = _mm256_set1_ps(-FLT_MAX);
+    for (; ix + 8 <= n; ix += 8) {
+        acc = _mm256_max_ps(_mm256_loadu_ps(x + ix), acc);
+    }
+    res = hmax_ps(_mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    __m128 acc = _mm_set1_ps(-FLT_MAX);
+    for (; ix + 4 <= n; ix += 4) {
+        acc = _mm_max_ps(_mm_loadu_ps(x + ix), acc);
+    }
+    res = hmax_ps(acc);
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON && defined(__aarch64__)
+    float32x4_t acc = vdupq_n_f32(-FLT_MAX);
+    for (; ix + 4 <= n; ix += 4) {
+        acc = vmaxnmq_f32(acc, vld1q_f32(x + ix));
+    }
+    res = vmaxnmvq_f32(acc);
+#endif
+    for (; ix < n; ix++) {
+        if (x[ix] > res) {
+            res = x[ix];
+        }
+    }
+    return res;
+}
+
+/**
+ * In place x[i] *= factor
+ */
+static inline void scale(float *x, size_t n, float factor) {
+    size_t ix = 0;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    const __m256 s = _mm256_set1_ps(factor);
+    for (; ix + 8 <= n; ix += 8) {
+        _mm256_storeu_ps(x + ix, _mm256_mul_ps(_mm256_loadu_ps(x + ix), s));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    const __m128 s = _mm_set1_ps(factor);
+    for (; ix + 4 <= n; ix += 4) {
+        _mm_storeu_ps(x + ix, _mm_mul_ps(_mm_loadu_ps(x + ix), s));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    for (; ix + 4 <= n; ix += 4) {
+        vst1q_f32(x + ix, vmulq_n_f32(vld1q_f32(x + ix), factor));
+    }
+#endif
+    for (; ix < n; ix++) {
+        x[ix] *= factor;
+    }
+}
+
+/**
+ * In place x[i] += value. Subtraction is offset(x, n, -value), which is exact.
+ */
+static inline void offset(float *x, size_t n, float value) {
+    size_t ix = 0;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    const __m256 o = _mm256_set1_ps(value);
+    for (; ix + 8 <= n; ix += 8) {
+        _mm256_storeu_ps(x + ix, _mm256_add_ps(_mm256_loadu_ps(x + ix), o));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    const __m128 o = _mm_set1_ps(value);
+    for (; ix + 4 <= n; ix += 4) {
+        _mm_storeu_ps(x + ix, _mm_add_ps(_mm_loadu_ps(x + ix), o));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    const float32x4_t o = vdupq_n_f32(value);
+    for (; ix + 4 <= n; ix += 4) {
+        vst1q_f32(x + ix, vaddq_f32(vld1q_f32(x + ix), o));
+    }
+#endif
+    for (; ix < n; ix++) {
+        x[ix] += value;
+    }
+}
+
+/**
+ * In place y[i] += a * x[i]
+ */
+static inline void axpy(float *y, const float *x, size_t n, float a) {
+    size_t ix = 0;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2
+    const __m256 va = _mm256_set1_ps(a);
+    for (; ix + 8 <= n; ix += 8) {
+        __m256 p = _mm256_mul_ps(_mm256_loadu_ps(x + ix), va);
+        _mm256_storeu_ps(y + ix, _mm256_add_ps(_mm256_loadu_ps(y + ix), p));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    const __m128 va = _mm_set1_ps(a);
+    for (; ix + 4 <= n; ix += 4) {
+        __m128 p = _mm_mul_ps(_mm_loadu_ps(x + ix), va);
+        _mm_storeu_ps(y + ix, _mm_add_ps(_mm_loadu_ps(y + ix), p));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    for (; ix + 4 <= n; ix += 4) {
+        vst1q_f32(y + ix, vmlaq_n_f32(vld1q_f32(y + ix), vld1q_f32(x + ix), a));
+    }
+#endif
+    for (; ix < n; ix++) {
+        y[ix] += a * x[ix];
+    }
+}
+
+/**
+ * out[i] = (a[i] * (2^14 - frac) + b[i] * frac + 2^13) >> 14, i.e. the rounded
+ * blend resize_image() uses between two rows (frac in Q14, 0 <= frac < 2^14)
+ */
+static inline void lerp_u8(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t n, uint32_t frac) {
+    if (frac == 0) {
+        if (out != a) {
+            memmove(out, a, n);
+        }
+        return;
+    }
+    const uint32_t nfrac = (1 << 14) - frac;
+    size_t ix = 0;
+#if EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_AVX2 || EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_SSE
+    // (a, b) pairs of int16 against (nfrac, frac) through madd, 16 pixels at a time
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights = _mm_set1_epi32((int)((frac << 16) | nfrac));
+    const __m128i half = _mm_set1_epi32(1 << 13);
+    for (; ix + 16 <= n; ix += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + ix));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + ix));
+        __m128i a_lo = _mm_unpacklo_epi8(va, zero);
+        __m128i a_hi = _mm_unpackhi_epi8(va, zero);
+        __m128i b_lo = _mm_unpacklo_epi8(vb, zero);
+        __m128i b_hi = _mm_unpackhi_epi8(vb, zero);
+        __m128i r0 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), weights), half), 14);
+        __m128i r1 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), weights), half), 14);
+        __m128i r2 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), weights), half), 14);
+        __m128i r3 = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), weights), half), 14);
+        __m128i lo = _mm_packs_epi32(r0, r1);
+        __m128i hi = _mm_packs_epi32(r2, r3);
+        _mm_storeu_si128((__m128i*)(out + ix), _mm_packus_epi16(lo, hi));
+    }
+#elif EIDSP_SIMD_BACKEND == EIDSP_SIMD_BACKEND_NEON
+    for (; ix + 8 <= n; ix += 8) {
+        uint16x8_t va = vmovl_u8(vld1_u8(a + ix));
+        uint16x8_t vb = vmovl_u8(vld1_u8(b + ix));
+        uint32x4_t lo = vmlal_n_u16(vmull_n_u16(vget_low_u16(va), (uint16_t)nfrac), vget_low_u16(vb), (uint16_t)frac);
+        uint32x4_t hi = vmlal_n_u16(vmull_n_u16(vget_high_u16(va), (uint16_t)nfrac), vget_high_u16(vb), (uint16_t)frac);
+        // rounding narrowing shift adds the 2^13
+        vst1_u8(out + ix, vmovn_u16(vcombine_u16(vrshrn_n_u32(lo, 14), vrshrn_n_u32(hi, 14))));
+    }
+#endif
+    for (; ix < n; ix++) {
+        out[ix] = (uint8_t)((a[ix] * nfrac + b[ix] * frac + (1 << 13)) >> 14);
+    }
+}
+
+} // namespace simd
+
+} // namespace ei
+
+#endif // _EIDSP_SIMD_KERNELS_H_
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#include "ei_alloc_profiler.h"
+
+#if EIDSP_TRACK_ALLOCATIONS
+
+#include <string.h>
+#include "../porting/ei_classifier_porting.h"
+
+extern size_t ei_memory_in_use;
+extern size_t ei_memory_peak_use;
+
+namespace {
+
+typedef struct {
+    const void *ptr;
+    size_t bytes;
+    uint16_t site;
+} live_alloc_t;
+
+const uint16_t no_site = 0xffff;
+const char *phase_names[EI_ALLOC_PHASE_COUNT] = { "other", "dsp", "inference", "postprocessing" };
+
+ei_alloc_profiler_site_t sites[EIDSP_ALLOC_PROFILER_MAX_SITES];
+size_t site_count = 0;
+uint32_t dropped_sites = 0;
+
+live_alloc_t live[EIDSP_ALLOC_PROFILER_MAX_LIVE];
+size_t live_count = 0;
+uint32_t untracked_allocs = 0;
+uint32_t unmatched_frees = 0;
+
+ei_alloc_profiler_phase_t phases[EI_ALLOC_PHASE_COUNT];
+ei_alloc_phase_t current_phase = EI_ALLOC_PHASE_OTHER;
+
+ei_alloc_profiler_arena_t arenas[EIDSP_ALLOC_PROFILER_MAX_ARENAS];
+size_t arena_count = 0;
+
+bool same_file(const char *a, const char *b)
+{
+    if (a == b) {
+        return true;
+    }
+    return a && b && strcmp(a, b) == 0;
+}
+
+uint16_t find_site(const char *fn, const char *file, int line)
+{
+    for (size_t ix = 0; ix < site_count; ix++) {
+        if (sites[ix].line == line && sites[ix].phase == current_phase && same_file(sites[ix].file, file)) {
+            return (uint16_t)ix;
+        }
+    }
+
+    if (site_count >= EIDSP_ALLOC_PROFILER_MAX_SITES) {
+        dropped_sites++;
+        return no_site;
+    }
+
+    ei_alloc_profiler_site_t *site = &sites[site_count];
+    memset(site, 0, sizeof(ei_alloc_profiler_site_t));
+    site->fn = fn;
+    site->file = file;
+    site->line = line;
+    site->phase = current_phase;
+    return (uint16_t)site_count++;
+}
+
+void update_phase_peak()
+{
+    if (ei_memory_in_use > phases[current_phase].peak_in_use) {
+        phases[current_phase].peak_in_use = ei_memory_in_use;
+    }
+}
+
+const char *file_basename(const char *file)
+{
+    if (!file) {
+        return "";
+    }
+    const char *name = file;
+    for (const char *p = file; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+void print_json_string(const char *s)
+{
+    ei_printf("\"");
+    for (const char *p = s ? s : ""; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            ei_printf("\\%c", *p);
+        }
+        else {
+            ei_printf("%c", *p);
+        }
+    }
+    ei_printf("\"");
+}
+
+} // namespace
+
+void ei_alloc_profiler_on_alloc(const char *fn, const char *file, int line, size_t bytes, const void *ptr)
+{
+    phases[current_phase].count++;
+    phases[current_phase].total_bytes += bytes;
+    update_phase_peak();
+
+    uint16_t site_ix = find_site(fn, file, line);
+    if (site_ix != no_site) {
+        ei_alloc_profiler_site_t *site = &sites[site_ix];
+        site->count++;
+        site->total_bytes += bytes;
+        site->live_bytes += bytes;
+        if (site->live_bytes > site->peak_live_bytes) {
+            site->peak_live_bytes = site->live_bytes;
+        }
+    }
+
+    if (live_count >= EIDSP_ALLOC_PROFILER_MAX_LIVE) {
+        untracked_allocs++;
+        return;
+    }
+    live[live_count].ptr = ptr;
+    live[live_count].bytes = bytes;
+    live[live_count].site = site_ix;
+    live_count++;
+}
+
+void ei_alloc_profiler_on_free(size_t bytes, const void *ptr)
+{
+    // search from the back, most frees are for the most recent allocation
+    for (size_t ix = live_count; ix-- > 0; ) {
+        if (live[ix].ptr != ptr) {
+            continue;
+        }
+        if (live[ix].site != no_site) {
+            ei_alloc_profiler_site_t *site = &sites[live[ix].site];
+            site->live_bytes -= live[ix].bytes < site->live_bytes ? live[ix].bytes : site->live_bytes;
+        }
+        live[ix] = live[--live_count];
+        return;
+    }
+    (void)bytes;
+    unmatched_frees++;
+}
+
+void ei_alloc_profiler_set_phase(ei_alloc_phase_t phase)
+{
+    current_phase = phase < EI_ALLOC_PHASE_COUNT ? phase : EI_ALLOC_PHASE_OTHER;
+    // memory that's still held from an earlier phase counts against this one as well
+    update_phase_peak();
+}
+
+ei_alloc_phase_t ei_alloc_profiler_get_phase(void)
+{
+    return current_phase;
+}
+
+void ei_alloc_profiler_record_arena(const ei_alloc_profiler_arena_t *arena)
+{
+    size_t ix = 0;
+    while (ix < arena_count && !same_file(arenas[ix].name, arena->name)) {
+        ix++;
+    }
+    if (ix == arena_count) {
+        if (arena_count >= EIDSP_ALLOC_PROFILER_MAX_ARENAS) {
+            return;
+        }
+        arena_count++;
+    }
+    arenas[ix] = *arena;
+}
+
+void ei_alloc_profiler_reset(void)
+{
+    site_count = 0;
+    dropped_sites = 0;
+    untracked_allocs = 0;
+    unmatched_frees = 0;
+    arena_count = 0;
+    memset(phases, 0, sizeof(phases));
+    for (size_t ix = 0; ix < live_count; ix++) {
+        live[ix].site = no_site;
+    }
+    ei_memory_peak_use = ei_memory_in_use;
+}
+
+size_t ei_alloc_profiler_get_sites(const ei_alloc_profiler_site_t **out)
+{
+    *out = sites;
+    return site_count;
+}
+
+const ei_alloc_profiler_phase_t *ei_alloc_profiler_get_phase_stats(ei_alloc_phase_t phase)
+{
+    return phase < EI_ALLOC_PHASE_COUNT ? &phases[phase] : nullptr;
+}
+
+void ei_alloc_profiler_print_json(void)
+{
+    ei_printf("{\"in_use\":%lu,\"peak\":%lu,\"dropped_sites\":%lu,\"untracked_allocs\":%lu,\"unmatched_frees\":%lu,",
+        (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, (unsigned long)dropped_sites,
+        (unsigned long)untracked_allocs, (unsigned long)unmatched_frees);
+
+    ei_printf("\"phases\":{");
+    for (size_t ix = 0; ix < EI_ALLOC_PHASE_COUNT; ix++) {
+        ei_printf("%s\"%s\":{\"count\":%lu,\"bytes\":%lu,\"peak_in_use\":%lu}", ix == 0 ? "" : ",",
+            phase_names[ix], (unsigned long)phases[ix].count, (unsigned long)phases[ix].total_bytes,
+            (unsigned long)phases[ix].peak_in_use);
+    }
+    ei_printf("},");
+
+    ei_printf("\"sites\":[");
+    for (size_t ix = 0; ix < site_count; ix++) {
+        const ei_alloc_profiler_site_t *site = &sites[ix];
+        ei_printf("%s{\"fn\":", ix == 0 ? "" : ",");
+        print_json_string(site->fn);
+        ei_printf(",\"file\":");
+        print_json_string(site->file);
+        ei_printf(",\"line\":%d,\"phase\":\"%s\",\"count\":%lu,\"bytes\":%lu,\"live\":%lu,\"peak_live\":%lu}",
+            site->line, phase_names[site->phase], (unsigned long)site->count, (unsigned long)site->total_bytes,
+            (unsigned long)site->live_bytes, (unsigned long)site->peak_live_bytes);
+    }
+    ei_printf("],");
+
+    ei_printf("\"arenas\":[");
+    for (size_t ix = 0; ix < arena_count; ix++) {
+        const ei_alloc_profiler_arena_t *arena = &arenas[ix];
+        ei_printf("%s{\"name\":", ix == 0 ? "" : ",");
+        print_json_string(arena->name);
+        ei_printf(",\"arena_bytes\":%lu,\"used_bytes\":%lu,\"sections\":[",
+            (unsigned long)arena->arena_bytes, (unsigned long)arena->used_bytes);
+        for (size_t s = 0; s < arena->section_count && s < EIDSP_ALLOC_PROFILER_MAX_ARENA_SECTIONS; s++) {
+            ei_printf("%s{\"name\":", s == 0 ? "" : ",");
+            print_json_string(arena->sections[s].name);
+            ei_printf(",\"bytes\":%lu,\"count\":%lu}",
+                (unsigned long)arena->sections[s].bytes, (unsigned long)arena->sections[s].count);
+        }
+        ei_printf("]}");
+    }
+    ei_printf("]}\n");
+}
+
+void ei_alloc_profiler_print_folded(void)
+{
+    for (size_t ix = 0; ix < site_count; ix++) {
+        const ei_alloc_profiler_site_t *site = &sites[ix];
+        ei_printf("impulse;%s;%s;%s:%d %lu\n", phase_names[site->phase], site->fn ? site->fn : "unknown",
+            file_basename(site->file), site->line, (unsigned long)site->total_bytes);
+    }
+    for (size_t ix = 0; ix < arena_count; ix++) {
+        const ei_alloc_profiler_arena_t *arena = &arenas[ix];
+        for (size_t s = 0; s < arena->section_count && s < EIDSP_ALLOC_PROFILER_MAX_ARENA_SECTIONS; s++) {
+            ei_printf("impulse;inference;%s_arena;%s %lu\n", arena->name ? arena->name : "arena",
+                arena->sections[s].name ? arena->sections[s].name : "unknown",
+                (unsigned long)arena->sections[s].bytes);
+        }
+    }
+}
+
+#endif // EIDSP_TRACK_ALLOCATIONS
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#ifndef _EIDSP_ALLOC_PROFILER_H_
+#define _EIDSP_ALLOC_PROFILER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.hpp"
+
+/**
+ * Allocation profiler, built on top of EIDSP_TRACK_ALLOCATIONS. Every allocation that
+ * goes through the tracking macros in memory.hpp (ei_dsp_malloc, matrix_t, tracked
+ * unique pointers) is attributed to its call site and to the phase of the impulse that
+ * was running (DSP, inference, postprocessing). Per call site it keeps the number of
+ * allocations, total bytes and the peak number of bytes that were live at the same time.
+ * The inferencing engines add their tensor arena usage, so after a run the report holds
+ * everything needed to size the heap and the arena for a model.
+ *
+ * Reports are printed through ei_printf, as JSON or as folded stacks
+ * ("impulse;phase;function;file:line total_bytes") that can be fed to flamegraph.pl.
+ *
+ * If EIDSP_TRACK_ALLOCATIONS is 0 everything here compiles to nothing.
+ */
+
+// Number of distinct (call site, phase) pairs that are aggregated
+#ifndef EIDSP_ALLOC_PROFILER_MAX_SITES
+#define EIDSP_ALLOC_PROFILER_MAX_SITES 48
+#endif
+
+// Number of allocations that can be live at the same time and still be matched to their call site on free
+#ifndef EIDSP_ALLOC_PROFILER_MAX_LIVE
+#define EIDSP_ALLOC_PROFILER_MAX_LIVE 64
+#endif
+
+// Number of tensor arenas (one per learning block) that can be recorded
+#ifndef EIDSP_ALLOC_PROFILER_MAX_ARENAS
+#define EIDSP_ALLOC_PROFILER_MAX_ARENAS 4
+#endif
+
+#define EIDSP_ALLOC_PROFILER_MAX_ARENA_SECTIONS 8
+
+// Run non-compiled (TFLM) models through RecordingMicroInterpreter, so the arena report is split
+// by allocation type. Needs RecordingMicroAllocator::GetDefaultTailUsage() extra bytes in the arena.
+#ifndef EIDSP_ALLOC_PROFILER_RECORD_TFLM
+#define EIDSP_ALLOC_PROFILER_RECORD_TFLM 0
+#endif
+
+typedef enum {
+    EI_ALLOC_PHASE_OTHER = 0, // outside of run_classifier (init, continuous buffers, ...)
+    EI_ALLOC_PHASE_DSP,
+    EI_ALLOC_PHASE_INFERENCE,
+    EI_ALLOC_PHASE_POSTPROCESSING,
+    EI_ALLOC_PHASE_COUNT
+} ei_alloc_phase_t;
+
+typedef struct {
+    const char *fn;
+    const char *file;
+    int line;
+    ei_alloc_phase_t phase;
+    uint32_t count;
+    size_t total_bytes;
+    size_t live_bytes;
+    size_t peak_live_bytes;
+} ei_alloc_profiler_site_t;
+
+typedef struct {
+    uint32_t count;
+    size_t total_bytes;
+    // highest heap use (all phases) observed while this phase was running
+    size_t peak_in_use;
+} ei_alloc_profiler_phase_t;
+
+typedef struct {
+    const char *name;
+    size_t bytes;
+    size_t count;
+} ei_alloc_profiler_arena_section_t;
+
+typedef struct {
+    const char *name;
+    size_t arena_bytes;
+    size_t used_bytes;
+    size_t section_count;
+    ei_alloc_profiler_arena_section_t sections[EIDSP_ALLOC_PROFILER_MAX_ARENA_SECTIONS];
+} ei_alloc_profiler_arena_t;
+
+#if EIDSP_TRACK_ALLOCATIONS
+
+void ei_alloc_profiler_on_alloc(const char *fn, const char *file, int line, size_t bytes, const void *ptr);
+void ei_alloc_profiler_on_free(size_t bytes, const void *ptr);
+
+void ei_alloc_profiler_set_phase(ei_alloc_phase_t phase);
+ei_alloc_phase_t ei_alloc_profiler_get_phase(void);
+
+/**
+ * Record (or replace, by name) the usage of a tensor arena
+ */
+void ei_alloc_profiler_record_arena(const ei_alloc_profiler_arena_t *arena);
+
+/**
+ * Clear all call sites, phases and arenas. Allocations that are live stay tracked.
+ */
+void ei_alloc_profiler_reset(void);
+
+size_t ei_alloc_profiler_get_sites(const ei_alloc_profiler_site_t **sites);
+const ei_alloc_profiler_phase_t *ei_alloc_profiler_get_phase_stats(ei_alloc_phase_t phase);
+
+void ei_alloc_profiler_print_json(void);
+void ei_alloc_profiler_print_folded(void);
+
+/**
+ * Switches the phase for the lifetime of the object, restores the previous phase after
+ */
+class EiAllocPhaseScope {
+public:
+    EiAllocPhaseScope(ei_alloc_phase_t phase) : previous(ei_alloc_profiler_get_phase())
+    {
+        ei_alloc_profiler_set_phase(phase);
+    }
+
+    ~EiAllocPhaseScope()
+    {
+        ei_alloc_profiler_set_phase(previous);
+    }
+
+private:
+    ei_alloc_phase_t previous;
+};
+
+#define EI_ALLOC_PROFILER_PHASE(phase) ei_alloc_profiler_set_phase(phase)
+#define EI_ALLOC_PROFILER_PHASE_SCOPE(phase) EiAllocPhaseScope ei_alloc_phase_scope_instance(phase)
+
+#else
+
+#define EI_ALLOC_PROFILER_PHASE(phase)
+#define EI_ALLOC_PROFILER_PHASE_SCOPE(phase)
+
+#endif // EIDSP_TRACK_ALLOCATIONS
+
+#endif // _EIDSP_ALLOC_PROFILER_H_
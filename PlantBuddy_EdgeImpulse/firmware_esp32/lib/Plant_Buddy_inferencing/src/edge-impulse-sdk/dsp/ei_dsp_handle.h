@@ -33,6 +33,7 @@
 
 #include "edge-impulse-sdk/dsp/config.hpp"
 #include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 
 class DspHandle {
@@ -62,6 +63,47 @@ public:
         const float frequency,
         ei_impulse_result_t *result) = 0; // result* is a hack.  I want to pass full context everywhere but custom DSP. TODO
 
+    /**
+     * @brief Optionally override to write features quantized straight into an int8 buffer
+     * (e.g. the model's input tensor), so no intermediate float feature matrix is needed.
+     * Must produce the same values as extract() followed by quantization. Only called if
+     * supports_quantized_output() returns true.
+     *
+     * @param signal Callback object to get raw data from
+     * @param output_matrix Output matrix to write quantized features to
+     * @param config Configuration object, generated by Studio based on your DSP block parameters
+     * @param frequency Sampling frequency, as set in your project
+     * @param scale Quantization scale of the output
+     * @param zero_point Quantization zero point of the output
+     * @param result Result object to write HR to. NULLABLE!
+     * @return int 0 on success, anything else for failure
+     */
+    virtual int extract_quantized(
+        ei::signal_t *signal,
+        ei::matrix_i8_t *output_matrix,
+        void *config,
+        const float frequency,
+        float scale,
+        int32_t zero_point,
+        ei_impulse_result_t *result)
+    {
+        (void)signal;
+        (void)output_matrix;
+        (void)config;
+        (void)frequency;
+        (void)scale;
+        (void)zero_point;
+        (void)result;
+        return ei::EIDSP_NOT_SUPPORTED;
+    }
+
+    /**
+     * @brief Override and return true if extract_quantized() is implemented
+     */
+    virtual bool supports_quantized_output() {
+        return false;
+    }
+
     // Must declare so user can override
     /**
      * @brief If you call new or ei_malloc anywhere in your class, you must override this function and delete your objects
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#include "ei_fft_plan.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include <math.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE fft_plans_mux = portMUX_INITIALIZER_UNLOCKED;
+#define EI_FFT_PLANS_LOCK()   portENTER_CRITICAL(&fft_plans_mux)
+#define EI_FFT_PLANS_UNLOCK() portEXIT_CRITICAL(&fft_plans_mux)
+#else
+#include <atomic>
+static std::atomic_flag fft_plans_flag = ATOMIC_FLAG_INIT;
+#define EI_FFT_PLANS_LOCK()   while (fft_plans_flag.test_and_set(std::memory_order_acquire)) { }
+#define EI_FFT_PLANS_UNLOCK() fft_plans_flag.clear(std::memory_order_release)
+#endif // ESP_PLATFORM
+
+namespace ei {
+namespace fft {
+
+// Only slot ownership (n_fft, busy) is changed under the lock. Buffers are
+// allocated and freed outside of it, by whoever owns the slot at that point.
+static fft_plan_t plans[EIDSP_FFT_PLAN_CACHE_SIZE];
+
+static void free_plan_buffers(fft_plan_t *plan) {
+    ei_free(plan->scratch);
+    plan->scratch = nullptr;
+    ei_free(plan->spectrum);
+    plan->spectrum = nullptr;
+    if (plan->kiss_cfg) {
+        KISS_FFT_FREE(plan->kiss_cfg);
+    }
+    plan->kiss_cfg = nullptr;
+    plan->kiss_cfg_size = 0;
+#if EIDSP_USE_ESP_DSP
+    ei_free(plan->rfft_twiddles);
+    plan->rfft_twiddles = nullptr;
+#endif
+}
+
+// Hand an owned slot back as unused
+static void release_plan_slot(fft_plan_t *plan) {
+    free_plan_buffers(plan);
+    EI_FFT_PLANS_LOCK();
+    plan->n_fft = 0;
+    plan->busy = false;
+    EI_FFT_PLANS_UNLOCK();
+}
+
+static bool alloc_plan_buffers(fft_plan_t *plan, size_t n_fft) {
+    plan->scratch = (float *)ei_malloc(n_fft * sizeof(float));
+    if (!plan->scratch) {
+        return false;
+    }
+#if EIDSP_USE_ESP_DSP
+    plan->rfft_twiddles = (float *)ei_malloc(n_fft * sizeof(float));
+    if (!plan->rfft_twiddles) {
+        return false;
+    }
+    for (size_t k = 0; k < n_fft / 2; k++) {
+        double phase = 2.0 * M_PI * (double)k / (double)n_fft;
+        plan->rfft_twiddles[2 * k + 0] = (float)cos(phase);
+        plan->rfft_twiddles[2 * k + 1] = (float)sin(phase);
+    }
+#endif
+    return true;
+}
+
+fft_plan_lease::fft_plan_lease(size_t n_fft) : plan(nullptr) {
+    if (n_fft == 0) {
+        return;
+    }
+
+    fft_plan_t *fresh = nullptr;
+
+    EI_FFT_PLANS_LOCK();
+    for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+        if (plans[ix].n_fft == n_fft && !plans[ix].busy) {
+            plan = &plans[ix];
+            break;
+        }
+        if (!fresh && plans[ix].n_fft == 0) {
+            fresh = &plans[ix];
+        }
+    }
+    if (!plan && fresh) {
+        // reserve the slot, it's filled in below without holding the lock
+        fresh->n_fft = n_fft;
+        plan = fresh;
+    }
+    if (plan) {
+        plan->busy = true;
+    }
+    EI_FFT_PLANS_UNLOCK();
+
+    if (plan && plan == fresh) {
+        if (!alloc_plan_buffers(plan, n_fft)) {
+            release_plan_slot(plan);
+            plan = nullptr;
+        }
+    }
+}
+
+fft_plan_lease::~fft_plan_lease() {
+    if (!plan) {
+        return;
+    }
+    EI_FFT_PLANS_LOCK();
+    plan->busy = false;
+    EI_FFT_PLANS_UNLOCK();
+}
+
+fft_complex_t *fft_plan_lease::spectrum() {
+    if (!plan) {
+        return nullptr;
+    }
+    if (!plan->spectrum) {
+        plan->spectrum = (fft_complex_t *)ei_malloc((plan->n_fft / 2 + 1) * sizeof(fft_complex_t));
+    }
+    return plan->spectrum;
+}
+
+kiss_fftr_cfg fft_plan_lease::kiss_cfg() {
+    if (!plan) {
+        return nullptr;
+    }
+    if (!plan->kiss_cfg) {
+        plan->kiss_cfg = kiss_fftr_alloc(plan->n_fft, 0, NULL, NULL, &plan->kiss_cfg_size);
+    }
+    return plan->kiss_cfg;
+}
+
+void clear_fft_plans(void) {
+    for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+        fft_plan_t *plan = &plans[ix];
+        bool owned = false;
+
+        EI_FFT_PLANS_LOCK();
+        if (plan->n_fft != 0 && !plan->busy) {
+            plan->busy = true;
+            owned = true;
+        }
+        EI_FFT_PLANS_UNLOCK();
+
+        if (!owned) {
+            continue;
+        }
+        release_plan_slot(plan);
+    }
+}
+
+} // namespace fft
+} // namespace ei
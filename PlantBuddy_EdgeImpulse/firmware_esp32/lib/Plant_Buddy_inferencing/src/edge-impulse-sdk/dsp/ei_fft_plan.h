@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef __EI_FFT_PLAN__H__
+#define __EI_FFT_PLAN__H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/dsp/kissfft/kiss_fftr.h"
+
+/**
+ * Number of FFT plans kept alive between calls. A plan is bound to one n_fft;
+ * an impulse typically needs one per spectral/MFE/MFCC block, plus one more
+ * for every handle that runs the same size at the same time.
+ */
+#ifndef EIDSP_FFT_PLAN_CACHE_SIZE
+#define EIDSP_FFT_PLAN_CACHE_SIZE   4
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE
+
+namespace ei {
+namespace fft {
+
+/**
+ * Everything an rfft of a given size needs besides its input and output, so
+ * repeated FFTs don't go back to the heap.
+ */
+typedef struct {
+    size_t n_fft;                   // 0 when the slot is unused
+    bool busy;                      // owned by a fft_plan_lease
+    float *scratch;                 // n_fft floats, input staging (in place on ESP-DSP)
+    fft_complex_t *spectrum;        // n_fft / 2 + 1 bins, allocated on first use
+    kiss_fftr_cfg kiss_cfg;         // allocated on first use
+    size_t kiss_cfg_size;
+#if EIDSP_USE_ESP_DSP
+    float *rfft_twiddles;           // (cos, sin) of 2*pi*k/n_fft for k < n_fft / 2
+#endif
+} fft_plan_t;
+
+/**
+ * Exclusive use of a cached FFT plan for the lifetime of the object.
+ *
+ * A lease first looks for an idle plan of the same size; if every plan of that
+ * size is held by another handle (or thread) a new one is created in a free
+ * slot, so two handles never share scratch memory. When the cache is full the
+ * lease is invalid, all accessors return nullptr and callers fall back to
+ * allocating per call, as before.
+ */
+class fft_plan_lease {
+public:
+    explicit fft_plan_lease(size_t n_fft);
+    ~fft_plan_lease();
+
+    fft_plan_lease(const fft_plan_lease&) = delete;
+    fft_plan_lease& operator=(const fft_plan_lease&) = delete;
+
+    bool valid() const { return plan != nullptr; }
+
+    /**
+     * n_fft floats the caller may overwrite.
+     */
+    float *scratch() { return plan ? plan->scratch : nullptr; }
+
+    /**
+     * n_fft / 2 + 1 complex bins, for callers that only need the spectrum
+     * as an intermediate result.
+     */
+    fft_complex_t *spectrum();
+
+    /**
+     * kissfft forward rfft configuration for n_fft.
+     */
+    kiss_fftr_cfg kiss_cfg();
+
+#if EIDSP_USE_ESP_DSP
+    const float *rfft_twiddles() { return plan ? plan->rfft_twiddles : nullptr; }
+#endif
+
+private:
+    fft_plan_t *plan;
+};
+
+/**
+ * Free all cached plans that are not currently leased.
+ */
+void clear_fft_plans(void);
+
+} // namespace fft
+} // namespace ei
+
+#endif // __EI_FFT_PLAN__H__
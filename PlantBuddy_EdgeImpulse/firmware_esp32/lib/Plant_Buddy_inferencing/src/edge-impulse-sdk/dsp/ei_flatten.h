@@ -37,15 +37,20 @@
 #include "model-parameters/model_metadata.h"
 #include "edge-impulse-sdk/dsp/numpy.hpp"
 #include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/ei_sliding_stats.h"
+#include "edge-impulse-sdk/classifier/ei_quantize.h"
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#include "edge-impulse-sdk/dsp/ei_profiler.h"
 
 class flatten_class : public DspHandle {
 public:
     int print() override {
         ei_printf("means: ");
-        for(int axis = 0; (size_t)axis < this->means.size(); axis++) {
-        ei_printf("axis: %i\n", axis);
-            for (size_t i = 0; i < this->means.size(); i++) {
-                ei_printf("%f ", this->means[axis][i]);
+        for (size_t axis = 0; axis < this->moving_averages.size(); axis++) {
+            ei_printf("axis: %i\n", (int)axis);
+            const float *history = this->mean_history.data() + (axis * this->moving_avg_num_windows);
+            for (size_t i = 0; i < this->moving_averages[axis].count; i++) {
+                ei_printf("%f ", history[i]);
             }
         }
         ei_printf("\n");
@@ -58,22 +63,183 @@ public:
         void *config_ptr,
         const float frequency,
         ei_impulse_result_t *result) override
+    {
+        float *out_buffer = output_matrix->buffer;
+        int ret = extract_features(signal, output_matrix->rows * output_matrix->cols, config_ptr,
+            [out_buffer](size_t ix, float value) {
+                out_buffer[ix] = value;
+            });
+        if (ret != ei::EIDSP_OK) {
+            return ret;
+        }
+
+        // flatten again
+        output_matrix->cols = output_matrix->rows * output_matrix->cols;
+        output_matrix->rows = 1;
+
+        return ei::EIDSP_OK;
+    }
+
+    int extract_quantized(
+        ei::signal_t *signal,
+        ei::matrix_i8_t *output_matrix,
+        void *config_ptr,
+        const float frequency,
+        float scale,
+        int32_t zero_point,
+        ei_impulse_result_t *result) override
+    {
+        int8_t *out_buffer = output_matrix->buffer;
+        return extract_features(signal, output_matrix->rows * output_matrix->cols, config_ptr,
+            [out_buffer, scale, zero_point](size_t ix, float value) {
+                out_buffer[ix] = static_cast<int8_t>(pre_cast_quantize(value, scale, zero_point, true));
+            });
+    }
+
+    bool supports_quantized_output() override {
+        return true;
+    }
+
+    /**
+     * Streaming counterpart of extract(), used by run_classifier_continuous().
+     * Pushes one slice into per-axis sliding windows of `window_size` samples and,
+     * once the windows are full, writes the features extract() would give for the
+     * last `window_size` samples. A slice costs O(slice), not O(window).
+     *
+     * @param signal Slice of raw data (interleaved axes)
+     * @param output_matrix Output matrix to write features to
+     * @param config_ptr ei_dsp_config_flatten_t struct pointer
+     * @param window_size Number of samples per axis in a full window
+     * @param matrix_size_out Size of the features written, 0x0 while the window is still filling
+     * @return int 0 on success, anything else for failure
+     */
+    int extract_per_slice(
+        ei::signal_t *signal,
+        ei::matrix_t *output_matrix,
+        void *config_ptr,
+        size_t window_size,
+        ei::matrix_size_t *matrix_size_out)
     {
         using namespace ei;
 
+        EI_PROFILE_ZONE("flatten_per_slice");
+
         ei_dsp_config_flatten_t config = *((ei_dsp_config_flatten_t*)config_ptr);
 
-        uint32_t expected_matrix_size = 0;
-        if (config.average) expected_matrix_size += config.axes;
-        if (config.minimum) expected_matrix_size += config.axes;
-        if (config.maximum) expected_matrix_size += config.axes;
-        if (config.rms) expected_matrix_size += config.axes;
-        if (config.stdev) expected_matrix_size += config.axes;
-        if (config.skewness) expected_matrix_size += config.axes;
-        if (config.kurtosis) expected_matrix_size += config.axes;
-        if (config.moving_avg_num_windows) expected_matrix_size += config.axes;
-
-        if (output_matrix->rows * output_matrix->cols != expected_matrix_size) {
+        matrix_size_out->rows = 0;
+        matrix_size_out->cols = 0;
+
+        const size_t feature_count = calculate_feature_count(config);
+        if (output_matrix->rows * output_matrix->cols != feature_count) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (config.axes == 0 || signal->total_length % config.axes != 0) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (window_stats.size() != (size_t)config.axes) {
+            window_stats.clear();
+            window_stats.resize(config.axes);
+            for (auto& stats : window_stats) {
+                int ret = stats.init(window_size, config.minimum || config.maximum);
+                if (ret != EIDSP_OK) {
+                    window_stats.clear();
+                    EIDSP_ERR(ret);
+                }
+            }
+        }
+
+        {
+            EI_PROFILE_OPS_SCOPE("flatten_push_slice");
+
+            // read the slice in small chunks, so a slice needs no heap
+            float chunk[64];
+            size_t axis = 0;
+            for (size_t offset = 0; offset < signal->total_length; offset += sizeof(chunk) / sizeof(chunk[0])) {
+                size_t length = std::min(sizeof(chunk) / sizeof(chunk[0]), signal->total_length - offset);
+                int ret = signal->get_data(offset, length, chunk);
+                if (ret != EIDSP_OK) {
+                    EIDSP_ERR(ret);
+                }
+                for (size_t ix = 0; ix < length; ix++) {
+                    window_stats[axis].push(chunk[ix] * config.scale_axes);
+                    if (++axis == (size_t)config.axes) {
+                        axis = 0;
+                    }
+                }
+            }
+        }
+
+        if (!window_stats[0].full()) {
+            return EIDSP_OK;
+        }
+
+        EI_PROFILE_OPS_SCOPE("flatten_features");
+
+        float *out_buffer = output_matrix->buffer;
+        size_t out_matrix_ix = 0;
+
+        for (size_t row = 0; row < window_stats.size(); row++) {
+            const ei_sliding_stats& stats = window_stats[row];
+            const float mean = stats.mean();
+
+            if (config.average) out_buffer[out_matrix_ix++] = mean;
+            if (config.minimum) out_buffer[out_matrix_ix++] = stats.min();
+            if (config.maximum) out_buffer[out_matrix_ix++] = stats.max();
+            if (config.rms) out_buffer[out_matrix_ix++] = stats.rms();
+            if (config.stdev) out_buffer[out_matrix_ix++] = stats.stdev();
+            if (config.skewness) out_buffer[out_matrix_ix++] = stats.skew();
+            if (config.kurtosis) out_buffer[out_matrix_ix++] = stats.kurtosis();
+            if (config.moving_avg_num_windows) {
+                out_buffer[out_matrix_ix++] = push_mean(row, mean);
+            }
+        }
+
+        matrix_size_out->rows = 1;
+        matrix_size_out->cols = feature_count;
+
+        return EIDSP_OK;
+    }
+
+    static DspHandle* create(void* config, float _sampling_frequency);
+
+    void* operator new(size_t size) {
+        // Custom memory allocation logic here
+        return ei_malloc(size);
+    }
+
+    void operator delete(void* ptr) {
+        // Custom memory deallocation logic here
+        ei_free(ptr);
+    }
+
+private:
+    static size_t calculate_feature_count(const ei_dsp_config_flatten_t& config) {
+        size_t count = 0;
+        if (config.average) count += config.axes;
+        if (config.minimum) count += config.axes;
+        if (config.maximum) count += config.axes;
+        if (config.rms) count += config.axes;
+        if (config.stdev) count += config.axes;
+        if (config.skewness) count += config.axes;
+        if (config.kurtosis) count += config.axes;
+        if (config.moving_avg_num_windows) count += config.axes;
+        return count;
+    }
+
+    /**
+     * Calculate the features and hand each one to `write(index, value)`
+     */
+    template<typename WriteFn>
+    int extract_features(ei::signal_t *signal, size_t output_size, void *config_ptr, WriteFn write)
+    {
+        using namespace ei;
+
+        EI_PROFILE_ZONE("flatten");
+
+        ei_dsp_config_flatten_t config = *((ei_dsp_config_flatten_t*)config_ptr);
+
+        if (output_size != calculate_feature_count(config)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
@@ -84,17 +250,26 @@ public:
         if (!input_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        signal->get_data(0, signal->total_length, input_matrix.buffer);
+        {
+            EI_PROFILE_OPS_SCOPE("flatten_get_data");
+            signal->get_data(0, signal->total_length, input_matrix.buffer);
+        }
+
+        {
+            EI_PROFILE_OPS_SCOPE("flatten_scale");
 
-        // scale the signal
-        ret = numpy::scale(&input_matrix, config.scale_axes);
-        if (ret != EIDSP_OK) {
-            ei_printf("ERR: Failed to scale signal (%d)\n", ret);
-            EIDSP_ERR(ret);
+            // scale the signal
+            ret = numpy::scale(&input_matrix, config.scale_axes);
+            if (ret != EIDSP_OK) {
+                ei_printf("ERR: Failed to scale signal (%d)\n", ret);
+                EIDSP_ERR(ret);
+            }
+
+            // transpose the matrix so we have one row per axis
+            numpy::transpose_in_place(&input_matrix);
         }
 
-        // transpose the matrix so we have one row per axis
-        numpy::transpose_in_place(&input_matrix);
+        EI_PROFILE_OPS_SCOPE("flatten_features");
 
         size_t out_matrix_ix = 0;
 
@@ -109,7 +284,7 @@ public:
                 numpy::mean(&row_matrix, &out_matrix);
                 mean = out_matrix.buffer[0];
                 if (config.average) {
-                    output_matrix->buffer[out_matrix_ix++] = mean;
+                    write(out_matrix_ix++, mean);
                 }
             }
 
@@ -117,90 +292,118 @@ public:
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::min(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.maximum) {
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::max(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.rms) {
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::rms(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.stdev) {
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::stdev(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.skewness) {
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::skew(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.kurtosis) {
                 float fbuffer;
                 matrix_t out_matrix(1, 1, &fbuffer);
                 numpy::kurtosis(&row_matrix, &out_matrix);
-                output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+                write(out_matrix_ix++, out_matrix.buffer[0]);
             }
 
             if (config.moving_avg_num_windows) {
-                push_mean(row, mean);
-                output_matrix->buffer[out_matrix_ix++] = numpy::mean(means[row].data(), means[row].size());
+                write(out_matrix_ix++, push_mean(row, mean));
             }
         }
 
-        // flatten again
-        output_matrix->cols = output_matrix->rows * output_matrix->cols;
-        output_matrix->rows = 1;
-
         return EIDSP_OK;
     }
 
-    static DspHandle* create(void* config, float _sampling_frequency);
+    /**
+     * Running sum over the last moving_avg_num_windows means of one axis.
+     * The sum is Kahan-compensated, and rebuilt from the history once per
+     * moving_avg_num_windows updates so adding and removing values can't drift.
+     */
+    typedef struct {
+        size_t head;
+        size_t count;
+        size_t updates_since_resum;
+        float sum;
+        float compensation;
+    } moving_average_t;
 
-    void* operator new(size_t size) {
-        // Custom memory allocation logic here
-        return ei_malloc(size);
-    }
+    // moving_avg_num_windows means per axis, one ring buffer after the other
+    ei_vector<float> mean_history;
+    ei_vector<moving_average_t> moving_averages;
+    size_t moving_avg_num_windows;
+    // only used by extract_per_slice()
+    ei_vector<ei_sliding_stats> window_stats;
 
-    void operator delete(void* ptr) {
-        // Custom memory deallocation logic here
-        ei_free(ptr);
+    flatten_class(int moving_avg_num_windows, int axes_count)
+        : mean_history(moving_avg_num_windows > 0 ? (size_t)moving_avg_num_windows * axes_count : 0, 0.0f),
+          moving_averages(axes_count, moving_average_t { 0, 0, 0, 0.0f, 0.0f }) {
+        this->moving_avg_num_windows = moving_avg_num_windows > 0 ? moving_avg_num_windows : 0;
     }
 
-private:
-    ei_vector<ei_vector<float>> means;
-    ei_vector<size_t> head_indexes;
-    size_t moving_avg_num_windows;
-
-    flatten_class(int moving_avg_num_windows, int axes_count) : means(axes_count), head_indexes(axes_count, 0) {
-        this->moving_avg_num_windows = moving_avg_num_windows;
+    static void kahan_add(moving_average_t& avg, float value) {
+        float y = value - avg.compensation;
+        float t = avg.sum + y;
+        avg.compensation = (t - avg.sum) - y;
+        avg.sum = t;
     }
 
-    void push_mean(int axis, float mean) {
-        auto& head = head_indexes[axis];
-        if (head_indexes[axis] >= means[axis].size()) {
-            means[axis].push_back(mean);
-        } else {
-            means[axis][head] = mean;
+    /**
+     * Add the mean of the current window to the history of an axis
+     * @returns The moving average over the history, including this mean
+     */
+    float push_mean(int axis, float mean) {
+        auto& avg = moving_averages[axis];
+        float *history = mean_history.data() + (axis * moving_avg_num_windows);
+
+        if (avg.count < moving_avg_num_windows) {
+            avg.count++;
         }
-        head = head + 1;
+        else {
+            kahan_add(avg, -history[avg.head]);
+        }
+        history[avg.head] = mean;
+        kahan_add(avg, mean);
+
+        avg.head++;
         // This is a lot cheaper than mod (%)
-        if (head >= moving_avg_num_windows) {
-            head = 0;
+        if (avg.head >= moving_avg_num_windows) {
+            avg.head = 0;
+        }
+
+        if (++avg.updates_since_resum >= moving_avg_num_windows) {
+            avg.updates_since_resum = 0;
+            avg.sum = 0.0f;
+            avg.compensation = 0.0f;
+            for (size_t ix = 0; ix < avg.count; ix++) {
+                kahan_add(avg, history[ix]);
+            }
         }
+
+        return avg.sum / avg.count;
     }
 };
 
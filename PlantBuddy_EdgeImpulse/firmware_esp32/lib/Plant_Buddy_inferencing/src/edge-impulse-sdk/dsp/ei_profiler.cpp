@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#include "ei_profiler.h"
+
+#if EI_PROFILER_ENABLED
+
+#include <string.h>
+#include <atomic>
+#include "edge-impulse-sdk/porting/ei_mpsc_ring.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE profiler_mux = portMUX_INITIALIZER_UNLOCKED;
+#define EI_PROFILER_LOCK()   portENTER_CRITICAL(&profiler_mux)
+#define EI_PROFILER_UNLOCK() portEXIT_CRITICAL(&profiler_mux)
+#else
+static std::atomic_flag profiler_flag = ATOMIC_FLAG_INIT;
+#define EI_PROFILER_LOCK()   while (profiler_flag.test_and_set(std::memory_order_acquire)) { }
+#define EI_PROFILER_UNLOCK() profiler_flag.clear(std::memory_order_release)
+#endif // ESP_PLATFORM
+
+namespace {
+
+// Log-scale histogram: values 0..3 get their own bucket, after that every power of
+// two is split in 4 buckets. Durations of 2^28 and up all land in the last bucket.
+const uint32_t histogram_sub_buckets = 4;
+const uint32_t histogram_max_log2 = 27;
+const uint32_t histogram_buckets = histogram_sub_buckets + (histogram_max_log2 - 1) * histogram_sub_buckets;
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[histogram_buckets];
+} zone_t;
+
+typedef struct {
+    uint16_t zone;
+    uint32_t duration;
+} event_t;
+
+zone_t zones[EI_PROFILER_MAX_ZONES];
+size_t zone_count = 0;
+
+ei_mpsc_ring<event_t, EI_PROFILER_EVENT_BUFFER_SIZE> events;
+
+uint32_t log2_floor(uint32_t value)
+{
+    uint32_t log2 = 0;
+    while (value >>= 1) {
+        log2++;
+    }
+    return log2;
+}
+
+uint32_t histogram_bucket(uint32_t value)
+{
+    if (value < histogram_sub_buckets) {
+        return value;
+    }
+    uint32_t log2 = log2_floor(value);
+    if (log2 > histogram_max_log2) {
+        return histogram_buckets - 1;
+    }
+    uint32_t sub = (value >> (log2 - 2)) & (histogram_sub_buckets - 1);
+    return histogram_sub_buckets + (log2 - 2) * histogram_sub_buckets + sub;
+}
+
+uint32_t histogram_bucket_upper(uint32_t bucket)
+{
+    if (bucket < histogram_sub_buckets) {
+        return bucket;
+    }
+    uint32_t shift = (bucket - histogram_sub_buckets) / histogram_sub_buckets;
+    uint32_t sub = (bucket - histogram_sub_buckets) % histogram_sub_buckets;
+    uint32_t lower = (histogram_sub_buckets + sub) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+void clear_zone(zone_t *zone)
+{
+    const char *name = zone->name;
+    memset(zone, 0, sizeof(zone_t));
+    zone->name = name;
+    zone->min = UINT32_MAX;
+}
+
+// call with the lock held, there's only a single consumer
+void drain_events(void)
+{
+    event_t event;
+    while (events.pop(&event)) {
+        if (event.zone < zone_count) {
+            zone_t *zone = &zones[event.zone];
+            uint32_t duration = event.duration;
+            zone->count++;
+            zone->total += duration;
+            if (duration < zone->min) {
+                zone->min = duration;
+            }
+            if (duration > zone->max) {
+                zone->max = duration;
+            }
+            zone->histogram[histogram_bucket(duration)]++;
+        }
+    }
+}
+
+uint32_t percentile(const zone_t *zone, uint32_t percent)
+{
+    if (zone->count == 0) {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)zone->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint32_t ix = 0; ix < histogram_buckets; ix++) {
+        seen += zone->histogram[ix];
+        if (seen >= rank) {
+            uint32_t upper = histogram_bucket_upper(ix);
+            return upper > zone->max ? zone->max : upper;
+        }
+    }
+    return zone->max;
+}
+
+} // namespace
+
+uint16_t ei_profiler_register_zone(const char *name)
+{
+    uint16_t id = EI_PROFILER_NO_ZONE;
+
+    EI_PROFILER_LOCK();
+    for (size_t ix = 0; ix < zone_count; ix++) {
+        if (zones[ix].name == name || strcmp(zones[ix].name, name) == 0) {
+            id = (uint16_t)ix;
+            break;
+        }
+    }
+    if (id == EI_PROFILER_NO_ZONE && zone_count < EI_PROFILER_MAX_ZONES) {
+        id = (uint16_t)zone_count;
+        zones[id].name = name;
+        clear_zone(&zones[id]);
+        zone_count++;
+    }
+    EI_PROFILER_UNLOCK();
+
+    return id;
+}
+
+void ei_profiler_record(uint16_t zone, uint32_t duration)
+{
+    if (zone == EI_PROFILER_NO_ZONE) {
+        return;
+    }
+
+    uint32_t pos;
+    event_t *event = events.reserve(&pos);
+    if (!event) {
+        return;
+    }
+    event->zone = zone;
+    event->duration = duration;
+    events.commit(pos);
+}
+
+void ei_profiler_flush(void)
+{
+    EI_PROFILER_LOCK();
+    drain_events();
+    EI_PROFILER_UNLOCK();
+}
+
+void ei_profiler_reset(void)
+{
+    EI_PROFILER_LOCK();
+    drain_events();
+    for (size_t ix = 0; ix < zone_count; ix++) {
+        clear_zone(&zones[ix]);
+    }
+    events.clear_dropped();
+    EI_PROFILER_UNLOCK();
+}
+
+size_t ei_profiler_get_zone_count(void)
+{
+    // zones are registered under the lock, from any task
+    EI_PROFILER_LOCK();
+    size_t count = zone_count;
+    EI_PROFILER_UNLOCK();
+    return count;
+}
+
+bool ei_profiler_get_zone_stats(size_t zone, ei_profiler_zone_stats_t *stats)
+{
+    if (stats == nullptr) {
+        return false;
+    }
+
+    EI_PROFILER_LOCK();
+    if (zone >= zone_count) {
+        EI_PROFILER_UNLOCK();
+        return false;
+    }
+    drain_events();
+    const zone_t *z = &zones[zone];
+    stats->name = z->name;
+    stats->count = z->count;
+    stats->min = z->count ? z->min : 0;
+    stats->max = z->max;
+    stats->mean = z->count ? (uint32_t)(z->total / z->count) : 0;
+    stats->p99 = percentile(z, 99);
+    stats->total = z->total;
+    EI_PROFILER_UNLOCK();
+
+    return true;
+}
+
+uint32_t ei_profiler_get_dropped_events(void)
+{
+    return events.get_dropped();
+}
+
+void ei_profiler_print(void)
+{
+    ei_profiler_zone_stats_t stats;
+
+    ei_printf("%-32s %8s %10s %10s %10s %10s (" EI_PROFILER_TIMESTAMP_UNIT ")\n",
+        "zone", "count", "min", "mean", "p99", "max");
+    for (size_t ix = 0; ix < ei_profiler_get_zone_count(); ix++) {
+        if (!ei_profiler_get_zone_stats(ix, &stats)) {
+            continue;
+        }
+        ei_printf("%-32s %8lu %10lu %10lu %10lu %10lu\n", stats.name, (unsigned long)stats.count,
+            (unsigned long)stats.min, (unsigned long)stats.mean, (unsigned long)stats.p99,
+            (unsigned long)stats.max);
+    }
+    if (ei_profiler_get_dropped_events() > 0) {
+        ei_printf("dropped %lu events, flush more often or increase EI_PROFILER_EVENT_BUFFER_SIZE\n",
+            (unsigned long)ei_profiler_get_dropped_events());
+    }
+}
+
+void ei_profiler_print_json(void)
+{
+    ei_profiler_zone_stats_t stats;
+
+    ei_printf("{\"unit\":\"" EI_PROFILER_TIMESTAMP_UNIT "\",\"dropped_events\":%lu,\"zones\":[",
+        (unsigned long)ei_profiler_get_dropped_events());
+    for (size_t ix = 0; ix < ei_profiler_get_zone_count(); ix++) {
+        if (!ei_profiler_get_zone_stats(ix, &stats)) {
+            continue;
+        }
+        ei_printf("%s{\"name\":\"%s\",\"count\":%lu,\"min\":%lu,\"mean\":%lu,\"p99\":%lu,\"max\":%lu}",
+            ix == 0 ? "" : ",", stats.name, (unsigned long)stats.count, (unsigned long)stats.min,
+            (unsigned long)stats.mean, (unsigned long)stats.p99, (unsigned long)stats.max);
+    }
+    ei_printf("]}\n");
+}
+
+#endif // EI_PROFILER_ENABLED
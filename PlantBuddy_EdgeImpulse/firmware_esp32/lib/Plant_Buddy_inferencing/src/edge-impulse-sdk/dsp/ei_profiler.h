@@ -31,8 +31,133 @@
 #ifndef __EIPROFILER__H__
 #define __EIPROFILER__H__
 
+#include <stdint.h>
+#include <stddef.h>
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 
+/**
+ * Scoped zone profiler. EI_PROFILE_ZONE("name") times the rest of the enclosing scope
+ * and pushes (zone, duration) into a fixed size lock-free event buffer; recording an
+ * event is two timestamps and a compare-and-swap, there's no printing or allocation on
+ * the hot path, so it's fine for stages that take a few microseconds and can be used
+ * from any task. The buffer is drained on demand by ei_profiler_flush() (called by the
+ * getters and print functions) into per-zone count/min/max/mean/p99 statistics.
+ *
+ * Zone names must have static storage (string literals, __func__). Zones with the same
+ * name are aggregated together, also across translation units.
+ *
+ * If EI_PROFILER_ENABLED is 0 the macros below compile to nothing.
+ */
+
+#ifndef EI_PROFILER_ENABLED
+#define EI_PROFILER_ENABLED 0
+#endif // EI_PROFILER_ENABLED
+
+// Number of distinct zones, zones registered after this are not recorded
+#ifndef EI_PROFILER_MAX_ZONES
+#define EI_PROFILER_MAX_ZONES 16
+#endif // EI_PROFILER_MAX_ZONES
+
+// Number of events that can be recorded between two flushes (must be a power of 2)
+#ifndef EI_PROFILER_EVENT_BUFFER_SIZE
+#define EI_PROFILER_EVENT_BUFFER_SIZE 256
+#endif // EI_PROFILER_EVENT_BUFFER_SIZE
+
+// Timestamp source, defaults to microseconds. Can be pointed to a cycle counter
+// (e.g. esp_cpu_get_cycle_count()), durations are then reported in cycles.
+#ifndef EI_PROFILER_TIMESTAMP
+#define EI_PROFILER_TIMESTAMP() ((uint32_t)ei_read_timer_us())
+#define EI_PROFILER_TIMESTAMP_UNIT "us"
+#endif // EI_PROFILER_TIMESTAMP
+
+#ifndef EI_PROFILER_TIMESTAMP_UNIT
+#define EI_PROFILER_TIMESTAMP_UNIT "ticks"
+#endif // EI_PROFILER_TIMESTAMP_UNIT
+
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    // upper bound of the histogram bucket holding the 99th percentile (buckets are <= 25% wide)
+    uint32_t p99;
+    uint64_t total;
+} ei_profiler_zone_stats_t;
+
+#if EI_PROFILER_ENABLED
+
+#if (EI_PROFILER_EVENT_BUFFER_SIZE & (EI_PROFILER_EVENT_BUFFER_SIZE - 1)) != 0
+#error "EI_PROFILER_EVENT_BUFFER_SIZE must be a power of 2"
+#endif
+
+#define EI_PROFILER_NO_ZONE 0xffff
+
+/**
+ * Look up a zone by name, or add it. Returns EI_PROFILER_NO_ZONE if the table is full.
+ */
+uint16_t ei_profiler_register_zone(const char *name);
+
+/**
+ * Push an event into the buffer. Safe to call from multiple tasks (and ISRs),
+ * events are dropped (and counted) if the buffer is full.
+ */
+void ei_profiler_record(uint16_t zone, uint32_t duration);
+
+/**
+ * Aggregate all recorded events into the per-zone statistics
+ */
+void ei_profiler_flush(void);
+
+/**
+ * Clear the statistics of all zones (zones stay registered)
+ */
+void ei_profiler_reset(void);
+
+size_t ei_profiler_get_zone_count(void);
+bool ei_profiler_get_zone_stats(size_t zone, ei_profiler_zone_stats_t *stats);
+uint32_t ei_profiler_get_dropped_events(void);
+
+void ei_profiler_print(void);
+void ei_profiler_print_json(void);
+
+/**
+ * Records the lifetime of the object into a zone
+ */
+class EiProfilerZone {
+public:
+    EiProfilerZone(uint16_t zone) : zone(zone), start(EI_PROFILER_TIMESTAMP())
+    {
+    }
+
+    ~EiProfilerZone()
+    {
+        ei_profiler_record(zone, EI_PROFILER_TIMESTAMP() - start);
+    }
+
+private:
+    uint16_t zone;
+    uint32_t start;
+};
+
+#define EI_PROFILER_CONCAT_INNER(a, b) a##b
+#define EI_PROFILER_CONCAT(a, b) EI_PROFILER_CONCAT_INNER(a, b)
+
+#define EI_PROFILE_ZONE(name) \
+    static const uint16_t EI_PROFILER_CONCAT(ei_profiler_zone_id_, __LINE__) = ei_profiler_register_zone(name); \
+    EiProfilerZone EI_PROFILER_CONCAT(ei_profiler_zone_, __LINE__)(EI_PROFILER_CONCAT(ei_profiler_zone_id_, __LINE__))
+#define EI_PROFILE_FUNCTION() EI_PROFILE_ZONE(__func__)
+
+#else
+
+#define EI_PROFILE_ZONE(name)
+#define EI_PROFILE_FUNCTION()
+
+#endif // EI_PROFILER_ENABLED
+
+/**
+ * Stopwatch, prints the time since the last reset()/report()
+ */
 class EiProfiler {
 public:
     EiProfiler()
@@ -41,12 +166,13 @@ public:
     }
     void reset()
     {
-        timestamp = ei_read_timer_ms();
+        timestamp = ei_read_timer_us();
     }
     void report(const char *message)
     {
-        ei_printf("%s took %llu\r\n", message, ei_read_timer_ms() - timestamp);
-        timestamp = ei_read_timer_ms(); //read again to not count printf time
+        uint64_t elapsed = ei_read_timer_us() - timestamp;
+        ei_printf("%s took %llu us\r\n", message, (unsigned long long)elapsed);
+        timestamp = ei_read_timer_us(); //read again to not count printf time
     }
 
 private:
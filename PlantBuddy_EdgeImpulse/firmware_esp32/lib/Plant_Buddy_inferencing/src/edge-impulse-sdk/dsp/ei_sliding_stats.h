@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef __EI_SLIDING_STATS__H__
+#define __EI_SLIDING_STATS__H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+
+/**
+ * Moments, minimum and maximum of the last `window_size` samples of a stream,
+ * updated in O(1) per sample. Used for continuous (sliding window) feature
+ * extraction, where a new slice should not cost a pass over the whole window.
+ *
+ * The power sums are kept in double around a shift value (the window mean at
+ * the last resync) so the central moments don't suffer from cancellation when
+ * the mean is large compared to the spread. Every `window_size` samples the
+ * sums are rebuilt from the ring buffer to drop accumulated rounding error, so
+ * the amortized cost stays O(1).
+ *
+ * Minimum and maximum use monotonic queues over ring positions, and are only
+ * allocated when asked for.
+ *
+ * The reported values follow the definitions in numpy.hpp (population stdev,
+ * skew of 0 and kurtosis of -3 for a constant window).
+ */
+class ei_sliding_stats {
+public:
+    ei_sliding_stats() { }
+
+    ~ei_sliding_stats() {
+        release();
+    }
+
+    ei_sliding_stats(const ei_sliding_stats&) = delete;
+    ei_sliding_stats& operator=(const ei_sliding_stats&) = delete;
+
+    ei_sliding_stats(ei_sliding_stats &&other) noexcept {
+        take(other);
+    }
+
+    ei_sliding_stats& operator=(ei_sliding_stats &&other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    /**
+     * Allocate the window. Any previous contents are dropped.
+     * @param window_size Number of samples in the window (> 0)
+     * @param track_min_max Also keep the minimum and maximum
+     * @returns EIDSP_OK if OK
+     */
+    int init(size_t window_size, bool track_min_max) {
+        release();
+
+        if (window_size == 0 || window_size > UINT32_MAX) {
+            return ei::EIDSP_PARAMETER_INVALID;
+        }
+
+        values = (float*)ei_malloc(window_size * sizeof(float));
+        if (track_min_max) {
+            min_queue.positions = (uint32_t*)ei_malloc(window_size * sizeof(uint32_t));
+            max_queue.positions = (uint32_t*)ei_malloc(window_size * sizeof(uint32_t));
+        }
+        if (!values || (track_min_max && (!min_queue.positions || !max_queue.positions))) {
+            release();
+            return ei::EIDSP_OUT_OF_MEM;
+        }
+
+        capacity = window_size;
+        reset();
+        return ei::EIDSP_OK;
+    }
+
+    /**
+     * Free the window
+     */
+    void release() {
+        ei_free(values);
+        ei_free(min_queue.positions);
+        ei_free(max_queue.positions);
+        values = nullptr;
+        min_queue.positions = nullptr;
+        max_queue.positions = nullptr;
+        capacity = 0;
+        reset();
+    }
+
+    /**
+     * Empty the window, keeping the buffers
+     */
+    void reset() {
+        head = 0;
+        count = 0;
+        pushes_since_resync = 0;
+        shift = 0.0;
+        s1 = s2 = s3 = s4 = 0.0;
+        min_queue.front = min_queue.size = 0;
+        max_queue.front = max_queue.size = 0;
+    }
+
+    /**
+     * Append a sample, evicting the oldest one when the window is full
+     */
+    void push(float x) {
+        size_t pos;
+
+        if (count == capacity) {
+            pos = head;
+            const double d = (double)values[pos] - shift;
+            const double d2 = d * d;
+            s1 -= d;
+            s2 -= d2;
+            s3 -= d2 * d;
+            s4 -= d2 * d2;
+            // the oldest sample can only be at the front of a queue
+            min_queue.expire(pos, capacity);
+            max_queue.expire(pos, capacity);
+            head = next(head);
+        }
+        else {
+            if (count == 0) {
+                shift = x;
+            }
+            pos = head + count;
+            if (pos >= capacity) {
+                pos -= capacity;
+            }
+            count++;
+        }
+
+        values[pos] = x;
+
+        const double d = (double)x - shift;
+        const double d2 = d * d;
+        s1 += d;
+        s2 += d2;
+        s3 += d2 * d;
+        s4 += d2 * d2;
+
+        if (min_queue.positions) {
+            while (min_queue.size > 0 && values[min_queue.back(capacity)] >= x) {
+                min_queue.size--;
+            }
+            min_queue.push_back((uint32_t)pos, capacity);
+
+            while (max_queue.size > 0 && values[max_queue.back(capacity)] <= x) {
+                max_queue.size--;
+            }
+            max_queue.push_back((uint32_t)pos, capacity);
+        }
+
+        if (++pushes_since_resync >= capacity) {
+            resync();
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool full() const {
+        return capacity > 0 && count == capacity;
+    }
+
+    float mean() const {
+        if (count == 0) return 0.0f;
+        return (float)(shift + s1 / count);
+    }
+
+    /**
+     * Minimum of the window, needs track_min_max
+     */
+    float min() const {
+        if (!min_queue.positions || min_queue.size == 0) return 0.0f;
+        return values[min_queue.positions[min_queue.front]];
+    }
+
+    /**
+     * Maximum of the window, needs track_min_max
+     */
+    float max() const {
+        if (!max_queue.positions || max_queue.size == 0) return 0.0f;
+        return values[max_queue.positions[max_queue.front]];
+    }
+
+    float rms() const {
+        if (count == 0) return 0.0f;
+        const double m = shift + s1 / count;
+        return (float)sqrt(m * m + central_m2());
+    }
+
+    float stdev() const {
+        return (float)sqrt(central_m2());
+    }
+
+    float skew() const {
+        const double m2 = central_m2();
+        if (m2 == 0.0) return 0.0f;
+        const double d = s1 / count;
+        const double m3 = s3 / count - 3.0 * d * (s2 / count) + 2.0 * d * d * d;
+        return (float)(m3 / sqrt(m2 * m2 * m2));
+    }
+
+    float kurtosis() const {
+        const double m2 = central_m2();
+        if (m2 == 0.0) return -3.0f;
+        const double d = s1 / count;
+        const double d2 = d * d;
+        const double m4 = s4 / count - 4.0 * d * (s3 / count) + 6.0 * d2 * (s2 / count) - 3.0 * d2 * d2;
+        return (float)(m4 / (m2 * m2) - 3.0);
+    }
+
+private:
+    /**
+     * Ring of ring-buffer positions, front is the oldest entry
+     */
+    struct position_queue {
+        uint32_t *positions = nullptr;
+        size_t front = 0;
+        size_t size = 0;
+
+        uint32_t back(size_t capacity) const {
+            size_t ix = front + size - 1;
+            if (ix >= capacity) ix -= capacity;
+            return positions[ix];
+        }
+
+        void push_back(uint32_t pos, size_t capacity) {
+            size_t ix = front + size;
+            if (ix >= capacity) ix -= capacity;
+            positions[ix] = pos;
+            size++;
+        }
+
+        void expire(size_t pos, size_t capacity) {
+            if (positions && size > 0 && positions[front] == pos) {
+                front++;
+                if (front >= capacity) front = 0;
+                size--;
+            }
+        }
+    };
+
+    size_t next(size_t ix) const {
+        ix++;
+        return ix >= capacity ? 0 : ix;
+    }
+
+    /**
+     * Variance, with values that are zero up to rounding reported as 0
+     */
+    double central_m2() const {
+        if (count == 0) return 0.0;
+        const double d = s1 / count;
+        const double e2 = s2 / count;
+        const double m2 = e2 - d * d;
+        if (m2 <= e2 * 1e-12) return 0.0;
+        return m2;
+    }
+
+    /**
+     * Re-center the sums on the current mean and rebuild them from the window
+     */
+    void resync() {
+        pushes_since_resync = 0;
+        shift = shift + s1 / count;
+        s1 = s2 = s3 = s4 = 0.0;
+        size_t ix = head;
+        for (size_t i = 0; i < count; i++) {
+            const double d = (double)values[ix] - shift;
+            const double d2 = d * d;
+            s1 += d;
+            s2 += d2;
+            s3 += d2 * d;
+            s4 += d2 * d2;
+            ix = next(ix);
+        }
+    }
+
+    void take(ei_sliding_stats &other) {
+        values = other.values;
+        capacity = other.capacity;
+        head = other.head;
+        count = other.count;
+        pushes_since_resync = other.pushes_since_resync;
+        shift = other.shift;
+        s1 = other.s1;
+        s2 = other.s2;
+        s3 = other.s3;
+        s4 = other.s4;
+        min_queue = other.min_queue;
+        max_queue = other.max_queue;
+        other.values = nullptr;
+        other.min_queue.positions = nullptr;
+        other.max_queue.positions = nullptr;
+        other.capacity = 0;
+        other.reset();
+    }
+
+    float *values = nullptr;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t count = 0;
+    size_t pushes_since_resync = 0;
+    double shift = 0.0;
+    double s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;
+    position_queue min_queue;
+    position_queue max_queue;
+};
+
+#endif // __EI_SLIDING_STATS__H__
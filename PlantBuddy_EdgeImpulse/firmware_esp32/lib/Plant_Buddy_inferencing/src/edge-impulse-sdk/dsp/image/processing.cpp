@@ -34,6 +34,7 @@
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 #include "edge-impulse-sdk/classifier/ei_constants.h"
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_simd_kernels.h"
 #include <string.h>
 #include <stddef.h>
 
@@ -544,6 +545,175 @@ int resize_image_using_mode(
     // shouldn't get here
     return -2;
 }
+
+/**
+ * @brief Read one pixel of a raw frame row as RGB888
+ */
+static inline void read_frame_pixel(const uint8_t *row, int x, PIXEL_FORMAT format, int32_t *rgb)
+{
+    if (format == PIXEL_FORMAT_RGB888) {
+        const uint8_t *p = row + x * 3;
+        rgb[0] = p[0];
+        rgb[1] = p[1];
+        rgb[2] = p[2];
+    }
+    else if (format == PIXEL_FORMAT_RGB565) {
+        uint32_t p = ((uint32_t)row[x * 2] << 8) | row[x * 2 + 1];
+        uint32_t r = p >> 11, g = (p >> 5) & 0x3f, b = p & 0x1f;
+        // replicate the high bits, so 0x1f maps to 0xff
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+    else {
+        // same conversion as yuv422_to_rgb888
+        const uint8_t *p = row + (x >> 1) * 4;
+        int u = p[0] - 128;
+        int y = p[1 + ((x & 1) << 1)] - 16;
+        int v = p[2] - 128;
+        rgb[0] = EI_CLAMP(EI_GET_R_FROM_YUV(y, u, v));
+        rgb[1] = EI_CLAMP(EI_GET_G_FROM_YUV(y, u, v));
+        rgb[2] = EI_CLAMP(EI_GET_B_FROM_YUV(y, u, v));
+    }
+}
+
+int resize_frame_to_rgb888_rows(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    PIXEL_FORMAT format,
+    int dstWidth,
+    int dstHeight,
+    int mode,
+    rgb888_row_fn_t row_fn,
+    void *ctx)
+{
+    // same fixed point as resize_image()
+    constexpr int FRAC_BITS = 14;
+    constexpr int FRAC_VAL = (1 << FRAC_BITS);
+    constexpr int FRAC_MASK = (FRAC_VAL - 1);
+
+    if (!srcImage || !row_fn || srcWidth < 1 || srcHeight < 1 || dstWidth < 1 || dstHeight < 1) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+    if (format != PIXEL_FORMAT_RGB888 && format != PIXEL_FORMAT_RGB565 && format != PIXEL_FORMAT_YUV422) {
+        return EIDSP_NOT_SUPPORTED;
+    }
+
+    // source region that gets resized, and where it lands in the output
+    int cropX = 0, cropY = 0, cropWidth = srcWidth, cropHeight = srcHeight;
+    int startX = 0, startY = 0, resizeWidth = dstWidth, resizeHeight = dstHeight;
+
+    if (mode == EI_CLASSIFIER_RESIZE_FIT_SHORTEST) {
+        calculate_crop_dims(srcWidth, srcHeight, dstWidth, dstHeight, cropWidth, cropHeight);
+        cropX = (srcWidth - cropWidth) / 2;
+        cropY = (srcHeight - cropHeight) / 2;
+    }
+    else if (mode == EI_CLASSIFIER_RESIZE_FIT_LONGEST) {
+        // as resize_image_using_mode()
+        float srcAspect = static_cast<float>(srcWidth) / srcHeight;
+        float dstAspect = static_cast<float>(dstWidth) / dstHeight;
+        if (srcAspect > dstAspect) {
+            resizeHeight = static_cast<int>(dstWidth / srcAspect);
+        }
+        else {
+            resizeWidth = static_cast<int>(dstHeight * srcAspect);
+        }
+        if (resizeWidth < 1 || resizeHeight < 1) {
+            return EIDSP_PARAMETER_INVALID;
+        }
+        startX = (dstWidth - resizeWidth) / 2;
+        startY = (dstHeight - resizeHeight) / 2;
+    }
+    else if (mode != EI_CLASSIFIER_RESIZE_SQUASH && mode != EI_CLASSIFIER_RESIZE_NONE) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+    if (cropWidth < 1 || cropHeight < 1) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+
+    const size_t row_stride = (size_t)srcWidth * (format == PIXEL_FORMAT_RGB888 ? 3 : 2);
+    const uint32_t src_x_frac = (cropWidth * FRAC_VAL) / resizeWidth;
+    const uint32_t src_y_frac = (cropHeight * FRAC_VAL) / resizeHeight;
+
+    // scratch: source columns and weights per output column, two horizontally
+    // interpolated source rows and the output row
+    const size_t line_size = (size_t)resizeWidth * 3;
+    uint8_t *scratch = (uint8_t*)ei_malloc(
+        (size_t)resizeWidth * 3 * sizeof(int32_t) + 2 * line_size + (size_t)dstWidth * 3);
+    if (!scratch) {
+        return EIDSP_OUT_OF_MEM;
+    }
+    int32_t *col_x0 = (int32_t*)scratch;
+    int32_t *col_x1 = col_x0 + resizeWidth;
+    int32_t *col_frac = col_x1 + resizeWidth;
+    uint8_t *lines[2] = { (uint8_t*)(col_frac + resizeWidth), (uint8_t*)(col_frac + resizeWidth) + line_size };
+    int line_rows[2] = { -1, -1 };
+    uint8_t *out_row = lines[1] + line_size;
+    uint8_t *out_pixels = out_row + startX * 3;
+
+    for (int x = 0; x < resizeWidth; x++) {
+        uint32_t src_x_accum = x * src_x_frac;
+        int tx = src_x_accum >> FRAC_BITS;
+        col_x0[x] = cropX + tx;
+        col_x1[x] = cropX + (tx + 1 < cropWidth ? tx + 1 : cropWidth - 1);
+        col_frac[x] = src_x_accum & FRAC_MASK;
+    }
+
+    // horizontal pass over one source row, into a line buffer that isn't holding `keep`
+    auto load_line = [&](int src_row, int keep) -> uint8_t* {
+        for (int ix = 0; ix < 2; ix++) {
+            if (line_rows[ix] == src_row) {
+                return lines[ix];
+            }
+        }
+        int slot = line_rows[0] == keep ? 1 : 0;
+        const uint8_t *s = srcImage + (size_t)(cropY + src_row) * row_stride;
+        uint8_t *d = lines[slot];
+        for (int x = 0; x < resizeWidth; x++) {
+            int32_t p0[3], p1[3];
+            read_frame_pixel(s, col_x0[x], format, p0);
+            read_frame_pixel(s, col_x1[x], format, p1);
+            uint32_t x_frac = col_frac[x];
+            uint32_t nx_frac = FRAC_VAL - x_frac;
+            for (int color = 0; color < 3; color++) {
+                *d++ = (uint8_t)((p0[color] * nx_frac + p1[color] * x_frac + FRAC_VAL / 2) >> FRAC_BITS);
+            }
+        }
+        line_rows[slot] = src_row;
+        return lines[slot];
+    };
+
+    // letterbox (FIT_LONGEST) is black, like resize_image_using_mode()
+    memset(out_row, 0, (size_t)dstWidth * 3);
+
+    int res = EIDSP_OK;
+    for (int y = 0; y < dstHeight && res == EIDSP_OK; y++) {
+        int ry = y - startY;
+        if (ry < 0 || ry >= resizeHeight) {
+            memset(out_pixels, 0, line_size);
+            res = row_fn(out_row, dstWidth, y, ctx);
+            continue;
+        }
+        uint32_t src_y_accum = ry * src_y_frac;
+        int ty = src_y_accum >> FRAC_BITS;
+        int ty1 = ty + 1 < cropHeight ? ty + 1 : cropHeight - 1;
+        uint32_t y_frac = src_y_accum & FRAC_MASK;
+
+        uint8_t *top = load_line(ty, y_frac ? ty1 : -1);
+        if (y_frac) {
+            uint8_t *bottom = load_line(ty1, ty);
+            ei::simd::lerp_u8(out_pixels, top, bottom, line_size, y_frac);
+        }
+        else {
+            memcpy(out_pixels, top, line_size);
+        }
+        res = row_fn(out_row, dstWidth, y, ctx);
+    }
+
+    ei_free(scratch);
+    return res;
+}
 } //namespaces
 }
 }
@@ -216,5 +216,52 @@ int resize_image_using_mode(
     int dstHeight,
     int pixel_size_B,
     int mode);
+
+enum PIXEL_FORMAT
+{
+    PIXEL_FORMAT_RGB888 = 0, // 3B per pixel, R first
+    PIXEL_FORMAT_RGB565 = 1, // 2B per pixel, big endian (as camera sensors send it)
+    PIXEL_FORMAT_YUV422 = 2, // 4B per 2 pixels: U, Y0, V, Y1 (as yuv422_to_rgb888)
+};
+
+/**
+ * @brief Receives one output row of resize_frame_to_rgb888_rows()
+ *
+ * @param rgb_row Row of width pixels, packed RGB888
+ * @param width Row width in pixels
+ * @param y Row index
+ * @param ctx Context pointer passed to resize_frame_to_rgb888_rows()
+ * @return EIDSP_OK to continue
+ */
+typedef int (*rgb888_row_fn_t)(const uint8_t *rgb_row, int width, int y, void *ctx);
+
+/**
+ * @brief Convert, crop and resize a raw camera frame in one pass, handing every output
+ * row to row_fn as RGB888 instead of writing a full-size intermediate image.
+ * Uses the arithmetic of resize_image(), so the rows are identical to converting the whole
+ * frame (e.g. yuv422_to_rgb888) and calling resize_image_using_mode() when downscaling.
+ * Reads outside the (cropped) frame are clamped to its edge.
+ *
+ * @param srcImage Raw frame
+ * @param srcWidth Frame width in pixels
+ * @param srcHeight Frame height in pixels
+ * @param format Pixel format of the frame
+ * @param dstWidth Output width in pixels
+ * @param dstHeight Output height in pixels
+ * @param mode Resizing mode (NONE=0 and SQUASH=3 stretch, FIT_SHORTEST=1, FIT_LONGEST=2)
+ * @param row_fn Called for every output row, top to bottom
+ * @param ctx Passed to row_fn
+ * @return int Status code (EIDSP_OK for success)
+ */
+int resize_frame_to_rgb888_rows(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    PIXEL_FORMAT format,
+    int dstWidth,
+    int dstHeight,
+    int mode,
+    rgb888_row_fn_t row_fn,
+    void *ctx);
 }}} //namespaces
 #endif //!__EI_IMAGE_PROCESSING__H__
\ No newline at end of file
@@ -38,6 +38,7 @@
 #include "../porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "config.hpp"
+#include "ei_alloc_profiler.h"
 
 extern size_t ei_memory_in_use;
 extern size_t ei_memory_peak_use;
@@ -80,6 +81,7 @@ namespace ei {
         if (ei_memory_in_use > ei_memory_peak_use) { \
             ei_memory_peak_use = ei_memory_in_use; \
         } \
+        ei_alloc_profiler_on_alloc(fn, file, line, bytes, ptr); \
         ei_dsp_printf("alloc %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)bytes, (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
 
@@ -95,6 +97,7 @@ namespace ei {
         if (ei_memory_in_use > ei_memory_peak_use) { \
             ei_memory_peak_use = ei_memory_in_use; \
         } \
+        ei_alloc_profiler_on_alloc(fn, file, line, (rows * cols * type_size), ptr); \
         ei_dsp_printf("alloc matrix %lu x %lu = %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)rows, (unsigned long)cols, (unsigned long)(rows * cols * type_size), (unsigned long)ei_memory_in_use, \
                 (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
@@ -105,6 +108,7 @@ namespace ei {
      */
     #define ei_dsp_register_free_internal(fn, file, line, bytes, ptr) \
         ei_memory_in_use -= bytes; \
+        ei_alloc_profiler_on_free(bytes, ptr); \
         ei_dsp_printf("free %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)bytes, (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
 
@@ -117,6 +121,7 @@ namespace ei {
      */
     #define ei_dsp_register_matrix_free_internal(fn, file, line, rows, cols, type_size, ptr) \
         ei_memory_in_use -= (rows * cols * type_size); \
+        ei_alloc_profiler_on_free((rows * cols * type_size), ptr); \
         ei_dsp_printf("free matrix %lu x %lu = %lu bytes (in_use=%lu, peak=%lu) (%s@ %s:%d) %p\n", \
             (unsigned long)rows, (unsigned long)cols, (unsigned long)(rows * cols * type_size), \
                 (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
@@ -131,6 +136,7 @@ namespace ei {
 
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
+    #define EI_DSP_MATRIX_BULK(name, ...) matrix_t name(__VA_ARGS__, EI_MEMORY_TIER_BULK, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
 #else
@@ -143,6 +149,7 @@ namespace ei {
     #define ei_dsp_free(ptr, size) ei_free(ptr)
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
+    #define EI_DSP_MATRIX_BULK(name, ...) matrix_t name(__VA_ARGS__, EI_MEMORY_TIER_BULK); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
 #endif
@@ -61,6 +61,7 @@
 #include "ei_utils.h"
 #include "dct/fast-dct-fft.h"
 #include "kissfft/kiss_fftr.h"
+#include "ei_fft_plan.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 
 #if __has_include("model-parameters/model_metadata.h")
@@ -82,6 +83,10 @@
 #include "edge-impulse-sdk/dsp/dsp_engines/ei_no_hw_dsp.h"
 #endif
 
+#if !EIDSP_USE_CMSIS_DSP
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_simd_kernels.h"
+#endif
+
 // More decisions on kissfft
 #ifndef EIDSP_INCLUDE_KISSFFT
 
@@ -229,11 +234,15 @@ public:
     }
 
     static float sum(float *input_array, size_t input_array_size) {
+#if EIDSP_USE_CMSIS_DSP
         float res = 0.0f;
         for (size_t ix = 0; ix < input_array_size; ix++) {
             res += input_array[ix];
         }
         return res;
+#else
+        return ei::simd::sum(input_array, input_array_size);
+#endif
     }
 
     /**
@@ -342,12 +351,11 @@ public:
             EIDSP_ERR(status);
         }
 #else
-        for (size_t j = 0; j < matrix2->cols; j++) {
-            float tmp = 0.0f;
-            for (size_t k = 0; k < matrix1_cols; k++) {
-                tmp += row[k] * matrix2->buffer[k * matrix2->cols + j];
-            }
-            out_matrix->buffer[i * matrix2->cols + j] += tmp;
+        // walk matrix2 row by row rather than column by column, so every step is
+        // a contiguous y += a * x over the output row
+        float *out_row = out_matrix->buffer + (i * matrix2->cols);
+        for (size_t k = 0; k < matrix1_cols; k++) {
+            ei::simd::axpy(out_row, matrix2->buffer + (k * matrix2->cols), matrix2->cols, row[k]);
         }
 #endif
 
@@ -788,9 +796,7 @@ public:
             return status;
         }
 #else
-        for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] *= scale;
-        }
+        ei::simd::scale(matrix->buffer, matrix->rows * matrix->cols, scale);
 #endif
         return EIDSP_OK;
     }
@@ -829,9 +835,13 @@ public:
      * @returns 0 if OK
      */
     static int add(matrix_t *matrix, float addition) {
+#if EIDSP_USE_CMSIS_DSP
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] += addition;
         }
+#else
+        ei::simd::offset(matrix->buffer, matrix->rows * matrix->cols, addition);
+#endif
         return EIDSP_OK;
     }
 
@@ -868,9 +878,13 @@ public:
      * @returns 0 if OK
      */
     static int subtract(matrix_t *matrix, float subtraction) {
+#if EIDSP_USE_CMSIS_DSP
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] -= subtraction;
         }
+#else
+        ei::simd::offset(matrix->buffer, matrix->rows * matrix->cols, -subtraction);
+#endif
         return EIDSP_OK;
     }
 
@@ -921,11 +935,7 @@ public:
             arm_rms_f32(matrix->buffer + (row * matrix->cols), matrix->cols, &rms_result);
             output_matrix->buffer[row] = rms_result;
 #else
-            float sum = 0.0;
-            for(size_t ix = 0; ix < matrix->cols; ix++) {
-                float v = matrix->buffer[(row * matrix->cols) + ix];
-                sum += v * v;
-            }
+            float sum = ei::simd::sum_squares(matrix->buffer + (row * matrix->cols), matrix->cols);
             output_matrix->buffer[row] = sqrt(sum / static_cast<float>(matrix->cols));
 #endif
         }
@@ -952,11 +962,7 @@ public:
             arm_mean_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &mean);
             output_matrix->buffer[row] = mean;
 #else
-            float sum = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                sum += input_matrix->buffer[( row * input_matrix->cols ) + col];
-            }
+            float sum = ei::simd::sum(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols);
 
             output_matrix->buffer[row] = sum / input_matrix->cols;
 #endif
@@ -980,6 +986,7 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_USE_CMSIS_DSP
         for (size_t col = 0; col < input_matrix->cols; col++) {
             // Note - not using CMSIS-DSP here
             // gathering up the current columnand moving it into sequential memory to use
@@ -995,6 +1002,18 @@ public:
 
             output_matrix->buffer[col] = sum / input_matrix->rows;
         }
+#else
+        // accumulate whole rows into the output; every column still sums its
+        // values in row order, so this matches the column-wise loop exactly
+        memset(output_matrix->buffer, 0, input_matrix->cols * sizeof(float));
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            ei::simd::axpy(output_matrix->buffer, input_matrix->buffer + (row * input_matrix->cols),
+                input_matrix->cols, 1.0f);
+        }
+        for (size_t col = 0; col < input_matrix->cols; col++) {
+            output_matrix->buffer[col] /= input_matrix->rows;
+        }
+#endif
 
         return EIDSP_OK;
     }
@@ -1061,16 +1080,7 @@ public:
             arm_min_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &min, &ix);
             output_matrix->buffer[row] = min;
 #else
-            float min = FLT_MAX;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                float v = input_matrix->buffer[( row * input_matrix->cols ) + col];
-                if (v < min) {
-                    min = v;
-                }
-            }
-
-            output_matrix->buffer[row] = min;
+            output_matrix->buffer[row] = ei::simd::min(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols);
 #endif
         }
 
@@ -1097,16 +1107,7 @@ public:
             arm_max_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &max, &ix);
             output_matrix->buffer[row] = max;
 #else
-            float max = -FLT_MAX;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                float v = input_matrix->buffer[( row * input_matrix->cols ) + col];
-                if (v > max) {
-                    max = v;
-                }
-            }
-
-            output_matrix->buffer[row] = max;
+            output_matrix->buffer[row] = ei::simd::max(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols);
 #endif
         }
 
@@ -1134,21 +1135,9 @@ public:
             arm_sqrt_f32(var, &std);
             output_matrix->buffer[row] = std;
 #else
-            float sum = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                sum += input_matrix->buffer[(row * input_matrix->cols) + col];
-            }
-
-            float mean = sum / input_matrix->cols;
-
-            float std = 0.0f;
-
-            for (size_t col = 0; col < input_matrix->cols; col++) {
-                float diff;
-                diff = input_matrix->buffer[(row * input_matrix->cols) + col] - mean;
-                std += diff * diff;
-            }
+            const float *row_buffer = input_matrix->buffer + (row * input_matrix->cols);
+            float mean = ei::simd::sum(row_buffer, input_matrix->cols) / input_matrix->cols;
+            float std = ei::simd::sum_squared_diff(row_buffer, input_matrix->cols, mean);
 
             output_matrix->buffer[row] = sqrt(std / input_matrix->cols);
 #endif
@@ -1318,11 +1307,16 @@ public:
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
         }
 
-        fft_complex_t *fft_output = NULL;
-        auto ptr = EI_MAKE_TRACKED_POINTER(fft_output, n_fft_out_features);
-        EI_ERR_AND_RETURN_ON_NULL(fft_output, EIDSP_OUT_OF_MEM);
+        // the complex spectrum is only an intermediate here, so keep it in the cached plan
+        ei::fft::fft_plan_lease plan(n_fft);
+        fft_complex_t *fft_output = plan.spectrum();
+        ei_unique_ptr_t ptr;
+        if (!fft_output) {
+            ptr = EI_MAKE_TRACKED_POINTER(fft_output, n_fft_out_features);
+            EI_ERR_AND_RETURN_ON_NULL(fft_output, EIDSP_OUT_OF_MEM);
+        }
 
-        int ret = rfft(src, src_size, fft_output, n_fft_out_features, n_fft);
+        int ret = rfft_with_plan(plan, src, src_size, fft_output, n_fft);
         if (ret != EIDSP_OK) {
             return ret;
         }
@@ -1351,6 +1345,25 @@ public:
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
         }
 
+        ei::fft::fft_plan_lease plan(n_fft);
+        return rfft_with_plan(plan, src, src_size, output, n_fft);
+    }
+
+    /**
+     * rfft() on a plan the caller already holds. Uses the plan's scratch and
+     * FFT state when the plan is valid, otherwise allocates them for this call.
+     * @param plan Plan leased for n_fft
+     * @param src Source buffer
+     * @param src_size Size of the source buffer
+     * @param output Output buffer, n_fft / 2 + 1 bins
+     * @param n_fft FFT size
+     * @returns 0 if OK
+     */
+    static int rfft_with_plan(ei::fft::fft_plan_lease &plan, const float *src, size_t src_size,
+        fft_complex_t *output, size_t n_fft)
+    {
+        size_t n_fft_out_features = (n_fft / 2) + 1;
+
         // truncate if needed
         if (src_size > n_fft) {
             src_size = n_fft;
@@ -1358,24 +1371,13 @@ public:
 
         // Unfortunately, arm fft (at least) modifies the input buffer AND does not work in place
         // So we have to copy the input to a new buffer
-        EI_DSP_MATRIX(fft_input, 1, n_fft);
-        if (!fft_input.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        // If the buffer wasn't assigned to source above, let's copy and pad
-        // copy from src to fft_input
-        memcpy(fft_input.buffer, src, src_size * sizeof(float));
-        // pad to the rigth with zeros
-        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
-
-        auto res = ei::fft::hw_r2c_fft(fft_input.buffer, output, n_fft);
-        if (handle_fft_hw_failure(res, n_fft)) {
-            // fallback to software
-            return software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
+        float *fft_input = plan.scratch();
+        if (!fft_input) {
+            EI_DSP_MATRIX(fft_input_matrix, 1, n_fft);
+            return rfft_staged(fft_input_matrix.buffer, nullptr, src, src_size, output, n_fft, n_fft_out_features);
         }
 
-        return EIDSP_OK;
+        return rfft_staged(fft_input, &plan, src, src_size, output, n_fft, n_fft_out_features);
     }
 
 
@@ -1505,6 +1507,7 @@ public:
             return numpy::signal_get_data(data, offset, length, out_ptr);
         };
 #endif
+        signal->raw_buffer = data;
         return EIDSP_OK;
     }
 
@@ -1741,9 +1744,16 @@ public:
         return EIDSP_OK;
     }
 
-    static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
+    static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features,
+        ei::fft::fft_plan_lease *plan = nullptr)
     {
     #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
+        kiss_fftr_cfg cached_cfg = plan ? plan->kiss_cfg() : nullptr;
+        if (cached_cfg) {
+            kiss_fftr(cached_cfg, fft_input, (kiss_fft_cpx*)output);
+            return EIDSP_OK;
+        }
+
         // create fftr context
         size_t kiss_fftr_mem_length;
 
@@ -2221,11 +2231,15 @@ public:
     }
 
     __attribute__((unused)) static float sum(const float* v, size_t n) {
+#if EIDSP_USE_CMSIS_DSP
         float sum = 0;
         for (size_t i = 0; i < n; i++) {
             sum += v[i];
         }
         return sum;
+#else
+        return ei::simd::sum(v, n);
+#endif
     }
 
     static float mean(const fvec& v) {
@@ -2393,11 +2407,15 @@ public:
     }
 
     static float dot(const float* x, const float* y, size_t n) {
+#if EIDSP_USE_CMSIS_DSP
         float res = 0;
         for (size_t i = 0; i < n; i++) {
             res += x[i] * y[i];
         }
         return res;
+#else
+        return ei::simd::dot(x, y, n);
+#endif
     }
 
 
@@ -2467,6 +2485,32 @@ public:
     }
 
 private:
+    /**
+     * Copy and zero pad src into fft_input, then run the HW rfft, falling back to kissfft.
+     * @param fft_input n_fft floats of scratch, may be overwritten by the FFT
+     * @param plan Plan for n_fft, or nullptr when running without one
+     */
+    static int rfft_staged(float *fft_input, ei::fft::fft_plan_lease *plan, const float *src, size_t src_size,
+        fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
+    {
+        // copy from src to fft_input
+        memcpy(fft_input, src, src_size * sizeof(float));
+        // pad to the rigth with zeros
+        memset(fft_input + src_size, 0, (n_fft - src_size) * sizeof(float));
+
+#if EIDSP_USE_ESP_DSP
+        auto res = ei::fft::hw_r2c_fft(fft_input, output, n_fft, plan ? plan->rfft_twiddles() : nullptr);
+#else
+        auto res = ei::fft::hw_r2c_fft(fft_input, output, n_fft);
+#endif
+        if (handle_fft_hw_failure(res, n_fft)) {
+            // fallback to software
+            return software_rfft(fft_input, output, n_fft, n_fft_out_features, plan);
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Helper function to handle FFT hardware acceleration failures and logging
      * @param res Result code from hardware FFT attempt
@@ -44,6 +44,7 @@
 #endif // __cplusplus
 #include "config.hpp"
 #include "edge-impulse-sdk/dsp/returntypes.h"
+#include "edge-impulse-sdk/porting/ei_memory_tiers.h"
 
 #if EIDSP_TRACK_ALLOCATIONS
 #include "memory.hpp"
@@ -112,21 +113,41 @@ typedef struct ei_matrix {
 
         if (!a_buffer) {
 #if EIDSP_TRACK_ALLOCATIONS
-            _fn = fn;
-            _file = file;
-            _line = line;
-            _originally_allocated_rows = rows;
-            _originally_allocated_cols = cols;
-            if (_fn) {
-                ei_dsp_register_matrix_alloc_internal(fn, file, line, rows, cols, sizeof(float), buffer);
-            }
-            else {
-                ei_dsp_register_matrix_alloc(rows, cols, sizeof(float), buffer);
-            }
+            register_alloc(fn, file, line);
 #endif
         }
     }
 
+    /**
+     * Create a new matrix on the heap, in a memory tier (see ei_memory_tiers.h).
+     * Use EI_MEMORY_TIER_BULK for large scratch that's streamed through once.
+     * @param n_rows Number of rows
+     * @param n_cols Number of columns
+     * @param tier Memory tier to allocate the buffer from
+     */
+    ei_matrix(
+        uint32_t n_rows,
+        uint32_t n_cols,
+        ei_memory_tier_t tier
+#if EIDSP_TRACK_ALLOCATIONS
+        ,
+        const char *fn = NULL,
+        const char *file = NULL,
+        int line = 0
+#endif
+        )
+    {
+        buffer = (float*)(tier == EI_MEMORY_TIER_BULK ?
+            ei_calloc_bulk(n_rows * n_cols, sizeof(float)) : ei_calloc_hot(n_rows * n_cols, sizeof(float)));
+        buffer_managed_by_me = true;
+        rows = n_rows;
+        cols = n_cols;
+
+#if EIDSP_TRACK_ALLOCATIONS
+        register_alloc(fn, file, line);
+#endif
+    }
+
     ~ei_matrix() {
         if (buffer && buffer_managed_by_me) {
             ei_free(buffer);
@@ -144,6 +165,23 @@ typedef struct ei_matrix {
         }
     }
 
+#if EIDSP_TRACK_ALLOCATIONS
+    void register_alloc(const char *fn, const char *file, int line)
+    {
+        _fn = fn;
+        _file = file;
+        _line = line;
+        _originally_allocated_rows = rows;
+        _originally_allocated_cols = cols;
+        if (_fn) {
+            ei_dsp_register_matrix_alloc_internal(fn, file, line, rows, cols, sizeof(float), buffer);
+        }
+        else {
+            ei_dsp_register_matrix_alloc(rows, cols, sizeof(float), buffer);
+        }
+    }
+#endif
+
     /**
      * @brief Get a pointer to the buffer advanced by n rows
      *
@@ -699,6 +737,17 @@ typedef struct ei_signal_t {
      *  preprocessing and inference.
     */
     size_t total_length;
+
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+    /**
+     * Optional pointer to the contiguous float buffer that backs this signal (set by
+     * `numpy::signal_from_buffer()`). When set, `raw_buffer[offset]` must equal the
+     * value `get_data()` returns for `offset`, which lets wrappers such as
+     * SignalWithAxes read directly from memory instead of going through the callback.
+     * Leave as `nullptr` for custom `get_data()` implementations.
+    */
+    const float *raw_buffer = nullptr;
+#endif // EIDSP_SIGNAL_C_FN_POINTER == 0
 } signal_t;
 
 /** @} */
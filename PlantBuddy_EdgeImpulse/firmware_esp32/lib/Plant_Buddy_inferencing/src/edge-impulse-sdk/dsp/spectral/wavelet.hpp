@@ -49,246 +49,360 @@ inline float dot(const float *x, const float *y, size_t sz)
     return sum;
 }
 
-inline void histo(const fvec &x, size_t nbins, fvec &h, bool normalize = false)
+/**
+ * Same as dot(), but walks y backwards (y[sz - 1] first), so filter taps can be
+ * applied time-reversed straight from the coefficient tables.
+ */
+inline float dot_reversed(const float *x, const float *y, size_t sz)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < sz; i++) {
+        sum += x[i] * y[sz - 1 - i];
+    }
+    return sum;
+}
+
+inline void histo(const float *x, size_t nx, size_t nbins, float *h, bool normalize = false)
 {
-    float min = *std::min_element(x.begin(), x.end());
-    float max = *std::max_element(x.begin(), x.end());
+    float min = *std::min_element(x, x + nx);
+    float max = *std::max_element(x, x + nx);
     float step = (max - min) / nbins;
-    h.resize(nbins);
-    for (size_t i = 0; i < x.size(); i++) {
+    for (size_t i = 0; i < nbins; i++) {
+        h[i] = 0.0f;
+    }
+    for (size_t i = 0; i < nx; i++) {
         size_t bin = (x[i] - min) / step;
         if (bin >= nbins)
             bin = nbins - 1;
         h[bin]++;
     }
     if (normalize) {
-        float s = numpy::sum(h.data(), h.size());
+        float s = numpy::sum(h, nbins);
         for (size_t i = 0; i < nbins; i++) {
             h[i] /= s;
         }
     }
 }
 
+/**
+ * Wavelet decomposition features (multi-level DWT, 14 statistics per sub-band).
+ *
+ * Nothing in here allocates: the decomposition runs out of a single work buffer of
+ * get_work_size() floats that the caller provides (extract_spectral_analysis_features()
+ * carves it out of the same allocation as the raw signal). The filter bank is applied
+ * exactly like PyWavelets does (symmetric padding, decimation by 2) so the features
+ * match the ones the model was trained on bit for bit.
+ */
 class wavelet {
 
     static constexpr size_t NUM_FEATHERS_PER_COMP = 14;
+    static constexpr size_t MAX_FILTER_TAPS = 20;
+    static constexpr size_t ENTROPY_BINS = 100;
 
-    template <size_t wave_size>
-    static void get_filter(const std::array<std::array<float, wave_size>, 2> wav, fvec &h, fvec &g)
+public:
+    /**
+     * Supported wavelets, same order as the name table in find_filter()
+     */
+    typedef enum {
+        BIOR1_3 = 0, BIOR1_5, BIOR2_2, BIOR2_4, BIOR2_6, BIOR2_8, BIOR3_1, BIOR3_3, BIOR3_5,
+        BIOR3_7, BIOR3_9, BIOR4_4, BIOR5_5, BIOR6_8,
+        COIF1, COIF2, COIF3,
+        DB2, DB3, DB4, DB5, DB6, DB7, DB8, DB9, DB10,
+        HAAR,
+        RBIO1_3, RBIO1_5, RBIO2_2, RBIO2_4, RBIO2_6, RBIO2_8, RBIO3_1, RBIO3_3, RBIO3_5,
+        RBIO3_7, RBIO3_9, RBIO4_4, RBIO5_5, RBIO6_8,
+        SYM2, SYM3, SYM4, SYM5, SYM6, SYM7, SYM8, SYM9, SYM10,
+        WAVELET_COUNT
+    } wavelet_type_t;
+
+    /**
+     * Decomposition filters, pointing into the tables in wavelet_coeff.hpp
+     * (stored in time order, applied reversed)
+     */
+    typedef struct {
+        const float *dec_lo;
+        const float *dec_hi;
+        size_t taps;
+    } wavelet_filter_t;
+
+    /**
+     * Look up a wavelet by its PyWavelets name (e.g. "db4")
+     * @returns false if the wavelet is not supported
+     */
+    static bool find_filter(const char *name, wavelet_type_t *type)
+    {
+        static const char *const names[WAVELET_COUNT] = {
+            "bior1.3", "bior1.5", "bior2.2", "bior2.4", "bior2.6", "bior2.8", "bior3.1", "bior3.3", "bior3.5",
+            "bior3.7", "bior3.9", "bior4.4", "bior5.5", "bior6.8",
+            "coif1", "coif2", "coif3",
+            "db2", "db3", "db4", "db5", "db6", "db7", "db8", "db9", "db10",
+            "haar",
+            "rbio1.3", "rbio1.5", "rbio2.2", "rbio2.4", "rbio2.6", "rbio2.8", "rbio3.1", "rbio3.3", "rbio3.5",
+            "rbio3.7", "rbio3.9", "rbio4.4", "rbio5.5", "rbio6.8",
+            "sym2", "sym3", "sym4", "sym5", "sym6", "sym7", "sym8", "sym9", "sym10",
+        };
+
+        for (int i = 0; i < WAVELET_COUNT; i++) {
+            if (strcmp(name, names[i]) == 0) {
+                *type = (wavelet_type_t)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static wavelet_filter_t get_filter(wavelet_type_t type)
     {
-        size_t n = wav[0].size();
-        h.resize(n);
-        g.resize(n);
-        for (size_t i = 0; i < n; i++) {
-            h[i] = wav[0][n - i - 1];
-            g[i] = wav[1][n - i - 1];
+        switch (type) {
+            case BIOR1_3: return get_filter<6>(bior1p3);
+            case BIOR1_5: return get_filter<10>(bior1p5);
+            case BIOR2_2: return get_filter<6>(bior2p2);
+            case BIOR2_4: return get_filter<10>(bior2p4);
+            case BIOR2_6: return get_filter<14>(bior2p6);
+            case BIOR2_8: return get_filter<18>(bior2p8);
+            case BIOR3_1: return get_filter<4>(bior3p1);
+            case BIOR3_3: return get_filter<8>(bior3p3);
+            case BIOR3_5: return get_filter<12>(bior3p5);
+            case BIOR3_7: return get_filter<16>(bior3p7);
+            case BIOR3_9: return get_filter<20>(bior3p9);
+            case BIOR4_4: return get_filter<10>(bior4p4);
+            case BIOR5_5: return get_filter<12>(bior5p5);
+            case BIOR6_8: return get_filter<18>(bior6p8);
+            case COIF1: return get_filter<6>(coif1);
+            case COIF2: return get_filter<12>(coif2);
+            case COIF3: return get_filter<18>(coif3);
+            case DB2: return get_filter<4>(db2);
+            case DB3: return get_filter<6>(db3);
+            case DB4: return get_filter<8>(db4);
+            case DB5: return get_filter<10>(db5);
+            case DB6: return get_filter<12>(db6);
+            case DB7: return get_filter<14>(db7);
+            case DB8: return get_filter<16>(db8);
+            case DB9: return get_filter<18>(db9);
+            case DB10: return get_filter<20>(db10);
+            case HAAR: return get_filter<2>(haar);
+            case RBIO1_3: return get_filter<6>(rbio1p3);
+            case RBIO1_5: return get_filter<10>(rbio1p5);
+            case RBIO2_2: return get_filter<6>(rbio2p2);
+            case RBIO2_4: return get_filter<10>(rbio2p4);
+            case RBIO2_6: return get_filter<14>(rbio2p6);
+            case RBIO2_8: return get_filter<18>(rbio2p8);
+            case RBIO3_1: return get_filter<4>(rbio3p1);
+            case RBIO3_3: return get_filter<8>(rbio3p3);
+            case RBIO3_5: return get_filter<12>(rbio3p5);
+            case RBIO3_7: return get_filter<16>(rbio3p7);
+            case RBIO3_9: return get_filter<20>(rbio3p9);
+            case RBIO4_4: return get_filter<10>(rbio4p4);
+            case RBIO5_5: return get_filter<12>(rbio5p5);
+            case RBIO6_8: return get_filter<18>(rbio6p8);
+            case SYM2: return get_filter<4>(sym2);
+            case SYM3: return get_filter<6>(sym3);
+            case SYM4: return get_filter<8>(sym4);
+            case SYM5: return get_filter<10>(sym5);
+            case SYM6: return get_filter<12>(sym6);
+            case SYM7: return get_filter<14>(sym7);
+            case SYM8: return get_filter<16>(sym8);
+            case SYM9: return get_filter<18>(sym9);
+            case SYM10: return get_filter<20>(sym10);
+            default: break;
         }
+        assert(0); // wavelet not in the list
+        return get_filter<2>(haar);
     }
 
-    static void find_filter(const char *wav, fvec &h, fvec &g)
+    /**
+     * Number of floats of work buffer extract_wavelet_features() needs for one axis
+     * of len samples: the signal itself, plus ping-pong approximation and detail
+     * buffers for the first (largest) decomposition level.
+     * @returns 0 if the wavelet is not supported
+     */
+    static size_t get_work_size(size_t len, const char *wav)
     {
-        if (strcmp(wav, "bior1.3") == 0) get_filter<6>(bior1p3, h, g);
-        else if (strcmp(wav, "bior1.5") == 0) get_filter<10>(bior1p5, h, g);
-        else if (strcmp(wav, "bior2.2") == 0) get_filter<6>(bior2p2, h, g);
-        else if (strcmp(wav, "bior2.4") == 0) get_filter<10>(bior2p4, h, g);
-        else if (strcmp(wav, "bior2.6") == 0) get_filter<14>(bior2p6, h, g);
-        else if (strcmp(wav, "bior2.8") == 0) get_filter<18>(bior2p8, h, g);
-        else if (strcmp(wav, "bior3.1") == 0) get_filter<4>(bior3p1, h, g);
-        else if (strcmp(wav, "bior3.3") == 0) get_filter<8>(bior3p3, h, g);
-        else if (strcmp(wav, "bior3.5") == 0) get_filter<12>(bior3p5, h, g);
-        else if (strcmp(wav, "bior3.7") == 0) get_filter<16>(bior3p7, h, g);
-        else if (strcmp(wav, "bior3.9") == 0) get_filter<20>(bior3p9, h, g);
-        else if (strcmp(wav, "bior4.4") == 0) get_filter<10>(bior4p4, h, g);
-        else if (strcmp(wav, "bior5.5") == 0) get_filter<12>(bior5p5, h, g);
-        else if (strcmp(wav, "bior6.8") == 0) get_filter<18>(bior6p8, h, g);
-        else if (strcmp(wav, "coif1") == 0) get_filter<6>(coif1, h, g);
-        else if (strcmp(wav, "coif2") == 0) get_filter<12>(coif2, h, g);
-        else if (strcmp(wav, "coif3") == 0) get_filter<18>(coif3, h, g);
-        else if (strcmp(wav, "db2") == 0) get_filter<4>(db2, h, g);
-        else if (strcmp(wav, "db3") == 0) get_filter<6>(db3, h, g);
-        else if (strcmp(wav, "db4") == 0) get_filter<8>(db4, h, g);
-        else if (strcmp(wav, "db5") == 0) get_filter<10>(db5, h, g);
-        else if (strcmp(wav, "db6") == 0) get_filter<12>(db6, h, g);
-        else if (strcmp(wav, "db7") == 0) get_filter<14>(db7, h, g);
-        else if (strcmp(wav, "db8") == 0) get_filter<16>(db8, h, g);
-        else if (strcmp(wav, "db9") == 0) get_filter<18>(db9, h, g);
-        else if (strcmp(wav, "db10") == 0) get_filter<20>(db10, h, g);
-        else if (strcmp(wav, "haar") == 0) get_filter<2>(haar, h, g);
-        else if (strcmp(wav, "rbio1.3") == 0) get_filter<6>(rbio1p3, h, g);
-        else if (strcmp(wav, "rbio1.5") == 0) get_filter<10>(rbio1p5, h, g);
-        else if (strcmp(wav, "rbio2.2") == 0) get_filter<6>(rbio2p2, h, g);
-        else if (strcmp(wav, "rbio2.4") == 0) get_filter<10>(rbio2p4, h, g);
-        else if (strcmp(wav, "rbio2.6") == 0) get_filter<14>(rbio2p6, h, g);
-        else if (strcmp(wav, "rbio2.8") == 0) get_filter<18>(rbio2p8, h, g);
-        else if (strcmp(wav, "rbio3.1") == 0) get_filter<4>(rbio3p1, h, g);
-        else if (strcmp(wav, "rbio3.3") == 0) get_filter<8>(rbio3p3, h, g);
-        else if (strcmp(wav, "rbio3.5") == 0) get_filter<12>(rbio3p5, h, g);
-        else if (strcmp(wav, "rbio3.7") == 0) get_filter<16>(rbio3p7, h, g);
-        else if (strcmp(wav, "rbio3.9") == 0) get_filter<20>(rbio3p9, h, g);
-        else if (strcmp(wav, "rbio4.4") == 0) get_filter<10>(rbio4p4, h, g);
-        else if (strcmp(wav, "rbio5.5") == 0) get_filter<12>(rbio5p5, h, g);
-        else if (strcmp(wav, "rbio6.8") == 0) get_filter<18>(rbio6p8, h, g);
-        else if (strcmp(wav, "sym2") == 0) get_filter<4>(sym2, h, g);
-        else if (strcmp(wav, "sym3") == 0) get_filter<6>(sym3, h, g);
-        else if (strcmp(wav, "sym4") == 0) get_filter<8>(sym4, h, g);
-        else if (strcmp(wav, "sym5") == 0) get_filter<10>(sym5, h, g);
-        else if (strcmp(wav, "sym6") == 0) get_filter<12>(sym6, h, g);
-        else if (strcmp(wav, "sym7") == 0) get_filter<14>(sym7, h, g);
-        else if (strcmp(wav, "sym8") == 0) get_filter<16>(sym8, h, g);
-        else if (strcmp(wav, "sym9") == 0) get_filter<18>(sym9, h, g);
-        else if (strcmp(wav, "sym10") == 0) get_filter<20>(sym10, h, g);
-        else assert(0); // wavelet not in the list
+        wavelet_type_t type;
+        if (!find_filter(wav, &type)) {
+            return 0;
+        }
+        size_t ny = (len + get_filter(type).taps - 1) / 2;
+        return len + 2 * ny;
+    }
+
+private:
+    template <size_t wave_size>
+    static wavelet_filter_t get_filter(const std::array<std::array<float, wave_size>, 2> &wav)
+    {
+        wavelet_filter_t filter = { wav[0].data(), wav[1].data(), wave_size };
+        return filter;
     }
 
-    static void calculate_entropy(const fvec &y, fvec &features)
+    static float calculate_entropy(const float *y, size_t n)
     {
-        fvec h;
-        histo(y, 100, h, true);
+        float h[ENTROPY_BINS];
+        histo(y, n, ENTROPY_BINS, h, true);
         // entropy = -sum(prob * log(prob)
         float entropy = 0.0f;
-        for (size_t i = 0; i < h.size(); i++) {
+        for (size_t i = 0; i < ENTROPY_BINS; i++) {
             if (h[i] > 0.0f) {
                 entropy -= h[i] * log(h[i]);
             }
         }
-        features.push_back(entropy);
+        return entropy;
     }
 
-    static float get_percentile_from_sorted(const fvec &sorted, float percentile)
+    static size_t get_percentile_index(size_t n, float percentile)
     {
         // adding 0.5 is a trick to get rounding out of C flooring behavior during cast
-        size_t index = (size_t) ((percentile * (sorted.size()-1)) + 0.5);
-        return sorted[index];
+        return (size_t) ((percentile * (n-1)) + 0.5);
     }
 
-    static void calculate_statistics(const fvec &y, fvec &features, float mean)
+    /**
+     * Writes p5, p25, p75, p95, p50, mean, stdev, variance, rms, skew and kurtosis.
+     * The percentiles are found by selection (nth_element) in place, so y is
+     * reordered; everything that depends on the sample order runs before that.
+     */
+    static void calculate_statistics(float *y, size_t n, float mean, float *features)
     {
-        fvec sorted = y;
-        std::sort(sorted.begin(), sorted.end());
-        features.push_back(get_percentile_from_sorted(sorted,0.05));
-        features.push_back(get_percentile_from_sorted(sorted,0.25));
-        features.push_back(get_percentile_from_sorted(sorted,0.75));
-        features.push_back(get_percentile_from_sorted(sorted,0.95));
-        features.push_back(get_percentile_from_sorted(sorted,0.5));
-
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
-
-        features.push_back(mean);
-        if (numpy::stdev(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        features.push_back(numpy::variance(const_cast<float *>(y.data()), y.size()));
-        if (numpy::rms(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        if (numpy::skew(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        if (numpy::kurtosis(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
+        matrix_t x(1, n, y);
+        float value;
+        matrix_t out(1, 1, &value);
+
+        features[5] = mean;
+        numpy::stdev(&x, &out);
+        features[6] = value;
+        features[7] = numpy::variance(y, n);
+        numpy::rms(&x, &out);
+        features[8] = value;
+        numpy::skew(&x, &out);
+        features[9] = value;
+        numpy::kurtosis(&x, &out);
+        features[10] = value;
+
+        // ascending, so each selection only has to look right of the previous one
+        const float percentiles[] = { 0.05f, 0.25f, 0.5f, 0.75f, 0.95f };
+        const size_t slots[] = { 0, 1, 4, 2, 3 };
+        float *first = y;
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+            float *nth = y + get_percentile_index(n, percentiles[i]);
+            if (nth >= first) {
+                std::nth_element(first, nth, y + n);
+                first = nth + 1;
+            }
+            features[slots[i]] = *nth;
+        }
     }
 
-    static void calculate_crossings(const fvec &y, fvec &features, float mean)
+    static void calculate_crossings(const float *y, size_t n, float mean, float *features)
     {
         size_t zc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
+        for (size_t i = 1; i < n; i++) {
             if (y[i] * y[i - 1] < 0) {
                 zc++;
             }
         }
-        features.push_back(zc / (float)y.size());
+        features[0] = zc / (float)n;
 
         size_t mc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
+        for (size_t i = 1; i < n; i++) {
             if ((y[i] - mean) * (y[i - 1] - mean) < 0) {
                 mc++;
             }
         }
-        features.push_back(mc / (float)y.size());
+        features[1] = mc / (float)n;
     }
 
-    static void
-    dwt(const float *x, size_t nx, const float *h, const float *g, size_t nh, fvec &a, fvec &d)
+    /**
+     * One level of the decomposition. x is read through PyWavelets' symmetric
+     * padding (x[-1 - i] = x[i], x[nx + i] = x[nx - 1 - i]) without materializing
+     * it; only windows that straddle an edge are gathered into a small stack buffer.
+     * a and d must hold (nx + nh - 1) / 2 floats and must not overlap x.
+     * @returns number of coefficients written to a and d
+     */
+    static size_t dwt(const float *x, size_t nx, const wavelet_filter_t &filter, float *a, float *d)
     {
-        assert(nh <= 20 && nh > 0 && nx > 0);
-        size_t nx_padded = nx + nh * 2 - 2;
-        fvec x_padded(nx_padded);
-
-        // symmetric padding (default in PyWavelet)
-        for (size_t i = 0; i < nh - 2; i++)
-            x_padded[i] = x[nh - 3 - i];
-        for (size_t i = 0; i < nx; i++)
-            x_padded[i + nh - 2] = x[i];
-        for (size_t i = 0; i < nh; i++)
-            x_padded[i + nx + nh - 2] = x[nx - 1 - i];
+        const size_t nh = filter.taps;
+        assert(nh <= MAX_FILTER_TAPS && nh > 0 && nx >= nh);
 
         size_t ny = (nx + nh - 1) / 2;
-        a.resize(ny);
-        d.resize(ny);
 
-        // decimate and filter
-        const float *xx = x_padded.data();
+        // decimate and filter, window i covers x[2i - (nh - 2)] .. x[2i + 1]
+        float edge[MAX_FILTER_TAPS];
         for (size_t i = 0; i < ny; i++) {
-            a[i] = dot(xx + 2 * i, h, nh);
-            d[i] = dot(xx + 2 * i, g, nh);
+            const float *xx;
+            ptrdiff_t start = (ptrdiff_t)(2 * i) - (ptrdiff_t)(nh - 2);
+            if (start >= 0 && start + (ptrdiff_t)nh <= (ptrdiff_t)nx) {
+                xx = x + start;
+            }
+            else {
+                for (size_t k = 0; k < nh; k++) {
+                    ptrdiff_t q = start + (ptrdiff_t)k;
+                    if (q < 0) {
+                        q = -q - 1;
+                    }
+                    else if (q >= (ptrdiff_t)nx) {
+                        q = 2 * (ptrdiff_t)nx - 1 - q;
+                    }
+                    edge[k] = x[q];
+                }
+                xx = edge;
+            }
+            a[i] = dot_reversed(xx, filter.dec_lo, nh);
+            d[i] = dot_reversed(xx, filter.dec_hi, nh);
         }
 
-        numpy::underflow_handling(d.data(), d.size());
-        numpy::underflow_handling(a.data(), a.size());
+        numpy::underflow_handling(d, ny);
+        numpy::underflow_handling(a, ny);
+        return ny;
     }
 
-    static void extract_features(fvec& y, fvec &features)
+    /**
+     * 14 features of one sub-band: entropy, zero / mean crossing rates and the
+     * statistics. Reorders y.
+     */
+    static void extract_features(float *y, size_t n, float *features)
     {
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
+        matrix_t x(1, n, y);
+        float mean;
+        matrix_t out(1, 1, &mean);
         if (numpy::mean(&x, &out) != EIDSP_OK)
             assert(0);
-        float mean = out.get_row_ptr(0)[0];
 
-        calculate_entropy(y, features);
-        calculate_crossings(y, features, mean);
-        calculate_statistics(y, features, mean);
+        features[0] = calculate_entropy(y, n);
+        calculate_crossings(y, n, mean, features + 1);
+        calculate_statistics(y, n, mean, features + 3);
     }
 
-    static void
-    wavedec_features(const float *x, int len, const char *wav, int level, fvec &features)
+    /**
+     * Decomposes x (len samples, consumed) down to level and writes
+     * (level + 1) * NUM_FEATHERS_PER_COMP features, coarsest band first to match
+     * the python results: a_level, d_level, ..., d_1.
+     * work must hold get_work_size(len, ...) - len floats.
+     */
+    static void wavedec_features(
+        float *x,
+        size_t len,
+        const wavelet_filter_t &filter,
+        int level,
+        float *work,
+        float *features)
     {
         assert(level > 0 && level < 8);
 
-        fvec h;
-        fvec g;
-        find_filter(wav, h, g);
+        // x is only needed for the first level, after that it's the other half of
+        // the ping-pong pair for the approximation coefficients
+        size_t ny = (len + filter.taps - 1) / 2;
+        float *a = work;
+        float *d = work + ny;
+        float *next = x;
 
-        features.clear();
-        fvec a;
-        fvec d;
-        dwt(x, len, h.data(), g.data(), h.size(), a, d);
-        extract_features(d, features);
+        size_t n = dwt(x, len, filter, a, d);
+        extract_features(d, n, features + level * NUM_FEATHERS_PER_COMP);
 
         for (int l = 1; l < level; l++) {
-            dwt(a.data(), a.size(), h.data(), g.data(), h.size(), a, d);
-            extract_features(d, features);
-        }
-
-        extract_features(a, features);
-
-        for (int l = 0; l <= level / 2; l++) { // reverse order to match python results.
-            for (int i = 0; i < (int)NUM_FEATHERS_PER_COMP; i++) {
-                std::swap(
-                    features[l * NUM_FEATHERS_PER_COMP + i],
-                    features[(level - l) * NUM_FEATHERS_PER_COMP + i]);
-            }
+            n = dwt(a, n, filter, next, d);
+            extract_features(d, n, features + (level - l) * NUM_FEATHERS_PER_COMP);
+            std::swap(a, next);
         }
-    }
-
-    static int dwt_features(const float *x, int len, const char *wav, int level, fvec &features)
-    {
-        assert(level <= 7);
-
-        assert(features.size() == 0); // make sure features is empty
-        features.reserve((level + 1) * NUM_FEATHERS_PER_COMP);
-
-        wavedec_features(x, len, wav, level, features);
 
-        return features.size();
+        extract_features(a, n, features);
     }
 
     static bool check_min_size(int len, int level)
@@ -298,61 +412,91 @@ class wavelet {
     }
 
 public:
+    /**
+     * Wavelet features for every axis of input_matrix (samples x axes, left untouched)
+     * @param work Work buffer of get_work_size(input_matrix->rows, config->wavelet)
+     *             floats, if NULL it's allocated for the duration of the call
+     * @param work_size Size of work, in floats
+     */
     static int extract_wavelet_features(
         matrix_t *input_matrix,
         matrix_t *output_matrix,
         ei_dsp_config_spectral_analysis_t *config,
-        const float sampling_freq)
+        const float sampling_freq,
+        float *work = NULL,
+        size_t work_size = 0)
     {
-        // transpose the matrix so we have one row per axis
-        numpy::transpose_in_place(input_matrix);
-
-        // func tests for scale of 1 and does a no op in that case
-        EI_TRY(numpy::scale(input_matrix, config->scale_axes));
-
-        // apply filter, if enabled
-        // "zero" order filter allowed.  will still remove unwanted fft bins later
-        if (strcmp(config->filter_type, "low") == 0) {
-            if (config->filter_order) {
-                EI_TRY(spectral::processing::butterworth_lowpass_filter(
-                    input_matrix,
-                    sampling_freq,
-                    config->filter_cutoff,
-                    config->filter_order));
-            }
+        wavelet_type_t type;
+        if (!find_filter(config->wavelet, &type)) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
-        else if (strcmp(config->filter_type, "high") == 0) {
-            if (config->filter_order) {
-                EI_TRY(spectral::processing::butterworth_highpass_filter(
-                    input_matrix,
-                    sampling_freq,
-                    config->filter_cutoff,
-                    config->filter_order));
-            }
+        const wavelet_filter_t filter = get_filter(type);
+
+        const size_t data_size = input_matrix->rows;
+        const size_t axes = input_matrix->cols;
+        if (!check_min_size(data_size, config->wavelet_level))
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+
+        const size_t num_features = (config->wavelet_level + 1) * NUM_FEATHERS_PER_COMP;
+        if (output_matrix->rows * output_matrix->cols < axes * num_features)
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+
+        const size_t required = get_work_size(data_size, config->wavelet);
+        if (work && work_size < required) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+        // only allocates when the caller didn't pass a work buffer in
+        matrix_t work_matrix(1, required, work);
+        if (!work_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        work = work_matrix.buffer;
 
-        EI_TRY(processing::subtract_mean(input_matrix));
+        float *data_window = work;
+        matrix_t row(1, data_size, data_window);
+        float mean;
+        matrix_t mean_matrix(1, 1, &mean);
 
-        int out_idx = 0;
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            float *data_window = input_matrix->get_row_ptr(row);
-            size_t data_size = input_matrix->cols;
+        for (size_t axis = 0; axis < axes; axis++) {
+            // one row per axis
+            for (size_t i = 0; i < data_size; i++) {
+                data_window[i] = input_matrix->buffer[i * axes + axis];
+            }
+
+            // func tests for scale of 1 and does a no op in that case
+            EI_TRY(numpy::scale(&row, config->scale_axes));
+
+            // apply filter, if enabled
+            // "zero" order filter allowed.  will still remove unwanted fft bins later
+            if (strcmp(config->filter_type, "low") == 0) {
+                if (config->filter_order) {
+                    EI_TRY(spectral::processing::butterworth_lowpass_filter(
+                        &row,
+                        sampling_freq,
+                        config->filter_cutoff,
+                        config->filter_order));
+                }
+            }
+            else if (strcmp(config->filter_type, "high") == 0) {
+                if (config->filter_order) {
+                    EI_TRY(spectral::processing::butterworth_highpass_filter(
+                        &row,
+                        sampling_freq,
+                        config->filter_cutoff,
+                        config->filter_order));
+                }
+            }
 
-            if (!check_min_size(data_size, config->wavelet_level))
-                EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+            EI_TRY(numpy::mean(&row, &mean_matrix));
+            EI_TRY(numpy::subtract(&row, mean));
 
-            fvec features;
-            size_t num_features = dwt_features(
+            wavedec_features(
                 data_window,
                 data_size,
-                config->wavelet,
+                filter,
                 config->wavelet_level,
-                features);
-
-            assert(num_features == output_matrix->cols / input_matrix->rows);
-            for (size_t i = 0; i < num_features; i++) {
-                output_matrix->buffer[out_idx++] = features[i];
-            }
+                work + data_size,
+                output_matrix->buffer + axis * num_features);
         }
         return EIDSP_OK;
     }
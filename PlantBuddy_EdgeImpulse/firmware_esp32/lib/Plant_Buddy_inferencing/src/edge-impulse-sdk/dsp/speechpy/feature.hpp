@@ -473,7 +473,7 @@ public:
 #if EIDSP_QUANTIZE_FILTERBANK
         EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
 #else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
+        EI_DSP_MATRIX_BULK(filterbanks, num_filters, coefficients);
 #endif
         if (!filterbanks.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -738,7 +738,7 @@ public:
         int ret = EIDSP_OK;
 
         // allocate some memory for the MFE result
-        EI_DSP_MATRIX(features_matrix, mfe_matrix_size.rows, mfe_matrix_size.cols);
+        EI_DSP_MATRIX_BULK(features_matrix, mfe_matrix_size.rows, mfe_matrix_size.cols);
         if (!features_matrix.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
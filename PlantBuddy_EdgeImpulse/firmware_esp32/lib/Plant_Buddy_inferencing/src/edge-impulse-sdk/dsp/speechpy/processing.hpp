@@ -410,7 +410,7 @@ namespace processing {
         float *features_buffer_ptr;
 
         // mean & variance normalization
-        EI_DSP_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
+        EI_DSP_MATRIX_BULK(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
         if (!vec_pad.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
@@ -33,6 +33,7 @@
  */
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/porting/ei_memory_tiers.h"
 #if EI_PORTING_CLIB == 1
 #include <stdarg.h>
 #include <stdio.h>
@@ -86,6 +87,7 @@ __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
+    ei_memory_tiers_release(ptr);
     free(ptr);
 }
 
@@ -253,6 +253,10 @@ void *ei_calloc(size_t nitems, size_t size);
  * }
  * ```
  *
+ * Memory handed out by the placement hints in ei_memory_tiers.h is released through
+ * `ei_free()` as well. Call `ei_memory_tiers_release(ptr)` before freeing to keep the
+ * per-tier statistics correct.
+ *
  * @param[in] ptr Pointer to the memory to free
  */
 void ei_free(void *ptr);
@@ -0,0 +1,371 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ei_deferred_log.h"
+
+#if EI_DEFERRED_LOG_ENABLED
+
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include "ei_logging.h"
+#include "ei_mpsc_ring.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif // ESP_PLATFORM
+
+namespace {
+
+ei_mpsc_ring<ei_deferred_log_record_t, EI_DEFERRED_LOG_BUFFER_SIZE> records;
+uint32_t reported_dropped = 0;
+
+// only one consumer at a time, a second one backs off rather than waiting
+std::atomic_flag consumer_flag = ATOMIC_FLAG_INIT;
+
+// float formats for ei_deferred_log_floats, indexed by the number of values
+const char *float_formats[] = {
+    "",
+    "%f ",
+    "%f %f ",
+    "%f %f %f ",
+    "%f %f %f %f ",
+    "%f %f %f %f %f ",
+    "%f %f %f %f %f %f ",
+    "%f %f %f %f %f %f %f ",
+    "%f %f %f %f %f %f %f %f ",
+};
+
+void append(char *buffer, size_t size, size_t *length, const char *format, ...)
+{
+    if (*length + 1 >= size) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + *length, size - *length, format, args);
+    va_end(args);
+    if (written > 0) {
+        *length += ((size_t)written < size - *length) ? (size_t)written : size - *length - 1;
+    }
+}
+
+void put_le(uint8_t *out, uint64_t value, size_t bytes)
+{
+    for (size_t ix = 0; ix < bytes; ix++) {
+        out[ix] = (uint8_t)(value >> (8 * ix));
+    }
+}
+
+} // namespace
+
+ei_deferred_log_record_t *ei_deferred_log_reserve(void)
+{
+    uint32_t pos;
+    ei_deferred_log_record_t *record = records.reserve(&pos);
+    if (record) {
+        record->position = pos;
+    }
+    return record;
+}
+
+void ei_deferred_log_commit(ei_deferred_log_record_t *record)
+{
+    records.commit(record->position);
+}
+
+void ei_deferred_log_floats(const float *values, size_t count)
+{
+    for (size_t ix = 0; ix < count; ix += EI_DEFERRED_LOG_MAX_ARGS) {
+        size_t chunk = count - ix < EI_DEFERRED_LOG_MAX_ARGS ? count - ix : EI_DEFERRED_LOG_MAX_ARGS;
+        ei_deferred_log_record_t *record = ei_deferred_log_reserve();
+        if (!record) {
+            return;
+        }
+        record->format = float_formats[chunk];
+        record->level = 0;
+        record->arg_count = (uint8_t)chunk;
+        record->float_mask = 0;
+        for (size_t jx = 0; jx < chunk; jx++) {
+            record->args[jx] = ei_deferred_log_pack(values[ix + jx], &record->float_mask, jx);
+        }
+        ei_deferred_log_commit(record);
+    }
+}
+
+size_t ei_deferred_log_format(char *buffer, size_t size, uint8_t level, const char *format,
+    uint8_t arg_count, uint8_t float_mask, const uint64_t *args,
+    const char *(*resolve_string)(uint64_t address))
+{
+    if (size == 0) {
+        return 0;
+    }
+    buffer[0] = '\0';
+    size_t length = 0;
+
+    if (level >= EI_LOG_LEVEL_ERROR && level <= EI_LOG_LEVEL_DEBUG) {
+        append(buffer, size, &length, "%s: ", debug_msgs[level]);
+    }
+    if (!format) {
+        append(buffer, size, &length, "(unknown format)\n");
+        return length;
+    }
+
+    size_t arg = 0;
+    const char *p = format;
+    while (*p) {
+        if (*p != '%') {
+            const char *end = strchr(p, '%');
+            size_t run = end ? (size_t)(end - p) : strlen(p);
+            append(buffer, size, &length, "%.*s", (int)run, p);
+            p += run;
+            continue;
+        }
+        if (p[1] == '%') {
+            append(buffer, size, &length, "%%");
+            p += 2;
+            continue;
+        }
+
+        // rebuild the conversion with explicit argument types
+        const char *start = p++;
+        char spec[64];
+        size_t spec_length = 0;
+        spec[spec_length++] = '%';
+        while (*p && strchr("-+ #0", *p) && spec_length < 8) {
+            spec[spec_length++] = *p++;
+        }
+        for (int field = 0; field < 2; field++) {
+            if (field == 1) {
+                if (*p != '.') {
+                    break;
+                }
+                spec[spec_length++] = *p++;
+            }
+            if (*p == '*') {
+                p++;
+                int value = arg < arg_count ? (int)(int64_t)args[arg++] : 0;
+                spec_length += snprintf(spec + spec_length, 12, "%d", value);
+            }
+            else {
+                while (*p >= '0' && *p <= '9' && spec_length < 24) {
+                    spec[spec_length++] = *p++;
+                }
+            }
+        }
+
+        // length modifiers: h and hh are kept, everything wider is passed as (unsigned) long long
+        bool is_long = false;
+        bool is_long_long = false;
+        while (*p && strchr("hljztL", *p)) {
+            if (*p == 'h') {
+                if (spec_length < 40) {
+                    spec[spec_length++] = 'h';
+                }
+            }
+            else if (*p == 'l') {
+                is_long_long = is_long;
+                is_long = true;
+            }
+            else if (*p != 'L') {
+                is_long_long = true;
+            }
+            p++;
+        }
+        char conversion = *p;
+        if (!conversion) {
+            break;
+        }
+        p++;
+
+        if (!strchr("diuoxXcspfFeEgGaAn", conversion) || arg >= arg_count) {
+            append(buffer, size, &length, "%.*s", (int)(p - start), start);
+            continue;
+        }
+        uint64_t value = args[arg];
+        bool is_float = (float_mask >> arg) & 1;
+        arg++;
+
+        if (is_long_long) {
+            spec[spec_length++] = 'l';
+            spec[spec_length++] = 'l';
+        }
+        else if (is_long) {
+            spec[spec_length++] = 'l';
+        }
+        spec[spec_length++] = conversion;
+        spec[spec_length] = '\0';
+
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                if (is_long_long) {
+                    append(buffer, size, &length, spec, (long long)(int64_t)value);
+                }
+                else if (is_long) {
+                    append(buffer, size, &length, spec, (long)(int64_t)value);
+                }
+                else {
+                    append(buffer, size, &length, spec, (int)(int64_t)value);
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if (is_long_long) {
+                    append(buffer, size, &length, spec, (unsigned long long)value);
+                }
+                else if (is_long) {
+                    append(buffer, size, &length, spec, (unsigned long)value);
+                }
+                else {
+                    append(buffer, size, &length, spec, (unsigned int)value);
+                }
+                break;
+            case 'c':
+                append(buffer, size, &length, spec, (int)value);
+                break;
+            case 's': {
+                const char *str = resolve_string ? resolve_string(value) : (const char *)(uintptr_t)value;
+                append(buffer, size, &length, spec, str ? str : "(null)");
+                break;
+            }
+            case 'p':
+                append(buffer, size, &length, "0x%llx", (unsigned long long)value);
+                break;
+            case 'n':
+                break;
+            default: {
+                double number;
+                if (is_float) {
+                    uint32_t bits = (uint32_t)value;
+                    float f;
+                    memcpy(&f, &bits, sizeof(f));
+                    number = f;
+                }
+                else {
+                    memcpy(&number, &value, sizeof(number));
+                }
+                append(buffer, size, &length, spec, number);
+                break;
+            }
+        }
+    }
+
+    return length;
+}
+
+size_t ei_deferred_log_flush(void)
+{
+    if (consumer_flag.test_and_set(std::memory_order_acquire)) {
+        return 0;
+    }
+
+    size_t count = 0;
+    ei_deferred_log_record_t record;
+    char line[EI_DEFERRED_LOG_MAX_LINE];
+    while (records.pop(&record)) {
+        ei_deferred_log_format(line, sizeof(line), record.level, record.format, record.arg_count,
+            record.float_mask, record.args, nullptr);
+        ei_printf("%s", line);
+        count++;
+    }
+
+    uint32_t dropped = records.get_dropped();
+    if (dropped != reported_dropped) {
+        ei_printf("%s: %lu deferred log records dropped, flush more often or increase EI_DEFERRED_LOG_BUFFER_SIZE\n",
+            debug_msgs[EI_LOG_LEVEL_WARNING], (unsigned long)(dropped - reported_dropped));
+        reported_dropped = dropped;
+    }
+
+    consumer_flag.clear(std::memory_order_release);
+    return count;
+}
+
+size_t ei_deferred_log_drain_binary(void (*write)(const uint8_t *data, size_t size))
+{
+    if (consumer_flag.test_and_set(std::memory_order_acquire)) {
+        return 0;
+    }
+
+    size_t count = 0;
+    ei_deferred_log_record_t record;
+    uint8_t out[EI_DEFERRED_LOG_RECORD_HEADER_SIZE + EI_DEFERRED_LOG_MAX_ARGS * 8];
+    while (records.pop(&record)) {
+        memset(out, 0, EI_DEFERRED_LOG_RECORD_HEADER_SIZE);
+        put_le(out, (uint64_t)(uintptr_t)record.format, 8);
+        out[8] = record.level;
+        out[9] = record.arg_count;
+        out[10] = record.float_mask;
+        for (size_t ix = 0; ix < record.arg_count; ix++) {
+            put_le(out + EI_DEFERRED_LOG_RECORD_HEADER_SIZE + ix * 8, record.args[ix], 8);
+        }
+        write(out, EI_DEFERRED_LOG_RECORD_HEADER_SIZE + record.arg_count * 8);
+        count++;
+    }
+
+    consumer_flag.clear(std::memory_order_release);
+    return count;
+}
+
+uint32_t ei_deferred_log_get_dropped(void)
+{
+    return records.get_dropped();
+}
+
+#if defined(ESP_PLATFORM)
+static void deferred_log_task(void *arg)
+{
+    TickType_t period = pdMS_TO_TICKS((uint32_t)(uintptr_t)arg);
+    while (true) {
+        ei_deferred_log_flush();
+        vTaskDelay(period > 0 ? period : 1);
+    }
+}
+
+bool ei_deferred_log_start_task(uint32_t period_ms, uint32_t priority)
+{
+    static TaskHandle_t task = nullptr;
+    if (task) {
+        return true;
+    }
+    // the stack holds a formatted line plus whatever the printf implementation needs
+    return xTaskCreate(deferred_log_task, "ei_deferred_log", 4096, (void *)(uintptr_t)period_ms,
+        priority, &task) == pdPASS;
+}
+#endif // ESP_PLATFORM
+
+#endif // EI_DEFERRED_LOG_ENABLED
@@ -0,0 +1,246 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_DEFERRED_LOG_H_
+#define _EI_DEFERRED_LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ei_classifier_porting.h"
+
+/**
+ * Deferred logging. Instead of formatting on the calling task, a log call stores the
+ * address of its format string (which doubles as the message ID) and the raw argument
+ * values into a fixed size lock-free ring: a compare-and-swap and a few stores, no
+ * vsnprintf and no shared print buffer, so it's cheap enough to leave on in production
+ * and safe to call from any task. The records are turned into text later, either:
+ *
+ * - on the device by ei_deferred_log_flush(), from a low priority task
+ *   (ei_deferred_log_start_task() on ESP-IDF) or from the main loop, or
+ * - on the host, by streaming them with ei_deferred_log_drain_binary() and decoding
+ *   with tools/log_decoder, which looks up the format strings in the firmware ELF.
+ *
+ * Because formatting happens later, format strings have to be string literals and
+ * %s arguments must point to memory that stays valid (literals, labels). Records that
+ * don't fit in the ring are dropped and counted.
+ *
+ * If EI_DEFERRED_LOG_ENABLED is 0 the macros below fall back to ei_printf.
+ *
+ * Binary stream (little endian), one record after the other:
+ *   uint64 format address, uint8 level, uint8 argument count, uint8 float mask,
+ *   uint8 reserved, uint32 reserved, then argument count x uint64 values.
+ * Integers are sign or zero extended, pointers are addresses, doubles are stored as
+ * their bits and floats as their bits in the low 32 bits (with their float mask bit set).
+ */
+
+#ifndef EI_DEFERRED_LOG_ENABLED
+#define EI_DEFERRED_LOG_ENABLED 0
+#endif // EI_DEFERRED_LOG_ENABLED
+
+// Number of records that can be pending (must be a power of 2)
+#ifndef EI_DEFERRED_LOG_BUFFER_SIZE
+#define EI_DEFERRED_LOG_BUFFER_SIZE 128
+#endif // EI_DEFERRED_LOG_BUFFER_SIZE
+
+#ifndef EI_DEFERRED_LOG_MAX_ARGS
+#define EI_DEFERRED_LOG_MAX_ARGS 6
+#endif // EI_DEFERRED_LOG_MAX_ARGS
+
+// Longest line ei_deferred_log_flush() prints, longer lines are truncated
+#ifndef EI_DEFERRED_LOG_MAX_LINE
+#define EI_DEFERRED_LOG_MAX_LINE 256
+#endif // EI_DEFERRED_LOG_MAX_LINE
+
+#define EI_DEFERRED_LOG_RECORD_HEADER_SIZE 16
+
+#if EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+
+#include <string.h>
+#include <type_traits>
+
+#if (EI_DEFERRED_LOG_BUFFER_SIZE & (EI_DEFERRED_LOG_BUFFER_SIZE - 1)) != 0
+#error "EI_DEFERRED_LOG_BUFFER_SIZE must be a power of 2"
+#endif
+
+#if EI_DEFERRED_LOG_MAX_ARGS > 8
+#error "EI_DEFERRED_LOG_MAX_ARGS can be at most 8 (one float mask bit per argument)"
+#endif
+
+typedef struct {
+    // position in the ring, see ei_deferred_log_commit()
+    uint32_t position;
+    const char *format;
+    uint8_t level;
+    uint8_t arg_count;
+    // bit n set: args[n] holds the bits of a float rather than a double
+    uint8_t float_mask;
+    uint64_t args[EI_DEFERRED_LOG_MAX_ARGS];
+} ei_deferred_log_record_t;
+
+/**
+ * Reserve the next record, or nullptr (and count a drop) if the ring is full.
+ * Every reserved record has to be committed.
+ */
+ei_deferred_log_record_t *ei_deferred_log_reserve(void);
+void ei_deferred_log_commit(ei_deferred_log_record_t *record);
+
+/**
+ * Format and print (through ei_printf) all pending records.
+ * Returns the number of records printed, 0 if another task is flushing.
+ */
+size_t ei_deferred_log_flush(void);
+
+/**
+ * Hand all pending records to `write` in the binary format described above.
+ * Returns the number of records written, 0 if another task is flushing.
+ */
+size_t ei_deferred_log_drain_binary(void (*write)(const uint8_t *data, size_t size));
+
+uint32_t ei_deferred_log_get_dropped(void);
+
+/**
+ * Format a single record into `buffer` (truncated to `size`), prefixed with the level
+ * name for EI_LOG_LEVEL_ERROR and up. Format strings and %s arguments are looked up
+ * through `resolve_string`, or used as pointers if it's nullptr.
+ *
+ * @return     Length of the formatted text
+ */
+size_t ei_deferred_log_format(char *buffer, size_t size, uint8_t level, const char *format,
+    uint8_t arg_count, uint8_t float_mask, const uint64_t *args,
+    const char *(*resolve_string)(uint64_t address));
+
+#if defined(ESP_PLATFORM)
+/**
+ * Start a FreeRTOS task that flushes the log every `period_ms`
+ */
+bool ei_deferred_log_start_task(uint32_t period_ms, uint32_t priority);
+#endif // ESP_PLATFORM
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, uint64_t>::type
+ei_deferred_log_pack(T value, uint8_t *, size_t)
+{
+    return (uint64_t)(int64_t)value;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, uint64_t>::type
+ei_deferred_log_pack(T value, uint8_t *, size_t)
+{
+    return (uint64_t)value;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_enum<T>::value, uint64_t>::type
+ei_deferred_log_pack(T value, uint8_t *, size_t)
+{
+    return (uint64_t)(int64_t)value;
+}
+
+template<typename T>
+inline uint64_t ei_deferred_log_pack(T *value, uint8_t *, size_t)
+{
+    return (uint64_t)(uintptr_t)value;
+}
+
+// floats aren't promoted here, that costs a soft double conversion on the ESP32
+inline uint64_t ei_deferred_log_pack(float value, uint8_t *float_mask, size_t ix)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    *float_mask |= (uint8_t)(1 << ix);
+    return bits;
+}
+
+inline uint64_t ei_deferred_log_pack(double value, uint8_t *, size_t)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline void ei_deferred_log_pack_args(ei_deferred_log_record_t *, size_t)
+{
+}
+
+template<typename T, typename... Rest>
+inline void ei_deferred_log_pack_args(ei_deferred_log_record_t *record, size_t ix, T value, Rest... rest)
+{
+    record->args[ix] = ei_deferred_log_pack(value, &record->float_mask, ix);
+    ei_deferred_log_pack_args(record, ix + 1, rest...);
+}
+
+template<typename... Args>
+inline void ei_deferred_log(uint8_t level, const char *format, Args... args)
+{
+    static_assert(sizeof...(Args) <= EI_DEFERRED_LOG_MAX_ARGS,
+        "Too many arguments for a deferred log record, increase EI_DEFERRED_LOG_MAX_ARGS");
+
+    ei_deferred_log_record_t *record = ei_deferred_log_reserve();
+    if (!record) {
+        return;
+    }
+    record->format = format;
+    record->level = level;
+    record->arg_count = (uint8_t)sizeof...(Args);
+    record->float_mask = 0;
+    ei_deferred_log_pack_args(record, 0, args...);
+    ei_deferred_log_commit(record);
+}
+
+/**
+ * Log `count` floats, space separated, packed EI_DEFERRED_LOG_MAX_ARGS to a record
+ */
+void ei_deferred_log_floats(const float *values, size_t count);
+
+// "" format: only string literals can be deferred
+#define EI_PRINTF_DEFERRED(format, ...) ei_deferred_log(0, "" format, ##__VA_ARGS__)
+#define EI_PRINTF_FLOAT_DEFERRED(value) ei_deferred_log(0, "%f", (float)(value))
+#define EI_PRINTF_FLOATS_DEFERRED(values, count) ei_deferred_log_floats(values, count)
+
+#else
+
+#define EI_PRINTF_DEFERRED(format, ...) ei_printf(format, ##__VA_ARGS__)
+#define EI_PRINTF_FLOAT_DEFERRED(value) ei_printf_float(value)
+#define EI_PRINTF_FLOATS_DEFERRED(values, count) \
+    do { \
+        for (size_t ei_deferred_log_ix = 0; ei_deferred_log_ix < (size_t)(count); ei_deferred_log_ix++) { \
+            ei_printf_float((values)[ei_deferred_log_ix]); \
+            ei_printf(" "); \
+        } \
+    } while (0)
+
+#endif // EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+
+#endif // _EI_DEFERRED_LOG_H_
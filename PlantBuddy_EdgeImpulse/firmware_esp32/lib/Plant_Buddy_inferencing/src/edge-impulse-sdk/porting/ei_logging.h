@@ -39,6 +39,7 @@
 #include <stdarg.h>
 
 #include "ei_classifier_porting.h"
+#include "ei_deferred_log.h"
 
 #define EI_LOG_LEVEL_NONE 0 /*!< No log output */
 #define EI_LOG_LEVEL_ERROR 1 /*!< Critical errors, software module can not recover on its own */
@@ -71,28 +72,44 @@ __attribute__((unused)) static const char *debug_msgs[] =
     #ifdef EI_LOGE
     #undef EI_LOGE
     #endif // EI_LOGE
+    #if EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+    #define EI_LOGE(format, ...) ei_deferred_log(EI_LOG_LEVEL_ERROR, "" format, ##__VA_ARGS__);
+    #else
     #define EI_LOGE(format, ...) ei_printf("%s: ",debug_msgs[EI_LOG_LEVEL_ERROR]); ei_printf(format, ##__VA_ARGS__);
+    #endif // EI_DEFERRED_LOG_ENABLED
 #endif
 
 #if EI_LOG_LEVEL >= EI_LOG_LEVEL_WARNING
     #ifdef EI_LOGW
     #undef EI_LOGW
     #endif // EI_LOGW
+    #if EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+    #define EI_LOGW(format, ...) ei_deferred_log(EI_LOG_LEVEL_WARNING, "" format, ##__VA_ARGS__);
+    #else
     #define EI_LOGW(format, ...) ei_printf("%s: ",debug_msgs[EI_LOG_LEVEL_WARNING]); ei_printf(format, ##__VA_ARGS__);
+    #endif // EI_DEFERRED_LOG_ENABLED
 #endif
 
 #if EI_LOG_LEVEL >= EI_LOG_LEVEL_INFO
     #ifdef EI_LOGI
     #undef EI_LOGI
     #endif // EI_LOGI
+    #if EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+    #define EI_LOGI(format, ...) ei_deferred_log(EI_LOG_LEVEL_INFO, "" format, ##__VA_ARGS__);
+    #else
     #define EI_LOGI(format, ...) ei_printf("%s: ",debug_msgs[EI_LOG_LEVEL_INFO]); ei_printf(format, ##__VA_ARGS__);
+    #endif // EI_DEFERRED_LOG_ENABLED
 #endif
 
 #if EI_LOG_LEVEL >= EI_LOG_LEVEL_DEBUG
     #ifdef EI_LOGD
     #undef EI_LOGD
     #endif // EI_LOGD
+    #if EI_DEFERRED_LOG_ENABLED && defined(__cplusplus)
+    #define EI_LOGD(format, ...) ei_deferred_log(EI_LOG_LEVEL_DEBUG, "" format, ##__VA_ARGS__);
+    #else
     #define EI_LOGD(format, ...) ei_printf("%s: ",debug_msgs[EI_LOG_LEVEL_DEBUG]); ei_printf(format, ##__VA_ARGS__);
+    #endif // EI_DEFERRED_LOG_ENABLED
 #endif
 
 #endif // _EI_LOGGING_H_
\ No newline at end of file
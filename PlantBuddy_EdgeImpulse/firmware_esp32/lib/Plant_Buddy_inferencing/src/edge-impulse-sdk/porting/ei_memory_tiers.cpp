@@ -0,0 +1,269 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ei_memory_tiers.h"
+#include "ei_classifier_porting.h"
+#include "ei_pool_allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if EI_PORTING_ESPRESSIF == 1
+#include "esp_heap_caps.h"
+#include "esp_idf_version.h"
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "esp_memory_utils.h"
+#else
+#include "soc/soc_memory_layout.h"
+#endif
+#endif // EI_PORTING_ESPRESSIF == 1
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE tiers_mux = portMUX_INITIALIZER_UNLOCKED;
+#define EI_TIERS_LOCK()   portENTER_CRITICAL(&tiers_mux)
+#define EI_TIERS_UNLOCK() portEXIT_CRITICAL(&tiers_mux)
+#else
+#include <atomic>
+static std::atomic_flag tiers_flag = ATOMIC_FLAG_INIT;
+#define EI_TIERS_LOCK()   while (tiers_flag.test_and_set(std::memory_order_acquire)) { }
+#define EI_TIERS_UNLOCK() tiers_flag.clear(std::memory_order_release)
+#endif // ESP_PLATFORM
+
+namespace {
+
+typedef struct {
+    void *ptr;
+    size_t size;
+    ei_memory_tier_t tier;
+} tracked_alloc_t;
+
+tracked_alloc_t tracked[EI_MEMORY_TIERS_MAX_TRACKED];
+volatile uint32_t tracked_count = 0;
+ei_memory_tier_stats_t stats = { };
+
+// caller holds the lock
+void track_locked(void *ptr, size_t size, ei_memory_tier_t requested, ei_memory_tier_t served)
+{
+    stats.alloc_count[requested]++;
+    if (served != requested) {
+        stats.spill_count[requested]++;
+    }
+    stats.alloc_bytes[served] += size;
+
+    for (size_t ix = 0; ix < EI_MEMORY_TIERS_MAX_TRACKED; ix++) {
+        if (tracked[ix].ptr == nullptr) {
+            tracked[ix].ptr = ptr;
+            tracked[ix].size = size;
+            tracked[ix].tier = served;
+            tracked_count++;
+
+            stats.live_bytes[served] += size;
+            if (stats.live_bytes[served] > stats.peak_bytes[served]) {
+                stats.peak_bytes[served] = stats.live_bytes[served];
+            }
+            return;
+        }
+    }
+    stats.untracked_count++;
+}
+
+/**
+ * Allocate from exactly this tier, or return NULL so the caller can try the other one
+ */
+void *tier_alloc(ei_memory_tier_t tier, size_t size, bool zero)
+{
+#if EI_PORTING_ESPRESSIF == 1
+#if EI_PORTING_POOL_ALLOCATOR == 1
+    // the pool is a static region in internal RAM, sized for the tensor arena, so hot
+    // allocations are served from it; bulk ones still go to PSRAM
+    if (tier == EI_MEMORY_TIER_HOT) {
+        return zero ? ei_calloc(size, 1) : ei_malloc(size);
+    }
+#endif // EI_PORTING_POOL_ALLOCATOR == 1
+    uint32_t caps = tier == EI_MEMORY_TIER_HOT ?
+        (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    // keep the 16 byte alignment ESP-NN needs on the S3 (see ei_malloc)
+    return zero ? heap_caps_aligned_calloc(16, 1, size, caps) : heap_caps_aligned_alloc(16, size, caps);
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    // no aligned caps allocator that can be released with free(), use the default heap
+    (void)caps;
+    if (tier != EI_MEMORY_TIER_HOT) {
+        return nullptr;
+    }
+    return zero ? ei_calloc(size, 1) : ei_malloc(size);
+#else
+    return zero ? heap_caps_calloc(1, size, caps) : heap_caps_malloc(size, caps);
+#endif
+#elif EI_MEMORY_TIERS_SIMULATE == 1
+    EI_TIERS_LOCK();
+    bool fits;
+    if (tier == EI_MEMORY_TIER_HOT) {
+        fits = EI_MEMORY_TIERS_SIM_INTERNAL_SIZE == 0 ||
+            stats.live_bytes[EI_MEMORY_TIER_HOT] + size <= (size_t)EI_MEMORY_TIERS_SIM_INTERNAL_SIZE;
+    }
+    else {
+        fits = EI_MEMORY_TIERS_SIM_HAS_EXTERNAL == 1;
+    }
+    EI_TIERS_UNLOCK();
+    if (!fits) {
+        return nullptr;
+    }
+    return zero ? ei_calloc(size, 1) : ei_malloc(size);
+#else
+    // single tier, both hints are served by the regular allocator
+    (void)tier;
+    return zero ? ei_calloc(size, 1) : ei_malloc(size);
+#endif
+}
+
+void *tiered_alloc(ei_memory_tier_t requested, size_t size, bool zero)
+{
+    if (size == 0) {
+        size = 1;
+    }
+
+    ei_memory_tier_t served = requested;
+    void *ptr = tier_alloc(served, size, zero);
+
+    bool may_spill = requested == EI_MEMORY_TIER_BULK || EI_MEMORY_TIERS_HOT_STRICT == 0;
+    if (!ptr && may_spill) {
+        served = requested == EI_MEMORY_TIER_HOT ? EI_MEMORY_TIER_BULK : EI_MEMORY_TIER_HOT;
+        ptr = tier_alloc(served, size, zero);
+    }
+
+    EI_TIERS_LOCK();
+    if (ptr) {
+        track_locked(ptr, size, requested, served);
+    }
+    else {
+        stats.failed_count++;
+    }
+    EI_TIERS_UNLOCK();
+
+    return ptr;
+}
+
+bool total_overflows(size_t nitems, size_t size)
+{
+    return size != 0 && (nitems * size) / size != nitems;
+}
+
+} // namespace
+
+void *ei_malloc_hot(size_t size)
+{
+    return tiered_alloc(EI_MEMORY_TIER_HOT, size, false);
+}
+
+void *ei_calloc_hot(size_t nitems, size_t size)
+{
+    if (total_overflows(nitems, size)) {
+        return nullptr;
+    }
+    return tiered_alloc(EI_MEMORY_TIER_HOT, nitems * size, true);
+}
+
+void *ei_malloc_bulk(size_t size)
+{
+    return tiered_alloc(EI_MEMORY_TIER_BULK, size, false);
+}
+
+void *ei_calloc_bulk(size_t nitems, size_t size)
+{
+    if (total_overflows(nitems, size)) {
+        return nullptr;
+    }
+    return tiered_alloc(EI_MEMORY_TIER_BULK, nitems * size, true);
+}
+
+ei_memory_tier_t ei_memory_tier_of(const void *ptr)
+{
+    EI_TIERS_LOCK();
+    for (size_t ix = 0; ix < EI_MEMORY_TIERS_MAX_TRACKED; ix++) {
+        if (tracked[ix].ptr != nullptr && tracked[ix].ptr == ptr) {
+            ei_memory_tier_t tier = tracked[ix].tier;
+            EI_TIERS_UNLOCK();
+            return tier;
+        }
+    }
+    EI_TIERS_UNLOCK();
+
+#if EI_PORTING_ESPRESSIF == 1
+    if (esp_ptr_external_ram(ptr)) {
+        return EI_MEMORY_TIER_BULK;
+    }
+#endif
+    return EI_MEMORY_TIER_HOT;
+}
+
+void ei_memory_tiers_release(void *ptr)
+{
+    // nothing tiered is live, keep ei_free() cheap
+    if (!ptr || tracked_count == 0) {
+        return;
+    }
+
+    EI_TIERS_LOCK();
+    for (size_t ix = 0; ix < EI_MEMORY_TIERS_MAX_TRACKED; ix++) {
+        if (tracked[ix].ptr == ptr) {
+            stats.live_bytes[tracked[ix].tier] -= tracked[ix].size;
+            tracked[ix].ptr = nullptr;
+            tracked_count--;
+            break;
+        }
+    }
+    EI_TIERS_UNLOCK();
+}
+
+void ei_memory_tiers_get_stats(ei_memory_tier_stats_t *out)
+{
+    EI_TIERS_LOCK();
+    *out = stats;
+    EI_TIERS_UNLOCK();
+}
+
+void ei_memory_tiers_reset_stats(void)
+{
+    EI_TIERS_LOCK();
+    for (size_t tier = 0; tier < EI_MEMORY_TIER_COUNT; tier++) {
+        stats.alloc_count[tier] = 0;
+        stats.spill_count[tier] = 0;
+        stats.alloc_bytes[tier] = 0;
+        stats.peak_bytes[tier] = stats.live_bytes[tier];
+    }
+    stats.failed_count = 0;
+    stats.untracked_count = 0;
+    EI_TIERS_UNLOCK();
+}
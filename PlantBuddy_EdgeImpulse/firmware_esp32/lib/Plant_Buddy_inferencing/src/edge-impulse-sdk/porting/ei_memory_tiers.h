@@ -0,0 +1,173 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_MEMORY_TIERS_H_
+#define _EI_MEMORY_TIERS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Placement hints for SDK allocations. ei_malloc() has no idea what a buffer is used for,
+ * on boards with external PSRAM (ESP32-WROVER, ESP32-S3 with octal PSRAM) that means the
+ * allocator picks whatever has room. The tiers let the SDK say what it wants:
+ *
+ *   - hot:  touched on every inference / every layer (tensor arena, persistent kernel
+ *           buffers). Served from internal SRAM, spills to external RAM only if internal
+ *           RAM is exhausted (unless EI_MEMORY_TIERS_HOT_STRICT is 1).
+ *   - bulk: large buffers that are streamed through once (DSP frames, spectral / image
+ *           scratch). Served from external RAM when there is any, otherwise internal RAM.
+ *
+ * Everything returned by these functions is released with ei_free(). With
+ * EI_PORTING_POOL_ALLOCATOR=1 the hot tier is served by the pool allocator (its static region
+ * is sized for the tensor arena) instead of straight from the internal heap.
+ *
+ * Model weights are const and are placed by the linker, not the allocator. On ESP32 they
+ * are read from flash through the cache by default; build with
+ * EI_MODEL_SECTION=.dram1.ei_model to copy them into internal DRAM at boot instead.
+ *
+ * On targets without tiers the hints are plain ei_malloc() / ei_calloc() calls. Host builds
+ * can define EI_MEMORY_TIERS_SIMULATE=1 to model a board with a limited internal RAM
+ * (EI_MEMORY_TIERS_SIM_INTERNAL_SIZE) and optional external RAM, so the spill behaviour
+ * can be checked without hardware.
+ */
+
+#ifndef EI_MEMORY_TIERS_SIMULATE
+#define EI_MEMORY_TIERS_SIMULATE 0
+#endif
+
+// Fail hot allocations that don't fit in internal RAM rather than spilling them
+#ifndef EI_MEMORY_TIERS_HOT_STRICT
+#define EI_MEMORY_TIERS_HOT_STRICT 0
+#endif
+
+// Number of live tiered allocations that are tracked for the live / peak statistics
+#ifndef EI_MEMORY_TIERS_MAX_TRACKED
+#define EI_MEMORY_TIERS_MAX_TRACKED 32
+#endif
+
+// Simulated internal RAM available to hot + spilled bulk allocations, 0 is unlimited
+#ifndef EI_MEMORY_TIERS_SIM_INTERNAL_SIZE
+#define EI_MEMORY_TIERS_SIM_INTERNAL_SIZE 0
+#endif
+
+// Whether the simulated board has external RAM (unlimited) for bulk allocations
+#ifndef EI_MEMORY_TIERS_SIM_HAS_EXTERNAL
+#define EI_MEMORY_TIERS_SIM_HAS_EXTERNAL 1
+#endif
+
+typedef enum {
+    EI_MEMORY_TIER_HOT = 0,
+    EI_MEMORY_TIER_BULK = 1,
+    EI_MEMORY_TIER_COUNT
+} ei_memory_tier_t;
+
+typedef struct {
+    /**
+     * Number of successful allocations per requested tier
+     */
+    uint32_t alloc_count[EI_MEMORY_TIER_COUNT];
+
+    /**
+     * Number of allocations per requested tier that were served from the other tier
+     */
+    uint32_t spill_count[EI_MEMORY_TIER_COUNT];
+
+    /**
+     * Number of allocations that could not be served at all
+     */
+    uint32_t failed_count;
+
+    /**
+     * Number of allocations that didn't fit in the tracking table (not in live / peak)
+     */
+    uint32_t untracked_count;
+
+    /**
+     * Bytes allocated since the last ei_memory_tiers_reset_stats(), per tier they were
+     * actually served from (tracked or not)
+     */
+    size_t alloc_bytes[EI_MEMORY_TIER_COUNT];
+
+    /**
+     * Bytes currently allocated per tier they were actually served from
+     * (EI_MEMORY_TIER_HOT is internal RAM, EI_MEMORY_TIER_BULK external RAM)
+     */
+    size_t live_bytes[EI_MEMORY_TIER_COUNT];
+
+    /**
+     * Highest value of live_bytes since the last ei_memory_tiers_reset_stats()
+     */
+    size_t peak_bytes[EI_MEMORY_TIER_COUNT];
+} ei_memory_tier_stats_t;
+
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+extern "C" {
+#endif // defined(__cplusplus)
+
+/**
+ * Allocate memory that is accessed on every inference, prefer internal RAM
+ */
+void *ei_malloc_hot(size_t size);
+void *ei_calloc_hot(size_t nitems, size_t size);
+
+/**
+ * Allocate a large, streamed-through buffer, prefer external RAM
+ */
+void *ei_malloc_bulk(size_t size);
+void *ei_calloc_bulk(size_t nitems, size_t size);
+
+/**
+ * Tier a pointer was served from. Pointers that were not allocated through the hints
+ * are reported by address on targets that can tell, otherwise as EI_MEMORY_TIER_HOT.
+ */
+ei_memory_tier_t ei_memory_tier_of(const void *ptr);
+
+/**
+ * Called by the porting layer's ei_free() so live statistics stay correct
+ */
+void ei_memory_tiers_release(void *ptr);
+
+void ei_memory_tiers_get_stats(ei_memory_tier_stats_t *stats);
+
+/**
+ * Restart the counters, peaks restart from the current live bytes
+ */
+void ei_memory_tiers_reset_stats(void);
+
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+}
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+
+#endif // _EI_MEMORY_TIERS_H_
@@ -0,0 +1,115 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_MPSC_RING_H_
+#define _EI_MPSC_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * Fixed size lock-free ring with any number of producers and a single consumer, used by
+ * the profiler's event buffer and the deferred log.
+ *
+ * A producer reserves a slot with a compare-and-swap on the head (failing, and counting a
+ * drop, if the consumer hasn't released the slot yet), writes it, and publishes it by
+ * storing its position + 1 in the slot's sequence number (release). The consumer only
+ * takes slots whose sequence number matches, so a slot that's reserved but not yet
+ * committed holds back everything after it, then hands them back by moving the tail.
+ *
+ * N must be a power of 2. There's no constructor, rings are meant to live in static
+ * storage (zero initialized), so they can be used before any constructors run.
+ */
+template<typename T, uint32_t N>
+class ei_mpsc_ring {
+    static_assert((N & (N - 1)) == 0, "ei_mpsc_ring size must be a power of 2");
+
+public:
+    /**
+     * Reserve the next slot, or nullptr (and count a drop) if the ring is full.
+     * Every reserved slot has to be committed with the position written to `pos`.
+     */
+    T *reserve(uint32_t *pos)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        do {
+            if (head - _tail.load(std::memory_order_acquire) >= N) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        } while (!_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        *pos = head;
+        return &_slots[head & (N - 1)];
+    }
+
+    void commit(uint32_t pos)
+    {
+        _seq[pos & (N - 1)].store(pos + 1, std::memory_order_release);
+    }
+
+    /**
+     * Copy out the oldest committed slot, or return false if there is none. Consumer only.
+     */
+    bool pop(T *out)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_seq[tail & (N - 1)].load(std::memory_order_acquire) != tail + 1) {
+            return false;
+        }
+        *out = _slots[tail & (N - 1)];
+        // hand the slot back to the producers
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t get_dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    void clear_dropped()
+    {
+        _dropped.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    T _slots[N];
+    std::atomic<uint32_t> _seq[N];
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    std::atomic<uint32_t> _dropped;
+};
+
+#endif // _EI_MPSC_RING_H_
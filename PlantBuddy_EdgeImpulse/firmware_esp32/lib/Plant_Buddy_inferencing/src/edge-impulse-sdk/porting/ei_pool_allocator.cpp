@@ -0,0 +1,382 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ei_pool_allocator.h"
+#if EI_PORTING_POOL_ALLOCATOR == 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "model-parameters/model_metadata.h"
+#include "ei_classifier_porting.h"
+#include "ei_memory_tiers.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+static portMUX_TYPE pool_mux = portMUX_INITIALIZER_UNLOCKED;
+#define EI_POOL_LOCK()   portENTER_CRITICAL(&pool_mux)
+#define EI_POOL_UNLOCK() portEXIT_CRITICAL(&pool_mux)
+#else
+#include <atomic>
+static std::atomic_flag pool_flag = ATOMIC_FLAG_INIT;
+#define EI_POOL_LOCK()   while (pool_flag.test_and_set(std::memory_order_acquire)) { }
+#define EI_POOL_UNLOCK() pool_flag.clear(std::memory_order_release)
+#endif // ESP_PLATFORM
+
+namespace {
+
+const size_t pool_alignment = 16;
+const size_t pool_class_count = 5;
+const size_t pool_class_sizes[pool_class_count] = { 16, 32, 64, 128, 256 };
+const size_t pools_size = (16 + 32 + 64 + 128 + 256) * EI_POOL_ALLOCATOR_BLOCKS_PER_CLASS;
+const size_t arena_size = (((size_t)EI_POOL_ALLOCATOR_ARENA_SIZE) + pool_alignment - 1) & ~(pool_alignment - 1);
+const size_t no_block = (size_t)-1;
+
+// every arena block starts with this header, keeps the payload 16 byte aligned
+typedef struct {
+    uint32_t size;      // block size including the header
+    uint32_t prev_size; // size of the block below, 0 for the first block
+    uint32_t live;
+    uint32_t epoch;     // arena_epoch when the block was handed out
+} arena_header_t;
+
+typedef struct free_block {
+    struct free_block *next;
+} free_block_t;
+
+__attribute__((aligned(16))) uint8_t pool_region[pools_size + arena_size];
+uint8_t *const arena = pool_region + pools_size;
+
+uint8_t *class_start[pool_class_count];
+free_block_t *free_lists[pool_class_count];
+bool pool_initialized = false;
+
+size_t arena_top = 0;           // first free byte in the arena
+size_t arena_last = no_block;   // offset of the topmost block, always live
+size_t arena_holes = 0;         // free blocks below the top
+uint32_t arena_epoch = 0;       // bumped on every mark
+
+ei_pool_allocator_stats_t stats = { };
+
+void pool_init()
+{
+    uint8_t *p = pool_region;
+    for (size_t c = 0; c < pool_class_count; c++) {
+        class_start[c] = p;
+        free_lists[c] = nullptr;
+        for (size_t b = 0; b < EI_POOL_ALLOCATOR_BLOCKS_PER_CLASS; b++) {
+            free_block_t *block = (free_block_t*)p;
+            block->next = free_lists[c];
+            free_lists[c] = block;
+            p += pool_class_sizes[c];
+        }
+    }
+    stats.capacity_bytes = sizeof(pool_region);
+    pool_initialized = true;
+}
+
+inline arena_header_t *arena_block(size_t offset)
+{
+    return (arena_header_t*)(arena + offset);
+}
+
+void account_alloc(size_t bytes)
+{
+    stats.alloc_count++;
+    stats.live_bytes += bytes;
+    if (stats.live_bytes > stats.peak_bytes) {
+        stats.peak_bytes = stats.live_bytes;
+    }
+}
+
+// caller holds the lock
+void *pool_alloc_locked(size_t size)
+{
+    if (!pool_initialized) {
+        pool_init();
+    }
+
+    for (size_t c = 0; c < pool_class_count; c++) {
+        if (size <= pool_class_sizes[c] && free_lists[c]) {
+            free_block_t *block = free_lists[c];
+            free_lists[c] = block->next;
+            account_alloc(pool_class_sizes[c]);
+            return block;
+        }
+    }
+
+    size_t needed = sizeof(arena_header_t) + ((size + pool_alignment - 1) & ~(pool_alignment - 1));
+    if (needed < size || needed > arena_size) {
+        return nullptr;
+    }
+
+    // first fit in the holes left below a block that's still live
+    if (arena_holes > 0) {
+        for (size_t offset = 0; offset < arena_top; offset += arena_block(offset)->size) {
+            arena_header_t *header = arena_block(offset);
+            if (header->live || header->size < needed) {
+                continue;
+            }
+
+            size_t rest = header->size - needed;
+            if (rest >= sizeof(arena_header_t) + pool_alignment) {
+                // split, the remainder stays a hole
+                header->size = (uint32_t)needed;
+                arena_header_t *tail = arena_block(offset + needed);
+                tail->size = (uint32_t)rest;
+                tail->prev_size = (uint32_t)needed;
+                tail->live = 0;
+                arena_block(offset + needed + rest)->prev_size = (uint32_t)rest;
+            }
+            else {
+                arena_holes--;
+            }
+
+            header->live = 1;
+            header->epoch = arena_epoch;
+            account_alloc(header->size);
+            return header + 1;
+        }
+    }
+
+    if (arena_top + needed > arena_size) {
+        return nullptr;
+    }
+
+    arena_header_t *header = arena_block(arena_top);
+    header->size = (uint32_t)needed;
+    header->prev_size = arena_last == no_block ? 0 : arena_block(arena_last)->size;
+    header->live = 1;
+    header->epoch = arena_epoch;
+    arena_last = arena_top;
+    arena_top += needed;
+
+    account_alloc(needed);
+    return header + 1;
+}
+
+// caller holds the lock, returns false if ptr is not ours
+bool pool_free_locked(void *ptr)
+{
+    uint8_t *p = (uint8_t*)ptr;
+    if (p < pool_region || p >= pool_region + sizeof(pool_region)) {
+        return false;
+    }
+
+    stats.free_count++;
+
+    if (p < arena) {
+        for (size_t c = pool_class_count; c-- > 0; ) {
+            if (p >= class_start[c]) {
+                free_block_t *block = (free_block_t*)p;
+                block->next = free_lists[c];
+                free_lists[c] = block;
+                stats.live_bytes -= pool_class_sizes[c];
+                break;
+            }
+        }
+        return true;
+    }
+
+    arena_header_t *header = ((arena_header_t*)p) - 1;
+    size_t offset = (uint8_t*)header - arena;
+    header->live = 0;
+    stats.live_bytes -= header->size;
+
+    // merge with a free block above (never the topmost block, that one is always live)
+    size_t next = offset + header->size;
+    if (next < arena_top && !arena_block(next)->live) {
+        header->size += arena_block(next)->size;
+        arena_holes--;
+    }
+
+    // merge into a free block below
+    if (header->prev_size != 0 && !arena_block(offset - header->prev_size)->live) {
+        offset -= header->prev_size;
+        arena_block(offset)->size += header->size;
+        header = arena_block(offset);
+        arena_holes--;
+    }
+
+    next = offset + header->size;
+    if (next < arena_top) {
+        arena_block(next)->prev_size = header->size;
+        arena_holes++;
+    }
+    else {
+        // the freed block was the topmost one, the block below is live so one pop is enough
+        arena_top = offset;
+        arena_last = header->prev_size == 0 ? no_block : offset - header->prev_size;
+    }
+    return true;
+}
+
+#if EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP == 1
+void *heap_alloc(size_t size)
+{
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    return aligned_alloc(16, (size + 15) & ~((size_t)15));
+#else
+    return malloc(size);
+#endif
+}
+#endif // EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP == 1
+
+} // namespace
+
+void *ei_pool_malloc(size_t size)
+{
+    if (size == 0) {
+        size = 1;
+    }
+
+    EI_POOL_LOCK();
+    void *ptr = pool_alloc_locked(size);
+    EI_POOL_UNLOCK();
+
+    if (ptr) {
+        return ptr;
+    }
+
+#if EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP == 1
+    ptr = heap_alloc(size);
+#endif
+
+    EI_POOL_LOCK();
+    if (ptr) {
+        stats.alloc_count++;
+        stats.fallback_count++;
+    }
+    else {
+        stats.failed_count++;
+    }
+    EI_POOL_UNLOCK();
+
+    return ptr;
+}
+
+void *ei_pool_calloc(size_t nitems, size_t size)
+{
+    size_t total = nitems * size;
+    if (size != 0 && total / size != nitems) {
+        EI_POOL_LOCK();
+        stats.failed_count++;
+        EI_POOL_UNLOCK();
+        return nullptr;
+    }
+
+    void *ptr = ei_pool_malloc(total);
+    if (ptr) {
+        memset(ptr, 0, total);
+    }
+    return ptr;
+}
+
+void ei_pool_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    EI_POOL_LOCK();
+    bool ours = pool_free_locked(ptr);
+    if (!ours) {
+        stats.free_count++;
+    }
+    EI_POOL_UNLOCK();
+
+    if (!ours) {
+        free(ptr);
+    }
+}
+
+void ei_pool_allocator_mark(void)
+{
+    EI_POOL_LOCK();
+    if (!pool_initialized) {
+        pool_init();
+    }
+    arena_epoch++;
+    stats.peak_bytes = stats.live_bytes;
+    stats.alloc_count = 0;
+    stats.free_count = 0;
+    stats.failed_count = 0;
+    stats.fallback_count = 0;
+    stats.retained_count = 0;
+    EI_POOL_UNLOCK();
+}
+
+void ei_pool_allocator_reset(void)
+{
+    EI_POOL_LOCK();
+    uint32_t retained = 0;
+    for (size_t offset = 0; offset < arena_top; offset += arena_block(offset)->size) {
+        arena_header_t *header = arena_block(offset);
+        if (header->live && header->epoch == arena_epoch) {
+            retained++;
+        }
+    }
+    stats.retained_count = retained;
+    // blocks handed out from here on belong to no window
+    arena_epoch++;
+    EI_POOL_UNLOCK();
+}
+
+void ei_pool_allocator_get_stats(ei_pool_allocator_stats_t *out)
+{
+    EI_POOL_LOCK();
+    if (!pool_initialized) {
+        pool_init();
+    }
+    *out = stats;
+    EI_POOL_UNLOCK();
+}
+
+// Strong definitions, these replace the weak ones in the porting layer
+void *ei_malloc(size_t size)
+{
+    return ei_pool_malloc(size);
+}
+
+void *ei_calloc(size_t nitems, size_t size)
+{
+    return ei_pool_calloc(nitems, size);
+}
+
+void ei_free(void *ptr)
+{
+    ei_memory_tiers_release(ptr);
+    ei_pool_free(ptr);
+}
+
+#endif // EI_PORTING_POOL_ALLOCATOR == 1
@@ -0,0 +1,165 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_POOL_ALLOCATOR_H_
+#define _EI_POOL_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Optional deterministic allocator for the SDK. If EI_PORTING_POOL_ALLOCATOR is set to 1,
+ * ei_malloc / ei_calloc / ei_free (normally weak symbols in the porting layer) are served from
+ * a static region instead of the system heap, so SDK allocations can't fragment the heap that
+ * the rest of the application uses. The region is split into:
+ *
+ *   - size-class pools (16..256 bytes), O(1) alloc/free from free lists
+ *   - an arena for everything larger. Blocks are bumped off the top and popped when the
+ *     topmost one is freed; blocks freed below a live one are merged with their free
+ *     neighbours and reused first-fit, so a long-lived block (FFT plan, DSP state) doesn't
+ *     strand the memory underneath it.
+ *
+ * process_impulse() marks the allocator when it starts and resets it when it's done. Freed
+ * memory is released immediately, reset only reports what the inference left behind (e.g.
+ * DSP state that lives across inferences). Statistics are restarted on every mark, so after
+ * run_classifier() they describe that inference.
+ *
+ * Requests that don't fit are handed to the system heap (unless
+ * EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP is 0) and counted as fallbacks.
+ */
+
+#ifndef EI_PORTING_POOL_ALLOCATOR
+#define EI_PORTING_POOL_ALLOCATOR 0
+#endif
+
+// Size of the arena, by default sized after the largest TFLite arena plus headroom for DSP buffers
+#ifndef EI_POOL_ALLOCATOR_ARENA_SIZE
+#define EI_POOL_ALLOCATOR_ARENA_SIZE (EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE + 4096)
+#endif
+
+// Number of blocks in each size class (16, 32, 64, 128 and 256 bytes)
+#ifndef EI_POOL_ALLOCATOR_BLOCKS_PER_CLASS
+#define EI_POOL_ALLOCATOR_BLOCKS_PER_CLASS 8
+#endif
+
+#ifndef EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP
+#define EI_POOL_ALLOCATOR_FALLBACK_TO_HEAP 1
+#endif
+
+typedef struct {
+    /**
+     * Bytes currently handed out (after rounding up to the block size), excluding heap fallbacks
+     */
+    size_t live_bytes;
+
+    /**
+     * Highest value of live_bytes since the last mark
+     */
+    size_t peak_bytes;
+
+    /**
+     * Total size of the pools plus the arena
+     */
+    size_t capacity_bytes;
+
+    /**
+     * Number of successful allocations since the last mark (including heap fallbacks)
+     */
+    uint32_t alloc_count;
+
+    /**
+     * Number of frees since the last mark
+     */
+    uint32_t free_count;
+
+    /**
+     * Number of allocations since the last mark that could not be served at all
+     */
+    uint32_t failed_count;
+
+    /**
+     * Number of allocations since the last mark that were served by the system heap
+     */
+    uint32_t fallback_count;
+
+    /**
+     * Number of arena blocks allocated since the last mark that were still live at reset
+     */
+    uint32_t retained_count;
+} ei_pool_allocator_stats_t;
+
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+extern "C" {
+#endif // defined(__cplusplus)
+
+void *ei_pool_malloc(size_t size);
+void *ei_pool_calloc(size_t nitems, size_t size);
+void ei_pool_free(void *ptr);
+
+/**
+ * Open a window: arena blocks allocated from here on are tracked, and the statistics restart
+ */
+void ei_pool_allocator_mark(void);
+
+/**
+ * Close the window opened by ei_pool_allocator_mark(). Freed arena blocks have been
+ * released already; blocks allocated since the mark that are still live are kept and
+ * counted in retained_count.
+ */
+void ei_pool_allocator_reset(void);
+
+/**
+ * Copy the statistics since the last mark
+ */
+void ei_pool_allocator_get_stats(ei_pool_allocator_stats_t *stats);
+
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+}
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+
+#if defined(__cplusplus) && EI_PORTING_POOL_ALLOCATOR == 1
+/**
+ * Marks the allocator on construction, resets it on destruction
+ */
+class ei_pool_allocator_scope {
+public:
+    ei_pool_allocator_scope() { ei_pool_allocator_mark(); }
+    ~ei_pool_allocator_scope() { ei_pool_allocator_reset(); }
+};
+#define EI_POOL_ALLOCATOR_SCOPE() ei_pool_allocator_scope ei_pool_allocator_scope_instance
+#else
+#define EI_POOL_ALLOCATOR_SCOPE()
+#endif // defined(__cplusplus) && EI_PORTING_POOL_ALLOCATOR == 1
+
+#endif // _EI_POOL_ALLOCATOR_H_
@@ -33,6 +33,7 @@
  */
 
 #include "../ei_classifier_porting.h"
+#include "../ei_memory_tiers.h"
 #if EI_PORTING_ESPRESSIF == 1
 
 #include <stdarg.h>
@@ -126,6 +127,7 @@ __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
+    ei_memory_tiers_release(ptr);
     free(ptr);
 }
 
@@ -0,0 +1,101 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_TINY_FULLY_CONNECTED_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_TINY_FULLY_CONNECTED_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+// Int8 fully connected kernels for small dense layers, specialized at compile time on the
+// layer shape. These are meant to be called directly from EON compiled models, which know
+// every shape and quantization parameter up front, so none of the per-call shape checks or
+// parameter lookups of the generic kernels are needed.
+//
+// Filter zero point must be 0 (symmetric int8 weights, per the TFLite quantization spec).
+// The input zero point is folded into the bias by the model compiler:
+//   folded_bias[o] = bias[o] + input_offset * sum(filter[o][:])
+// so the inner loop is a plain int8 dot product. Results are bit-exact with
+// reference_integer_ops::FullyConnected.
+
+namespace tflite {
+namespace tiny_fc {
+
+struct LayerParams {
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t output_offset;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+};
+
+// Unrolled int8 dot product; recursion depth is the accumulation depth, which
+// is small for the layers this is used for.
+template <int N>
+struct DotS8 {
+  static inline int32_t Run(const int8_t* input, const int8_t* filter) {
+    return DotS8<N - 1>::Run(input, filter) +
+           static_cast<int32_t>(input[N - 1]) * static_cast<int32_t>(filter[N - 1]);
+  }
+};
+
+template <>
+struct DotS8<0> {
+  static inline int32_t Run(const int8_t*, const int8_t*) { return 0; }
+};
+
+template <int InDepth, int OutDepth>
+inline void FullyConnectedS8(const int8_t* input, const int8_t* filter,
+                             const int32_t* folded_bias,
+                             const LayerParams& params, int8_t* output) {
+  static_assert(InDepth > 0 && OutDepth > 0, "invalid layer shape");
+
+  for (int out_c = 0; out_c < OutDepth; ++out_c) {
+    int32_t acc = DotS8<InDepth>::Run(input, filter + out_c * InDepth) +
+                  folded_bias[out_c];
+    acc = MultiplyByQuantizedMultiplier(acc, params.output_multiplier,
+                                        params.output_shift);
+    acc += params.output_offset;
+    acc = std::max(acc, params.output_activation_min);
+    acc = std::min(acc, params.output_activation_max);
+    output[out_c] = static_cast<int8_t>(acc);
+  }
+}
+
+}  // namespace tiny_fc
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_TINY_FULLY_CONNECTED_H_
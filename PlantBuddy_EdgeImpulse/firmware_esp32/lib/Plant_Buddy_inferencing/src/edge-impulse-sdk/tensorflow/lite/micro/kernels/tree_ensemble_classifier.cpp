@@ -38,12 +38,36 @@
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include <math.h>
+#include <algorithm>
 
 #define FEATURE_TYPE float
 
+// Repack the trees into a breadth-first node array at prepare time (8 bytes per
+// node, taken from the persistent arena). Set to 0 to walk the model's node
+// arrays directly, which takes no arena.
+#ifndef EI_TFLITE_TREE_ENSEMBLE_PACKED
+#define EI_TFLITE_TREE_ENSEMBLE_PACKED 1
+#endif
+
+// Number of (sample, tree) traversals advanced in lock-step
+#ifndef EI_TFLITE_TREE_ENSEMBLE_LANES
+#define EI_TFLITE_TREE_ENSEMBLE_LANES 8
+#endif
+
 namespace tflite {
 namespace {
 
+// Internal node: go to `children` if x[feature] <= value, else to `children + 1`.
+// Leaf (feature == kPackedLeaf): add `value` to output class `children`.
+struct PackedTreeNode {
+  float value;
+  uint16_t feature;
+  uint16_t children;
+};
+static_assert(sizeof(PackedTreeNode) == 8, "PackedTreeNode should stay 8 bytes");
+
+constexpr uint16_t kPackedLeaf = 0xFFFF;
+
 struct OpDataTree {
   uint32_t num_leaf_nodes;
   uint32_t num_internal_nodes;
@@ -58,8 +82,152 @@ struct OpDataTree {
   const uint16_t* tree_root_ids;
   const uint8_t* buffer_t;
   size_t buffer_length;
+  // Breadth-first copy of the trees, nullptr if not built
+  const PackedTreeNode* packed_nodes;
+  const uint16_t* packed_roots;
 };
 
+/**
+ * Lay the trees out breadth-first into `nodes` (room for num_leaf_nodes +
+ * num_internal_nodes), siblings next to each other, so a split is one 8 byte
+ * load and the children of a node share a cache line.
+ * The array itself is used as the BFS queue: queued entries hold their source
+ * node id in `children` until they are visited.
+ * @returns false if the node graph is not a forest (shared or cyclic nodes)
+ *  or a leaf refers to a class outside the output, callers then keep walking
+ *  the source arrays.
+ */
+bool PackTrees(const OpDataTree* data, int input_width, int output_width,
+               PackedTreeNode* nodes, uint16_t* roots) {
+  const uint32_t num_nodes = data->num_leaf_nodes + data->num_internal_nodes;
+  if (num_nodes > (uint32_t)UINT16_MAX + 1 || input_width > kPackedLeaf) {
+    return false;
+  }
+
+  uint32_t tail = 0;
+  for (uint32_t tree = 0; tree < data->num_trees; tree++) {
+    if (tail >= num_nodes) {
+      return false;
+    }
+    uint32_t head = tail;
+    roots[tree] = head;
+    nodes[tail++].children = data->tree_root_ids[tree];
+
+    for (; head < tail; head++) {
+      const uint16_t ix = nodes[head].children;
+
+      if (ix < data->num_internal_nodes) {
+        if (tail + 2 > num_nodes) {
+          return false;
+        }
+        float node_val = 0;
+        memcpy(&node_val, (data->nodes_values + ix), sizeof(float));
+
+        nodes[head].value = node_val;
+        nodes[head].feature = data->nodes_featureids[ix];
+        nodes[head].children = tail;
+        nodes[tail++].children = data->nodes_truenodeids[ix];
+        nodes[tail++].children = data->nodes_falsenodeids[ix];
+      }
+      else {
+        const uint16_t leaf = ix - data->num_internal_nodes;
+        if (data->nodes_classids[leaf] >= output_width) {
+          return false;
+        }
+        float weight = 0;
+        memcpy(&weight, (data->nodes_weights + leaf), sizeof(float));
+
+        nodes[head].value = weight;
+        nodes[head].feature = kPackedLeaf;
+        nodes[head].children = data->nodes_classids[leaf];
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Score `num_samples` rows with the packed trees. Traversals for consecutive
+ * (sample, tree) pairs run interleaved so their node loads overlap; leaf
+ * weights are still added per sample in tree order.
+ */
+void EvalPacked(const OpDataTree* data, const float* in_data, int input_width,
+                float* out_data, int output_width, int num_samples) {
+  constexpr int kLanes = EI_TFLITE_TREE_ENSEMBLE_LANES;
+  const PackedTreeNode* nodes = data->packed_nodes;
+  const uint32_t total = (uint32_t)num_samples * data->num_trees;
+
+  uint32_t tree = 0;
+  const float* row = in_data;
+  float* out_row = out_data;
+
+  for (uint32_t k = 0; k < total; k += kLanes) {
+    const int lanes = (total - k) < (uint32_t)kLanes ? (int)(total - k) : kLanes;
+
+    uint32_t cur[kLanes];
+    const float* rows[kLanes];
+    float* out_rows[kLanes];
+    for (int l = 0; l < lanes; l++) {
+      cur[l] = data->packed_roots[tree];
+      rows[l] = row;
+      out_rows[l] = out_row;
+      if (++tree == data->num_trees) {
+        tree = 0;
+        row += input_width;
+        out_row += output_width;
+      }
+    }
+
+    bool active = true;
+    while (active) {
+      active = false;
+      for (int l = 0; l < lanes; l++) {
+        const PackedTreeNode& n = nodes[cur[l]];
+        if (n.feature != kPackedLeaf) {
+          cur[l] = n.children + !(rows[l][n.feature] <= n.value);
+          active = true;
+        }
+      }
+    }
+
+    for (int l = 0; l < lanes; l++) {
+      const PackedTreeNode& leaf = nodes[cur[l]];
+      out_rows[l][leaf.children] += leaf.value;
+    }
+  }
+}
+
+/**
+ * Score `num_samples` rows by walking the model's node arrays
+ */
+void EvalUnpacked(const OpDataTree* data, const float* in_data, int input_width,
+                  float* out_data, int output_width, int num_samples) {
+  for (int s = 0; s < num_samples; s++) {
+    const float* row = in_data + s * input_width;
+    float* out_row = out_data + s * output_width;
+
+    for (uint32_t i = 0; i < data->num_trees; i++) {
+      uint16_t ix = data->tree_root_ids[i];
+
+      while (ix < data->num_internal_nodes) {
+        float node_val = 0;
+        memcpy(&node_val, (data->nodes_values + ix), sizeof(float));
+
+        if (row[data->nodes_featureids[ix]] <= node_val) {
+          ix = data->nodes_truenodeids[ix];
+        } else {
+          ix = data->nodes_falsenodeids[ix];
+        }
+      }
+      ix -= data->num_internal_nodes;
+
+      float weight = 0;
+      memcpy(&weight, (data->nodes_weights + ix), sizeof(float));
+      out_row[data->nodes_classids[ix]] += weight;
+    }
+  }
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
   const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
@@ -83,13 +251,16 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   data->nodes_classids = (uint8_t*)(m["nodes_classids"].AsBlob().data());
   data->tree_root_ids = (uint16_t*)(m["tree_root_ids"].AsBlob().data());
 
+  data->packed_nodes = nullptr;
+  data->packed_roots = nullptr;
+
   return data;
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   MicroContext* micro_context = GetMicroContext(context);
-  const OpDataTree* data = static_cast<const OpDataTree*>(node->user_data);
+  OpDataTree* data = static_cast<OpDataTree*>(node->user_data);
   const flexbuffers::Map& m = flexbuffers::GetRoot(data->buffer_t, data->buffer_length).AsMap();
 
   // The OOB checks below are very important to prevent vulnerabilities where an adversary sends
@@ -149,6 +320,23 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
+#if EI_TFLITE_TREE_ENSEMBLE_PACKED
+  // Prepare can run more than once, only pack on the first pass
+  if (data->packed_nodes == nullptr && data->num_trees > 0) {
+    const uint32_t num_nodes = data->num_leaf_nodes + data->num_internal_nodes;
+    PackedTreeNode* nodes = static_cast<PackedTreeNode*>(
+        context->AllocatePersistentBuffer(context, num_nodes * sizeof(PackedTreeNode)));
+    uint16_t* roots = static_cast<uint16_t*>(
+        context->AllocatePersistentBuffer(context, data->num_trees * sizeof(uint16_t)));
+
+    // on failure Eval keeps using the model's node arrays
+    if (nodes && roots && PackTrees(data, input_width, output_width, nodes, roots)) {
+      data->packed_nodes = nodes;
+      data->packed_roots = roots;
+    }
+  }
+#endif // EI_TFLITE_TREE_ENSEMBLE_PACKED
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(output);
 
@@ -170,24 +358,13 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const tflite::RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
   memset(out_data, 0, output_shape.FlatSize() * sizeof(float));
 
-  for (uint32_t i = 0; i < data->num_trees; i++) {
-    uint16_t ix = data->tree_root_ids[i];
-
-    while (ix < data->num_internal_nodes) {
-      float node_val = 0;
-      memcpy(&node_val, (data->nodes_values + ix), sizeof(float));
-
-      if (in_data[data->nodes_featureids[ix]] <= node_val) {
-        ix = data->nodes_truenodeids[ix];
-      } else {
-        ix = data->nodes_falsenodeids[ix];
-      }
-    }
-    ix -= data->num_internal_nodes;
-
-    float weight = 0;
-    memcpy(&weight, (data->nodes_weights + ix), sizeof(float));
-    out_data[data->nodes_classids[ix]] += weight;
+  const tflite::RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  const int num_samples = std::min(input_shape.Dims(0), output_shape.Dims(0));
+  if (data->packed_nodes) {
+    EvalPacked(data, in_data, input_shape.Dims(1), out_data, output_shape.Dims(1), num_samples);
+  }
+  else {
+    EvalUnpacked(data, in_data, input_shape.Dims(1), out_data, output_shape.Dims(1), num_samples);
   }
 
   return kTfLiteOk;
@@ -0,0 +1,298 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/precomputed_memory_planner.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace {
+
+// Highest end offset placed so far at each time step of the plan. Raise()
+// lifts every step in [first, last] to at least `end`, Max() returns the
+// highest end in [first, last]. A segment tree without lazy propagation:
+// node_max holds the highest end raised anywhere below a node, node_all the
+// highest end raised over the whole node, so both are O(log steps).
+class TimeStepEnds {
+ public:
+  // node_max and node_all hold NodeCount(steps) zeroed entries each.
+  TimeStepEnds(int32_t* node_max, int32_t* node_all, int steps)
+      : node_max_(node_max), node_all_(node_all), steps_(steps) {}
+
+  static size_t NodeCount(int steps) { return 4 * static_cast<size_t>(steps); }
+
+  void Raise(int first, int last, int32_t end) {
+    Raise(0, 0, steps_ - 1, first, last, end);
+  }
+  int32_t Max(int first, int last) const {
+    return Max(0, 0, steps_ - 1, first, last);
+  }
+
+ private:
+  void Raise(int node, int lo, int hi, int first, int last, int32_t end) {
+    if (last < lo || hi < first) {
+      return;
+    }
+    node_max_[node] = std::max(node_max_[node], end);
+    if (first <= lo && hi <= last) {
+      node_all_[node] = std::max(node_all_[node], end);
+      return;
+    }
+    const int mid = lo + (hi - lo) / 2;
+    Raise(2 * node + 1, lo, mid, first, last, end);
+    Raise(2 * node + 2, mid + 1, hi, first, last, end);
+  }
+
+  int32_t Max(int node, int lo, int hi, int first, int last) const {
+    if (last < lo || hi < first) {
+      return 0;
+    }
+    if (first <= lo && hi <= last) {
+      return node_max_[node];
+    }
+    const int mid = lo + (hi - lo) / 2;
+    return std::max({node_all_[node],
+                     Max(2 * node + 1, lo, mid, first, last),
+                     Max(2 * node + 2, mid + 1, hi, first, last)});
+  }
+
+  int32_t* node_max_;
+  int32_t* node_all_;
+  int steps_;
+};
+
+// The plan comes from model metadata, so don't trust it: every entry has to
+// lie inside the arena, and must not share memory with another entry that is
+// live at the same time. Entries are visited by offset, so an entry overlaps
+// an earlier one iff some end placed during its lifetime lies past its
+// offset. O(n log n) in the entry count, using scratch for the visit order
+// and a segment tree over the time steps.
+bool IsValidPlan(const PrecomputedMemoryPlan* plan, unsigned char* scratch,
+                 int scratch_size) {
+  const int count = plan->buffer_count;
+  int last_step = 0;
+  for (int i = 0; i < count; ++i) {
+    const PrecomputedBufferEntry& entry = plan->entries[i];
+    if (entry.offset < 0 || entry.size < 0 ||
+        entry.offset > plan->arena_size - entry.size ||
+        entry.first_time_used < 0 ||
+        entry.first_time_used > entry.last_time_used) {
+      return false;
+    }
+    last_step = std::max(last_step, entry.last_time_used);
+  }
+  if (count < 2) {
+    return true;
+  }
+
+  // Bound each term by the scratch before adding, so a hostile step count
+  // can't wrap the size on 32-bit targets.
+  const size_t scratch_words =
+      scratch_size > 0 ? scratch_size / sizeof(int32_t) : 0;
+  if (static_cast<size_t>(count) > scratch_words ||
+      static_cast<size_t>(last_step) >= (scratch_words - count) / 8) {
+    MicroPrintf("Not enough planner scratch to validate the precomputed plan");
+    return false;
+  }
+  const int steps = last_step + 1;
+  int32_t* order = reinterpret_cast<int32_t*>(scratch);
+  int32_t* node_max = order + count;
+  int32_t* node_all = node_max + TimeStepEnds::NodeCount(steps);
+  memset(node_max, 0, 2 * TimeStepEnds::NodeCount(steps) * sizeof(int32_t));
+
+  for (int i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  std::sort(order, order + count, [plan](int32_t a, int32_t b) {
+    return plan->entries[a].offset < plan->entries[b].offset;
+  });
+
+  TimeStepEnds ends(node_max, node_all, steps);
+  for (int i = 0; i < count; ++i) {
+    const PrecomputedBufferEntry& entry = plan->entries[order[i]];
+    if (entry.size == 0) {
+      continue;
+    }
+    if (ends.Max(entry.first_time_used, entry.last_time_used) > entry.offset) {
+      return false;
+    }
+    ends.Raise(entry.first_time_used, entry.last_time_used,
+               entry.offset + entry.size);
+  }
+  return true;
+}
+
+}  // namespace
+
+const PrecomputedMemoryPlan* GetPrecomputedMemoryPlan(const Model* model) {
+  if (model == nullptr || model->metadata() == nullptr ||
+      model->buffers() == nullptr) {
+    return nullptr;
+  }
+
+  const size_t name_length = strlen(kPrecomputedMemoryPlanMetadata);
+  for (size_t i = 0; i < model->metadata()->size(); ++i) {
+    auto metadata = model->metadata()->Get(i);
+    if (metadata->name() == nullptr ||
+        metadata->name()->size() != name_length ||
+        strncmp(metadata->name()->c_str(), kPrecomputedMemoryPlanMetadata,
+                name_length) != 0) {
+      continue;
+    }
+    if (metadata->buffer() >= model->buffers()->size()) {
+      return nullptr;
+    }
+    auto* array = model->buffers()->Get(metadata->buffer())->data();
+    if (array == nullptr || array->size() < 3 * sizeof(int32_t) ||
+        (reinterpret_cast<uintptr_t>(array->data()) % alignof(int32_t)) != 0) {
+      return nullptr;
+    }
+
+    const PrecomputedMemoryPlan* plan =
+        reinterpret_cast<const PrecomputedMemoryPlan*>(array->data());
+    // Bound the count by what the buffer can hold before multiplying, so the
+    // size check can't wrap on 32-bit targets.
+    const size_t max_entries = (array->size() - 3 * sizeof(int32_t)) /
+                               sizeof(PrecomputedBufferEntry);
+    if (plan->version != kPrecomputedMemoryPlanVersion ||
+        plan->buffer_count < 0 || plan->arena_size < 0 ||
+        (size_t)plan->buffer_count > max_entries) {
+      MicroPrintf("Ignoring unsupported %s metadata",
+                  kPrecomputedMemoryPlanMetadata);
+      return nullptr;
+    }
+    return plan;
+  }
+  return nullptr;
+}
+
+PrecomputedMemoryPlanner::PrecomputedMemoryPlanner(
+    const PrecomputedMemoryPlan* plan)
+    : plan_(plan), buffer_count_(0), plan_matches_(true) {}
+
+PrecomputedMemoryPlanner::~PrecomputedMemoryPlanner() {}
+
+TfLiteStatus PrecomputedMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                            int scratch_buffer_size) {
+  buffer_count_ = 0;
+  // Validated before the greedy planner takes over the scratch, it only needs
+  // it once buffers are added.
+  plan_matches_ = IsValidPlan(plan_, scratch_buffer, scratch_buffer_size);
+  return fallback_.Init(scratch_buffer, scratch_buffer_size);
+}
+
+void PrecomputedMemoryPlanner::CheckBuffer(int size, int first_time_used,
+                                           int last_time_used,
+                                           int offline_offset) {
+  if (!plan_matches_ || buffer_count_ >= plan_->buffer_count) {
+    plan_matches_ = false;
+    return;
+  }
+  // A buffer that is smaller and lives shorter than planned can't overlap
+  // anything the planned one didn't.
+  const PrecomputedBufferEntry& entry = plan_->entries[buffer_count_];
+  if (size > entry.size || first_time_used < entry.first_time_used ||
+      last_time_used > entry.last_time_used ||
+      (offline_offset != kOnlinePlannedBuffer &&
+       offline_offset != entry.offset)) {
+    plan_matches_ = false;
+  }
+}
+
+TfLiteStatus PrecomputedMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                                 int last_time_used) {
+  CheckBuffer(size, first_time_used, last_time_used, kOnlinePlannedBuffer);
+  buffer_count_++;
+  return fallback_.AddBuffer(size, first_time_used, last_time_used);
+}
+
+TfLiteStatus PrecomputedMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                                 int last_time_used,
+                                                 int offline_offset) {
+  CheckBuffer(size, first_time_used, last_time_used, offline_offset);
+  buffer_count_++;
+  return fallback_.AddBuffer(size, first_time_used, last_time_used,
+                             offline_offset);
+}
+
+bool PrecomputedMemoryPlanner::UsingPrecomputedPlan() const {
+  return plan_matches_ && buffer_count_ == plan_->buffer_count;
+}
+
+size_t PrecomputedMemoryPlanner::GetMaximumMemorySize() {
+  if (UsingPrecomputedPlan()) {
+    return plan_->arena_size;
+  }
+  return fallback_.GetMaximumMemorySize();
+}
+
+int PrecomputedMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus PrecomputedMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                          int* offset) {
+  if (!UsingPrecomputedPlan()) {
+    return fallback_.GetOffsetForBuffer(buffer_index, offset);
+  }
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = plan_->entries[buffer_index].offset;
+  return kTfLiteOk;
+}
+
+void PrecomputedMemoryPlanner::PrintMemoryPlan() {
+  if (!UsingPrecomputedPlan()) {
+    MicroPrintf("Precomputed memory plan does not match the model, using the "
+                "greedy plan");
+    fallback_.PrintMemoryPlan();
+    return;
+  }
+  MicroPrintf("Precomputed memory plan, %d buffers, %d bytes",
+              plan_->buffer_count, plan_->arena_size);
+  for (int i = 0; i < plan_->buffer_count; ++i) {
+    const PrecomputedBufferEntry& entry = plan_->entries[i];
+    (void)entry;  // unused when MicroPrintf is stripped
+    MicroPrintf("(id=%d): size=%d, offset=%d, first_used=%d last_used=%d", i,
+                entry.size, entry.offset, entry.first_time_used,
+                entry.last_time_used);
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,124 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_PRECOMPUTED_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_PRECOMPUTED_MEMORY_PLANNER_H_
+
+#include <stdint.h>
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/compatibility.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
+
+namespace tflite {
+
+// Name of the model metadata entry that holds a precomputed arena plan.
+constexpr char kPrecomputedMemoryPlanMetadata[] = "EIMemoryPlan";
+constexpr int32_t kPrecomputedMemoryPlanVersion = 1;
+
+// Layout of the metadata buffer, all fields int32 little endian:
+//   version, buffer_count, arena_size,
+//   buffer_count x { offset, size, first_time_used, last_time_used }
+// The buffers are in the order the allocator adds them to the planner
+// (tensors first, then scratch buffers in op request order), and sizes are
+// already aligned. See tools/memory_plan in the firmware project for the host
+// tool that computes the plan and writes it into a .tflite file.
+struct PrecomputedBufferEntry {
+  int32_t offset;
+  int32_t size;
+  int32_t first_time_used;
+  int32_t last_time_used;
+};
+
+struct PrecomputedMemoryPlan {
+  int32_t version;
+  int32_t buffer_count;
+  int32_t arena_size;
+  PrecomputedBufferEntry entries[1];  // buffer_count entries, see BufferPlan
+};
+
+// Returns the plan stored in the model's metadata, or nullptr if there is
+// none or it is malformed.
+const PrecomputedMemoryPlan* GetPrecomputedMemoryPlan(const Model* model);
+
+// A memory planner that adopts a plan computed offline, so setting up the
+// interpreter does not run the O(n^2) greedy placement.
+//
+// Init() validates the whole plan once in O(n log n): every entry must lie
+// inside the arena without overlapping any entry that is live at the same
+// time. Each buffer the allocator adds is then checked against its entry in
+// O(1): it must fit in the planned size and lifetime (and match the offline
+// offset, if any). Host and target kernels may request
+// different scratch sizes; if any buffer does not fit, the plan is invalid,
+// or the count differs, the planner falls back to a GreedyMemoryPlanner that
+// has been fed the same buffers.
+class PrecomputedMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Does not take ownership of plan, which must outlive this object.
+  explicit PrecomputedMemoryPlanner(const PrecomputedMemoryPlan* plan);
+  ~PrecomputedMemoryPlanner() override;
+
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  size_t GetMaximumMemorySize() override;
+  int GetBufferCount() override;
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  void PrintMemoryPlan() override;
+
+  // Whether the last set of buffers matched the plan.
+  bool UsingPrecomputedPlan() const;
+
+ private:
+  void CheckBuffer(int size, int first_time_used, int last_time_used,
+                   int offline_offset);
+
+  const PrecomputedMemoryPlan* plan_;  // not owned, can't be null
+  GreedyMemoryPlanner fallback_;
+  int buffer_count_;
+  bool plan_matches_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_PRECOMPUTED_MEMORY_PLANNER_H_
@@ -329,6 +329,19 @@ TfLiteTensor* MicroInterpreter::tensor(size_t index, size_t subgraph_idx) {
   return allocator_.AllocatePersistentTfLiteTensor(model_, graph_.GetAllocations(), index, subgraph_idx);
 }
 
+TfLiteEvalTensor* MicroInterpreter::variable_tensor(size_t index,
+                                                    size_t subgraph_idx) {
+  if (!tensors_allocated_ || subgraph_idx >= model_->subgraphs()->size() ||
+      index >= tensors_size(subgraph_idx)) {
+    return nullptr;
+  }
+  const auto* tensors = model_->subgraphs()->Get(subgraph_idx)->tensors();
+  if (!tensors->Get(index)->is_variable()) {
+    return nullptr;
+  }
+  return &graph_.GetAllocations()[subgraph_idx].tensors[index];
+}
+
 // Repurposing free subgraphs to reset state for some ops for now
 // will reset api is made. See b/220940833#comment25 for more context.
 TfLiteStatus MicroInterpreter::Reset() {
@@ -84,6 +84,13 @@ class MicroInterpreter {
 
   TfLiteTensor* tensor(size_t tensor_index, size_t subgraph_idx = 0);
 
+  // Returns the eval tensor backing a variable (is_variable) tensor, e.g. the
+  // hidden/cell state of a recurrent op, or nullptr for any other tensor.
+  // Unlike tensor() this doesn't allocate from the arena, so it can be called
+  // on every invoke. Only valid after `AllocateTensors` has been called.
+  TfLiteEvalTensor* variable_tensor(size_t tensor_index,
+                                    size_t subgraph_idx = 0);
+
   template <class T>
   T* typed_tensor(int tensor_index) {
     if (TfLiteTensor* tensor_ptr = tensor(tensor_index)) {
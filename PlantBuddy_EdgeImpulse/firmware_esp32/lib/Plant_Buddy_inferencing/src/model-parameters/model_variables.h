@@ -45,6 +45,7 @@
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/engines.h"
 #include "edge-impulse-sdk/classifier/postprocessing/ei_postprocessing_common.h"
+#include "edge-impulse-sdk/classifier/ei_static_impulse.h"
 
 const char* ei_classifier_inferencing_categories_841442_1[] = { "fine", "needs_water" };
 
@@ -86,6 +87,12 @@ const ei_config_tflite_eon_graph_t ei_config_graph_841442_6 = {
     .model_reset = &tflite_learn_841442_6_reset,
     .model_input = &tflite_learn_841442_6_input,
     .model_output = &tflite_learn_841442_6_output,
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    .model_set_profiler = &tflite_learn_841442_6_set_profiler,
+#else
+    .model_set_profiler = nullptr,
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+    .model_arena_usage = &tflite_learn_841442_6_arena_usage,
 };
 
 const uint8_t ei_output_tensors_indices_841442_6[1] = { 0 };
@@ -184,7 +191,42 @@ const ei_impulse_t impulse_841442_1 = {
 
 ei_impulse_handle_t impulse_handle_841442_1 = ei_impulse_handle_t( &impulse_841442_1 );
 
+#if EI_CLASSIFIER_HAS_STATIC_IMPULSE
+struct ei_static_dsp_config_841442_10 {
+    static constexpr uint32_t axes = 3;
+    static constexpr float scale_axes = 1.0f;
+    static constexpr bool average = true;
+    static constexpr bool minimum = true;
+    static constexpr bool maximum = true;
+    static constexpr bool rms = true;
+    static constexpr bool stdev = true;
+    static constexpr bool skewness = true;
+    static constexpr bool kurtosis = true;
+    static constexpr int moving_avg_num_windows = 0;
+};
+
+struct ei_static_postprocessing_config_841442_6 {
+    static constexpr size_t label_count = 2;
+};
+
+typedef ei_static_impulse<
+    1, // raw sample count
+    3, // raw samples per frame
+    ei_static_flatten_block<ei_static_dsp_config_841442_10, &ei_dsp_config_841442_10, 1, 3, 0, 1, 2>,
+    ei_static_eon_block<
+        &tflite_learn_841442_6_init,
+        &tflite_learn_841442_6_invoke,
+        &tflite_learn_841442_6_reset,
+        &tflite_learn_841442_6_input,
+        &tflite_learn_841442_6_output>,
+    ei_static_classification_i8<ei_static_postprocessing_config_841442_6, ei_classifier_inferencing_categories_841442_1>
+> ei_static_impulse_841442_1;
+#endif // EI_CLASSIFIER_HAS_STATIC_IMPULSE
+
 ei_impulse_handle_t& ei_default_impulse = impulse_handle_841442_1;
+#if EI_CLASSIFIER_HAS_STATIC_IMPULSE
+typedef ei_static_impulse_841442_1 ei_default_static_impulse;
+#endif // EI_CLASSIFIER_HAS_STATIC_IMPULSE
 constexpr auto& ei_classifier_inferencing_categories = ei_classifier_inferencing_categories_841442_1;
 const auto ei_dsp_blocks_size = ei_dsp_blocks_841442_1_size;
 ei_model_dsp_t *ei_dsp_blocks = ei_dsp_blocks_841442_1;
@@ -36,6 +36,10 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/porting/ei_memory_tiers.h"
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -87,6 +91,16 @@ extern void ei_printf(const char *format, ...);
 #define EI_MAX_OVERFLOW_BUFFER_COUNT 10
 #endif // EI_MAX_OVERFLOW_BUFFER_COUNT
 
+// All fully connected layers in this graph are small enough for the shape-specialized
+// tiny_fc kernels. Define as 0 to run them through the generic FULLY_CONNECTED kernel.
+#ifndef EI_TFLITE_TINY_FULLY_CONNECTED
+#define EI_TFLITE_TINY_FULLY_CONNECTED 1
+#endif // EI_TFLITE_TINY_FULLY_CONNECTED
+
+#if EI_TFLITE_TINY_FULLY_CONNECTED
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/tiny_fully_connected.h"
+#endif // EI_TFLITE_TINY_FULLY_CONNECTED
+
 using namespace tflite;
 using namespace tflite::ops;
 using namespace tflite::ops::micro;
@@ -283,6 +297,16 @@ const TfArray<1, int> outputs3 = { 1, { 12 } };
 const TfLiteSoftmaxParams opdata4 = { 1 };
 const TfArray<1, int> inputs4 = { 1, { 12 } };
 const TfArray<1, int> outputs4 = { 1, { 13 } };
+#if EI_TFLITE_TINY_FULLY_CONNECTED
+const int32_t tiny_fc_bias0[32] = { 512, -9856, -9472, 39815, -11640, -10618, -34560, 9593, -16128, -9216, -20480, 1664, -1534, -11145, 4352, 3456, 9465, -9344, -4480, 34437, -18560, -4864, -5504, -15489, 16512, -8321, -15616, -8832, -9, 6008, 7808, -7417, };
+const tiny_fc::LayerParams tiny_fc_params0 = { 1381429789, -5, -128, -128, 127 };
+const int32_t tiny_fc_bias1[16] = { 17659, 12800, 14325, -81674, -7852, -33030, -48000, 86010, -2945, -781, -58373, -37744, -15455, -63104, 13952, -35845, };
+const tiny_fc::LayerParams tiny_fc_params1 = { 1376407230, -5, -128, -128, 127 };
+const int32_t tiny_fc_bias2[8] = { -22734, 1889, 10940, -2564, 24565, -19349, -10776, -23944, };
+const tiny_fc::LayerParams tiny_fc_params2 = { 1618685367, -6, -128, -128, 127 };
+const int32_t tiny_fc_bias3[2] = { -48625, -54287, };
+const tiny_fc::LayerParams tiny_fc_params3 = { 1470416569, -7, 127, -128, 127 };
+#endif // EI_TFLITE_TINY_FULLY_CONNECTED
 };
 
 TensorInfo_t tensorData[] = {
@@ -323,6 +347,11 @@ TfLiteNode tflNodes[5] = {
 used_operators_e used_ops[] =
 {OP_FULLY_CONNECTED, OP_FULLY_CONNECTED, OP_FULLY_CONNECTED, OP_FULLY_CONNECTED, OP_SOFTMAX, };
 
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+const char* used_op_names[OP_LAST] = { "FULLY_CONNECTED", "SOFTMAX", };
+tflite::MicroProfilerInterface* profiler = nullptr;
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
 
 // Indices into tflTensors and tflNodes for subgraphs
 const size_t tflTensors_subgraph_index[] = {0, 14, };
@@ -394,8 +423,29 @@ static void init_tflite_eval_tensor(int i, TfLiteEvalTensor *tensor) {
 #endif // EI_CLASSIFIER_ALLOCATION_HEAP
 }
 
+#if EI_TFLITE_TINY_FULLY_CONNECTED
+static int8_t* tiny_fc_tensor(size_t i) {
+#if defined(EI_CLASSIFIER_ALLOCATION_HEAP)
+  return (int8_t*)((uintptr_t)tensorData[i].data + (uintptr_t)tensor_arena);
+#else
+  return (int8_t*)tensorData[i].data;
+#endif // EI_CLASSIFIER_ALLOCATION_HEAP
+}
+
+static TfLiteStatus invoke_tiny_fully_connected(size_t node) {
+  switch (node) {
+    case 0: tiny_fc::FullyConnectedS8<21, 32>(tiny_fc_tensor(0), g0::tensor_data8, g0::tiny_fc_bias0, g0::tiny_fc_params0, tiny_fc_tensor(9)); return kTfLiteOk;
+    case 1: tiny_fc::FullyConnectedS8<32, 16>(tiny_fc_tensor(9), g0::tensor_data6, g0::tiny_fc_bias1, g0::tiny_fc_params1, tiny_fc_tensor(10)); return kTfLiteOk;
+    case 2: tiny_fc::FullyConnectedS8<16, 8>(tiny_fc_tensor(10), g0::tensor_data4, g0::tiny_fc_bias2, g0::tiny_fc_params2, tiny_fc_tensor(11)); return kTfLiteOk;
+    case 3: tiny_fc::FullyConnectedS8<8, 2>(tiny_fc_tensor(11), g0::tensor_data2, g0::tiny_fc_bias3, g0::tiny_fc_params3, tiny_fc_tensor(12)); return kTfLiteOk;
+    default: return kTfLiteError;
+  }
+}
+#endif // EI_TFLITE_TINY_FULLY_CONNECTED
+
 static void* overflow_buffers[EI_MAX_OVERFLOW_BUFFER_COUNT];
 static size_t overflow_buffers_ix = 0;
+static size_t overflow_buffers_bytes = 0;
 static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
                                        size_t bytes) {
   void *ptr;
@@ -410,12 +460,13 @@ static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
 
     // OK, this will look super weird, but.... we have CMSIS-NN buffers which
     // we cannot calculate beforehand easily.
-    ptr = ei_calloc(bytes, 1);
+    ptr = ei_calloc_hot(bytes, 1);
     if (ptr == NULL) {
       ei_printf("ERR: Failed to allocate persistent buffer of size %d\n", (int)bytes);
       return NULL;
     }
     overflow_buffers[overflow_buffers_ix++] = ptr;
+    overflow_buffers_bytes += bytes;
     return ptr;
   }
 
@@ -654,7 +705,23 @@ TfLiteStatus tflite_learn_841442_6_invoke() {
   for (size_t i = 0; i < 5; ++i) {
     ResetTensors();
 
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    uint32_t profiler_event = profiler ? profiler->BeginEvent(used_op_names[used_ops[i]]) : 0;
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
+#if EI_TFLITE_TINY_FULLY_CONNECTED
+    TfLiteStatus status = (used_ops[i] == OP_FULLY_CONNECTED)
+      ? invoke_tiny_fully_connected(i)
+      : registrations[used_ops[i]].invoke(&ctx, &tflNodes[i]);
+#else
     TfLiteStatus status = registrations[used_ops[i]].invoke(&ctx, &tflNodes[i]);
+#endif // EI_TFLITE_TINY_FULLY_CONNECTED
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+    if (profiler) {
+      profiler->EndEvent(profiler_event);
+    }
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -722,6 +789,22 @@ TfLiteStatus tflite_learn_841442_6_invoke() {
   return kTfLiteOk;
 }
 
+TfLiteStatus tflite_learn_841442_6_arena_usage(size_t *arena_bytes, size_t *planned_bytes,
+                                               size_t *persistent_bytes, size_t *overflow_bytes) {
+  *arena_bytes = kTensorArenaSize;
+  *planned_bytes = tensor_boundary - tensor_arena;
+  *persistent_bytes = (tensor_arena + kTensorArenaSize) - current_location;
+  *overflow_bytes = overflow_buffers_bytes;
+  return kTfLiteOk;
+}
+
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+TfLiteStatus tflite_learn_841442_6_set_profiler(tflite::MicroProfilerInterface* new_profiler) {
+  profiler = new_profiler;
+  return kTfLiteOk;
+}
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
+
 TfLiteStatus tflite_learn_841442_6_reset( void (*free_fnc)(void* ptr) ) {
 #ifdef EI_CLASSIFIER_ALLOCATION_HEAP
   free_fnc(tensor_arena);
@@ -735,5 +818,6 @@ TfLiteStatus tflite_learn_841442_6_reset( void (*free_fnc)(void* ptr) ) {
     ei_free(overflow_buffers[ix]);
   }
   overflow_buffers_ix = 0;
+  overflow_buffers_bytes = 0;
   return kTfLiteOk;
 }
@@ -45,6 +45,15 @@ TfLiteStatus tflite_learn_841442_6_output(int index, TfLiteTensor* tensor);
 TfLiteStatus tflite_learn_841442_6_invoke();
 //Frees memory allocated
 TfLiteStatus tflite_learn_841442_6_reset( void (*free)(void* ptr) );
+// Reports how the tensor arena is used: planned activations at the head, persistent
+// and scratch buffers at the tail, and persistent buffers that overflowed to the heap.
+TfLiteStatus tflite_learn_841442_6_arena_usage(size_t *arena_bytes, size_t *planned_bytes,
+                                               size_t *persistent_bytes, size_t *overflow_bytes);
+#if EI_CLASSIFIER_PROFILE_OPS == 1
+namespace tflite { class MicroProfilerInterface; }
+// Reports every node to the profiler during invoke (nullptr to disable).
+TfLiteStatus tflite_learn_841442_6_set_profiler(tflite::MicroProfilerInterface* profiler);
+#endif // EI_CLASSIFIER_PROFILE_OPS == 1
 
 
 // Returns the number of input tensors.
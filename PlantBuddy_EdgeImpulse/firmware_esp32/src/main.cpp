@@ -50,6 +50,8 @@ static const bool RELAY_ACTIVE_LOW = true;
 static const int SOIL_SAFETY_WET = 1600;     // Below this, never water (soil clearly moist)
 static const int SOIL_DRY_THRESHOLD = 2100;  // at or above this = clearly dry (adjust after testing)
 static const float AI_CONF_THRESHOLD = 0.6f; // How sure AI must be to trigger watering
+static const float AI_CONF_EXIT_THRESHOLD = 0.45f; // AI must drop below this before it stops asking for water
+static const float AI_SMOOTHING_ALPHA = 0.4f;      // EWMA weight of the newest prediction (1 = no smoothing)
 
 // -------- State --------
 unsigned long lastReadMs = 0;
@@ -59,6 +61,10 @@ bool pumpState = false;
 String last_ai_label = "unknown";
 float last_ai_conf = 0.0f;
 
+// Smoothed AI decision, so a confidence hovering around AI_CONF_THRESHOLD doesn't flap
+ei_classifier_hysteresis_t ai_hysteresis;
+bool ai_needs_water = false;
+
 // ====== SANITIZATION FUNCTIONS (Fix NaN Issues) ======
 int safeAnalogRead(int pin)
 {
@@ -188,8 +194,7 @@ ConditionState computeCondition(const Readings &r)
 
   bool soilClearlyWet = (r.soilRaw <= SOIL_SAFETY_WET);
   bool soilMaybeDry = (r.soilRaw >= SOIL_DRY_THRESHOLD); // stricter dry
-  bool aiSaysDry = (last_ai_label == "needs_water" &&
-                    last_ai_conf >= AI_CONF_THRESHOLD);
+  bool aiSaysDry = ai_needs_water;
 
   // Default: happy
   cs.label = "fine";
@@ -397,6 +402,16 @@ void run_edge_impulse_classifier(float soil,
   last_ai_label = String(result.classification[best_i].label);
   last_ai_conf = best_val;
 
+  // Watering decision uses the smoothed confidence with separate enter/exit thresholds
+  ei_classifier_hysteresis_update(&ai_hysteresis, &result);
+  for (size_t i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++)
+  {
+    if (strcmp(result.classification[i].label, "needs_water") == 0)
+    {
+      ai_needs_water = ei_classifier_hysteresis_is_active(&ai_hysteresis, i);
+    }
+  }
+
 #ifndef CLEAN_SERIAL
   Serial.print("Predicted: ");
   Serial.print(last_ai_label);
@@ -463,6 +478,11 @@ void setup()
   Serial.begin(115200);
   delay(100);
 
+#if EI_DEFERRED_LOG_ENABLED
+  // SDK log output is formatted on this low priority task, not on the inference path
+  ei_deferred_log_start_task(100, 1);
+#endif
+
   Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
 
   bool lightOK = lightMeter.begin(BH1750::CONTINUOUS_HIGH_RES_MODE);
@@ -474,6 +494,9 @@ void setup()
   if (bmeOK)
     ledsOK();
 
+  ei_classifier_hysteresis_init(&ai_hysteresis, AI_SMOOTHING_ALPHA,
+                                AI_CONF_THRESHOLD, AI_CONF_EXIT_THRESHOLD);
+
   connectToWiFi();
   lastReadMs = millis();
 }
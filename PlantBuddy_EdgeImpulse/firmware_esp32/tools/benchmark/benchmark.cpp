@@ -0,0 +1,999 @@
+/******************************************************
+ * Plant Buddy – host benchmark suite
+ *
+ * Builds the inferencing library natively and times every DSP block the SDK
+ * ships (flatten, spectral analysis v1-v4, wavelet, MFCC, MFE, spectrogram),
+ * the audio blocks again per slice of a continuous window (2, 4 or 8 slices),
+ * numpy::rfft, the numpy reductions and elementwise ops over 3 to 16k values,
+ * the SignalWithAxes axis gather, allocating and sweeping memory
+ * through each placement hint (ei_malloc_hot / ei_malloc_bulk / ei_malloc),
+ * the int8 dense layers of our model (per layer, per kernel), a camera frame
+ * taken to a quantized 96x96 input through separate convert / resize / extract
+ * steps against the fused single pass, the
+ * TreeEnsembleClassifier kernel walking the model's node arrays against its
+ * packed layout (depth 4-10, 10-500 trees, see tree_ensemble_bench.cpp),
+ * non-max suppression per class against the bucketed version over 100 to 30k
+ * boxes, plus a check that both keep the same boxes (see nms_bench.cpp), K-means
+ * anomaly scoring by linear scan against the pruned search over 8 to 256
+ * clusters (see kmeans_bench.cpp), the object tracker on 1 to 16 objects in
+ * view (see object_tracking_bench.cpp), and a full run_classifier() on our
+ * impulse.
+ * The DSP blocks run on synthetic signals and configurations, so they don't
+ * depend on the impulse that's exported into the library.
+ *
+ * Per benchmark it reports ns/op, heap allocations and bytes allocated per op,
+ * and the peak heap use above the level before the op. Heap use is counted
+ * through ei_malloc / ei_calloc / ei_free (overridden here, the porting layer
+ * only has weak versions) and through global operator new / delete.
+ *
+ * The host has no external RAM, so the cost of a bulk (PSRAM) placement is
+ * modeled: every byte an op allocates in the bulk tier is taken to be written
+ * and read once (that's what the tier is for), plus what the memory placement
+ * sweeps read from a bulk buffer, at --external-ns-per-byte (default 25 ns, a
+ * cached sequential read from ESP32 quad SPI PSRAM at 80 MHz, about 40 MB/s).
+ * It's reported next to the measured time as ext ns/op, not added to it.
+ *
+ * Usage:
+ *   benchmark [--filter SUBSTRING] [--min-time SECONDS] [--repetitions N]
+ *             [--out FILE] [--baseline FILE] [--max-regression PERCENT]
+ *             [--external-ns-per-byte NS]
+ *
+ * Results are written as JSON (to stdout, or to --out). With --baseline the
+ * run is compared against an earlier JSON file, and the tool exits with 1 if
+ * any benchmark got slower by more than --max-regression percent (default 10)
+ * or allocates more bytes per op than before, so it can gate commits in CI.
+ * Times are compared on the fastest repetition, heap use is deterministic.
+ *
+ * Build on the host (CMakeLists.txt next to this file compiles the SDK, the
+ * exported model and porting/clib natively, see tools/cmake/inferencing.cmake):
+ *   cmake -S tools/benchmark -B build/benchmark
+ *   cmake --build build/benchmark
+ *
+ * Typical CI use, keep the JSON of the target branch and gate on it:
+ *   build/benchmark/benchmark --out baseline.json
+ *   build/benchmark/benchmark --out current.json --baseline baseline.json
+ *
+ * The target defines EI_DSP_PARAMS_ALL=1, which compiles in the spectral
+ * analysis variants the exported impulse doesn't use. Don't build with
+ * EI_PORTING_POOL_ALLOCATOR=1, it provides its own ei_malloc. Add
+ * EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN=1 and the ESP-NN sources
+ * (porting/espressif/ESP-NN/src) to also time the dense layers through
+ * ESP-NN, which is its ANSI C kernel off target.
+ ******************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/dsp/ei_fft_plan.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/porting/ei_memory_tiers.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/tiny_fully_connected.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/include/esp_nn.h"
+#endif
+#include "kmeans_bench.h"
+#include "nms_bench.h"
+#include "object_tracking_bench.h"
+#include "tree_ensemble_bench.h"
+
+// -------- Heap accounting --------
+struct HeapStats {
+    uint64_t allocs;
+    uint64_t bytes;
+    size_t live;
+    size_t peak;
+};
+
+static HeapStats heap = { 0, 0, 0, 0 };
+
+// Every block carries its size in front, so frees can be accounted without a lookup
+static constexpr size_t heap_header = alignof(std::max_align_t);
+
+static void *counted_alloc(size_t size, bool zero)
+{
+    unsigned char *p = (unsigned char *)(zero ? calloc(1, size + heap_header) : malloc(size + heap_header));
+    if (!p) {
+        return nullptr;
+    }
+    *(size_t *)p = size;
+    heap.allocs++;
+    heap.bytes += size;
+    heap.live += size;
+    if (heap.live > heap.peak) {
+        heap.peak = heap.live;
+    }
+    return p + heap_header;
+}
+
+// out of line, so the compiler doesn't pair the header access with a specific operator new
+__attribute__((noinline)) static void counted_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    unsigned char *p = (unsigned char *)ptr - heap_header;
+    heap.live -= *(size_t *)p;
+    free(p);
+}
+
+void *ei_malloc(size_t size)
+{
+    return counted_alloc(size, false);
+}
+
+void *ei_calloc(size_t nitems, size_t size)
+{
+    return counted_alloc(nitems * size, true);
+}
+
+void ei_free(void *ptr)
+{
+    // same contract as the porting layer's ei_free, keeps the tier statistics right
+    ei_memory_tiers_release(ptr);
+    counted_free(ptr);
+}
+
+void *operator new(size_t size)
+{
+    void *p = counted_alloc(size, false);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    void *p = counted_alloc(size, false);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, false);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return counted_alloc(size, false);
+}
+
+void operator delete(void *ptr) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { counted_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr); }
+
+// -------- Runner --------
+struct Benchmark {
+    std::string name;
+    std::function<int()> op; // returns 0 on success
+    size_t external_bytes = 0; // read per op from a bulk buffer the op didn't allocate
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double real_ns;       // median over repetitions
+    double real_ns_min;
+    double cpu_ns;
+    double allocs_per_op;
+    double bytes_per_op;
+    size_t peak_heap;     // highest heap use above the level before the op
+    double external_bytes; // external RAM traffic per op (see the header)
+    double external_ns;   // modeled cost of that traffic
+};
+
+struct Options {
+    const char *filter = nullptr;
+    double min_time = 0.2;
+    int repetitions = 5;
+    const char *out = nullptr;
+    const char *baseline = nullptr;
+    double max_regression = 10.0;
+    double external_ns_per_byte = 25.0;
+};
+
+static bool run_benchmark(const Benchmark &b, const Options &opts, Result *res)
+{
+    using clock = std::chrono::steady_clock;
+
+    // start from an empty FFT plan cache, so sizes used by earlier benchmarks
+    // don't hold every slot and leave this one uncached
+    ei::fft::clear_fft_plans();
+
+    // one warm-up op, which also fills lazily built caches (FFT plans, tables)
+    if (b.op() != 0) {
+        fprintf(stderr, "%s: failed\n", b.name.c_str());
+        return false;
+    }
+
+    // grow the batch until one batch takes min_time / repetitions
+    double target_ns = opts.min_time * 1e9 / opts.repetitions;
+    uint64_t iterations = 1;
+    while (true) {
+        auto t0 = clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            b.op();
+        }
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+        if (ns >= target_ns || iterations >= (1ull << 30)) {
+            break;
+        }
+        uint64_t next = ns > 0 ? (uint64_t)(iterations * 1.4 * target_ns / ns) : iterations * 10;
+        iterations = std::max(iterations + 1, std::min(next, iterations * 10));
+    }
+
+    std::vector<double> real;
+    real.reserve(opts.repetitions); // no allocations of our own while counting
+    double cpu_ns = 0;
+    HeapStats before = heap;
+    size_t peak_heap = 0;
+    ei_memory_tiers_reset_stats();
+
+    for (int r = 0; r < opts.repetitions; r++) {
+        size_t base_live = heap.live;
+        heap.peak = heap.live;
+        std::clock_t c0 = std::clock();
+        auto t0 = clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            b.op();
+        }
+        auto t1 = clock::now();
+        std::clock_t c1 = std::clock();
+        peak_heap = std::max(peak_heap, heap.peak - base_live);
+        real.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations);
+        cpu_ns += (double)(c1 - c0) * 1e9 / CLOCKS_PER_SEC / iterations;
+    }
+
+    uint64_t ops = iterations * opts.repetitions;
+    std::sort(real.begin(), real.end());
+
+    res->name = b.name;
+    res->iterations = iterations;
+    res->real_ns = real[real.size() / 2];
+    res->real_ns_min = real[0];
+    res->cpu_ns = cpu_ns / opts.repetitions;
+    res->allocs_per_op = (double)(heap.allocs - before.allocs) / ops;
+    res->bytes_per_op = (double)(heap.bytes - before.bytes) / ops;
+    res->peak_heap = peak_heap;
+
+    ei_memory_tier_stats_t tiers;
+    ei_memory_tiers_get_stats(&tiers);
+    res->external_bytes = b.external_bytes + 2.0 * tiers.alloc_bytes[EI_MEMORY_TIER_BULK] / ops;
+    res->external_ns = res->external_bytes * opts.external_ns_per_byte;
+    return true;
+}
+
+// One benchmark per line, so --baseline can read the file back without a JSON parser
+static void write_json(FILE *f, const std::vector<Result> &results, const Options &opts)
+{
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"context\": { \"date\": \"%s\", \"min_time\": %g, \"repetitions\": %d, \"external_ns_per_byte\": %g },\n",
+        date, opts.min_time, opts.repetitions, opts.external_ns_per_byte);
+    fprintf(f, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(f, "    { \"name\": \"%s\", \"iterations\": %llu, \"real_time\": %.1f, \"real_time_min\": %.1f, "
+            "\"cpu_time\": %.1f, \"time_unit\": \"ns\", \"allocs_per_iter\": %.2f, \"bytes_per_iter\": %.1f, "
+            "\"peak_heap_bytes\": %zu, \"external_bytes_per_iter\": %.1f, \"external_time\": %.1f }%s\n",
+            r.name.c_str(), (unsigned long long)r.iterations, r.real_ns, r.real_ns_min, r.cpu_ns,
+            r.allocs_per_op, r.bytes_per_op, r.peak_heap, r.external_bytes, r.external_ns,
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static bool read_field(const char *line, const char *key, double *value)
+{
+    const char *p = strstr(line, key);
+    if (!p) {
+        return false;
+    }
+    p = strchr(p + strlen(key), ':');
+    return p && sscanf(p + 1, "%lf", value) == 1;
+}
+
+// Returns the number of regressions, or -1 if the baseline can't be read
+static int compare_baseline(const std::vector<Result> &results, const Options &opts)
+{
+    FILE *f = fopen(opts.baseline, "r");
+    if (!f) {
+        fprintf(stderr, "Failed to open baseline %s\n", opts.baseline);
+        return -1;
+    }
+
+    int regressions = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        const char *n = strstr(line, "\"name\": \"");
+        if (!n) {
+            continue;
+        }
+        n += strlen("\"name\": \"");
+        const char *end = strchr(n, '"');
+        if (!end) {
+            continue;
+        }
+        std::string name(n, end - n);
+
+        double base_ns, base_bytes;
+        // the fastest repetition is the least disturbed by other load on the machine
+        if (!read_field(line, "\"real_time_min\"", &base_ns) || !read_field(line, "\"bytes_per_iter\"", &base_bytes)) {
+            continue;
+        }
+
+        for (const Result &r : results) {
+            if (r.name != name) {
+                continue;
+            }
+            double change = base_ns > 0 ? (r.real_ns_min - base_ns) * 100.0 / base_ns : 0;
+            bool slower = change > opts.max_regression;
+            bool more_heap = r.bytes_per_op > base_bytes + 0.5;
+            fprintf(stderr, "%-44s %12.1f -> %12.1f ns (%+6.1f%%) %10.1f -> %10.1f B/op%s\n",
+                name.c_str(), base_ns, r.real_ns_min, change, base_bytes, r.bytes_per_op,
+                slower || more_heap ? "  REGRESSION" : "");
+            if (slower || more_heap) {
+                regressions++;
+            }
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+// -------- Signals --------
+static std::vector<float> make_motion(size_t samples, size_t axes, float frequency)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 0.2f);
+    std::vector<float> v(samples * axes);
+    for (size_t i = 0; i < samples; i++) {
+        float t = i / frequency;
+        for (size_t a = 0; a < axes; a++) {
+            v[i * axes + a] = (a + 1) * sinf(2 * (float)M_PI * (1.5f + a) * t) + 0.5f * sinf(2 * (float)M_PI * 7.0f * t) + noise(rng);
+        }
+    }
+    return v;
+}
+
+static std::vector<float> make_audio(size_t samples, float frequency)
+{
+    std::mt19937 rng(2);
+    std::normal_distribution<float> noise(0.0f, 300.0f);
+    std::vector<float> v(samples);
+    for (size_t i = 0; i < samples; i++) {
+        float t = i / frequency;
+        v[i] = 8000.0f * sinf(2 * (float)M_PI * 440.0f * t) + 3000.0f * sinf(2 * (float)M_PI * 1800.0f * t) + noise(rng);
+    }
+    return v;
+}
+
+// One int8 dense layer of In x Out, through the shape-specialized tiny_fc kernel the
+// EON model uses, the generic reference kernel, and ESP-NN if it's compiled in. Random
+// weights and typical quantization parameters, the timing doesn't depend on the values.
+template<int In, int Out>
+static void add_dense_benchmarks(std::vector<Benchmark> &benchmarks)
+{
+    struct Layer {
+        int8_t input[In];
+        int8_t filter[Out * In];
+        int32_t bias[Out];
+        int32_t folded_bias[Out];
+        int8_t output[Out];
+    };
+    Layer *layer = new Layer();
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> int8(-128, 127);
+    std::uniform_int_distribution<int> bias(-2000, 2000);
+    for (int i = 0; i < In; i++) {
+        layer->input[i] = (int8_t)int8(rng);
+    }
+    for (int i = 0; i < Out * In; i++) {
+        layer->filter[i] = (int8_t)int8(rng);
+    }
+
+    const int32_t input_offset = 128; // input zero point -128
+    for (int o = 0; o < Out; o++) {
+        int32_t filter_sum = 0;
+        for (int i = 0; i < In; i++) {
+            filter_sum += layer->filter[o * In + i];
+        }
+        layer->bias[o] = bias(rng);
+        layer->folded_bias[o] = layer->bias[o] + input_offset * filter_sum;
+    }
+
+    const tflite::tiny_fc::LayerParams params = { 1518500250, -8, -128, -128, 127 };
+    const std::string shape = std::to_string(In) + "x" + std::to_string(Out);
+
+    benchmarks.push_back({ "dense_s8/tiny_fc/" + shape, [=]() {
+        tflite::tiny_fc::FullyConnectedS8<In, Out>(layer->input, layer->filter, layer->folded_bias,
+            params, layer->output);
+        return 0;
+    } });
+
+    tflite::FullyConnectedParams op_params;
+    op_params.input_offset = input_offset;
+    op_params.weights_offset = 0;
+    op_params.output_offset = params.output_offset;
+    op_params.output_multiplier = params.output_multiplier;
+    op_params.output_shift = params.output_shift;
+    op_params.quantized_activation_min = params.output_activation_min;
+    op_params.quantized_activation_max = params.output_activation_max;
+    benchmarks.push_back({ "dense_s8/reference/" + shape, [=]() {
+        const int32_t input_dims[2] = { 1, In };
+        const int32_t filter_dims[2] = { Out, In };
+        const int32_t bias_dims[1] = { Out };
+        const int32_t output_dims[2] = { 1, Out };
+        tflite::reference_integer_ops::FullyConnected(op_params,
+            tflite::RuntimeShape(2, input_dims), layer->input,
+            tflite::RuntimeShape(2, filter_dims), layer->filter,
+            tflite::RuntimeShape(1, bias_dims), layer->bias,
+            tflite::RuntimeShape(2, output_dims), layer->output);
+        return 0;
+    } });
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN
+    benchmarks.push_back({ "dense_s8/esp_nn/" + shape, [=]() {
+        esp_nn_fully_connected_s8(layer->input, input_offset, In, layer->filter, 0, layer->bias,
+            layer->output, Out, params.output_offset, params.output_shift, params.output_multiplier,
+            params.output_activation_min, params.output_activation_max);
+        return 0;
+    } });
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN
+}
+
+// Runs a DSP block on a fixed signal into a preallocated output matrix
+static std::function<int()> dsp_op(extract_fn_t fn, std::vector<float> *data, void *config, float frequency, size_t out_size)
+{
+    matrix_t *out = new matrix_t(1, out_size);
+    return [=]() {
+        signal_t signal;
+        numpy::signal_from_buffer(data->data(), data->size(), &signal);
+        out->rows = 1;
+        out->cols = out_size;
+        return fn(&signal, out, config, frequency);
+    };
+}
+
+// Runs the per-slice version of an audio block on consecutive slices of a signal, one
+// slice per op, like run_classifier_continuous() does. The samples carried from one
+// slice to the next are kept per config pointer, in one of only
+// EI_DSP_CONTINUOUS_MAX_WINDOWED_BLOCKS slots, so each case needs a config of its own
+// and its first op clears what the cases before it left behind.
+typedef int (*extract_slice_fn_t)(signal_t *signal, matrix_t *output_matrix, void *config, float frequency,
+    matrix_size_t *matrix_size_out);
+
+static std::function<int()> dsp_slice_op(extract_slice_fn_t fn, std::vector<float> *data, void *config,
+    float frequency, size_t slices, size_t out_size)
+{
+    matrix_t *out = new matrix_t(1, out_size);
+    const size_t slice_size = data->size() / slices;
+    return [=, next_slice = (size_t)0, started = false]() mutable {
+        if (!started) {
+            ei_dsp_clear_continuous_audio_state();
+            started = true;
+        }
+        signal_t signal;
+        numpy::signal_from_buffer(data->data() + next_slice * slice_size, slice_size, &signal);
+        next_slice = (next_slice + 1) % slices;
+        out->rows = 1;
+        out->cols = out_size;
+        matrix_size_t written;
+        return fn(&signal, out, config, frequency, &written);
+    };
+}
+
+// A raw camera frame, and the buffers an application needs to take it to the model's
+// int8 input: a full-size RGB888 copy of the frame (the resize works in place in it)
+// for the chain of separate steps, and an input tensor per path
+struct CameraFrame {
+    int width;
+    int height;
+    ei::image::processing::PIXEL_FORMAT format;
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> rgb;
+    std::vector<int8_t> chained;
+    std::vector<int8_t> fused;
+};
+
+static constexpr int camera_model_size = 96;
+static constexpr float camera_scale = 0.003921568859368563f;
+static constexpr float camera_zero_point = -128.0f;
+static ei_dsp_config_image_t camera_config = { 1, 1, 1, nullptr, 0, "RGB" };
+
+static CameraFrame *make_camera_frame(int width, int height, ei::image::processing::PIXEL_FORMAT format)
+{
+    std::mt19937 rng(width + format);
+    CameraFrame *frame = new CameraFrame();
+    frame->width = width;
+    frame->height = height;
+    frame->format = format;
+    frame->raw.resize((size_t)width * height * (format == ei::image::processing::PIXEL_FORMAT_RGB888 ? 3 : 2));
+    for (uint8_t &b : frame->raw) {
+        b = (uint8_t)rng();
+    }
+    frame->rgb.resize((size_t)width * height * 3);
+    frame->chained.resize(camera_model_size * camera_model_size * 3);
+    frame->fused.resize(camera_model_size * camera_model_size * 3);
+    return frame;
+}
+
+// Convert the whole frame to RGB888, resize_image_using_mode() to the model input,
+// then extract_image_features_quantized() over the pixels packed into floats
+static int camera_chained(CameraFrame *frame)
+{
+    const size_t pixels = (size_t)frame->width * frame->height;
+    uint8_t *rgb = frame->rgb.data();
+    if (frame->format == ei::image::processing::PIXEL_FORMAT_YUV422) {
+        int ret = ei::image::processing::yuv422_to_rgb888(rgb, frame->raw.data(), frame->raw.size(),
+            ei::image::processing::BIG_ENDIAN_ORDER);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    else if (frame->format == ei::image::processing::PIXEL_FORMAT_RGB565) {
+        const uint8_t *p = frame->raw.data();
+        for (size_t ix = 0; ix < pixels; ix++, p += 2) {
+            uint32_t v = ((uint32_t)p[0] << 8) | p[1];
+            uint32_t r = v >> 11, g = (v >> 5) & 0x3f, b = v & 0x1f;
+            rgb[ix * 3 + 0] = (uint8_t)((r << 3) | (r >> 2));
+            rgb[ix * 3 + 1] = (uint8_t)((g << 2) | (g >> 4));
+            rgb[ix * 3 + 2] = (uint8_t)((b << 3) | (b >> 2));
+        }
+    }
+    else {
+        memcpy(rgb, frame->raw.data(), pixels * 3);
+    }
+
+    int ret = ei::image::processing::resize_image_using_mode(rgb, frame->width, frame->height, rgb,
+        camera_model_size, camera_model_size, 3, EI_CLASSIFIER_RESIZE_FIT_SHORTEST);
+    if (ret != 0) {
+        return ret;
+    }
+
+    signal_t signal;
+    signal.total_length = camera_model_size * camera_model_size;
+    signal.get_data = [rgb](size_t offset, size_t length, float *out_ptr) {
+        for (size_t ix = 0; ix < length; ix++) {
+            const uint8_t *p = rgb + (offset + ix) * 3;
+            out_ptr[ix] = (float)((p[0] << 16) | (p[1] << 8) | p[2]);
+        }
+        return 0;
+    };
+    matrix_i8_t out(1, frame->chained.size(), frame->chained.data());
+    return extract_image_features_quantized(&signal, &out, &camera_config, camera_scale, camera_zero_point, 0, 0);
+}
+
+// The same in one pass, as run_classifier_image_frame() does
+static int camera_fused(CameraFrame *frame)
+{
+    ei_image_frame_t image = { frame->raw.data(), frame->width, frame->height, frame->format };
+    matrix_i8_t out(1, frame->fused.size(), frame->fused.data());
+    return extract_image_frame_features_quantized(&image, &out, &camera_config, camera_scale, camera_zero_point,
+        camera_model_size, camera_model_size, EI_CLASSIFIER_RESIZE_FIT_SHORTEST, 0);
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            opts.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            opts.min_time = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            opts.repetitions = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            opts.out = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            opts.baseline = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-regression") == 0 && i + 1 < argc) {
+            opts.max_regression = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--external-ns-per-byte") == 0 && i + 1 < argc) {
+            opts.external_ns_per_byte = atof(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--filter SUBSTRING] [--min-time SECONDS] [--repetitions N] "
+                "[--out FILE] [--baseline FILE] [--max-regression PERCENT] [--external-ns-per-byte NS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks;
+
+    // -------- Motion blocks: 3 axes, 2 s at 100 Hz --------
+    static std::vector<float> motion = make_motion(200, 3, 100.0f);
+
+    static ei_dsp_config_flatten_t flatten = { 1, 1, 3, 1.0f, true, true, true, true, true, true, true, 0 };
+    benchmarks.push_back({ "flatten/3x200", dsp_op(&extract_flatten_features, &motion, &flatten, 100.0f, 21) });
+
+    // The spectral blocks want an exactly sized output, per axis:
+    //   v1:    rms + 3 peaks (freq, height) + 4 power bands = 11
+    //   v2/v3: rms, skewness, kurtosis + 5 FFT bins up to the 8 Hz cutoff = 8
+    //   v4:    v3 + spectral skewness and kurtosis = 10
+    static const size_t spectral_features[4] = { 3 * 11, 3 * 8, 3 * 8, 3 * 10 };
+    static ei_dsp_config_spectral_analysis_t spectral[4];
+    for (int version = 1; version <= 4; version++) {
+        spectral[version - 1] = { 1, (uint16_t)version, 3, 1.0f, 1, "low", 8.0f, 6, "FFT",
+            version == 1 ? 128 : 64, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", true, false, 1, "", false };
+        benchmarks.push_back({ "spectral_analysis_v" + std::to_string(version) + "/3x200",
+            dsp_op(&extract_spectral_analysis_features, &motion, &spectral[version - 1], 100.0f, spectral_features[version - 1]) });
+    }
+
+    static ei_dsp_config_spectral_analysis_t wavelet = { 1, 4, 3, 1.0f, 1, "none", 0.0f, 0, "Wavelet",
+        64, 3, 0.1f, "", false, false, 2, "db4", false };
+    // 14 features for each of the level + 1 components, per axis
+    benchmarks.push_back({ "wavelet_db4_l2/3x200", dsp_op(&extract_spectral_analysis_features, &motion, &wavelet, 100.0f, 3 * 14 * 3) });
+
+    // -------- Audio blocks: 1 s at 16 kHz --------
+    static std::vector<float> audio = make_audio(16000, 16000.0f);
+
+    static ei_dsp_config_mfcc_t mfcc = { 1, 4, 1, nullptr, 0, 13, 0.02f, 0.02f, 32, 256, 101, 0, 0, 0.98f, 1 };
+    benchmarks.push_back({ "mfcc/16k_1s", dsp_op(&extract_mfcc_features, &audio, &mfcc, 16000.0f, 13 * 50) });
+
+    static ei_dsp_config_mfe_t mfe = { 1, 4, 1, nullptr, 0, 0.02f, 0.01f, 40, 256, 0, 0, 101, -52 };
+    benchmarks.push_back({ "mfe/16k_1s", dsp_op(&extract_mfe_features, &audio, &mfe, 16000.0f, 40 * 100) });
+
+    static ei_dsp_config_spectrogram_t spectrogram = { 1, 4, 1, nullptr, 0, 0.02f, 0.01f, 256, -52, false };
+    benchmarks.push_back({ "spectrogram/16k_1s", dsp_op(&extract_spectrogram_features, &audio, &spectrogram, 16000.0f, 129 * 100) });
+
+    // -------- Continuous audio: the same blocks per slice, 2, 4 and 8 slices per window --------
+    // The output matrix is sized for the whole window, as in run_classifier_continuous()
+    for (size_t slices : { 2, 4, 8 }) {
+        const std::string len = "/16k_" + std::to_string(1000 / slices) + "ms";
+        benchmarks.push_back({ "mfcc_per_slice" + len,
+            dsp_slice_op(&extract_mfcc_per_slice_features, &audio, new ei_dsp_config_mfcc_t(mfcc), 16000.0f, slices, 13 * 50) });
+        benchmarks.push_back({ "mfe_per_slice" + len,
+            dsp_slice_op(&extract_mfe_per_slice_features, &audio, new ei_dsp_config_mfe_t(mfe), 16000.0f, slices, 40 * 100) });
+        benchmarks.push_back({ "spectrogram_per_slice" + len,
+            dsp_slice_op(&extract_spectrogram_per_slice_features, &audio, new ei_dsp_config_spectrogram_t(spectrogram),
+                16000.0f, slices, 129 * 100) });
+    }
+
+    // -------- FFT --------
+    for (size_t n_fft : { 64, 256, 1024 }) {
+        std::vector<float> *src = new std::vector<float>(audio.begin(), audio.begin() + n_fft);
+        std::vector<float> *dst = new std::vector<float>(n_fft / 2 + 1);
+        benchmarks.push_back({ "rfft/" + std::to_string(n_fft), [=]() {
+            return numpy::rfft(src->data(), src->size(), dst->data(), dst->size(), n_fft);
+        } });
+    }
+
+    // -------- numpy kernels: 3 .. 16k values --------
+    // Runs on whatever backend ei_simd_kernels.h picked for this build; build once
+    // more with -DEIDSP_USE_SIMD_KERNELS=0 and pass its JSON as --baseline to compare
+    // against the plain scalar loops
+    for (size_t n : { 3, 16, 64, 256, 1024, 4096, 16384 }) {
+        const std::string len = "/" + std::to_string(n);
+        std::vector<float> *x = new std::vector<float>(make_audio(n, 16000.0f));
+        std::vector<float> *y = new std::vector<float>(x->rbegin(), x->rend());
+        matrix_t *in = new matrix_t(1, n, x->data());
+        matrix_t *out = new matrix_t(1, 1);
+
+        benchmarks.push_back({ "numpy/sum" + len, [=]() {
+            out->buffer[0] = numpy::sum(x->data(), n);
+            return 0;
+        } });
+        benchmarks.push_back({ "numpy/dot" + len, [=]() {
+            out->buffer[0] = numpy::dot(x->data(), y->data(), n);
+            return 0;
+        } });
+        benchmarks.push_back({ "numpy/rms" + len, [=]() { return numpy::rms(in, out); } });
+        benchmarks.push_back({ "numpy/mean" + len, [=]() { return numpy::mean(in, out); } });
+        benchmarks.push_back({ "numpy/stdev" + len, [=]() { return numpy::stdev(in, out); } });
+        benchmarks.push_back({ "numpy/min" + len, [=]() { return numpy::min(in, out); } });
+        benchmarks.push_back({ "numpy/max" + len, [=]() { return numpy::max(in, out); } });
+        // in place; a factor of 1 returns early, -1 only flips the sign between iterations
+        benchmarks.push_back({ "numpy/scale" + len, [=]() { return numpy::scale(in, -1.0f); } });
+    }
+
+    // -------- SignalWithAxes: 3 of 6 interleaved axes --------
+    // Same gather from a callback-backed signal (staged in chunks) and from a
+    // buffer-backed one (read straight from memory)
+    static ei_impulse_t six_axes = *ei_default_impulse.impulse;
+    six_axes.raw_samples_per_frame = 6;
+    static EI_CLASSIFIER_DSP_AXES_INDEX_TYPE selected_axes[3] = { 0, 2, 4 };
+    for (size_t frames : { 128, 512, 2048, 8192 }) {
+        std::vector<float> *raw = new std::vector<float>(make_motion(frames, 6, 100.0f));
+        std::vector<float> *dst = new std::vector<float>(frames * 3);
+        for (bool callback : { true, false }) {
+            benchmarks.push_back({ std::string("signal_with_axes/") + (callback ? "callback/" : "buffer/") + std::to_string(frames),
+                [=]() {
+                    signal_t signal;
+                    numpy::signal_from_buffer(raw->data(), raw->size(), &signal);
+                    if (callback) {
+                        signal.raw_buffer = nullptr;
+                    }
+                    SignalWithAxes swa(&signal, selected_axes, 3, &six_axes);
+                    signal_t *wrapped = swa.get_signal();
+                    return wrapped->get_data(0, wrapped->total_length, dst->data());
+                } });
+        }
+    }
+
+    // -------- Memory placement: hot / bulk / default --------
+    // Allocating and then sweeping a tensor-arena sized and a DSP-scratch sized buffer
+    // through each placement. Off target all three come from the same heap, so the
+    // measured time is the tier bookkeeping and ext ns/op models what using a bulk
+    // (external RAM) buffer adds: one read for the sweeps, a write and a read of the
+    // block for the alloc cases. On a board with PSRAM the measured time shows it.
+    std::vector<void *> placement_buffers;
+    typedef void *(*placement_fn_t)(size_t);
+    static const struct { const char *name; placement_fn_t alloc; } placements[] = {
+        { "hot", &ei_malloc_hot }, { "bulk", &ei_malloc_bulk }, { "default", &ei_malloc },
+    };
+    for (const auto &placement : placements) {
+        const placement_fn_t alloc = placement.alloc;
+        for (size_t bytes : { 4096, 65536 }) {
+            const std::string suffix = std::string(placement.name) + "/" + std::to_string(bytes);
+            benchmarks.push_back({ "memory_placement/alloc/" + suffix, [=]() {
+                void *p = alloc(bytes);
+                if (!p) {
+                    return -1;
+                }
+                ei_free(p);
+                return 0;
+            } });
+
+            int32_t *buffer = (int32_t *)alloc(bytes);
+            if (!buffer) {
+                fprintf(stderr, "memory_placement/sweep/%s: out of memory, skipped\n", suffix.c_str());
+                continue;
+            }
+            memset(buffer, 1, bytes);
+            placement_buffers.push_back(buffer);
+            benchmarks.push_back({ "memory_placement/sweep/" + suffix, [=]() {
+                int32_t sum = 0;
+                for (size_t i = 0; i < bytes / sizeof(int32_t); i++) {
+                    sum += buffer[i];
+                }
+                buffer[0] = sum;
+                return 0;
+            }, ei_memory_tier_of(buffer) == EI_MEMORY_TIER_BULK ? bytes : 0 });
+        }
+    }
+
+    // -------- Dense layers of our model: 21 -> 32 -> 16 -> 8 -> 2 --------
+    add_dense_benchmarks<21, 32>(benchmarks);
+    add_dense_benchmarks<32, 16>(benchmarks);
+    add_dense_benchmarks<16, 8>(benchmarks);
+    add_dense_benchmarks<8, 2>(benchmarks);
+
+    // -------- Camera frames: convert + resize + quantize vs fused --------
+    // A 640x480 or 320x240 frame (random pixels, the work doesn't depend on them) to
+    // a 96x96 RGB int8 input, fit shortest. Both paths must give the same tensor, a
+    // mismatch fails the fused case.
+    std::vector<CameraFrame *> camera_frames;
+    static const char *camera_format_names[] = { "rgb888", "rgb565", "yuv422" };
+    for (int width : { 320, 640 }) {
+        for (auto format : { ei::image::processing::PIXEL_FORMAT_YUV422, ei::image::processing::PIXEL_FORMAT_RGB565,
+                ei::image::processing::PIXEL_FORMAT_RGB888 }) {
+            CameraFrame *frame = make_camera_frame(width, width * 3 / 4, format);
+            camera_frames.push_back(frame);
+            const std::string suffix = std::string(camera_format_names[format]) + "/" + std::to_string(width) +
+                "x" + std::to_string(width * 3 / 4);
+
+            const bool same = camera_chained(frame) == 0 && camera_fused(frame) == 0 && frame->chained == frame->fused;
+            if (!same) {
+                fprintf(stderr, "camera_frame/%s: chained and fused input tensors differ\n", suffix.c_str());
+            }
+
+            benchmarks.push_back({ "camera_frame/chained/" + suffix, [=]() {
+                return camera_chained(frame);
+            } });
+            benchmarks.push_back({ "camera_frame/fused/" + suffix, [=]() {
+                return same ? camera_fused(frame) : 1;
+            } });
+        }
+    }
+
+    // -------- Tree ensemble: model node arrays vs packed layout --------
+    // Random forests (32 features, 4 classes) over 64 input rows, scored one row
+    // per op (the next row each time, as on target) and all 64 rows per op. Both
+    // paths must give bit-identical scores, a mismatch fails the packed case.
+    // Depth 8-10 with 500 trees needs more nodes than uint16 node ids hold and
+    // is skipped.
+    std::vector<tree_ensemble_forest_t *> forests;
+    for (int depth : { 4, 6, 8, 10 }) {
+        for (int trees : { 10, 100, 500 }) {
+            for (int batch : { 1, 64 }) {
+                const std::string suffix = "d" + std::to_string(depth) + "_t" + std::to_string(trees) +
+                    "_b" + std::to_string(batch);
+                tree_ensemble_forest_t *forest = tree_ensemble_bench_create(depth, trees, 64, batch, 1000 * depth + trees);
+                if (!forest) {
+                    fprintf(stderr, "tree_ensemble/%s: too many nodes, skipped\n", suffix.c_str());
+                    continue;
+                }
+                forests.push_back(forest);
+
+                const bool same = tree_ensemble_bench_outputs_match(forest);
+                if (!same) {
+                    fprintf(stderr, "tree_ensemble/%s: packed and unpacked scores differ\n", suffix.c_str());
+                }
+
+                benchmarks.push_back({ "tree_ensemble/unpacked/" + suffix, [=]() {
+                    tree_ensemble_bench_eval(forest, false);
+                    return 0;
+                } });
+                benchmarks.push_back({ "tree_ensemble/packed/" + suffix, [=]() {
+                    tree_ensemble_bench_eval(forest, true);
+                    return same ? 0 : 1;
+                } });
+            }
+        }
+    }
+
+    // -------- Non-max suppression: per-class scan vs bucketed --------
+    // Class-batched NMS (4 classes, IoU 0.45) over clustered detector-like boxes.
+    // nms/equivalence runs both paths over an edge case corpus and fails on any
+    // difference; each sweep size is checked too and fails its bucketed case.
+    std::vector<nms_bench_boxes_t *> nms_sets;
+    benchmarks.push_back({ "nms/equivalence", []() {
+        int mismatches = nms_bench_check_equivalence();
+        if (mismatches != 0) {
+            fprintf(stderr, "nms/equivalence: %d cases differ\n", mismatches);
+        }
+        return mismatches;
+    } });
+    for (int boxes : { 100, 300, 1000, 3000, 10000, 30000 }) {
+        nms_bench_boxes_t *set = nms_bench_create(boxes, 4, boxes);
+        nms_sets.push_back(set);
+        const std::string suffix = std::to_string(boxes);
+        benchmarks.push_back({ "nms/" + suffix + "/per_class", [=]() {
+            return nms_bench_run(set, false) < 0 ? -1 : 0;
+        } });
+        // checked on the warm-up op, the per-class path takes seconds at 30k boxes
+        benchmarks.push_back({ "nms/" + suffix + "/bucketed", [=, checked = false, same = false]() mutable {
+            if (!checked) {
+                same = nms_bench_outputs_match(set);
+                checked = true;
+                if (!same) {
+                    fprintf(stderr, "nms/%d: per-class and bucketed results differ\n", boxes);
+                }
+            }
+            return same && nms_bench_run(set, true) >= 0 ? 0 : -1;
+        } });
+    }
+
+    // -------- K-means anomaly: linear scan vs pruned search --------
+    // 8 to 256 clusters in 16 and 64 dimensions, one input vector per op (the next
+    // of 256 each time, one in eight an anomaly). Both paths must give
+    // bit-identical scores, a mismatch fails the pruned case. Below
+    // EI_CLASSIFIER_ANOMALY_KMEANS_PRUNE_MIN_CLUSTERS (8) the block always scans.
+    std::vector<kmeans_bench_set_t *> kmeans_sets;
+    for (int features : { 16, 64 }) {
+        for (int clusters : { 8, 16, 32, 64, 128, 256 }) {
+            const std::string suffix = "k" + std::to_string(clusters) + "_d" + std::to_string(features);
+            kmeans_bench_set_t *set = kmeans_bench_create(clusters, features, 100 * clusters + features);
+            kmeans_sets.push_back(set);
+
+            const bool same = kmeans_bench_outputs_match(set);
+            if (!same) {
+                fprintf(stderr, "kmeans_anomaly/%s: linear and pruned scores differ\n", suffix.c_str());
+            }
+
+            benchmarks.push_back({ "kmeans_anomaly/linear/" + suffix, [=]() {
+                kmeans_bench_score(set, false);
+                return 0;
+            } });
+            benchmarks.push_back({ "kmeans_anomaly/pruned/" + suffix, [=]() {
+                kmeans_bench_score(set, true);
+                return same ? 0 : 1;
+            } });
+        }
+    }
+
+    // -------- Object tracking: one frame of detections per op --------
+    // Objects that stay in view, after the first frame every detection matches an
+    // open trace. The tracker keeps everything inline, so this allocates nothing;
+    // an object that gets a new trace fails the case.
+    std::vector<object_tracking_scene_t *> tracking_scenes;
+    for (int objects : { 1, 8, 16 }) {
+        object_tracking_scene_t *scene = object_tracking_bench_create(objects, objects);
+        tracking_scenes.push_back(scene);
+        benchmarks.push_back({ "object_tracking/" + std::to_string(objects) + "_objects", [=]() {
+            return object_tracking_bench_frame(scene) ? 0 : 1;
+        } });
+    }
+
+    // -------- Our impulse, end to end --------
+    static float features[EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE];
+    for (size_t i = 0; i < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE; i++) {
+        features[i] = (i % 3 == 0) ? 2200.0f : (i % 3 == 1) ? 40.0f : 0.0f;
+    }
+    benchmarks.push_back({ "run_classifier/impulse", []() {
+        signal_t signal;
+        numpy::signal_from_buffer(features, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+        ei_impulse_result_t result = { 0 };
+        return (int)run_classifier(&signal, &result, false);
+    } });
+#if EI_CLASSIFIER_HAS_STATIC_IMPULSE
+    // same impulse through the compile-time specialized pipeline, A/B against the above
+    benchmarks.push_back({ "run_classifier_static/impulse", []() {
+        signal_t signal;
+        numpy::signal_from_buffer(features, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+        ei_impulse_result_t result = { 0 };
+        return (int)run_classifier_static(&signal, &result, false);
+    } });
+#endif // EI_CLASSIFIER_HAS_STATIC_IMPULSE
+
+    std::vector<Result> results;
+    bool failed = false;
+    for (const Benchmark &b : benchmarks) {
+        if (opts.filter && b.name.find(opts.filter) == std::string::npos) {
+            continue;
+        }
+        Result r;
+        if (!run_benchmark(b, opts, &r)) {
+            failed = true;
+            continue;
+        }
+        fprintf(stderr, "%-44s %12.1f ns/op %8.2f allocs/op %10.1f B/op %10zu B peak %12.1f ext ns/op\n",
+            r.name.c_str(), r.real_ns, r.allocs_per_op, r.bytes_per_op, r.peak_heap, r.external_ns);
+        results.push_back(r);
+    }
+    for (void *buffer : placement_buffers) {
+        ei_free(buffer);
+    }
+    for (tree_ensemble_forest_t *forest : forests) {
+        tree_ensemble_bench_free(forest);
+    }
+    for (nms_bench_boxes_t *set : nms_sets) {
+        nms_bench_free(set);
+    }
+    for (kmeans_bench_set_t *set : kmeans_sets) {
+        kmeans_bench_free(set);
+    }
+    for (CameraFrame *frame : camera_frames) {
+        delete frame;
+    }
+    for (object_tracking_scene_t *scene : tracking_scenes) {
+        object_tracking_bench_free(scene);
+    }
+
+    FILE *f = opts.out ? fopen(opts.out, "w") : stdout;
+    if (!f) {
+        fprintf(stderr, "Failed to open %s\n", opts.out);
+        return 1;
+    }
+    write_json(f, results, opts);
+    if (opts.out) {
+        fclose(f);
+    }
+
+    if (opts.baseline) {
+        int regressions = compare_baseline(results, opts);
+        if (regressions != 0) {
+            failed = true;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/******************************************************
+ * Plant Buddy – K-means anomaly benchmark clusters
+ *
+ * anomaly.h is only compiled in for impulses with a K-means anomaly block,
+ * and ours has none, so this file turns it on for itself.
+ ******************************************************/
+#include "kmeans_bench.h"
+
+#include <random>
+#include <vector>
+
+#include "model-parameters/model_metadata.h"
+#undef EI_CLASSIFIER_HAS_ANOMALY_KMEANS
+#define EI_CLASSIFIER_HAS_ANOMALY_KMEANS 1
+#undef EI_CLASSIFIER_LOAD_ANOMALY_H
+#define EI_CLASSIFIER_LOAD_ANOMALY_H 1
+#include "edge-impulse-sdk/classifier/inferencing_engines/anomaly.h"
+
+static constexpr int kmeans_inputs = 256;
+
+struct kmeans_bench_set_t {
+    int features;
+    std::vector<float> centroids;
+    std::vector<ei_classifier_anom_cluster_t> clusters;
+    std::vector<float> inputs;
+    int next_input[2]; // per path, linear / pruned
+};
+
+// the set whose clusters the index slots were last built for
+static const kmeans_bench_set_t *indexed_set = nullptr;
+
+kmeans_bench_set_t *kmeans_bench_create(int clusters, int features, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> spread(0.2f, 0.6f);
+
+    kmeans_bench_set_t *set = new kmeans_bench_set_t();
+    set->features = features;
+    set->centroids.resize((size_t)clusters * features);
+    set->clusters.resize(clusters);
+    std::vector<float> radius(clusters);
+    for (int c = 0; c < clusters; c++) {
+        for (int d = 0; d < features; d++) {
+            set->centroids[(size_t)c * features + d] = unit(rng);
+        }
+        radius[c] = spread(rng);
+        set->clusters[c].centroid = &set->centroids[(size_t)c * features];
+        // the block exports the largest distance of a training sample to its centroid
+        set->clusters[c].max_error = radius[c] * sqrtf((float)features) * 1.5f;
+    }
+
+    set->inputs.resize((size_t)kmeans_inputs * features);
+    for (int ix = 0; ix < kmeans_inputs; ix++) {
+        float *input = &set->inputs[(size_t)ix * features];
+        if (ix % 8 == 7) {
+            for (int d = 0; d < features; d++) {
+                input[d] = 3.0f * unit(rng);
+            }
+        }
+        else {
+            const int c = rng() % clusters;
+            for (int d = 0; d < features; d++) {
+                input[d] = set->clusters[c].centroid[d] + radius[c] * unit(rng);
+            }
+        }
+    }
+    set->next_input[0] = set->next_input[1] = 0;
+    return set;
+}
+
+void kmeans_bench_free(kmeans_bench_set_t *set)
+{
+    if (indexed_set == set) {
+        clear_kmeans_indexes();
+        indexed_set = nullptr;
+    }
+    delete set;
+}
+
+static float score(kmeans_bench_set_t *set, bool pruned, int input_ix)
+{
+    const float *input = &set->inputs[(size_t)input_ix * set->features];
+    if (!pruned) {
+        return get_min_distance_to_cluster_linear(input, set->features, set->clusters.data(), set->clusters.size());
+    }
+    // there are only EI_CLASSIFIER_ANOMALY_KMEANS_MAX_INDEXES slots, once they're
+    // taken by earlier sets the search would quietly fall back to the linear scan
+    if (indexed_set != set) {
+        clear_kmeans_indexes();
+        indexed_set = set;
+    }
+    return get_min_distance_to_cluster(input, set->features, set->clusters.data(), set->clusters.size());
+}
+
+float kmeans_bench_score(kmeans_bench_set_t *set, bool pruned)
+{
+    int &next_input = set->next_input[pruned ? 1 : 0];
+    float anomaly = score(set, pruned, next_input);
+    next_input = (next_input + 1) % kmeans_inputs;
+    return anomaly;
+}
+
+bool kmeans_bench_outputs_match(kmeans_bench_set_t *set)
+{
+    for (int ix = 0; ix < kmeans_inputs; ix++) {
+        float linear = score(set, false, ix);
+        float pruned = score(set, true, ix);
+        if (memcmp(&linear, &pruned, sizeof(float)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+/******************************************************
+ * Plant Buddy – K-means anomaly benchmark clusters
+ *
+ * Cluster sets scored through the K-means anomaly block's linear scan over
+ * every cluster and through its pruned search (norm and pairwise bounds plus
+ * partial distances). See kmeans_bench.cpp.
+ ******************************************************/
+#ifndef PLANT_BUDDY_KMEANS_BENCH_H
+#define PLANT_BUDDY_KMEANS_BENCH_H
+
+#include <cstdint>
+
+struct kmeans_bench_set_t;
+
+/**
+ * `clusters` clusters in `features` dimensions, like a K-means block trained on
+ * standard scaled features, plus 256 input vectors: most near a cluster, one in
+ * eight far from all of them (an anomaly)
+ */
+kmeans_bench_set_t *kmeans_bench_create(int clusters, int features, uint32_t seed);
+
+void kmeans_bench_free(kmeans_bench_set_t *set);
+
+/**
+ * Score the next input vector, through the linear scan (pruned = false) or
+ * get_min_distance_to_cluster(), which builds its search index on first use
+ * @returns the anomaly score
+ */
+float kmeans_bench_score(kmeans_bench_set_t *set, bool pruned);
+
+/**
+ * Score every input vector through both paths
+ * @returns whether the scores are bit-identical
+ */
+bool kmeans_bench_outputs_match(kmeans_bench_set_t *set);
+
+#endif // PLANT_BUDDY_KMEANS_BENCH_H
@@ -0,0 +1,225 @@
+/******************************************************
+ * Plant Buddy – non-max suppression benchmark boxes
+ *
+ * ei_nms.h is only compiled in for object detection models, and our impulse
+ * is a classifier, so this file turns it on for itself.
+ ******************************************************/
+#include "nms_bench.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "model-parameters/model_metadata.h"
+#undef EI_HAS_YOLOV11
+#define EI_HAS_YOLOV11 1
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_nms.h"
+
+static constexpr float nms_iou_threshold = 0.45f;
+static constexpr float nms_score_threshold = 0.2f;
+
+struct nms_bench_boxes_t {
+    int count;
+    int classes;
+    std::vector<float> boxes; // [y1, x1, y2, x2] per box
+    std::vector<float> scores;
+    std::vector<int> box_classes;
+    std::vector<int> selected;
+    std::vector<float> selected_scores;
+};
+
+enum nms_corpus_kind_t {
+    NMS_CLUSTERED = 0, // jittered around a few objects, like raw detector output
+    NMS_SCATTERED,
+    NMS_UNORDERED,     // corners in any order, some degenerate
+    NMS_LARGE,         // large boxes, some zero width
+    NMS_TINY_FAR,      // tiny boxes at large coordinates
+    NMS_WITH_NAN,
+    NMS_CORPUS_KINDS
+};
+
+static void make_boxes(nms_bench_boxes_t *set, int count, int classes, nms_corpus_kind_t kind, std::mt19937 &rng)
+{
+    auto uniform = [&rng](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); };
+
+    set->count = count;
+    set->classes = classes;
+    set->boxes.resize((size_t)count * 4);
+    set->scores.resize(count);
+    set->box_classes.resize(count);
+    set->selected.resize(count);
+    set->selected_scores.resize(count);
+
+    const int objects = std::max(1, count / 40);
+    std::vector<float> ox(objects), oy(objects), ow(objects), oh(objects);
+    for (int o = 0; o < objects; o++) {
+        ow[o] = uniform(4, 60);
+        oh[o] = uniform(4, 60);
+        ox[o] = uniform(0, 320 - ow[o]);
+        oy[o] = uniform(0, 320 - oh[o]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        float y1, x1, y2, x2;
+        switch (kind) {
+            case NMS_CLUSTERED: {
+                const int o = rng() % objects;
+                x1 = ox[o] + uniform(-0.3f, 0.3f) * ow[o];
+                y1 = oy[o] + uniform(-0.3f, 0.3f) * oh[o];
+                x2 = x1 + ow[o] * uniform(0.7f, 1.3f);
+                y2 = y1 + oh[o] * uniform(0.7f, 1.3f);
+                break;
+            }
+            case NMS_SCATTERED: {
+                x1 = uniform(0, 320);
+                y1 = uniform(0, 320);
+                x2 = x1 + uniform(1, 100);
+                y2 = y1 + uniform(1, 100);
+                break;
+            }
+            case NMS_UNORDERED: {
+                x1 = uniform(0, 320);
+                y1 = uniform(0, 320);
+                x2 = uniform(0, 320);
+                y2 = uniform(0, 320);
+                break;
+            }
+            case NMS_LARGE: {
+                x1 = uniform(0, 300);
+                y1 = uniform(0, 300);
+                x2 = x1 + (rng() % 4 == 0 ? 0 : uniform(1, 300));
+                y2 = y1 + uniform(1, 300);
+                break;
+            }
+            case NMS_TINY_FAR: {
+                x1 = 1e4f + uniform(0, 0.01f);
+                y1 = 1e4f + uniform(0, 0.01f);
+                x2 = x1 + uniform(0, 0.01f);
+                y2 = y1 + uniform(0, 0.01f);
+                break;
+            }
+            default: {
+                x1 = uniform(0, 320);
+                y1 = uniform(0, 320);
+                x2 = x1 + uniform(1, 50);
+                y2 = (rng() % 50 == 0) ? NAN : y1 + uniform(1, 50);
+                break;
+            }
+        }
+        set->boxes[i * 4 + 0] = y1;
+        set->boxes[i * 4 + 1] = x1;
+        set->boxes[i * 4 + 2] = y2;
+        set->boxes[i * 4 + 3] = x2;
+        set->scores[i] = (float)(rng() % 256) / 255.0f;
+        set->box_classes[i] = rng() % classes;
+    }
+}
+
+nms_bench_boxes_t *nms_bench_create(int boxes, int classes, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    nms_bench_boxes_t *set = new nms_bench_boxes_t();
+    make_boxes(set, boxes, classes, NMS_CLUSTERED, rng);
+    return set;
+}
+
+void nms_bench_free(nms_bench_boxes_t *set)
+{
+    delete set;
+}
+
+// Same as the EI_CLASSIFIER_NMS_BUCKETED=0 branch of ei_run_nms()
+static int run_per_class(nms_bench_boxes_t *set, bool class_batched, float iou_threshold)
+{
+    const int classes = class_batched ? set->classes : 1;
+    int num_selected = 0;
+    for (int cls = 0; cls < classes; cls++) {
+        std::vector<float> class_boxes;
+        std::vector<float> class_scores;
+        std::vector<int> class_map;
+        for (int ix = 0; ix < set->count; ix++) {
+            if (class_batched && set->box_classes[ix] != cls) {
+                continue;
+            }
+            class_boxes.insert(class_boxes.end(), &set->boxes[ix * 4], &set->boxes[ix * 4] + 4);
+            class_scores.push_back(set->scores[ix]);
+            class_map.push_back(ix);
+        }
+        if (class_map.empty()) {
+            continue;
+        }
+        int class_selected = 0;
+        NonMaxSuppression(class_boxes.data(), class_map.size(), class_scores.data(), class_map.size(),
+                          iou_threshold, nms_score_threshold, 0.0f,
+                          &set->selected[num_selected], &set->selected_scores[num_selected], &class_selected);
+        for (int ix = 0; ix < class_selected; ix++) {
+            set->selected[num_selected + ix] = class_map[set->selected[num_selected + ix]];
+        }
+        num_selected += class_selected;
+    }
+    return num_selected;
+}
+
+static int run_bucketed(nms_bench_boxes_t *set, bool class_batched, float iou_threshold)
+{
+    const int num_classes = class_batched ? set->classes : 0;
+    void *scratch = ei_malloc(NonMaxSuppressionBucketedScratchSize(set->count, num_classes));
+    if (!scratch) {
+        return -1;
+    }
+    int num_selected = 0;
+    NonMaxSuppressionBucketed(set->boxes.data(), set->count, set->scores.data(),
+                              class_batched ? set->box_classes.data() : nullptr, num_classes,
+                              set->count, iou_threshold, nms_score_threshold, scratch,
+                              set->selected.data(), set->selected_scores.data(), &num_selected);
+    ei_free(scratch);
+    return num_selected;
+}
+
+int nms_bench_run(nms_bench_boxes_t *set, bool bucketed)
+{
+    return bucketed ? run_bucketed(set, true, nms_iou_threshold) : run_per_class(set, true, nms_iou_threshold);
+}
+
+static bool paths_match(nms_bench_boxes_t *set, bool class_batched, float iou_threshold)
+{
+    const int expected = run_per_class(set, class_batched, iou_threshold);
+    const std::vector<int> expected_selected(set->selected.begin(), set->selected.begin() + expected);
+    const std::vector<float> expected_scores(set->selected_scores.begin(), set->selected_scores.begin() + expected);
+
+    const int kept = run_bucketed(set, class_batched, iou_threshold);
+    if (kept != expected) {
+        return false;
+    }
+    // scores compared bitwise, they're copied through, not recomputed
+    return std::equal(expected_selected.begin(), expected_selected.end(), set->selected.begin()) &&
+        memcmp(expected_scores.data(), set->selected_scores.data(), expected * sizeof(float)) == 0;
+}
+
+bool nms_bench_outputs_match(nms_bench_boxes_t *set)
+{
+    return paths_match(set, true, nms_iou_threshold);
+}
+
+int nms_bench_check_equivalence()
+{
+    static const float iou_thresholds[] = { -0.1f, 0.0f, 0.05f, 0.3f, 0.45f, 0.5f, 0.7f, 0.95f, 1.0f, 1.5f };
+    std::mt19937 rng(7);
+    nms_bench_boxes_t set;
+    int mismatches = 0;
+    for (int count : { 1, 2, 10, 50, 200, 1000 }) {
+        for (int kind = 0; kind < NMS_CORPUS_KINDS; kind++) {
+            for (bool class_batched : { false, true }) {
+                make_boxes(&set, count, class_batched ? 3 : 1, (nms_corpus_kind_t)kind, rng);
+                for (float iou_threshold : iou_thresholds) {
+                    if (!paths_match(&set, class_batched, iou_threshold)) {
+                        mismatches++;
+                    }
+                }
+            }
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,44 @@
+/******************************************************
+ * Plant Buddy – non-max suppression benchmark boxes
+ *
+ * Detection-like box sets run through NonMaxSuppression() once per class
+ * (ei_run_nms() with EI_CLASSIFIER_NMS_BUCKETED=0) and through
+ * NonMaxSuppressionBucketed() (the default). See nms_bench.cpp.
+ ******************************************************/
+#ifndef PLANT_BUDDY_NMS_BENCH_H
+#define PLANT_BUDDY_NMS_BENCH_H
+
+#include <cstdint>
+
+struct nms_bench_boxes_t;
+
+/**
+ * `boxes` boxes on a 320x320 frame, jittered around one object per 40 boxes,
+ * with 8-bit quantized scores (so there are ties) in `classes` classes
+ */
+nms_bench_boxes_t *nms_bench_create(int boxes, int classes, uint32_t seed);
+
+void nms_bench_free(nms_bench_boxes_t *set);
+
+/**
+ * Class-batched NMS at IoU 0.45, score threshold 0.2, through the per-class
+ * NonMaxSuppression() calls (bucketed = false) or NonMaxSuppressionBucketed().
+ * Scratch is allocated per call, like ei_run_nms().
+ * @returns number of boxes kept, -1 if out of memory
+ */
+int nms_bench_run(nms_bench_boxes_t *set, bool bucketed);
+
+/**
+ * @returns whether both paths keep the same boxes with the same scores in the same order
+ */
+bool nms_bench_outputs_match(nms_bench_boxes_t *set);
+
+/**
+ * Compare both paths over a corpus of 1-1000 boxes: clustered, scattered,
+ * unordered corners, zero-sized and NaN boxes, IoU thresholds from -0.1 to
+ * 1.5, class-batched and class-agnostic
+ * @returns number of cases where they differ
+ */
+int nms_bench_check_equivalence();
+
+#endif // PLANT_BUDDY_NMS_BENCH_H
@@ -0,0 +1,123 @@
+/******************************************************
+ * Plant Buddy – object tracker benchmark scenes
+ *
+ * ei_object_tracking.h is only compiled in for impulses with object tracking
+ * enabled, and ours has none, so this file turns it on for itself. The
+ * tracker's output types are generated into model_metadata.h for such
+ * impulses, our export has an empty ei_post_processing_output_t instead, so
+ * they're declared here as a tracking export has them. Nothing else in the
+ * benchmark sees ei_impulse_result_t from this file.
+ ******************************************************/
+#include "object_tracking_bench.h"
+
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#define ei_post_processing_output_t ei_post_processing_output_unused_t
+#include "model-parameters/model_metadata.h"
+#undef ei_post_processing_output_t
+#undef EI_CLASSIFIER_OBJECT_TRACKING_ENABLED
+#define EI_CLASSIFIER_OBJECT_TRACKING_ENABLED 1
+
+typedef struct {
+    uint32_t id;
+    uint32_t last_ground_truth_update_t;
+    const char *label;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    std::tuple<int, int, int, int> last_centroid_segment;
+} ei_object_tracking_trace_t;
+
+typedef struct {
+    ei_object_tracking_trace_t *open_traces;
+    uint32_t open_traces_count;
+} ei_object_tracking_output_t;
+
+typedef struct {
+    ei_object_tracking_output_t object_tracking_output;
+} ei_post_processing_output_t;
+
+// the postprocessing helpers are defined in the header, benchmark.cpp has its own copy
+#define get_block_number bench_get_block_number
+#define process_classification_f32 bench_process_classification_f32
+#define set_threshold_postprocessing bench_set_threshold_postprocessing
+#define get_threshold_postprocessing bench_get_threshold_postprocessing
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/postprocessing/ei_object_tracking.h"
+#undef get_block_number
+#undef process_classification_f32
+#undef set_threshold_postprocessing
+#undef get_threshold_postprocessing
+
+static constexpr int scene_frames = 64;
+static const char *scene_labels[] = { "leaf", "pot", "watering_can" };
+
+struct object_tracking_scene_t {
+    int objects;
+    int next_frame;
+    std::vector<ei_impulse_result_bounding_box_t> detections; // scene_frames x objects
+    Tracker *tracker;
+};
+
+object_tracking_scene_t *object_tracking_bench_create(int objects, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    auto uniform = [&rng](float lo, float hi) { return std::uniform_real_distribution<float>(lo, hi)(rng); };
+
+    object_tracking_scene_t *scene = new object_tracking_scene_t();
+    scene->objects = objects;
+    scene->next_frame = 0;
+    scene->detections.resize((size_t)scene_frames * objects);
+
+    // spots on a grid, so objects don't cross each other
+    const int grid = (int)ceilf(sqrtf((float)objects));
+    const float cell = 320.0f / grid;
+    for (int o = 0; o < objects; o++) {
+        const float cx = (o % grid + 0.5f) * cell;
+        const float cy = (o / grid + 0.5f) * cell;
+        const float size = cell * 0.4f;
+        const float radius = cell * 0.1f;
+        const float phase = uniform(0, 2 * (float)M_PI);
+        for (int f = 0; f < scene_frames; f++) {
+            const float angle = phase + 2 * (float)M_PI * f / scene_frames;
+            ei_impulse_result_bounding_box_t &box = scene->detections[(size_t)f * objects + o];
+            box.label = scene_labels[o % 3];
+            box.x = (uint32_t)(cx + radius * cosf(angle) - size / 2 + uniform(-2, 2));
+            box.y = (uint32_t)(cy + radius * sinf(angle) - size / 2 + uniform(-2, 2));
+            box.width = (uint32_t)(size + uniform(-2, 2));
+            box.height = (uint32_t)(size + uniform(-2, 2));
+            box.value = uniform(0.6f, 0.95f);
+        }
+    }
+
+    // the Tracker's default settings: grace of 5 frames, 5 observations, IoU of 0.5
+    scene->tracker = new Tracker(5, 5, 0.5f, true, scene_labels, 3);
+    return scene;
+}
+
+void object_tracking_bench_free(object_tracking_scene_t *scene)
+{
+    delete scene->tracker;
+    delete scene;
+}
+
+bool object_tracking_bench_frame(object_tracking_scene_t *scene)
+{
+    Tracker *tracker = scene->tracker;
+    tracker->process_new_detections(&scene->detections[(size_t)scene->next_frame * scene->objects], scene->objects);
+    scene->next_frame = (scene->next_frame + 1) % scene_frames;
+
+    if (tracker->object_tracking_output_count != (size_t)scene->objects) {
+        return false;
+    }
+    for (size_t ix = 0; ix < tracker->object_tracking_output_count; ix++) {
+        if (tracker->object_tracking_output[ix].id >= (uint32_t)scene->objects) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+/******************************************************
+ * Plant Buddy – object tracker benchmark scenes
+ *
+ * Detection streams fed frame by frame to the object tracking
+ * postprocessing block's Tracker. See object_tracking_bench.cpp.
+ ******************************************************/
+#ifndef PLANT_BUDDY_OBJECT_TRACKING_BENCH_H
+#define PLANT_BUDDY_OBJECT_TRACKING_BENCH_H
+
+#include <cstdint>
+
+struct object_tracking_scene_t;
+
+/**
+ * `objects` objects of 3 labels, each circling its own spot on a 320x320 frame
+ * (one lap per 64 frames, with a few pixels of detector jitter), and a Tracker
+ * with its default settings
+ */
+object_tracking_scene_t *object_tracking_bench_create(int objects, uint32_t seed);
+
+void object_tracking_bench_free(object_tracking_scene_t *scene);
+
+/**
+ * Hand the next frame's detections to Tracker::process_new_detections()
+ * @returns whether every object is still followed by the trace it opened on the first frame
+ */
+bool object_tracking_bench_frame(object_tracking_scene_t *scene);
+
+#endif // PLANT_BUDDY_OBJECT_TRACKING_BENCH_H
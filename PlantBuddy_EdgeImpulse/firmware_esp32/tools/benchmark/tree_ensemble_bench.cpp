@@ -0,0 +1,196 @@
+/******************************************************
+ * Plant Buddy – tree ensemble benchmark forests
+ *
+ * The kernel keeps PackTrees / EvalPacked / EvalUnpacked in an anonymous
+ * namespace, so its source is compiled into this file again, with the
+ * registration functions renamed so they don't clash with the library's copy.
+ ******************************************************/
+#include "tree_ensemble_bench.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define Register_TreeEnsembleClassifier bench_Register_TreeEnsembleClassifier
+#define GetString_TreeEnsembleClassifier bench_GetString_TreeEnsembleClassifier
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/tree_ensemble_classifier.cpp"
+#undef Register_TreeEnsembleClassifier
+#undef GetString_TreeEnsembleClassifier
+
+static constexpr int forest_features = 32;
+static constexpr int forest_classes = 4;
+
+struct tree_ensemble_forest_t {
+    std::vector<uint16_t> featureids;
+    std::vector<float> values;
+    std::vector<uint16_t> truenodeids;
+    std::vector<uint16_t> falsenodeids;
+    std::vector<float> weights;
+    std::vector<uint8_t> classids;
+    std::vector<uint16_t> roots;
+
+    std::vector<tflite::PackedTreeNode> packed_nodes;
+    std::vector<uint16_t> packed_roots;
+
+    tflite::OpDataTree data;
+    tflite::OpDataTree packed_data;
+
+    int rows;
+    int batch;
+    int next_row[2]; // per path, unpacked / packed
+    std::vector<float> input;
+    std::vector<float> out_unpacked;
+    std::vector<float> out_packed;
+};
+
+tree_ensemble_forest_t *tree_ensemble_bench_create(int depth, int trees, int rows, int batch, uint32_t seed)
+{
+    if (batch < 1 || rows % batch != 0) {
+        return nullptr;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    // shape each tree first (a node past depth 1 becomes a leaf with p = 1/6,
+    // so trees aren't all complete), then hand out shuffled node ids, so the
+    // model arrays are scattered like an exported forest's
+    struct shape_node_t {
+        bool leaf;
+        int left;
+        int right;
+        int depth;
+    };
+    std::vector<std::vector<shape_node_t>> shapes(trees);
+    size_t internal = 0, leaves = 0;
+    for (auto &shape : shapes) {
+        shape.push_back({ false, -1, -1, 0 });
+        for (size_t ix = 0; ix < shape.size(); ix++) {
+            const int d = shape[ix].depth;
+            shape[ix].leaf = d >= depth || (d > 1 && rng() % 6 == 0);
+            if (!shape[ix].leaf) {
+                shape[ix].left = (int)shape.size();
+                shape.push_back({ false, -1, -1, d + 1 });
+                shape[ix].right = (int)shape.size();
+                shape.push_back({ false, -1, -1, d + 1 });
+            }
+        }
+        for (const auto &node : shape) {
+            (node.leaf ? leaves : internal)++;
+        }
+    }
+    if (internal + leaves > UINT16_MAX) {
+        return nullptr;
+    }
+
+    tree_ensemble_forest_t *forest = new tree_ensemble_forest_t();
+    forest->featureids.resize(internal);
+    forest->values.resize(internal);
+    forest->truenodeids.resize(internal);
+    forest->falsenodeids.resize(internal);
+    forest->weights.resize(leaves);
+    forest->classids.resize(leaves);
+
+    std::vector<uint16_t> internal_ids(internal), leaf_ids(leaves);
+    for (size_t ix = 0; ix < internal; ix++) {
+        internal_ids[ix] = (uint16_t)ix;
+    }
+    for (size_t ix = 0; ix < leaves; ix++) {
+        leaf_ids[ix] = (uint16_t)ix;
+    }
+    std::shuffle(internal_ids.begin(), internal_ids.end(), rng);
+    std::shuffle(leaf_ids.begin(), leaf_ids.end(), rng);
+
+    size_t next_internal = 0, next_leaf = 0;
+    for (const auto &shape : shapes) {
+        std::vector<uint16_t> ids(shape.size());
+        for (size_t ix = 0; ix < shape.size(); ix++) {
+            ids[ix] = shape[ix].leaf ? (uint16_t)(internal + leaf_ids[next_leaf++]) : internal_ids[next_internal++];
+        }
+        forest->roots.push_back(ids[0]);
+        for (size_t ix = 0; ix < shape.size(); ix++) {
+            if (shape[ix].leaf) {
+                const size_t leaf = ids[ix] - internal;
+                forest->weights[leaf] = uniform(rng);
+                forest->classids[leaf] = (uint8_t)(rng() % forest_classes);
+            }
+            else {
+                const size_t node = ids[ix];
+                forest->featureids[node] = (uint16_t)(rng() % forest_features);
+                forest->values[node] = uniform(rng);
+                forest->truenodeids[node] = ids[shape[ix].left];
+                forest->falsenodeids[node] = ids[shape[ix].right];
+            }
+        }
+    }
+
+    tflite::OpDataTree &data = forest->data;
+    memset(&data, 0, sizeof(data));
+    data.num_leaf_nodes = (uint32_t)leaves;
+    data.num_internal_nodes = (uint32_t)internal;
+    data.num_trees = (uint32_t)trees;
+    data.nodes_featureids = forest->featureids.data();
+    data.nodes_values = forest->values.data();
+    data.nodes_truenodeids = forest->truenodeids.data();
+    data.nodes_falsenodeids = forest->falsenodeids.data();
+    data.nodes_weights = forest->weights.data();
+    data.nodes_classids = forest->classids.data();
+    data.tree_root_ids = forest->roots.data();
+
+    forest->packed_nodes.resize(internal + leaves);
+    forest->packed_roots.resize(trees);
+    forest->packed_data = data;
+    if (!tflite::PackTrees(&data, forest_features, forest_classes,
+            forest->packed_nodes.data(), forest->packed_roots.data())) {
+        delete forest;
+        return nullptr;
+    }
+    forest->packed_data.packed_nodes = forest->packed_nodes.data();
+    forest->packed_data.packed_roots = forest->packed_roots.data();
+
+    // slightly wider than the thresholds, so some rows take the same branch everywhere
+    std::uniform_real_distribution<float> inputs(-1.2f, 1.2f);
+    forest->rows = rows;
+    forest->batch = batch;
+    forest->next_row[0] = forest->next_row[1] = 0;
+    forest->input.resize((size_t)rows * forest_features);
+    for (float &value : forest->input) {
+        value = inputs(rng);
+    }
+    forest->out_unpacked.resize((size_t)rows * forest_classes);
+    forest->out_packed.resize((size_t)rows * forest_classes);
+    return forest;
+}
+
+void tree_ensemble_bench_free(tree_ensemble_forest_t *forest)
+{
+    delete forest;
+}
+
+static void eval_rows(tree_ensemble_forest_t *forest, bool packed, int first_row, int rows)
+{
+    const float *in = forest->input.data() + (size_t)first_row * forest_features;
+    float *out = (packed ? forest->out_packed : forest->out_unpacked).data() + (size_t)first_row * forest_classes;
+    memset(out, 0, (size_t)rows * forest_classes * sizeof(float));
+    if (packed) {
+        tflite::EvalPacked(&forest->packed_data, in, forest_features, out, forest_classes, rows);
+    }
+    else {
+        tflite::EvalUnpacked(&forest->data, in, forest_features, out, forest_classes, rows);
+    }
+}
+
+void tree_ensemble_bench_eval(tree_ensemble_forest_t *forest, bool packed)
+{
+    int &next_row = forest->next_row[packed ? 1 : 0];
+    eval_rows(forest, packed, next_row, forest->batch);
+    next_row = (next_row + forest->batch) % forest->rows;
+}
+
+bool tree_ensemble_bench_outputs_match(tree_ensemble_forest_t *forest)
+{
+    eval_rows(forest, false, 0, forest->rows);
+    eval_rows(forest, true, 0, forest->rows);
+    return memcmp(forest->out_unpacked.data(), forest->out_packed.data(),
+        forest->out_packed.size() * sizeof(float)) == 0;
+}
@@ -0,0 +1,42 @@
+/******************************************************
+ * Plant Buddy – tree ensemble benchmark forests
+ *
+ * Random forests scored through the TreeEnsembleClassifier kernel's own
+ * evaluation paths (the walk over the model's node arrays, and the packed
+ * breadth-first layout), without building a .tflite model around them.
+ * See tree_ensemble_bench.cpp.
+ ******************************************************/
+#ifndef PLANT_BUDDY_TREE_ENSEMBLE_BENCH_H
+#define PLANT_BUDDY_TREE_ENSEMBLE_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct tree_ensemble_forest_t;
+
+/**
+ * Build `trees` random trees of up to `depth` levels over 32 features and 4
+ * classes, plus `rows` random input rows
+ * @param batch Rows scored per tree_ensemble_bench_eval() call, rows must be a multiple
+ *  of it. Consecutive calls move on to the next batch, so a batch of 1 sees a new
+ *  sample every call, as on target.
+ * @returns nullptr if the forest needs more nodes than the uint16 node ids hold
+ */
+tree_ensemble_forest_t *tree_ensemble_bench_create(int depth, int trees, int rows, int batch, uint32_t seed);
+
+void tree_ensemble_bench_free(tree_ensemble_forest_t *forest);
+
+/**
+ * Score the next batch, like the kernel's Eval: through the model's node arrays
+ * (packed = false) or the packed layout. Each path has its own output buffer
+ * and batch cursor.
+ */
+void tree_ensemble_bench_eval(tree_ensemble_forest_t *forest, bool packed);
+
+/**
+ * Score all rows through both paths
+ * @returns whether the scores are bit-identical
+ */
+bool tree_ensemble_bench_outputs_match(tree_ensemble_forest_t *forest);
+
+#endif // PLANT_BUDDY_TREE_ENSEMBLE_BENCH_H
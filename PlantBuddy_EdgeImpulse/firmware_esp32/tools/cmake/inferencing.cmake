@@ -0,0 +1,26 @@
+# Sources and flags to build the inferencing library natively, for the host tools.
+# Sets:
+#   EI_INFERENCING_DIR          root of the library (lib/Plant_Buddy_inferencing/src)
+#   EI_INFERENCING_SOURCES      SDK, model and porting/clib sources
+#   EI_PORTING_SOURCES          only the porting layer (porting/*.cpp and porting/clib)
+#   EI_INFERENCING_DEFINITIONS  compile definitions for a host build
+set(EI_INFERENCING_DIR ${CMAKE_CURRENT_LIST_DIR}/../../lib/Plant_Buddy_inferencing/src)
+set(EI_SDK_DIR ${EI_INFERENCING_DIR}/edge-impulse-sdk)
+
+include(${EI_SDK_DIR}/cmake/utils.cmake)
+
+# porting/ only contributes the plain C library port, CMSIS is for Arm targets
+RECURSIVE_FIND_FILE(EI_INFERENCING_SOURCES ${EI_SDK_DIR}/dsp "*.cpp")
+RECURSIVE_FIND_FILE_APPEND(EI_INFERENCING_SOURCES ${EI_SDK_DIR}/dsp "*.c")
+RECURSIVE_FIND_FILE_APPEND(EI_INFERENCING_SOURCES ${EI_SDK_DIR}/tensorflow "*.cpp")
+RECURSIVE_FIND_FILE_APPEND(EI_INFERENCING_SOURCES ${EI_SDK_DIR}/tensorflow "*.c")
+RECURSIVE_FIND_FILE_APPEND(EI_INFERENCING_SOURCES ${EI_INFERENCING_DIR}/tflite-model "*.cpp")
+SOURCE_FILES(EI_PORTING_SOURCES ${EI_SDK_DIR}/porting "*.cpp")
+SOURCE_FILES(EI_PORTING_CLIB_SOURCES ${EI_SDK_DIR}/porting/clib "*.cpp")
+list(APPEND EI_PORTING_SOURCES ${EI_PORTING_CLIB_SOURCES})
+list(APPEND EI_INFERENCING_SOURCES ${EI_PORTING_SOURCES})
+
+set(EI_INFERENCING_DEFINITIONS
+    EI_PORTING_CLIB=1
+    EI_PORTING_POSIX=0
+)
@@ -0,0 +1,189 @@
+/******************************************************
+ * Plant Buddy – deferred log decoder (host tool)
+ *
+ * Turns the binary stream written by ei_deferred_log_drain_binary() on the
+ * device back into text. A record only holds the address of its format
+ * string and the raw argument values, so the format strings (and the strings
+ * passed to %s) are looked up in the firmware ELF the stream came from; see
+ * ei_deferred_log.h in the SDK for the record layout.
+ *
+ * Usage:
+ *   log_decoder <firmware.elf> [log.bin]
+ *
+ * Reads the stream from log.bin, or from stdin, and prints one line per
+ * record. With PlatformIO the ELF is .pio/build/esp32dev/firmware.elf. The
+ * stream has no framing, so capture it on a channel of its own (a second
+ * UART, a file), not interleaved with Serial output.
+ *
+ * Build on the host (CMakeLists.txt next to this file):
+ *   cmake -S tools/log_decoder -B build/log_decoder
+ *   cmake --build build/log_decoder
+ ******************************************************/
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "edge-impulse-sdk/porting/ei_deferred_log.h"
+
+namespace {
+
+struct LoadSegment {
+    uint64_t vaddr;
+    uint64_t offset;
+    uint64_t size;
+};
+
+std::vector<uint8_t> elf;
+std::vector<LoadSegment> segments;
+
+uint64_t read_le(const uint8_t *p, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t ix = 0; ix < bytes; ix++) {
+        value |= (uint64_t)p[ix] << (8 * ix);
+    }
+    return value;
+}
+
+bool load_elf(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return false;
+    }
+    elf.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    if (elf.size() < 64 || memcmp(elf.data(), "\x7f" "ELF", 4) != 0) {
+        fprintf(stderr, "%s is not an ELF file\n", path);
+        return false;
+    }
+    bool is_64 = elf[4] == 2;
+    if (elf[5] != 1) {
+        fprintf(stderr, "%s is not little endian\n", path);
+        return false;
+    }
+
+    uint64_t phoff = is_64 ? read_le(&elf[0x20], 8) : read_le(&elf[0x1c], 4);
+    size_t phentsize = read_le(&elf[is_64 ? 0x36 : 0x2a], 2);
+    size_t phnum = read_le(&elf[is_64 ? 0x38 : 0x2c], 2);
+
+    for (size_t ix = 0; ix < phnum; ix++) {
+        uint64_t at = phoff + ix * phentsize;
+        if (at + phentsize > elf.size()) {
+            break;
+        }
+        const uint8_t *ph = &elf[at];
+        const uint32_t pt_load = 1;
+        if (read_le(ph, 4) != pt_load) {
+            continue;
+        }
+        LoadSegment segment;
+        if (is_64) {
+            segment.offset = read_le(ph + 8, 8);
+            segment.vaddr = read_le(ph + 16, 8);
+            segment.size = read_le(ph + 32, 8);
+        }
+        else {
+            segment.offset = read_le(ph + 4, 4);
+            segment.vaddr = read_le(ph + 8, 4);
+            segment.size = read_le(ph + 16, 4);
+        }
+        if (segment.offset + segment.size <= elf.size()) {
+            segments.push_back(segment);
+        }
+    }
+
+    if (segments.empty()) {
+        fprintf(stderr, "%s has no loadable segments\n", path);
+        return false;
+    }
+    return true;
+}
+
+// A NUL terminated string at a device address, or nullptr if it's not in the image
+const char *resolve_string(uint64_t address)
+{
+    for (const LoadSegment &segment : segments) {
+        if (address < segment.vaddr || address >= segment.vaddr + segment.size) {
+            continue;
+        }
+        const uint8_t *start = &elf[segment.offset + (address - segment.vaddr)];
+        const uint8_t *end = &elf[0] + segment.offset + segment.size;
+        if (memchr(start, 0, end - start) == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<const char *>(start);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <firmware.elf> [log.bin]\n", argv[0]);
+        return 1;
+    }
+    if (!load_elf(argv[1])) {
+        return 1;
+    }
+
+    FILE *in = stdin;
+    if (argc == 3) {
+        in = fopen(argv[2], "rb");
+        if (!in) {
+            fprintf(stderr, "Failed to open %s\n", argv[2]);
+            return 1;
+        }
+    }
+
+    uint8_t header[EI_DEFERRED_LOG_RECORD_HEADER_SIZE];
+    uint8_t raw_args[8 * 8];
+    uint64_t args[8];
+    char line[1024];
+    size_t records = 0;
+    size_t unknown = 0;
+
+    while (fread(header, 1, sizeof(header), in) == sizeof(header)) {
+        uint64_t format_address = read_le(header, 8);
+        uint8_t level = header[8];
+        uint8_t arg_count = header[9];
+        uint8_t float_mask = header[10];
+        if (arg_count > 8) {
+            fprintf(stderr, "Corrupt record %zu (%u arguments), stopping\n", records, (unsigned)arg_count);
+            break;
+        }
+        if (fread(raw_args, 8, arg_count, in) != arg_count) {
+            fprintf(stderr, "Truncated record %zu\n", records);
+            break;
+        }
+        for (size_t ix = 0; ix < arg_count; ix++) {
+            args[ix] = read_le(raw_args + ix * 8, 8);
+        }
+
+        const char *format = resolve_string(format_address);
+        if (!format) {
+            printf("<unknown format 0x%llx>\n", (unsigned long long)format_address);
+            unknown++;
+        }
+        else {
+            ei_deferred_log_format(line, sizeof(line), level, format, arg_count, float_mask, args, resolve_string);
+            fputs(line, stdout);
+        }
+        records++;
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    fprintf(stderr, "%zu records decoded", records);
+    if (unknown > 0) {
+        fprintf(stderr, ", %zu with unknown format strings (wrong ELF?)", unknown);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
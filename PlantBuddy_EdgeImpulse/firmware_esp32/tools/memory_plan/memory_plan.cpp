@@ -0,0 +1,473 @@
+/******************************************************
+ * Plant Buddy – offline arena planner (host tool)
+ *
+ * Computes the TFLite Micro arena layout for a .tflite model once, on the
+ * host, and stores it in the model as "EIMemoryPlan" metadata. The
+ * interpreter path (tflite_micro.h) adopts that plan instead of running the
+ * GreedyMemoryPlanner at every setup; see precomputed_memory_planner.h in the
+ * SDK for the format and the fallback rules.
+ *
+ * Usage:
+ *   memory_plan <in.tflite> <out.tflite> [--arena BYTES] [--iterations N]
+ *
+ * Build on the host (CMakeLists.txt next to this file):
+ *   cmake -S tools/memory_plan -B build/memory_plan
+ *   cmake --build build/memory_plan
+ *
+ * The buffers are recorded with the host's kernels. If the target's kernels
+ * ask for bigger scratch buffers, the device falls back to the greedy planner,
+ * so build the tool with the same kernel set as the firmware where possible.
+ ******************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/linear_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/precomputed_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_allocator.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_arena_constants.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/single_arena_buffer_allocator.h"
+#include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
+
+// -------- Buffer requests --------
+struct BufferRequest {
+  int size;
+  int first;
+  int last;
+  int offline;  // tflite::kOnlinePlannedBuffer if the planner may place it
+};
+
+// Greedy planner that also keeps a copy of every buffer the allocator adds
+class RecordingPlanner : public tflite::GreedyMemoryPlanner {
+ public:
+  TfLiteStatus Init(unsigned char* scratch, int scratch_size) override {
+    requests.clear();
+    return GreedyMemoryPlanner::Init(scratch, scratch_size);
+  }
+  TfLiteStatus AddBuffer(int size, int first, int last) override {
+    requests.push_back({ size, first, last, tflite::kOnlinePlannedBuffer });
+    return GreedyMemoryPlanner::AddBuffer(size, first, last);
+  }
+  TfLiteStatus AddBuffer(int size, int first, int last, int offline) override {
+    requests.push_back({ size, first, last, offline });
+    return GreedyMemoryPlanner::AddBuffer(size, first, last, offline);
+  }
+  std::vector<BufferRequest> requests;
+};
+
+// -------- Interpreter setup --------
+enum class PlannerKind { Greedy, Linear, Precomputed };
+
+struct SetupResult {
+  bool ok = false;
+  double setup_us = 0;       // interpreter construction + AllocateTensors()
+  size_t arena_used = 0;
+  bool plan_adopted = false;
+  bool invoked = false;      // false if the host kernels couldn't run the model
+};
+
+static tflite::AllOpsResolver resolver;
+
+static SetupResult setup_interpreter(const tflite::Model* model, uint8_t* arena, size_t arena_size,
+                                     PlannerKind kind, RecordingPlanner* recorder,
+                                     std::vector<uint8_t>* outputs, const std::vector<uint8_t>* input) {
+  SetupResult result;
+  auto start = std::chrono::steady_clock::now();
+
+  uint8_t* aligned = tflite::AlignPointerUp(arena, tflite::MicroArenaBufferAlignment());
+  tflite::SingleArenaBufferAllocator* memory =
+      tflite::SingleArenaBufferAllocator::Create(aligned, arena + arena_size - aligned);
+
+  tflite::MicroMemoryPlanner* planner = nullptr;
+  tflite::PrecomputedMemoryPlanner* precomputed = nullptr;
+  if (recorder) {
+    planner = recorder;
+  }
+  else if (kind == PlannerKind::Linear) {
+    planner = new (memory->AllocatePersistentBuffer(sizeof(tflite::LinearMemoryPlanner),
+                                                    alignof(tflite::LinearMemoryPlanner)))
+        tflite::LinearMemoryPlanner();
+  }
+  else if (kind == PlannerKind::Precomputed) {
+    const tflite::PrecomputedMemoryPlan* plan = tflite::GetPrecomputedMemoryPlan(model);
+    if (!plan) {
+      return result;
+    }
+    precomputed = new (memory->AllocatePersistentBuffer(sizeof(tflite::PrecomputedMemoryPlanner),
+                                                        alignof(tflite::PrecomputedMemoryPlanner)))
+        tflite::PrecomputedMemoryPlanner(plan);
+    planner = precomputed;
+  }
+  else {
+    planner = new (memory->AllocatePersistentBuffer(sizeof(tflite::GreedyMemoryPlanner),
+                                                    alignof(tflite::GreedyMemoryPlanner)))
+        tflite::GreedyMemoryPlanner();
+  }
+
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(memory, planner);
+  tflite::MicroInterpreter interpreter(model, resolver, allocator);
+  if (interpreter.AllocateTensors(true) != kTfLiteOk) {
+    return result;
+  }
+  result.setup_us = std::chrono::duration<double, std::micro>(
+      std::chrono::steady_clock::now() - start).count();
+  result.arena_used = interpreter.arena_used_bytes();
+  result.plan_adopted = precomputed && precomputed->UsingPrecomputedPlan();
+  result.ok = true;
+
+  if (outputs && input) {
+    for (size_t ix = 0; ix < interpreter.inputs_size(); ix++) {
+      TfLiteTensor* tensor = interpreter.input(ix);
+      for (size_t b = 0; b < tensor->bytes; b++) {
+        tensor->data.uint8[b] = (*input)[b % input->size()];
+      }
+    }
+    if (interpreter.Invoke() != kTfLiteOk) {
+      return result;
+    }
+    result.invoked = true;
+    outputs->clear();
+    for (size_t ix = 0; ix < interpreter.outputs_size(); ix++) {
+      TfLiteTensor* tensor = interpreter.output(ix);
+      outputs->insert(outputs->end(), tensor->data.uint8, tensor->data.uint8 + tensor->bytes);
+    }
+  }
+  return result;
+}
+
+static SetupResult time_setup(const tflite::Model* model, uint8_t* arena, size_t arena_size,
+                              PlannerKind kind, int runs) {
+  SetupResult best;
+  for (int ix = 0; ix < runs; ix++) {
+    SetupResult r = setup_interpreter(model, arena, arena_size, kind, nullptr, nullptr, nullptr);
+    if (!r.ok) {
+      return r;
+    }
+    if (ix == 0 || r.setup_us < best.setup_us) {
+      best = r;
+    }
+  }
+  return best;
+}
+
+// -------- Offline placement --------
+static bool overlaps_in_time(const BufferRequest& a, const BufferRequest& b) {
+  return a.first <= b.last && b.first <= a.last;
+}
+
+// Place buffers in the given order, each at the lowest offset that doesn't
+// collide with an already placed buffer that is live at the same time.
+// Returns the arena size.
+static int place(const std::vector<BufferRequest>& buffers, const std::vector<int>& order,
+                 std::vector<int>& offsets) {
+  const int alignment = tflite::MicroArenaBufferAlignment();
+  std::vector<std::pair<int, int>> taken;
+  std::vector<int> placed;
+  int arena = 0;
+
+  offsets.assign(buffers.size(), -1);
+  for (size_t ix = 0; ix < buffers.size(); ix++) {
+    if (buffers[ix].offline != tflite::kOnlinePlannedBuffer) {
+      offsets[ix] = buffers[ix].offline;
+      placed.push_back(ix);
+      arena = std::max(arena, offsets[ix] + buffers[ix].size);
+    }
+  }
+
+  for (int id : order) {
+    const BufferRequest& want = buffers[id];
+    if (want.offline != tflite::kOnlinePlannedBuffer) {
+      continue;
+    }
+    taken.clear();
+    for (int other : placed) {
+      if (overlaps_in_time(want, buffers[other])) {
+        taken.push_back({ offsets[other], offsets[other] + buffers[other].size });
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+
+    int candidate = 0;
+    for (const auto& range : taken) {
+      if (range.first - candidate >= want.size) {
+        break;
+      }
+      candidate = std::max(candidate, range.second);
+      candidate = (candidate + alignment - 1) / alignment * alignment;
+    }
+    offsets[id] = candidate;
+    placed.push_back(id);
+    arena = std::max(arena, candidate + want.size);
+  }
+  return arena;
+}
+
+// No layout can be smaller than the bytes live at the busiest point in time
+static int lower_bound(const std::vector<BufferRequest>& buffers) {
+  int max_time = 0;
+  for (const auto& b : buffers) {
+    max_time = std::max(max_time, b.last);
+  }
+  int bound = 0;
+  for (int t = 0; t <= max_time; t++) {
+    int live = 0;
+    for (const auto& b : buffers) {
+      if (b.first <= t && t <= b.last) {
+        live += b.size;
+      }
+    }
+    bound = std::max(bound, live);
+  }
+  return bound;
+}
+
+static bool plan_is_valid(const std::vector<BufferRequest>& buffers, const std::vector<int>& offsets,
+                          int arena) {
+  for (size_t a = 0; a < buffers.size(); a++) {
+    if (offsets[a] < 0 || offsets[a] + buffers[a].size > arena) {
+      return false;
+    }
+    for (size_t b = a + 1; b < buffers.size(); b++) {
+      if (overlaps_in_time(buffers[a], buffers[b]) &&
+          offsets[a] < offsets[b] + buffers[b].size &&
+          offsets[b] < offsets[a] + buffers[a].size) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Try a few orderings, then improve the best one by random swaps. Stops early
+// once the layout reaches the lower bound, which is then optimal.
+static int plan_offsets(const std::vector<BufferRequest>& buffers, int iterations,
+                        std::vector<int>& best_offsets, int* bound_out) {
+  const int bound = lower_bound(buffers);
+  *bound_out = bound;
+
+  std::vector<int> identity(buffers.size());
+  for (size_t ix = 0; ix < buffers.size(); ix++) {
+    identity[ix] = ix;
+  }
+  auto by = [&](auto key) {
+    std::vector<int> order = identity;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key(a) > key(b); });
+    return order;
+  };
+  std::vector<std::vector<int>> seeds = {
+    by([&](int i) { return (long)buffers[i].size; }),
+    by([&](int i) { return (long)buffers[i].size * (buffers[i].last - buffers[i].first + 1); }),
+    by([&](int i) { return (long)(buffers[i].last - buffers[i].first) * (1L << 32) + buffers[i].size; }),
+    by([&](int i) { return -(long)buffers[i].first * (1L << 32) + buffers[i].size; }),
+  };
+
+  std::vector<int> best_order, offsets;
+  int best = -1;
+  for (auto& order : seeds) {
+    int size = place(buffers, order, offsets);
+    if (best < 0 || size < best) {
+      best = size;
+      best_order = order;
+      best_offsets = offsets;
+    }
+  }
+
+  std::mt19937 rng(1);
+  std::vector<int> order = best_order;
+  int current = best;
+  for (int it = 0; it < iterations && best > bound && buffers.size() > 1; it++) {
+    std::vector<int> trial = order;
+    size_t a = rng() % trial.size(), b = rng() % trial.size();
+    if (rng() & 1) {
+      std::swap(trial[a], trial[b]);
+    }
+    else {
+      int moved = trial[a];
+      trial.erase(trial.begin() + a);
+      trial.insert(trial.begin() + b, moved);
+    }
+    int size = place(buffers, trial, offsets);
+    if (size <= current) {
+      current = size;
+      order = trial;
+      if (size < best) {
+        best = size;
+        best_offsets = offsets;
+      }
+    }
+  }
+  return best;
+}
+
+// -------- Model I/O --------
+static bool read_file(const char* path, std::vector<uint8_t>& out) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+static std::vector<uint8_t> embed_plan(const std::vector<uint8_t>& model_data,
+                                       const std::vector<int32_t>& plan_words) {
+  std::unique_ptr<tflite::ModelT> model(tflite::GetModel(model_data.data())->UnPack());
+
+  // replace a plan from an earlier run; its buffer stays, but is left empty
+  for (auto it = model->metadata.begin(); it != model->metadata.end();) {
+    if ((*it)->name == tflite::kPrecomputedMemoryPlanMetadata) {
+      model->buffers[(*it)->buffer]->data.clear();
+      it = model->metadata.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  std::unique_ptr<tflite::BufferT> buffer(new tflite::BufferT());
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(plan_words.data());
+  buffer->data.assign(bytes, bytes + plan_words.size() * sizeof(int32_t));
+  model->buffers.push_back(std::move(buffer));
+
+  std::unique_ptr<tflite::MetadataT> metadata(new tflite::MetadataT());
+  metadata->name = tflite::kPrecomputedMemoryPlanMetadata;
+  metadata->buffer = model->buffers.size() - 1;
+  model->metadata.push_back(std::move(metadata));
+
+  // the SDK's flatbuffers has no implicit default allocator
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, model.get()));
+  return std::vector<uint8_t>(fbb.GetBufferPointer(), fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("Usage: %s <in.tflite> <out.tflite> [--arena BYTES] [--iterations N]\n", argv[0]);
+    return 1;
+  }
+  size_t arena_size = 16 * 1024 * 1024;
+  int iterations = 20000;
+  for (int ix = 3; ix + 1 < argc; ix += 2) {
+    if (strcmp(argv[ix], "--arena") == 0) {
+      arena_size = strtoul(argv[ix + 1], nullptr, 10);
+    }
+    else if (strcmp(argv[ix], "--iterations") == 0) {
+      iterations = atoi(argv[ix + 1]);
+    }
+  }
+
+  std::vector<uint8_t> model_data;
+  if (!read_file(argv[1], model_data)) {
+    printf("Failed to read %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> arena(arena_size + tflite::MicroArenaBufferAlignment());
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+
+  // 1. record the buffers the allocator asks for
+  RecordingPlanner recorder;
+  std::vector<uint8_t> reference;
+  std::vector<uint8_t> input(251);
+  for (size_t ix = 0; ix < input.size(); ix++) {
+    input[ix] = (uint8_t)(ix * 37 + 11);
+  }
+  SetupResult greedy_run = setup_interpreter(model, arena.data(), arena.size(), PlannerKind::Greedy,
+                                             &recorder, &reference, &input);
+  if (!greedy_run.ok) {
+    printf("AllocateTensors() failed, try a bigger --arena\n");
+    return 1;
+  }
+  const std::vector<BufferRequest> buffers = recorder.requests;
+
+  // the recorder's own scratch lived in the arena and is gone by now, so
+  // replay the buffers into a fresh greedy planner for its plan size
+  std::vector<unsigned char> greedy_scratch(buffers.size() * tflite::GreedyMemoryPlanner::per_buffer_size());
+  tflite::GreedyMemoryPlanner greedy_replay;
+  greedy_replay.Init(greedy_scratch.data(), greedy_scratch.size());
+  for (const auto& b : buffers) {
+    if (b.offline == tflite::kOnlinePlannedBuffer) {
+      greedy_replay.AddBuffer(b.size, b.first, b.last);
+    }
+    else {
+      greedy_replay.AddBuffer(b.size, b.first, b.last, b.offline);
+    }
+  }
+  const int greedy_plan = greedy_replay.GetMaximumMemorySize();
+
+  // 2. plan them
+  std::vector<int> offsets;
+  int bound = 0;
+  auto plan_start = std::chrono::steady_clock::now();
+  const int planned = plan_offsets(buffers, iterations, offsets, &bound);
+  const double plan_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - plan_start).count();
+  if (!plan_is_valid(buffers, offsets, planned)) {
+    printf("Internal error, computed plan has overlapping buffers\n");
+    return 1;
+  }
+
+  std::vector<int32_t> words = { tflite::kPrecomputedMemoryPlanVersion, (int32_t)buffers.size(), planned };
+  for (size_t ix = 0; ix < buffers.size(); ix++) {
+    words.insert(words.end(), { offsets[ix], buffers[ix].size, buffers[ix].first, buffers[ix].last });
+  }
+  std::vector<uint8_t> planned_model = embed_plan(model_data, words);
+
+  // 3. check the runtime adopts it and produces the same outputs
+  const tflite::Model* out_model = tflite::GetModel(planned_model.data());
+  std::vector<uint8_t> check;
+  SetupResult adopted = setup_interpreter(out_model, arena.data(), arena.size(), PlannerKind::Precomputed,
+                                          nullptr, &check, &input);
+  if (!adopted.ok || !adopted.plan_adopted) {
+    printf("Runtime did not adopt the plan\n");
+    return 1;
+  }
+  if (!greedy_run.invoked || !adopted.invoked) {
+    printf("Warning: the host kernels could not run the model, outputs not compared\n");
+  }
+  else if (check.size() != reference.size() ||
+           memcmp(check.data(), reference.data(), check.size()) != 0) {
+    printf("Outputs differ between the greedy and the precomputed plan\n");
+    return 1;
+  }
+
+  std::ofstream out(argv[2], std::ios::binary);
+  out.write(reinterpret_cast<const char*>(planned_model.data()), planned_model.size());
+  if (!out) {
+    printf("Failed to write %s\n", argv[2]);
+    return 1;
+  }
+
+  // 4. report
+  const int runs = 20;
+  SetupResult greedy = time_setup(model, arena.data(), arena.size(), PlannerKind::Greedy, runs);
+  SetupResult linear = time_setup(model, arena.data(), arena.size(), PlannerKind::Linear, runs);
+  SetupResult precomputed = time_setup(out_model, arena.data(), arena.size(), PlannerKind::Precomputed, runs);
+
+  printf("%zu buffers, lower bound %d bytes, planned in %.1f ms\n", buffers.size(), bound, plan_ms);
+  printf("%-12s %12s %14s %12s\n", "planner", "plan bytes", "arena used", "setup us");
+  printf("%-12s %12d %14zu %12.1f\n", "greedy", greedy_plan, greedy.arena_used, greedy.setup_us);
+  if (linear.ok) {
+    int linear_plan = 0;
+    for (const auto& b : buffers) {
+      linear_plan += b.size;
+    }
+    printf("%-12s %12d %14zu %12.1f\n", "linear", linear_plan, linear.arena_used, linear.setup_us);
+  }
+  else {
+    printf("%-12s %12s\n", "linear", "(arena too small)");
+  }
+  printf("%-12s %12d %14zu %12.1f\n", "precomputed", planned, precomputed.arena_used, precomputed.setup_us);
+  printf("Wrote %s (%zu bytes)\n", argv[2], planned_model.size());
+  return 0;
+}